@@ -137,3 +137,41 @@ appendRemoteShellString(PQExpBuffer buf, const char *str)
 
 	appendPQExpBufferStr(buf, "\\'");
 }
+
+/*
+ * As appendRemoteShellString(), for a remote command which is enclosed in
+ * double quotes on the local command line (e.g. so a sequence of commands
+ * joined with "&&" is executed on the remote host): characters which are
+ * special within double quotes are escaped for the local shell, and the
+ * string is single-quoted for the remote shell.
+ */
+void
+appendDoubleQuotedRemoteShellString(PQExpBuffer buf, const char *str)
+{
+	const char *p;
+
+	appendPQExpBufferChar(buf, '\'');
+
+	for (p = str; *p; p++)
+	{
+		if (*p == '\n' || *p == '\r')
+		{
+			fprintf(stderr,
+					_("shell command argument contains a newline or carriage return: \"%s\"\n"),
+					str);
+			exit(ERR_BAD_CONFIG);
+		}
+
+		if (*p == '\'')
+			appendPQExpBufferStr(buf, "'\\''");
+		else if (*p == '"' || *p == '\\' || *p == '$' || *p == '`')
+		{
+			appendPQExpBufferChar(buf, '\\');
+			appendPQExpBufferChar(buf, *p);
+		}
+		else
+			appendPQExpBufferChar(buf, *p);
+	}
+
+	appendPQExpBufferChar(buf, '\'');
+}
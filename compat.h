@@ -29,4 +29,6 @@ extern void appendShellString(PQExpBuffer buf, const char *str);
 
 extern void appendRemoteShellString(PQExpBuffer buf, const char *str);
 
+extern void appendDoubleQuotedRemoteShellString(PQExpBuffer buf, const char *str);
+
 #endif
@@ -401,6 +401,56 @@ struct ConfigFileSetting config_file_settings[] =
 		{},
 		{}
 	},
+	/* switchover_prepare_timeout */
+	{
+		"switchover_prepare_timeout",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.switchover_prepare_timeout },
+		{ .intdefault = DEFAULT_SWITCHOVER_PREPARE_TIMEOUT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* switchover_prepare_lag_bytes */
+	{
+		"switchover_prepare_lag_bytes",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.switchover_prepare_lag_bytes },
+		{ .intdefault = DEFAULT_SWITCHOVER_PREPARE_LAG_BYTES },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* switchover_prepare_lag_seconds */
+	{
+		"switchover_prepare_lag_seconds",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.switchover_prepare_lag_seconds },
+		{ .intdefault = DEFAULT_SWITCHOVER_PREPARE_LAG_SECONDS },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* siblings_follow_max_parallel */
+	{
+		"siblings_follow_max_parallel",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.siblings_follow_max_parallel },
+		{ .intdefault = DEFAULT_SIBLINGS_FOLLOW_MAX_PARALLEL },
+		{ .intminval = 1 },
+		{},
+		{}
+	},
+	/* siblings_follow_timeout */
+	{
+		"siblings_follow_timeout",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.siblings_follow_timeout },
+		{ .intdefault = DEFAULT_SIBLINGS_FOLLOW_TIMEOUT },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
 
 	/* ====================
 	 * node rejoin settings
@@ -761,6 +811,36 @@ struct ConfigFileSetting config_file_settings[] =
 		{ .strmaxlen = sizeof(config_file_options.child_nodes_disconnect_command) },
 		{}
 	},
+	/* connectivity_check_interval */
+	{
+		"connectivity_check_interval",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.connectivity_check_interval },
+		{ .intdefault = DEFAULT_CONNECTIVITY_CHECK_INTERVAL },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* prewarm_interval */
+	{
+		"prewarm_interval",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.prewarm_interval },
+		{ .intdefault = DEFAULT_PREWARM_INTERVAL },
+		{ .intminval = 0 },
+		{},
+		{}
+	},
+	/* prewarm_min_priority */
+	{
+		"prewarm_min_priority",
+		CONFIG_INT,
+		{ .intptr = &config_file_options.prewarm_min_priority },
+		{ .intdefault = DEFAULT_PREWARM_MIN_PRIORITY },
+		{ .intminval = 1 },
+		{},
+		{}
+	},
 	/* ================
 	 * service settings
 	 * ================
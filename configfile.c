@@ -869,6 +869,7 @@ parse_time_unit_parameter(const char *name, const char *value, char *dest, ItemL
  * - child_nodes_disconnect_min_count
  * - child_nodes_disconnect_timeout
  * - connection_check_type
+ * - connectivity_check_interval
  * - conninfo
  * - degraded_monitoring_timeout
  * - event_notification_command
@@ -1103,6 +1104,15 @@ reload_config(t_server_type server_type)
 								config_file_options.child_nodes_disconnect_timeout);
 	}
 
+	/* connectivity_check_interval */
+	if (config_file_options.connectivity_check_interval != orig_config_file_options.connectivity_check_interval)
+	{
+		item_list_append_format(&config_changes,
+								_("\"connectivity_check_interval\" changed from \"%i\" to \"%i\""),
+								orig_config_file_options.connectivity_check_interval,
+								config_file_options.connectivity_check_interval);
+	}
+
 
 	/* degraded_monitoring_timeout */
 	if (config_file_options.degraded_monitoring_timeout != orig_config_file_options.degraded_monitoring_timeout)
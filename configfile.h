@@ -182,6 +182,11 @@ typedef struct
 	int			shutdown_check_timeout;
 	int			standby_reconnect_timeout;
 	int			wal_receive_check_timeout;
+	int			switchover_prepare_timeout;
+	int			switchover_prepare_lag_bytes;
+	int			switchover_prepare_lag_seconds;
+	int			siblings_follow_max_parallel;
+	int			siblings_follow_timeout;
 
 	/* node rejoin settings */
 	int			node_rejoin_timeout;
@@ -224,6 +229,9 @@ typedef struct
 	bool		child_nodes_connected_include_witness;
 	int			child_nodes_disconnect_timeout;
 	char		child_nodes_disconnect_command[MAXPGPATH];
+	int			connectivity_check_interval;
+	int			prewarm_interval;
+	int			prewarm_min_priority;
 
 	/* service settings */
 	char		pg_ctl_options[MAXLEN];
@@ -24,6 +24,7 @@
 #include <sys/stat.h>
 #include <dirent.h>
 #include <arpa/inet.h>
+#include <poll.h>
 
 #include "repmgr.h"
 #include "dbutils.h"
@@ -63,6 +64,8 @@ static bool _create_event(PGconn *conn, t_configuration_options *options, int no
 
 static NodeAttached _is_downstream_node_attached(PGconn *conn, char *node_name, char **node_state, bool quiet);
 
+static char *_get_extension_schema(PGconn *conn, const char *extname);
+
 /*
  * This provides a standardized way of logging database errors. Note
  * that the provided PGconn can be a normal or a replication connection;
@@ -438,6 +441,185 @@ duplicate_connection(PGconn *conn, const char *user, bool replication)
 }
 
 
+/*
+ * establish_db_connections_parallel()
+ *
+ * Attempt to connect to each node in the provided list concurrently, using
+ * libpq's non-blocking connection functions. At most "max_parallel" connection
+ * attempts will be in progress at any one time, and all attempts share a
+ * single timeout of "timeout" seconds; any attempts still in progress when
+ * the timeout expires are abandoned.
+ *
+ * On return each node's "conn" will be set; callers must check its status
+ * with PQstatus() as usual. Nodes whose connection attempt timed out will
+ * have "node_status" set to NODE_STATUS_DOWN, so callers can avoid pinging
+ * them again.
+ *
+ * Note that libpq does not enforce "connect_timeout" for non-blocking
+ * connections, so "timeout" is the only limit applied here.
+ *
+ * Returns the number of successful connections.
+ */
+int
+establish_db_connections_parallel(NodeInfoList *node_list, int max_parallel, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	NodeInfoListCell *next_cell = node_list->head;
+	t_node_info **active_nodes = NULL;
+	PostgresPollingStatusType *active_states = NULL;
+	struct pollfd *pollfds = NULL;
+	int			active_count = 0;
+	int			connected_count = 0;
+	instr_time	start_time;
+
+	if (node_list->node_count == 0)
+		return 0;
+
+	if (max_parallel < 1)
+		max_parallel = 1;
+
+	if (max_parallel > node_list->node_count)
+		max_parallel = node_list->node_count;
+
+	active_nodes = pg_malloc0(sizeof(t_node_info *) * max_parallel);
+	active_states = pg_malloc0(sizeof(PostgresPollingStatusType) * max_parallel);
+	pollfds = pg_malloc0(sizeof(struct pollfd) * max_parallel);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+		cell->node_info->conn = NULL;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	for (;;)
+	{
+		instr_time	elapsed_time;
+		double		remaining_ms;
+		int			poll_timeout;
+		int			i;
+
+		/* start new connection attempts while capacity is available */
+		while (next_cell != NULL && active_count < max_parallel)
+		{
+			t_node_info *node_info = next_cell->node_info;
+			t_conninfo_param_list conninfo_params = T_CONNINFO_PARAM_LIST_INITIALIZER;
+			char	   *errmsg = NULL;
+
+			next_cell = next_cell->next;
+
+			initialize_conninfo_params(&conninfo_params, false);
+
+			if (parse_conninfo_string(node_info->conninfo, &conninfo_params, &errmsg, false) == false)
+			{
+				log_verbose(LOG_WARNING, _("unable to parse conninfo string \"%s\" for node \"%s\" (ID: %i)"),
+							node_info->conninfo, node_info->node_name, node_info->node_id);
+				free_conninfo_params(&conninfo_params);
+				continue;
+			}
+
+			param_set_ine(&conninfo_params, "fallback_application_name", "repmgr");
+
+			/* use a secure search_path */
+			param_set(&conninfo_params, "options", "-csearch_path=");
+
+			log_debug("establish_db_connections_parallel(): connecting to node %i", node_info->node_id);
+
+			node_info->conn = PQconnectStartParams((const char **) conninfo_params.keywords,
+												   (const char **) conninfo_params.values,
+												   false);
+			free_conninfo_params(&conninfo_params);
+
+			if (node_info->conn == NULL || PQstatus(node_info->conn) == CONNECTION_BAD)
+				continue;
+
+			active_nodes[active_count] = node_info;
+			active_states[active_count] = PGRES_POLLING_WRITING;
+			active_count++;
+		}
+
+		if (active_count == 0)
+			break;
+
+		INSTR_TIME_SET_CURRENT(elapsed_time);
+		INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+		remaining_ms = ((double) timeout * 1000) - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+		if (remaining_ms <= 0)
+			break;
+
+		poll_timeout = (int) remaining_ms + 1;
+
+		for (i = 0; i < active_count; i++)
+		{
+			pollfds[i].fd = PQsocket(active_nodes[i]->conn);
+			pollfds[i].events = (active_states[i] == PGRES_POLLING_READING) ? POLLIN : POLLOUT;
+			pollfds[i].revents = 0;
+
+			/* no socket yet - let PQconnectPoll() create one without waiting */
+			if (pollfds[i].fd < 0)
+				poll_timeout = 0;
+		}
+
+		if (poll(pollfds, active_count, poll_timeout) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			log_warning(_("establish_db_connections_parallel(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
+			break;
+		}
+
+		/*
+		 * Advance each connection whose socket is ready; iterate backwards so
+		 * completed entries can be replaced by the last active entry.
+		 */
+		for (i = active_count - 1; i >= 0; i--)
+		{
+			if (pollfds[i].revents == 0 && pollfds[i].fd >= 0)
+				continue;
+
+			active_states[i] = PQconnectPoll(active_nodes[i]->conn);
+
+			if (active_states[i] == PGRES_POLLING_OK || active_states[i] == PGRES_POLLING_FAILED)
+			{
+				if (active_states[i] == PGRES_POLLING_OK)
+					connected_count++;
+
+				active_count--;
+				active_nodes[i] = active_nodes[active_count];
+				active_states[i] = active_states[active_count];
+				pollfds[i] = pollfds[active_count];
+			}
+		}
+	}
+
+	/* abandon any attempts which did not complete within the timeout */
+	if (active_count > 0 || next_cell != NULL)
+	{
+		int			i;
+
+		for (i = 0; i < active_count; i++)
+		{
+			log_verbose(LOG_WARNING, _("connection attempt to node \"%s\" (ID: %i) timed out after %i seconds"),
+						active_nodes[i]->node_name, active_nodes[i]->node_id, timeout);
+
+			PQfinish(active_nodes[i]->conn);
+			active_nodes[i]->conn = NULL;
+			active_nodes[i]->node_status = NODE_STATUS_DOWN;
+		}
+
+		for (; next_cell != NULL; next_cell = next_cell->next)
+			next_cell->node_info->node_status = NODE_STATUS_DOWN;
+	}
+
+	pfree(active_nodes);
+	pfree(active_states);
+	pfree(pollfds);
+
+	return connected_count;
+}
+
+
 
 void
 close_connection(PGconn **conn)
@@ -1255,6 +1437,44 @@ alter_system_int(PGconn *conn, const char *name, int value)
 }
 
 
+bool
+alter_system_str(PGconn *conn, const char *name, const char *value)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+	char	   *escaped_value = PQescapeLiteral(conn, value, strlen(value));
+
+	if (escaped_value == NULL)
+	{
+		log_error(_("alter_system_str(): unable to escape value for \"%s\""), name);
+		log_detail("%s", PQerrorMessage(conn));
+		return false;
+	}
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  "ALTER SYSTEM SET %s = %s",
+					  name, escaped_value);
+
+	PQfreemem(escaped_value);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_COMMAND_OK)
+	{
+		log_db_error(conn, query.data, _("alter_system_str() - unable to execute query"));
+
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
 bool
 pg_reload_conf(PGconn *conn)
 {
@@ -1933,6 +2153,53 @@ can_execute_pg_promote(PGconn *conn)
 }
 
 
+/*
+ * Determine if the user associated with the current connection can change
+ * "primary_conninfo" and "primary_slot_name" with ALTER SYSTEM, and reload
+ * the configuration with pg_reload_conf().
+ */
+bool
+can_alter_replication_config(PGconn *conn)
+{
+	PQExpBufferData query;
+	PGresult   *res;
+	bool		has_privileges = false;
+
+	/*
+	 * Superusers can do anything
+	 */
+	if (is_superuser_connection(conn, NULL) == true)
+		return true;
+
+	/* GRANT ALTER SYSTEM available from PostgreSQL 15 */
+	if (PQserverVersion(conn) < 150000)
+		return false;
+
+	initPQExpBuffer(&query);
+	appendPQExpBufferStr(&query,
+						 " SELECT pg_catalog.has_parameter_privilege('primary_conninfo', 'ALTER SYSTEM') "
+						 "    AND pg_catalog.has_parameter_privilege('primary_slot_name', 'ALTER SYSTEM') "
+						 "    AND pg_catalog.has_function_privilege('pg_catalog.pg_reload_conf()', 'execute') ");
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("can_alter_replication_config(): unable to query user privileges"));
+	}
+	else
+	{
+		has_privileges = atobool(PQgetvalue(res, 0, 0));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return has_privileges;
+}
+
+
 /*
  * Determine if the user associated with the current connection
  * has sufficient permissions to disable the walsender
@@ -2441,6 +2708,42 @@ repmgrd_set_upstream_node_id(PGconn *conn, int node_id)
 	return success;
 }
 
+
+/*
+ * Record the reachability of the specified node, as seen from the local
+ * node, in repmgrd's shared memory; "rtt_us" is the round-trip time in
+ * microseconds, or -1 if not known.
+ */
+bool
+repmgrd_set_node_connectivity(PGconn *conn, int node_id, bool reachable, int rtt_us)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT repmgr.set_node_connectivity(%i, %s, %i)",
+					  node_id,
+					  reachable == true ? "TRUE" : "FALSE",
+					  rtt_us);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("repmgrd_set_node_connectivity(): unable to execute query"));
+
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
 /* ================ */
 /* result functions */
 /* ================ */
@@ -4862,6 +5165,44 @@ get_inactive_replication_slots(PGconn *conn, KeyValueList *list)
 
 
 
+/*
+ * create_temporary_replication_slot_sql()
+ *
+ * Create a physical replication slot which reserves WAL immediately and
+ * is dropped automatically when the session ends (PostgreSQL 10 and later).
+ */
+bool
+create_temporary_replication_slot_sql(PGconn *conn, char *slot_name)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	bool		success = true;
+
+	initPQExpBuffer(&query);
+
+	appendPQExpBuffer(&query,
+					  "SELECT * FROM pg_catalog.pg_create_physical_replication_slot('%s', TRUE, TRUE)",
+					  slot_name);
+
+	log_verbose(LOG_DEBUG, "create_temporary_replication_slot_sql():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data,
+					 _("create_temporary_replication_slot_sql(): unable to create temporary replication slot \"%s\""),
+					 slot_name);
+		success = false;
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return success;
+}
+
+
 /* ==================== */
 /* tablespace functions */
 /* ==================== */
@@ -4907,50 +5248,412 @@ get_tablespace_name_by_location(PGconn *conn, const char *location, char *name)
 	return success;
 }
 
-/* ============================ */
-/* asynchronous query functions */
-/* ============================ */
 
+/*
+ * get_tablespace_locations()
+ *
+ * Populate the provided list with the OID and location of each
+ * user-defined tablespace.
+ */
 bool
-cancel_query(PGconn *conn, int timeout)
+get_tablespace_locations(PGconn *conn, KeyValueList *tablespaces)
 {
-	char		errbuf[ERRBUFF_SIZE] = "";
-	PGcancel   *pgcancel = NULL;
-
-	if (wait_connection_availability(conn, timeout) != 1)
-		return false;
+	PGresult   *res = NULL;
+	const char *sqlquery =
+		"SELECT oid, pg_catalog.pg_tablespace_location(oid) "
+		"  FROM pg_catalog.pg_tablespace "
+		" WHERE spcname NOT IN ('pg_default', 'pg_global') "
+		"ORDER BY oid";
+	bool		success = true;
+	int			i;
 
-	pgcancel = PQgetCancel(conn);
+	log_verbose(LOG_DEBUG, "get_tablespace_locations():\n%s", sqlquery);
 
-	if (pgcancel == NULL)
-		return false;
+	res = PQexec(conn, sqlquery);
 
-	/*
-	 * PQcancel can only return 0 if socket()/connect()/send() fails, in any
-	 * of those cases we can assume something bad happened to the connection
-	 */
-	if (PQcancel(pgcancel, errbuf, ERRBUFF_SIZE) == 0)
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
-		log_warning(_("unable to cancel current query"));
-		log_detail("\n%s", errbuf);
-		PQfreeCancel(pgcancel);
-		return false;
+		log_db_error(conn, sqlquery,
+					 _("get_tablespace_locations(): unable to execute tablespace query"));
+		success = false;
+	}
+	else
+	{
+		for (i = 0; i < PQntuples(res); i++)
+		{
+			key_value_list_set(tablespaces,
+							   PQgetvalue(res, i, 0),
+							   PQgetvalue(res, i, 1));
+		}
 	}
 
-	PQfreeCancel(pgcancel);
+	PQclear(res);
 
-	return true;
+	return success;
 }
 
 
+/* ================ */
+/* backup functions */
+/* ================ */
+
 /*
- * Wait until current query finishes, ignoring any results.
- * Usually this will be an async query or query cancellation.
+ * start_backup()
  *
- * Returns 1 for success; 0 if any error occurred; -1 if timeout reached.
+ * Start a non-exclusive backup (PostgreSQL 10 and later); the backup
+ * remains in progress until stop_backup() is called, or the connection
+ * is closed.
+ *
+ * Returns the backup start LSN, or InvalidXLogRecPtr on failure.
  */
-int
-wait_connection_availability(PGconn *conn, int timeout)
+XLogRecPtr
+start_backup(PGconn *conn, const char *label, bool fast_checkpoint)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	XLogRecPtr	ptr = InvalidXLogRecPtr;
+	char	   *escaped_label = NULL;
+
+	escaped_label = escape_string(conn, label);
+
+	if (escaped_label == NULL)
+	{
+		log_error(_("unable to escape backup label \"%s\""), label);
+		return InvalidXLogRecPtr;
+	}
+
+	initPQExpBuffer(&query);
+
+	if (PQserverVersion(conn) >= 150000)
+	{
+		appendPQExpBuffer(&query,
+						  "SELECT pg_catalog.pg_backup_start('%s', %s)",
+						  escaped_label,
+						  fast_checkpoint ? "TRUE" : "FALSE");
+	}
+	else
+	{
+		appendPQExpBuffer(&query,
+						  "SELECT pg_catalog.pg_start_backup('%s', %s, FALSE)",
+						  escaped_label,
+						  fast_checkpoint ? "TRUE" : "FALSE");
+	}
+
+	pfree(escaped_label);
+
+	log_verbose(LOG_DEBUG, "start_backup():\n  %s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("start_backup(): unable to start backup"));
+	}
+	else
+	{
+		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return ptr;
+}
+
+
+/*
+ * stop_backup()
+ *
+ * Stop a non-exclusive backup started with start_backup(), without
+ * waiting for WAL to be archived, and return the contents of the
+ * "backup_label" and "tablespace_map" files which must be written to
+ * the backup.
+ *
+ * Returns the backup stop LSN, or InvalidXLogRecPtr on failure.
+ */
+XLogRecPtr
+stop_backup(PGconn *conn, PQExpBufferData *labelfile, PQExpBufferData *spcmapfile)
+{
+	PGresult   *res = NULL;
+	XLogRecPtr	ptr = InvalidXLogRecPtr;
+	const char *sqlquery = NULL;
+
+	if (PQserverVersion(conn) >= 150000)
+		sqlquery = "SELECT lsn, labelfile, spcmapfile FROM pg_catalog.pg_backup_stop(FALSE)";
+	else
+		sqlquery = "SELECT lsn, labelfile, spcmapfile FROM pg_catalog.pg_stop_backup(FALSE, FALSE)";
+
+	log_verbose(LOG_DEBUG, "stop_backup():\n  %s", sqlquery);
+
+	res = PQexec(conn, sqlquery);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, sqlquery, _("stop_backup(): unable to stop backup"));
+	}
+	else
+	{
+		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+		appendPQExpBufferStr(labelfile, PQgetvalue(res, 0, 1));
+
+		if (!PQgetisnull(res, 0, 2))
+			appendPQExpBufferStr(spcmapfile, PQgetvalue(res, 0, 2));
+	}
+
+	PQclear(res);
+
+	return ptr;
+}
+
+
+/*
+ * get_wal_segment_size()
+ *
+ * Returns the server's WAL segment size in bytes, or 0 on failure.
+ */
+uint64
+get_wal_segment_size(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	uint64		wal_segment_size = 0;
+	const char *sqlquery =
+		"SELECT pg_catalog.pg_size_bytes(pg_catalog.current_setting('wal_segment_size'))";
+
+	res = PQexec(conn, sqlquery);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, sqlquery, _("get_wal_segment_size(): unable to determine WAL segment size"));
+	}
+	else
+	{
+		wal_segment_size = strtoul(PQgetvalue(res, 0, 0), NULL, 10);
+	}
+
+	PQclear(res);
+
+	return wal_segment_size;
+}
+
+
+/* ============================ */
+/* asynchronous query functions */
+/* ============================ */
+
+/*
+ * execute_query_parallel()
+ *
+ * Send "query" to each node in the provided list which has an open connection,
+ * and process the results concurrently as they arrive. "callback" is called
+ * once for each node the query was sent to, with the final result returned
+ * by that node; the result will be NULL if the query could not be executed
+ * or did not complete within "timeout" seconds. Results are freed after the
+ * callback returns.
+ *
+ * Queries still executing when the timeout expires are cancelled; however
+ * the connection may not immediately be available for further use, so
+ * callers should close it.
+ *
+ * Returns the number of queries which executed successfully.
+ */
+int
+execute_query_parallel(NodeInfoList *node_list, const char *query, int timeout,
+					   void (*callback) (t_node_info *node_info, PGresult *res, void *arg),
+					   void *arg)
+{
+	NodeInfoListCell *cell = NULL;
+	t_node_info **active_nodes = NULL;
+	PGresult  **active_results = NULL;
+	struct pollfd *pollfds = NULL;
+	int			active_count = 0;
+	int			success_count = 0;
+	int			i;
+	instr_time	start_time;
+
+	if (node_list->node_count == 0)
+		return 0;
+
+	active_nodes = pg_malloc0(sizeof(t_node_info *) * node_list->node_count);
+	active_results = pg_malloc0(sizeof(PGresult *) * node_list->node_count);
+	pollfds = pg_malloc0(sizeof(struct pollfd) * node_list->node_count);
+
+	for (cell = node_list->head; cell; cell = cell->next)
+	{
+		t_node_info *node_info = cell->node_info;
+
+		if (node_info->conn == NULL || PQstatus(node_info->conn) != CONNECTION_OK)
+			continue;
+
+		log_debug("execute_query_parallel(): sending query to node %i", node_info->node_id);
+
+		if (PQsendQuery(node_info->conn, query) == 0)
+		{
+			log_warning(_("unable to send query to node \"%s\" (ID: %i)"),
+						node_info->node_name, node_info->node_id);
+			log_detail("%s", PQerrorMessage(node_info->conn));
+
+			callback(node_info, NULL, arg);
+			continue;
+		}
+
+		active_nodes[active_count] = node_info;
+		active_results[active_count] = NULL;
+		active_count++;
+	}
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	while (active_count > 0)
+	{
+		instr_time	elapsed_time;
+		double		remaining_ms;
+
+		INSTR_TIME_SET_CURRENT(elapsed_time);
+		INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+		remaining_ms = ((double) timeout * 1000) - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+		if (remaining_ms <= 0)
+			break;
+
+		for (i = 0; i < active_count; i++)
+		{
+			pollfds[i].fd = PQsocket(active_nodes[i]->conn);
+			pollfds[i].events = POLLIN;
+			pollfds[i].revents = 0;
+		}
+
+		if (poll(pollfds, active_count, (int) remaining_ms + 1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			log_warning(_("execute_query_parallel(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
+			break;
+		}
+
+		/*
+		 * Read any available input; iterate backwards so completed entries
+		 * can be replaced by the last active entry.
+		 */
+		for (i = active_count - 1; i >= 0; i--)
+		{
+			t_node_info *node_info = active_nodes[i];
+			bool		query_complete = false;
+
+			if (pollfds[i].revents == 0)
+				continue;
+
+			if (PQconsumeInput(node_info->conn) == 0)
+			{
+				log_warning(_("unable to receive data from node \"%s\" (ID: %i)"),
+							node_info->node_name, node_info->node_id);
+				log_detail("%s", PQerrorMessage(node_info->conn));
+				query_complete = true;
+			}
+			else
+			{
+				/* retain the last result returned */
+				while (PQisBusy(node_info->conn) == 0)
+				{
+					PGresult   *res = PQgetResult(node_info->conn);
+
+					if (res == NULL)
+					{
+						query_complete = true;
+						break;
+					}
+
+					PQclear(active_results[i]);
+					active_results[i] = res;
+				}
+			}
+
+			if (query_complete == false)
+				continue;
+
+			if (PQresultStatus(active_results[i]) == PGRES_TUPLES_OK ||
+				PQresultStatus(active_results[i]) == PGRES_COMMAND_OK)
+				success_count++;
+
+			callback(node_info, active_results[i], arg);
+			PQclear(active_results[i]);
+
+			active_count--;
+			active_nodes[i] = active_nodes[active_count];
+			active_results[i] = active_results[active_count];
+			pollfds[i] = pollfds[active_count];
+		}
+	}
+
+	/* cancel any queries which did not complete within the timeout */
+	for (i = 0; i < active_count; i++)
+	{
+		char		errbuf[ERRBUFF_SIZE] = "";
+		PGcancel   *pgcancel = PQgetCancel(active_nodes[i]->conn);
+
+		log_verbose(LOG_WARNING, _("query on node \"%s\" (ID: %i) did not complete within %i seconds"),
+					active_nodes[i]->node_name, active_nodes[i]->node_id, timeout);
+
+		if (pgcancel != NULL)
+		{
+			(void) PQcancel(pgcancel, errbuf, ERRBUFF_SIZE);
+			PQfreeCancel(pgcancel);
+		}
+
+		PQclear(active_results[i]);
+
+		callback(active_nodes[i], NULL, arg);
+	}
+
+	pfree(active_nodes);
+	pfree(active_results);
+	pfree(pollfds);
+
+	return success_count;
+}
+
+
+bool
+cancel_query(PGconn *conn, int timeout)
+{
+	char		errbuf[ERRBUFF_SIZE] = "";
+	PGcancel   *pgcancel = NULL;
+
+	if (wait_connection_availability(conn, timeout) != 1)
+		return false;
+
+	pgcancel = PQgetCancel(conn);
+
+	if (pgcancel == NULL)
+		return false;
+
+	/*
+	 * PQcancel can only return 0 if socket()/connect()/send() fails, in any
+	 * of those cases we can assume something bad happened to the connection
+	 */
+	if (PQcancel(pgcancel, errbuf, ERRBUFF_SIZE) == 0)
+	{
+		log_warning(_("unable to cancel current query"));
+		log_detail("\n%s", errbuf);
+		PQfreeCancel(pgcancel);
+		return false;
+	}
+
+	PQfreeCancel(pgcancel);
+
+	return true;
+}
+
+
+/*
+ * Wait until current query finishes, ignoring any results.
+ * Usually this will be an async query or query cancellation.
+ *
+ * Returns 1 for success; 0 if any error occurred; -1 if timeout reached.
+ */
+int
+wait_connection_availability(PGconn *conn, int timeout)
 {
 	PGresult   *res = NULL;
 	fd_set		read_set;
@@ -5544,6 +6247,36 @@ get_last_wal_receive_location(PGconn *conn)
 	return ptr;
 }
 
+
+XLogRecPtr
+get_last_wal_replay_location(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	XLogRecPtr	ptr = InvalidXLogRecPtr;
+
+	if (PQserverVersion(conn) >= 100000)
+	{
+		res = PQexec(conn, "SELECT pg_catalog.pg_last_wal_replay_lsn()");
+	}
+	else
+	{
+		res = PQexec(conn, "SELECT pg_catalog.pg_last_xlog_replay_location()");
+	}
+
+	if (PQresultStatus(res) == PGRES_TUPLES_OK)
+	{
+		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+	}
+	else
+	{
+		log_db_error(conn, NULL, _("unable to execute get_last_wal_replay_location()"));
+	}
+
+	PQclear(res);
+
+	return ptr;
+}
+
 /*
  * Returns the latest LSN for the node regardless of recovery state.
  */
@@ -5817,6 +6550,506 @@ get_replication_lag_seconds(PGconn *conn)
 }
 
 
+/*
+ * get_max_downstream_replay_lag_seconds()
+ *
+ * Return the greatest replay lag (in seconds) of any streaming standby
+ * attached to the node, excluding pg_basebackup sessions. Requires
+ * PostgreSQL 10 or later.
+ */
+int
+get_max_downstream_replay_lag_seconds(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	int			lag_seconds = UNKNOWN_REPLICATION_LAG;
+	const char *sqlquery =
+		"SELECT COALESCE(MAX(EXTRACT(epoch FROM replay_lag)), 0)::INT "
+		"  FROM pg_catalog.pg_stat_replication "
+		" WHERE state = 'streaming' "
+		"   AND application_name != 'pg_basebackup'";
+
+	if (PQserverVersion(conn) < 100000)
+		return UNKNOWN_REPLICATION_LAG;
+
+	log_verbose(LOG_DEBUG, "get_max_downstream_replay_lag_seconds():\n%s", sqlquery);
+
+	res = PQexec(conn, sqlquery);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, sqlquery, _("get_max_downstream_replay_lag_seconds(): unable to query replication status"));
+	}
+	else
+	{
+		lag_seconds = atoi(PQgetvalue(res, 0, 0));
+	}
+
+	PQclear(res);
+
+	return lag_seconds;
+}
+
+
+/*
+ * get_requested_checkpoint_count()
+ *
+ * Return the number of checkpoints requested (e.g. because "max_wal_size"
+ * was reached) since the statistics were last reset, or -1 on error.
+ */
+int64
+get_requested_checkpoint_count(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	int64		checkpoint_count = -1;
+	const char *sqlquery = NULL;
+
+	if (PQserverVersion(conn) >= 170000)
+		sqlquery = "SELECT num_requested FROM pg_catalog.pg_stat_checkpointer";
+	else
+		sqlquery = "SELECT checkpoints_req FROM pg_catalog.pg_stat_bgwriter";
+
+	log_verbose(LOG_DEBUG, "get_requested_checkpoint_count():\n%s", sqlquery);
+
+	res = PQexec(conn, sqlquery);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, sqlquery, _("get_requested_checkpoint_count(): unable to query checkpoint statistics"));
+	}
+	else
+	{
+		checkpoint_count = atol(PQgetvalue(res, 0, 0));
+	}
+
+	PQclear(res);
+
+	return checkpoint_count;
+}
+
+
+/*
+ * get_last_checkpoint_lsn()
+ *
+ * Return the location of the latest checkpoint record, or InvalidXLogRecPtr
+ * if it cannot be determined.
+ *
+ * pg_control_checkpoint() was introduced in PostgreSQL 9.6.
+ */
+XLogRecPtr
+get_last_checkpoint_lsn(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	XLogRecPtr	ptr = InvalidXLogRecPtr;
+
+	if (PQserverVersion(conn) < 90600)
+		return ptr;
+
+	res = PQexec(conn, "SELECT checkpoint_lsn FROM pg_catalog.pg_control_checkpoint()");
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, NULL, _("get_last_checkpoint_lsn(): unable to query pg_control_checkpoint()"));
+	}
+	else
+	{
+		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+	}
+
+	PQclear(res);
+
+	return ptr;
+}
+
+
+/*
+ * get_last_checkpoint_redo_lsn()
+ *
+ * Return the redo location of the latest checkpoint (or, on a standby,
+ * restartpoint), or InvalidXLogRecPtr if it cannot be determined.
+ *
+ * pg_control_checkpoint() was introduced in PostgreSQL 9.6.
+ */
+XLogRecPtr
+get_last_checkpoint_redo_lsn(PGconn *conn)
+{
+	PGresult   *res = NULL;
+	XLogRecPtr	ptr = InvalidXLogRecPtr;
+
+	if (PQserverVersion(conn) < 90600)
+		return ptr;
+
+	res = PQexec(conn, "SELECT redo_lsn FROM pg_catalog.pg_control_checkpoint()");
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, NULL, _("get_last_checkpoint_redo_lsn(): unable to query pg_control_checkpoint()"));
+	}
+	else
+	{
+		ptr = parse_lsn(PQgetvalue(res, 0, 0));
+	}
+
+	PQclear(res);
+
+	return ptr;
+}
+
+
+/*
+ * get_dirty_buffer_bytes()
+ *
+ * Return the size of the dirty pages in shared buffers, which must be written
+ * by the next checkpoint; requires the "pg_buffercache" extension. Returns -1
+ * if the extension is not installed or the query fails.
+ *
+ * Note this scans all of shared buffers.
+ */
+int64
+get_dirty_buffer_bytes(PGconn *conn)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int64		dirty_bytes = -1;
+	char	   *schema = _get_extension_schema(conn, "pg_buffercache");
+
+	if (schema == NULL)
+		return dirty_bytes;
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  " SELECT pg_catalog.count(*) * pg_catalog.current_setting('block_size')::BIGINT "
+					  "   FROM %s.pg_buffercache "
+					  "  WHERE isdirty IS TRUE ",
+					  schema);
+
+	PQfreemem(schema);
+
+	log_verbose(LOG_DEBUG, "get_dirty_buffer_bytes():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("get_dirty_buffer_bytes(): unable to query pg_buffercache"));
+	}
+	else
+	{
+		dirty_bytes = atol(PQgetvalue(res, 0, 0));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return dirty_bytes;
+}
+
+
+/*
+ * send_buffer_hot_set_query()
+ *
+ * Asynchronously retrieve the most frequently used blocks in shared buffers
+ * (those with a usage count of at least "min_usagecount"), as up to
+ * "max_ranges" ranges of consecutive blocks, the ranges with the highest
+ * total usage count first, grouped by database; requires the
+ * "pg_buffercache" extension. Blocks of shared catalogs and initialization
+ * forks are not included. The result should be passed to
+ * parse_buffer_hot_set().
+ *
+ * Note this scans all of shared buffers, which can take some time, so the
+ * caller should set "statement_timeout" on "conn" as appropriate.
+ *
+ * Returns false if the "pg_buffercache" extension is not installed, or the
+ * query could not be sent.
+ */
+bool
+send_buffer_hot_set_query(PGconn *conn, int min_usagecount, int max_ranges)
+{
+	PQExpBufferData query;
+	char	   *schema = _get_extension_schema(conn, "pg_buffercache");
+
+	if (schema == NULL)
+	{
+		log_warning(_("extension \"pg_buffercache\" is not installed"));
+		return false;
+	}
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  "   WITH b AS ( "
+					  "     SELECT reldatabase, reltablespace, relfilenode, relforknumber, "
+					  "            relblocknumber, usagecount, "
+					  "            relblocknumber - pg_catalog.row_number() OVER ( "
+					  "              PARTITION BY reldatabase, reltablespace, relfilenode, relforknumber "
+					  "              ORDER BY relblocknumber) AS block_group "
+					  "       FROM %s.pg_buffercache "
+					  "      WHERE usagecount >= %i "
+					  "        AND reldatabase IS NOT NULL "
+					  "        AND reldatabase != 0 "
+					  "        AND relforknumber < 3 "
+					  "   ), "
+					  "   r AS ( "
+					  "     SELECT reldatabase, reltablespace, relfilenode, relforknumber, "
+					  "            pg_catalog.min(relblocknumber) AS first_block, "
+					  "            pg_catalog.max(relblocknumber) AS last_block, "
+					  "            pg_catalog.sum(usagecount) AS usage "
+					  "       FROM b "
+					  "   GROUP BY reldatabase, reltablespace, relfilenode, relforknumber, block_group "
+					  "   ORDER BY usage DESC "
+					  "      LIMIT %i "
+					  "   ) "
+					  " SELECT d.datname, r.reltablespace, r.relfilenode, "
+					  "        CASE r.relforknumber WHEN 0 THEN 'main' WHEN 1 THEN 'fsm' ELSE 'vm' END, "
+					  "        r.first_block, r.last_block "
+					  "   FROM r "
+					  "   JOIN pg_catalog.pg_database d "
+					  "     ON d.oid = r.reldatabase "
+					  " ORDER BY d.datname, r.usage DESC ",
+					  schema,
+					  min_usagecount,
+					  max_ranges);
+
+	PQfreemem(schema);
+
+	log_verbose(LOG_DEBUG, "send_buffer_hot_set_query():\n%s", query.data);
+
+	if (PQsendQuery(conn, query.data) == 0)
+	{
+		log_warning(_("unable to send buffer hot set query"));
+		log_detail("%s", PQerrorMessage(conn));
+		termPQExpBuffer(&query);
+		return false;
+	}
+
+	termPQExpBuffer(&query);
+
+	return true;
+}
+
+
+/*
+ * parse_buffer_hot_set()
+ *
+ * Populate "range_list" from the result of the query sent by
+ * send_buffer_hot_set_query().
+ */
+bool
+parse_buffer_hot_set(PGresult *res, BufferRangeList *range_list)
+{
+	int			i;
+
+	clear_buffer_range_list(range_list);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_warning(_("unable to retrieve buffer hot set"));
+		log_detail("%s", PQresultErrorMessage(res));
+		return false;
+	}
+
+	range_list->range_count = PQntuples(res);
+
+	if (range_list->range_count > 0)
+		range_list->ranges = pg_malloc0(sizeof(t_buffer_range) * range_list->range_count);
+
+	for (i = 0; i < range_list->range_count; i++)
+	{
+		t_buffer_range *range = &range_list->ranges[i];
+
+		snprintf(range->database, NAMEDATALEN, "%s", PQgetvalue(res, i, 0));
+		range->tablespace = (Oid) strtoul(PQgetvalue(res, i, 1), NULL, 10);
+		range->relfilenode = (Oid) strtoul(PQgetvalue(res, i, 2), NULL, 10);
+		snprintf(range->fork, sizeof(range->fork), "%s", PQgetvalue(res, i, 3));
+		range->first_block = atol(PQgetvalue(res, i, 4));
+		range->last_block = atol(PQgetvalue(res, i, 5));
+	}
+
+	return true;
+}
+
+
+void
+clear_buffer_range_list(BufferRangeList *range_list)
+{
+	if (range_list->ranges != NULL)
+		pfree(range_list->ranges);
+
+	range_list->ranges = NULL;
+	range_list->range_count = 0;
+}
+
+
+/*
+ * send_prewarm_query()
+ *
+ * Asynchronously load "range_count" ranges of blocks from "range_list",
+ * starting at "first_range", into shared buffers with pg_prewarm(); "conn"
+ * must be connected to the database the ranges belong to. Relations which no
+ * longer exist are skipped, and ranges are truncated to the current size of
+ * the relation. The result is a single row containing the number of blocks
+ * loaded.
+ *
+ * Returns false if the "pg_prewarm" extension is not installed in the
+ * database, or the query could not be sent.
+ */
+bool
+send_prewarm_query(PGconn *conn, BufferRangeList *range_list, int first_range, int range_count)
+{
+	PQExpBufferData query;
+	char	   *schema = _get_extension_schema(conn, "pg_prewarm");
+	int			i;
+
+	if (schema == NULL)
+	{
+		log_verbose(LOG_INFO, _("extension \"pg_prewarm\" is not installed in database \"%s\""),
+					PQdb(conn));
+		return false;
+	}
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  " SELECT COALESCE(pg_catalog.sum(%s.pg_prewarm(rel, 'buffer', fork, first_block, last_block)), 0) "
+					  "   FROM (SELECT rel, fork, first_block, "
+					  "                LEAST(last_block, "
+					  "                      pg_catalog.pg_relation_size(rel, fork) / pg_catalog.current_setting('block_size')::BIGINT - 1) AS last_block "
+					  "           FROM (SELECT pg_catalog.pg_filenode_relation(v.tablespace, v.relfilenode) AS rel, "
+					  "                        v.fork, v.first_block, v.last_block "
+					  "                   FROM (VALUES ",
+					  schema);
+
+	PQfreemem(schema);
+
+	for (i = first_range; i < first_range + range_count; i++)
+	{
+		t_buffer_range *range = &range_list->ranges[i];
+
+		appendPQExpBuffer(&query,
+						  "%s(%u::OID, %u::OID, '%s', " INT64_FORMAT "::BIGINT, " INT64_FORMAT "::BIGINT)",
+						  i == first_range ? "" : ", ",
+						  range->tablespace,
+						  range->relfilenode,
+						  range->fork,
+						  range->first_block,
+						  range->last_block);
+	}
+
+	appendPQExpBufferStr(&query,
+						 "                        ) AS v(tablespace, relfilenode, fork, first_block, last_block) "
+						 "                ) r "
+						 "          WHERE rel IS NOT NULL "
+						 "        ) p "
+						 "  WHERE first_block <= last_block ");
+
+	log_verbose(LOG_DEBUG, "send_prewarm_query(): prewarming %i ranges in database \"%s\"",
+				range_count, PQdb(conn));
+
+	if (PQsendQuery(conn, query.data) == 0)
+	{
+		log_warning(_("unable to send prewarm query to database \"%s\""), PQdb(conn));
+		log_detail("%s", PQerrorMessage(conn));
+		termPQExpBuffer(&query);
+		return false;
+	}
+
+	termPQExpBuffer(&query);
+
+	return true;
+}
+
+
+/*
+ * _get_extension_schema()
+ *
+ * Return the schema the extension "extname" is installed in, quoted for use
+ * as an identifier (to be freed with PQfreemem()), or NULL if the extension
+ * is not installed or the query fails.
+ */
+static char *
+_get_extension_schema(PGconn *conn, const char *extname)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	char	   *schema = NULL;
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  " SELECT n.nspname "
+					  "   FROM pg_catalog.pg_extension e "
+					  "   JOIN pg_catalog.pg_namespace n "
+					  "     ON n.oid = e.extnamespace "
+					  "  WHERE e.extname = '%s' ",
+					  extname);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("_get_extension_schema(): unable to query pg_extension"));
+	}
+	else if (PQntuples(res) > 0)
+	{
+		schema = PQescapeIdentifier(conn, PQgetvalue(res, 0, 0), strlen(PQgetvalue(res, 0, 0)));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return schema;
+}
+
+
+/*
+ * get_switchover_promote_duration()
+ *
+ * Return the average duration, in milliseconds, of the "promote" phase of up
+ * to "limit" recent successful switchovers, as recorded in the phase timings
+ * of the "standby_switchover" event details; "sample_count" is set to the
+ * number of switchovers found. Returns -1 if none are found.
+ */
+int
+get_switchover_promote_duration(PGconn *conn, int limit, int *sample_count)
+{
+	PQExpBufferData query;
+	PGresult   *res = NULL;
+	int			promote_ms = -1;
+
+	*sample_count = 0;
+
+	initPQExpBuffer(&query);
+	appendPQExpBuffer(&query,
+					  " SELECT pg_catalog.count(*), "
+					  "        pg_catalog.round(pg_catalog.avg(promote_ms)) "
+					  "   FROM (SELECT pg_catalog.substring(details FROM 'promote ([0-9]+) ms')::INT AS promote_ms "
+					  "           FROM repmgr.events "
+					  "          WHERE event = 'standby_switchover' "
+					  "            AND successful IS TRUE "
+					  "            AND details ~ 'promote [0-9]+ ms' "
+					  "       ORDER BY event_timestamp DESC "
+					  "          LIMIT %i) e ",
+					  limit);
+
+	log_verbose(LOG_DEBUG, "get_switchover_promote_duration():\n%s", query.data);
+
+	res = PQexec(conn, query.data);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_db_error(conn, query.data, _("get_switchover_promote_duration(): unable to query events"));
+	}
+	else
+	{
+		*sample_count = atoi(PQgetvalue(res, 0, 0));
+
+		if (*sample_count > 0)
+			promote_ms = atoi(PQgetvalue(res, 0, 1));
+	}
+
+	termPQExpBuffer(&query);
+	PQclear(res);
+
+	return promote_ms;
+}
+
+
 
 TimeLineID
 get_node_timeline(PGconn *conn, char *timeline_id_str)
@@ -288,6 +288,33 @@ typedef struct s_event_info
 }
 
 
+/*
+ * Range of consecutive blocks of a relation fork held in shared buffers,
+ * identified by database name and relfilenode as these are identical on
+ * all nodes in a physical replication cluster.
+ */
+typedef struct s_buffer_range
+{
+	char		database[NAMEDATALEN];
+	Oid			tablespace;
+	Oid			relfilenode;
+	char		fork[5];
+	int64		first_block;
+	int64		last_block;
+} t_buffer_range;
+
+typedef struct BufferRangeList
+{
+	t_buffer_range *ranges;
+	int			range_count;
+} BufferRangeList;
+
+#define T_BUFFER_RANGE_LIST_INITIALIZER { \
+	NULL, \
+	0 \
+}
+
+
 /*
  * Struct to store list of conninfo keywords and values
  */
@@ -405,6 +432,7 @@ PGconn	   *establish_primary_db_connection(PGconn *conn,
 PGconn	   *get_primary_connection(PGconn *standby_conn, int *primary_id, char *primary_conninfo_out);
 PGconn	   *get_primary_connection_quiet(PGconn *standby_conn, int *primary_id, char *primary_conninfo_out);
 PGconn	   *duplicate_connection(PGconn *conn, const char *user, bool replication);
+int			establish_db_connections_parallel(NodeInfoList *node_list, int max_parallel, int timeout);
 
 void		close_connection(PGconn **conn);
 
@@ -438,6 +466,7 @@ bool		get_pg_setting(PGconn *conn, const char *setting, char *output);
 bool		get_pg_setting_bool(PGconn *conn, const char *setting, bool *output);
 bool		get_pg_setting_int(PGconn *conn, const char *setting, int *output);
 bool		alter_system_int(PGconn *conn, const char *name, int value);
+bool		alter_system_str(PGconn *conn, const char *name, const char *value);
 bool		pg_reload_conf(PGconn *conn);
 
 /* server information functions */
@@ -456,6 +485,7 @@ pid_t		get_wal_receiver_pid(PGconn *conn);
 bool		can_execute_checkpoint(PGconn *conn);
 bool		can_execute_pg_promote(PGconn *conn);
 bool		can_disable_walsender(PGconn *conn);
+bool		can_alter_replication_config(PGconn *conn);
 bool		connection_has_pg_monitor_role(PGconn *conn, const char *subrole);
 bool		is_replication_role(PGconn *conn, char *rolname);
 bool		is_superuser_connection(PGconn *conn, t_connection_user *userinfo);
@@ -472,6 +502,7 @@ bool		repmgrd_is_paused(PGconn *conn);
 bool		repmgrd_pause(PGconn *conn, bool pause);
 int			repmgrd_get_upstream_node_id(PGconn *conn);
 bool		repmgrd_set_upstream_node_id(PGconn *conn, int node_id);
+bool		repmgrd_set_node_connectivity(PGconn *conn, int node_id, bool reachable, int rtt_us);
 
 /* extension functions */
 ExtensionStatus get_repmgr_extension_status(PGconn *conn, t_extension_versions *extversions);
@@ -542,6 +573,7 @@ bool		create_replication_slot_sql(PGconn *conn, char *slot_name, PQExpBufferData
 bool		create_replication_slot_replprot(PGconn *conn, PGconn *repl_conn, char *slot_name, PQExpBufferData *error_msg);
 bool		drop_replication_slot_sql(PGconn *conn, char *slot_name);
 bool		drop_replication_slot_replprot(PGconn *repl_conn, char *slot_name);
+bool		create_temporary_replication_slot_sql(PGconn *conn, char *slot_name);
 
 RecordStatus get_slot_record(PGconn *conn, char *slot_name, t_replication_slot *record);
 int			get_free_replication_slot_count(PGconn *conn, int *max_replication_slots);
@@ -549,10 +581,19 @@ int			get_inactive_replication_slots(PGconn *conn, KeyValueList *list);
 
 /* tablespace functions */
 bool		get_tablespace_name_by_location(PGconn *conn, const char *location, char *name);
+bool		get_tablespace_locations(PGconn *conn, KeyValueList *tablespaces);
+
+/* backup functions */
+XLogRecPtr	start_backup(PGconn *conn, const char *label, bool fast_checkpoint);
+XLogRecPtr	stop_backup(PGconn *conn, PQExpBufferData *labelfile, PQExpBufferData *spcmapfile);
+uint64		get_wal_segment_size(PGconn *conn);
 
 /* asynchronous query functions */
 bool		cancel_query(PGconn *conn, int timeout);
 int			wait_connection_availability(PGconn *conn, int timeout);
+int			execute_query_parallel(NodeInfoList *node_list, const char *query, int timeout,
+								   void (*callback) (t_node_info *node_info, PGresult *res, void *arg),
+								   void *arg);
 
 /* node availability functions */
 bool		is_server_available(const char *conninfo);
@@ -593,9 +634,20 @@ void		reset_voting_status(PGconn *conn);
 XLogRecPtr	get_primary_current_lsn(PGconn *conn);
 XLogRecPtr	get_node_current_lsn(PGconn *conn);
 XLogRecPtr	get_last_wal_receive_location(PGconn *conn);
+XLogRecPtr	get_last_wal_replay_location(PGconn *conn);
 void		init_replication_info(ReplInfo *replication_info);
 bool		get_replication_info(PGconn *conn, t_server_type node_type, ReplInfo *replication_info);
 int			get_replication_lag_seconds(PGconn *conn);
+int			get_max_downstream_replay_lag_seconds(PGconn *conn);
+int64		get_requested_checkpoint_count(PGconn *conn);
+XLogRecPtr	get_last_checkpoint_lsn(PGconn *conn);
+XLogRecPtr	get_last_checkpoint_redo_lsn(PGconn *conn);
+int64		get_dirty_buffer_bytes(PGconn *conn);
+int			get_switchover_promote_duration(PGconn *conn, int limit, int *sample_count);
+bool		send_buffer_hot_set_query(PGconn *conn, int min_usagecount, int max_ranges);
+bool		parse_buffer_hot_set(PGresult *res, BufferRangeList *range_list);
+void		clear_buffer_range_list(BufferRangeList *range_list);
+bool		send_prewarm_query(PGconn *conn, BufferRangeList *range_list, int first_range, int range_count);
 TimeLineID	get_node_timeline(PGconn *conn, char *timeline_id_str);
 void		get_node_replication_stats(PGconn *conn, t_node_info *node_info);
 NodeAttached is_downstream_node_attached(PGconn *conn, char *node_name, char **node_state);
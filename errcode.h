@@ -50,5 +50,6 @@
 #define ERR_REPMGRD_PAUSE 26
 #define ERR_REPMGRD_SERVICE 27
 #define ERR_PGBACKUPAPI_SERVICE 28
+#define ERR_PROVISION_FAIL 29
 
 #endif							/* _ERRCODE_H_ */
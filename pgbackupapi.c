@@ -49,6 +49,20 @@ size_t receive_operations_cb(void *content, size_t size, size_t nmemb, char *buf
 	return size * nmemb;
 }
 
+//A single handle is used for all requests, so the connection is kept alive between polls
+CURL * init_pg_backupapi_handle(void) {
+	CURL *curl = curl_easy_init();
+
+	if (curl != NULL) {
+		curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+		curl_easy_setopt(curl, CURLOPT_TCP_KEEPIDLE, 30L);
+		curl_easy_setopt(curl, CURLOPT_TCP_KEEPINTVL, 10L);
+		curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
+	}
+
+	return curl;
+}
+
 char * define_base_url(operation_task *task) {
 	char *format = "http://%s:7480/servers/%s/operations";
 	char *url = malloc(MAX_BUFFER_LENGTH);
@@ -113,6 +127,10 @@ CURLcode create_new_task(CURL *curl, operation_task *task) {
 	free(url);
 	termPQExpBuffer(&payload);
 
+	//The handle is reused for subsequent GET requests
+	curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+	curl_slist_free_all(chunk);
+
 	return ret;
 }
 
@@ -132,16 +150,21 @@ size_t receive_operation_status(void *content, size_t size, size_t nmemb, char *
 
 CURLcode get_status_of_operation(CURL *curl, operation_task *task) {
 	CURLcode ret;
-	char *url = define_base_url(task);
+	char *base_url = define_base_url(task);
+	PQExpBufferData url;
 
-	strcat(url, "/");
-	strcat(url, task->operation_id);
-	curl_easy_setopt(curl, CURLOPT_URL, url);
+	initPQExpBuffer(&url);
+	appendPQExpBuffer(&url, "%s/%s", base_url, task->operation_id);
+	free(base_url);
+
+	//Reset the request method, in case the handle was used for a POST
+	curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+	curl_easy_setopt(curl, CURLOPT_URL, url.data);
 	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, receive_operation_status);
 	curl_easy_setopt(curl, CURLOPT_WRITEDATA, task->operation_status);
 
 	ret = curl_easy_perform(curl);
-	free(url);
+	termPQExpBuffer(&url);
 
 	return ret;
 }
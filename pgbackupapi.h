@@ -37,6 +37,9 @@ size_t receive_operations_cb(void *content, size_t size, size_t nmemb, char *buf
 size_t receive_operation_id(void *content, size_t size, size_t nmemb, char *buffer);
 size_t receive_operation_status(void *content, size_t size, size_t nmemb, char *buffer);
 
+//Creates the handle used for all requests to pg-backup-api
+CURL * init_pg_backupapi_handle(void);
+
 //Functions that implement the logic and know what to do and how to comunnicate wuth the API
 CURLcode get_operations_on_server(CURL *curl, operation_task *task);
 CURLcode create_new_task(CURL *curl, operation_task *task);
@@ -0,0 +1,18 @@
+-- complain if script is sourced in psql, rather than via CREATE EXTENSION
+\echo Use "CREATE EXTENSION repmgr" to load this file. \quit
+
+/* node connectivity functions */
+
+CREATE OR REPLACE FUNCTION set_node_connectivity(INT, BOOL, INT)
+  RETURNS VOID
+  AS 'MODULE_PATHNAME', 'repmgr_set_node_connectivity'
+  LANGUAGE C STRICT;
+
+CREATE OR REPLACE FUNCTION get_node_connectivity(
+    OUT node_id INT,
+    OUT reachable BOOL,
+    OUT rtt_us INT,
+    OUT last_checked TIMESTAMP WITH TIME ZONE)
+  RETURNS SETOF record
+  AS 'MODULE_PATHNAME', 'repmgr_get_node_connectivity'
+  LANGUAGE C STRICT;
@@ -41,6 +41,12 @@ typedef enum
 
 #define EVENT_HEADER_COUNT 6
 
+/*
+ * Allowance (in seconds) for establishing the SSH connection and starting
+ * the remote repmgr, added to the time the remote command itself may take.
+ */
+#define REMOTE_COMMAND_SSH_OVERHEAD 10
+
 typedef enum
 {
 	EV_NODE_ID = 0,
@@ -52,12 +58,55 @@ typedef enum
 }			EventHeader;
 
 
+/* state passed to the execute_commands_parallel() callbacks */
+typedef struct
+{
+	t_node_status_matrix *matrix;
+	int			local_node_id;
+	int			max_age;
+	bool	   *connectivity_found;
+	ItemList   *warnings;
+	int		   *error_code;
+}			t_matrix_task_context;
+
+typedef struct
+{
+	t_node_status_cube *cube;
+	int			timeout;
+	ItemList   *warnings;
+	int		   *error_code;
+}			t_cube_task_context;
+
+/* state passed to the "cluster show --watch" query callback */
+typedef struct
+{
+	int			node_count;
+	t_node_info **node_infos;
+	char	  **fingerprints;
+}			t_show_watch_context;
+
+
 struct ColHeader headers_show[SHOW_HEADER_COUNT];
 struct ColHeader headers_event[EVENT_HEADER_COUNT];
 
-static int	build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, int *error_code);
-static int	build_cluster_crosscheck(t_node_status_cube ***cube_dest, ItemList *warnings, int *error_code);
-static void cube_set_node_status(t_node_status_cube **cube, int n, int node_id, int matrix_node_id, int connection_node_id, int connection_status);
+static int	build_cluster_matrix(t_node_status_matrix *matrix, ItemList *warnings, int *error_code);
+static int	build_cluster_crosscheck(t_node_status_cube *cube, ItemList *warnings, int *error_code);
+static void node_index_init(t_node_index *index, NodeInfoList *nodes);
+static int	node_index_lookup(t_node_index *index, int node_id);
+static void node_index_free(t_node_index *index);
+static void matrix_set_node_status(t_node_status_matrix *matrix, int node_id, int connection_node_id, int connection_status);
+static void cube_set_node_status(t_node_status_cube *cube, int node_id, int matrix_node_id, int connection_node_id, int connection_status);
+static int	cube_get_node_status(t_node_status_cube *cube, int row, int column);
+static void matrix_process_task_output(t_command_task *task, void *arg);
+static void matrix_process_connectivity_result(t_node_info *node_info, PGresult *res, void *arg);
+static void cube_process_task_output(t_command_task *task, void *arg);
+static int	cluster_show_task_timeout(int node_count);
+static int	cluster_matrix_task_timeout(int node_count);
+static bool cluster_show_format_row(t_node_info *node_info, NodeInfoList *nodes, ItemList *warnings);
+static bool cluster_show_update_column_widths(t_node_info *node_info);
+static void cluster_show_print_row(t_node_info *node_info);
+static void cluster_show_watch(PGconn *conn, NodeInfoList *nodes);
+static void cluster_show_process_watch_result(t_node_info *node_info, PGresult *res, void *arg);
 
 /*
  * CLUSTER SHOW
@@ -67,6 +116,9 @@ static void cube_set_node_status(t_node_status_cube **cube, int n, int node_id,
  *   --csv
  *   --terse
  *   --verbose
+ *   --parallel
+ *   --timeout
+ *   --watch
  */
 void
 do_cluster_show(void)
@@ -166,12 +218,22 @@ do_cluster_show(void)
 	 * unreachable.
 	 */
 
+	/*
+	 * Connect to all nodes concurrently; an unreachable node will then only
+	 * delay the output by at most the --timeout value, rather than adding
+	 * its connection timeout to the total execution time.
+	 */
+	log_verbose(LOG_INFO, _("connecting to %i nodes (parallel: %i; timeout: %i seconds)"),
+				nodes.node_count,
+				runtime_options.parallel,
+				runtime_options.timeout);
+
+	(void) establish_db_connections_parallel(&nodes,
+											 runtime_options.parallel,
+											 runtime_options.timeout);
+
 	for (cell = nodes.head; cell; cell = cell->next)
 	{
-		PQExpBufferData node_status;
-		PQExpBufferData upstream;
-		PQExpBufferData buf;
-
 		cell->node_info->replication_info = palloc0(sizeof(ReplInfo));
 		if (cell->node_info->replication_info == NULL)
 		{
@@ -179,96 +241,25 @@ do_cluster_show(void)
 			exit(ERR_INTERNAL);
 		}
 
-		init_replication_info(cell->node_info->replication_info);
-
-		cell->node_info->conn = establish_db_connection_quiet(cell->node_info->conninfo);
-
 		if (PQstatus(cell->node_info->conn) != CONNECTION_OK)
-		{
 			connection_error_found = true;
 
-			if (runtime_options.verbose)
-			{
-				char		error[MAXLEN];
-
-				strncpy(error, PQerrorMessage(cell->node_info->conn), MAXLEN);
-				item_list_append_format(&warnings,
-										"when attempting to connect to node \"%s\" (ID: %i), following error encountered :\n\"%s\"",
-										cell->node_info->node_name, cell->node_info->node_id, trim(error));
-			}
-			else
-			{
-				item_list_append_format(&warnings,
-										"unable to connect to node \"%s\" (ID: %i)",
-										cell->node_info->node_name, cell->node_info->node_id);
-			}
-		}
-		else
-		{
-			/* NOP on pre-9.6 servers */
-			cell->node_info->replication_info->timeline_id = get_node_timeline(cell->node_info->conn,
-																			   cell->node_info->replication_info->timeline_id_str);
-		}
-
-		initPQExpBuffer(&node_status);
-		initPQExpBuffer(&upstream);
-
-		if (format_node_status(cell->node_info, &node_status, &upstream, &warnings) == true)
+		if (cluster_show_format_row(cell->node_info, &nodes, &warnings) == true)
 			error_found = true;
 
-		snprintf(cell->node_info->details, sizeof(cell->node_info->details),
-				 "%s", node_status.data);
-		snprintf(cell->node_info->upstream_node_name, sizeof(cell->node_info->upstream_node_name),
-				 "%s", upstream.data);
-
-		termPQExpBuffer(&node_status);
-		termPQExpBuffer(&upstream);
-
-		PQfinish(cell->node_info->conn);
-		cell->node_info->conn = NULL;
-
-		initPQExpBuffer(&buf);
-		appendPQExpBuffer(&buf, "%i", cell->node_info->node_id);
-		headers_show[SHOW_ID].cur_length = strlen(buf.data);
-		termPQExpBuffer(&buf);
-
-		headers_show[SHOW_ROLE].cur_length = strlen(get_node_type_string(cell->node_info->type));
-		headers_show[SHOW_NAME].cur_length = strlen(cell->node_info->node_name);
-		headers_show[SHOW_STATUS].cur_length = strlen(cell->node_info->details);
-
-		headers_show[SHOW_UPSTREAM_NAME].cur_length = strlen(cell->node_info->upstream_node_name);
-
-		initPQExpBuffer(&buf);
-		appendPQExpBuffer(&buf, "%i", cell->node_info->priority);
-		headers_show[SHOW_PRIORITY].cur_length = strlen(buf.data);
-		termPQExpBuffer(&buf);
-
-		headers_show[SHOW_LOCATION].cur_length = strlen(cell->node_info->location);
-
-		/* Format timeline ID */
-		if (cell->node_info->type == WITNESS)
-		{
-			/* The witness node's timeline ID is irrelevant */
-			strncpy(cell->node_info->replication_info->timeline_id_str, _("n/a"), MAXLEN);
-		}
-		headers_show[SHOW_TIMELINE_ID].cur_length = strlen(cell->node_info->replication_info->timeline_id_str);
-
-		headers_show[SHOW_CONNINFO].cur_length = strlen(cell->node_info->conninfo);
+		(void) cluster_show_update_column_widths(cell->node_info);
+	}
 
-		for (i = 0; i < SHOW_HEADER_COUNT; i++)
+	/*
+	 * Node connections are no longer required, unless we're going to
+	 * periodically refresh the output.
+	 */
+	if (runtime_options.watch == 0)
+	{
+		for (cell = nodes.head; cell; cell = cell->next)
 		{
-			if (runtime_options.compact == true)
-			{
-				if (headers_show[i].display == false)
-					continue;
-			}
-
-			if (headers_show[i].cur_length > headers_show[i].max_length)
-			{
-				headers_show[i].max_length = headers_show[i].cur_length;
-			}
+			close_connection(&cell->node_info->conn);
 		}
-
 	}
 
 	/* Print column header row (text mode only) */
@@ -308,28 +299,17 @@ do_cluster_show(void)
 		}
 		else
 		{
-			printf(" %-*i ", headers_show[SHOW_ID].max_length, cell->node_info->node_id);
-			printf("| %-*s ", headers_show[SHOW_NAME].max_length, cell->node_info->node_name);
-			printf("| %-*s ", headers_show[SHOW_ROLE].max_length, get_node_type_string(cell->node_info->type));
-			printf("| %-*s ", headers_show[SHOW_STATUS].max_length, cell->node_info->details);
-			printf("| %-*s ", headers_show[SHOW_UPSTREAM_NAME].max_length, cell->node_info->upstream_node_name);
-			printf("| %-*s ", headers_show[SHOW_LOCATION].max_length, cell->node_info->location);
-			printf("| %-*i ", headers_show[SHOW_PRIORITY].max_length, cell->node_info->priority);
-
-			if (headers_show[SHOW_TIMELINE_ID].display == true)
-			{
-				printf("| %-*s ", headers_show[SHOW_TIMELINE_ID].max_length, cell->node_info->replication_info->timeline_id_str);
-			}
-
-			if (headers_show[SHOW_CONNINFO].display == true)
-			{
-				printf("| %-*s", headers_show[SHOW_CONNINFO].max_length, cell->node_info->conninfo);
-			}
-
+			cluster_show_print_row(cell->node_info);
 			puts("");
 		}
 	}
 
+	/* does not return */
+	if (runtime_options.watch > 0)
+	{
+		cluster_show_watch(conn, &nodes);
+	}
+
 	clear_node_info_list(&nodes);
 	PQfinish(conn);
 
@@ -378,212 +358,647 @@ do_cluster_show(void)
 
 
 /*
- * CLUSTER EVENT
+ * cluster_show_format_row()
  *
- * Parameters:
- *   --limit[=20]
- *   --all
- *   --node-[id|name]
- *   --event
- *   --csv
- *   --compact
+ * Populate the status, upstream and timeline fields displayed by
+ * "cluster show" for the provided node; node_info->conn should contain
+ * a connection to the node, if one could be established.
+ *
+ * Returns true if the node's status is not as expected.
  */
-
-void
-do_cluster_event(void)
+static bool
+cluster_show_format_row(t_node_info *node_info, NodeInfoList *nodes, ItemList *warnings)
 {
-	PGconn	   *conn = NULL;
-	PGresult   *res;
-	int			i = 0;
-	int			column_count = EVENT_HEADER_COUNT;
-
-	conn = establish_db_connection(config_file_options.conninfo, true);
+	PQExpBufferData node_status;
+	PQExpBufferData upstream;
+	bool		error_found = false;
 
-	res = get_event_records(conn,
-							runtime_options.node_id,
-							runtime_options.node_name,
-							runtime_options.event,
-							runtime_options.all,
-							runtime_options.limit);
+	init_replication_info(node_info->replication_info);
 
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	if (PQstatus(node_info->conn) != CONNECTION_OK)
 	{
-		log_error(_("unable to execute event query:\n  %s"),
-				  PQerrorMessage(conn));
-		PQclear(res);
-		PQfinish(conn);
-		exit(ERR_DB_QUERY);
-	}
+		if (runtime_options.verbose)
+		{
+			char		error[MAXLEN];
 
-	if (PQntuples(res) == 0)
+			if (node_info->conn == NULL)
+				maxlen_snprintf(error, _("connection attempt timed out after %i seconds"), runtime_options.timeout);
+			else
+				strncpy(error, PQerrorMessage(node_info->conn), MAXLEN);
+
+			item_list_append_format(warnings,
+									"when attempting to connect to node \"%s\" (ID: %i), following error encountered :\n\"%s\"",
+									node_info->node_name, node_info->node_id, trim(error));
+		}
+		else
+		{
+			item_list_append_format(warnings,
+									"unable to connect to node \"%s\" (ID: %i)",
+									node_info->node_name, node_info->node_id);
+		}
+	}
+	else
 	{
-		/* print this message directly, rather than as a log line */
-		printf(_("no matching events found\n"));
-		PQclear(res);
-		PQfinish(conn);
-		return;
+		/* NOP on pre-9.6 servers */
+		node_info->replication_info->timeline_id = get_node_timeline(node_info->conn,
+																	 node_info->replication_info->timeline_id_str);
 	}
 
-	strncpy(headers_event[EV_NODE_ID].title, _("Node ID"), MAXLEN);
-	strncpy(headers_event[EV_NODE_NAME].title, _("Name"), MAXLEN);
-	strncpy(headers_event[EV_EVENT].title, _("Event"), MAXLEN);
-	strncpy(headers_event[EV_SUCCESS].title, _("OK"), MAXLEN);
-	strncpy(headers_event[EV_TIMESTAMP].title, _("Timestamp"), MAXLEN);
-	strncpy(headers_event[EV_DETAILS].title, _("Details"), MAXLEN);
+	initPQExpBuffer(&node_status);
+	initPQExpBuffer(&upstream);
 
 	/*
-	 * If --compact or --csv provided, simply omit the "Details" column.
-	 * In --csv mode we'd need to quote/escape the contents "Details" column,
-	 * which is doable but which will remain a TODO for now.
+	 * Pass the node list so format_node_status() can reuse the
+	 * connections we already have when checking each node's upstream.
 	 */
-	if (runtime_options.compact == true || runtime_options.output_mode == OM_CSV)
-		column_count --;
+	if (format_node_status(node_info, &node_status, &upstream, warnings, nodes) == true)
+		error_found = true;
 
-	for (i = 0; i < column_count; i++)
+	snprintf(node_info->details, sizeof(node_info->details),
+			 "%s", node_status.data);
+	snprintf(node_info->upstream_node_name, sizeof(node_info->upstream_node_name),
+			 "%s", upstream.data);
+
+	termPQExpBuffer(&node_status);
+	termPQExpBuffer(&upstream);
+
+	/* Format timeline ID */
+	if (node_info->type == WITNESS)
 	{
-		headers_event[i].max_length = strlen(headers_event[i].title);
+		/* The witness node's timeline ID is irrelevant */
+		strncpy(node_info->replication_info->timeline_id_str, _("n/a"), MAXLEN);
 	}
 
-	for (i = 0; i < PQntuples(res); i++)
-	{
-		int			j;
+	return error_found;
+}
 
-		for (j = 0; j < column_count; j++)
-		{
-			headers_event[j].cur_length = strlen(PQgetvalue(res, i, j));
-			if (headers_event[j].cur_length > headers_event[j].max_length)
-			{
-				headers_event[j].max_length = headers_event[j].cur_length;
-			}
-		}
 
-	}
+/*
+ * cluster_show_update_column_widths()
+ *
+ * Widen the "cluster show" columns as required to accommodate the
+ * provided node's values.
+ *
+ * Returns true if any column width was changed.
+ */
+static bool
+cluster_show_update_column_widths(t_node_info *node_info)
+{
+	PQExpBufferData buf;
+	bool		width_changed = false;
+	int			i;
 
-	if (runtime_options.output_mode == OM_TEXT)
-	{
-		for (i = 0; i < column_count; i++)
-		{
-			if (i == 0)
-				printf(" ");
-			else
-				printf(" | ");
+	initPQExpBuffer(&buf);
+	appendPQExpBuffer(&buf, "%i", node_info->node_id);
+	headers_show[SHOW_ID].cur_length = strlen(buf.data);
+	termPQExpBuffer(&buf);
 
-			printf("%-*s",
-				   headers_event[i].max_length,
-				   headers_event[i].title);
-		}
-		printf("\n");
-		printf("-");
-		for (i = 0; i < column_count; i++)
-		{
-			int			j;
+	headers_show[SHOW_ROLE].cur_length = strlen(get_node_type_string(node_info->type));
+	headers_show[SHOW_NAME].cur_length = strlen(node_info->node_name);
+	headers_show[SHOW_STATUS].cur_length = strlen(node_info->details);
 
-			for (j = 0; j < headers_event[i].max_length; j++)
-				printf("-");
+	headers_show[SHOW_UPSTREAM_NAME].cur_length = strlen(node_info->upstream_node_name);
 
-			if (i < (column_count - 1))
-				printf("-+-");
-			else
-				printf("-");
-		}
+	initPQExpBuffer(&buf);
+	appendPQExpBuffer(&buf, "%i", node_info->priority);
+	headers_show[SHOW_PRIORITY].cur_length = strlen(buf.data);
+	termPQExpBuffer(&buf);
 
-		printf("\n");
-	}
+	headers_show[SHOW_LOCATION].cur_length = strlen(node_info->location);
 
-	for (i = 0; i < PQntuples(res); i++)
-	{
-		int			j;
+	headers_show[SHOW_TIMELINE_ID].cur_length = strlen(node_info->replication_info->timeline_id_str);
 
-		if (runtime_options.output_mode == OM_CSV)
+	headers_show[SHOW_CONNINFO].cur_length = strlen(node_info->conninfo);
+
+	for (i = 0; i < SHOW_HEADER_COUNT; i++)
+	{
+		if (runtime_options.compact == true)
 		{
-			for (j = 0; j < column_count; j++)
-			{
-				printf("%s", PQgetvalue(res, i, j));
-				if ((j + 1) < column_count)
-				{
-					printf(",");
-				}
-			}
+			if (headers_show[i].display == false)
+				continue;
 		}
-		else
-		{
-			printf(" ");
-			for (j = 0; j < column_count; j++)
-			{
-				printf("%-*s",
-					   headers_event[j].max_length,
-					   PQgetvalue(res, i, j));
 
-				if (j < (column_count - 1))
-					printf(" | ");
-			}
+		if (headers_show[i].cur_length > headers_show[i].max_length)
+		{
+			headers_show[i].max_length = headers_show[i].cur_length;
+			width_changed = true;
 		}
-
-		printf("\n");
 	}
 
-	PQclear(res);
+	return width_changed;
+}
 
-	PQfinish(conn);
 
-	if (runtime_options.output_mode == OM_TEXT)
-		puts("");
+/*
+ * cluster_show_print_row()
+ *
+ * Print the provided node's "cluster show" row in text format,
+ * without a trailing newline.
+ */
+static void
+cluster_show_print_row(t_node_info *node_info)
+{
+	printf(" %-*i ", headers_show[SHOW_ID].max_length, node_info->node_id);
+	printf("| %-*s ", headers_show[SHOW_NAME].max_length, node_info->node_name);
+	printf("| %-*s ", headers_show[SHOW_ROLE].max_length, get_node_type_string(node_info->type));
+	printf("| %-*s ", headers_show[SHOW_STATUS].max_length, node_info->details);
+	printf("| %-*s ", headers_show[SHOW_UPSTREAM_NAME].max_length, node_info->upstream_node_name);
+	printf("| %-*s ", headers_show[SHOW_LOCATION].max_length, node_info->location);
+	printf("| %-*i ", headers_show[SHOW_PRIORITY].max_length, node_info->priority);
+
+	if (headers_show[SHOW_TIMELINE_ID].display == true)
+	{
+		printf("| %-*s ", headers_show[SHOW_TIMELINE_ID].max_length, node_info->replication_info->timeline_id_str);
+	}
+
+	if (headers_show[SHOW_CONNINFO].display == true)
+	{
+		printf("| %-*s", headers_show[SHOW_CONNINFO].max_length, node_info->conninfo);
+	}
 }
 
 
-void
-do_cluster_crosscheck(void)
+/*
+ * cluster_show_watch()
+ *
+ * Refresh the "cluster show" output every --watch seconds until interrupted.
+ *
+ * The node connections opened for the initial display are kept open, and on
+ * each iteration a single query returning the state which affects a node's
+ * row (recovery status, timeline, the node's view of the repmgr metadata and
+ * its attached downstream nodes) is sent to all nodes concurrently. Rows are
+ * only regenerated for nodes where this state has changed, or whose upstream's
+ * state has changed; when writing to a terminal, only those rows are redrawn.
+ *
+ * Nodes which are unreachable are reconnected to on each iteration.
+ *
+ * Nodes registered after the initial display are not shown.
+ */
+static void
+cluster_show_watch(PGconn *conn, NodeInfoList *nodes)
 {
-	int			i = 0,
-				n = 0;
+	t_show_watch_context context;
+	NodeInfoListCell *cell = NULL;
+	PQExpBufferData query;
+	char	  **previous_fingerprints = NULL;
+	bool	   *refresh = NULL;
+	bool		is_tty = isatty(fileno(stdout)) ? true : false;
+	int			i = 0;
 
-	t_node_status_cube **cube;
+	context.node_count = nodes->node_count;
+	context.node_infos = pg_malloc0(sizeof(t_node_info *) * nodes->node_count);
+	context.fingerprints = pg_malloc0(sizeof(char *) * nodes->node_count);
 
-	bool		connection_error_found = false;
-	int			error_code = SUCCESS;
-	ItemList	warnings = {NULL, NULL};
+	previous_fingerprints = pg_malloc0(sizeof(char *) * nodes->node_count);
+	refresh = pg_malloc0(sizeof(bool) * nodes->node_count);
 
-	n = build_cluster_crosscheck(&cube, &warnings, &error_code);
+	for (cell = nodes->head; cell; cell = cell->next)
+		context.node_infos[i++] = cell->node_info;
 
-	if (runtime_options.output_mode == OM_CSV)
-	{
-		for (i = 0; i < n; i++)
-		{
-			int j;
-			for (j = 0; j < n; j++)
-			{
-				int			max_node_status = -2;
-				int			node_ix = 0;
+	initPQExpBuffer(&query);
 
-				for (node_ix = 0; node_ix < n; node_ix++)
-				{
-					int			node_status = cube[node_ix]->matrix_list_rec[i]->node_status_list[j]->node_status;
+	appendPQExpBufferStr(&query,
+						 "SELECT pg_catalog.pg_is_in_recovery()::TEXT ");
 
-					if (node_status > max_node_status)
-						max_node_status = node_status;
-				}
-				printf("%i,%i,%i\n",
-					   cube[i]->node_id,
-					   cube[j]->node_id,
-					   max_node_status);
+	/* the timeline column is only displayed for 9.6 and later */
+	if (headers_show[SHOW_TIMELINE_ID].display == true)
+		appendPQExpBufferStr(&query,
+							 "    || ':' || (SELECT timeline_id FROM pg_catalog.pg_control_checkpoint())::TEXT ");
 
-				if (max_node_status == -1)
-				{
-					connection_error_found = true;
-				}
-			}
+	appendPQExpBufferStr(&query,
+						 "    || ':' || COALESCE((SELECT pg_catalog.string_agg( "
+						 "       node_id || ':' || type || ':' || active::TEXT || ':' || COALESCE(upstream_node_id::TEXT, ''), "
+						 "       ',' ORDER BY node_id) "
+						 "       FROM repmgr.nodes), '') "
+						 "    || ':' || COALESCE((SELECT pg_catalog.string_agg( "
+						 "       application_name || ':' || COALESCE(state, ''), "
+						 "       ',' ORDER BY application_name) "
+						 "       FROM pg_catalog.pg_stat_replication), '') ");
 
-		}
-	}
-	else
-	{
-		/* output header contains node name, node ID and one column for each node in the cluster */
-		struct ColHeader *headers_crosscheck = NULL;
+	log_debug("cluster_show_watch():\n%s", query.data);
 
-		int header_count = n + 2;
-		int header_id = 2;
+	/* establish the state corresponding to the initial display */
+	(void) execute_query_parallel(nodes, query.data, runtime_options.timeout,
+								  cluster_show_process_watch_result, &context);
 
-		headers_crosscheck = palloc0(sizeof(ColHeader) * header_count);
+	for (;;)
+	{
+		NodeInfoList unreachable_nodes = T_NODE_INFO_LIST_INITIALIZER;
+		ItemList	warnings = {NULL, NULL};
+		bool		refresh_found = false;
+		bool		redraw_all = false;
+
+		fflush(stdout);
+		sleep(runtime_options.watch);
+
+		/* attempt to reconnect to any nodes which were unreachable */
+		for (i = 0; i < context.node_count; i++)
+		{
+			t_node_info *node_info = context.node_infos[i];
+
+			if (PQstatus(node_info->conn) == CONNECTION_OK)
+				continue;
+
+			close_connection(&node_info->conn);
+			node_info->node_status = NODE_STATUS_UNKNOWN;
+
+			cell = (NodeInfoListCell *) pg_malloc0(sizeof(NodeInfoListCell));
+			cell->node_info = node_info;
+
+			if (unreachable_nodes.tail)
+				unreachable_nodes.tail->next = cell;
+			else
+				unreachable_nodes.head = cell;
+
+			unreachable_nodes.tail = cell;
+			unreachable_nodes.node_count++;
+		}
+
+		if (unreachable_nodes.node_count > 0)
+		{
+			NodeInfoListCell *next_cell = NULL;
+
+			(void) establish_db_connections_parallel(&unreachable_nodes,
+													 runtime_options.parallel,
+													 runtime_options.timeout);
+
+			/* the node records themselves belong to the main list */
+			for (cell = unreachable_nodes.head; cell; cell = next_cell)
+			{
+				next_cell = cell->next;
+				pfree(cell);
+			}
+		}
+
+		for (i = 0; i < context.node_count; i++)
+		{
+			previous_fingerprints[i] = context.fingerprints[i];
+			context.fingerprints[i] = NULL;
+		}
+
+		(void) execute_query_parallel(nodes, query.data, runtime_options.timeout,
+									  cluster_show_process_watch_result, &context);
+
+		/* determine which nodes' state has changed */
+		for (i = 0; i < context.node_count; i++)
+		{
+			refresh[i] = false;
+
+			if (previous_fingerprints[i] == NULL && context.fingerprints[i] == NULL)
+				continue;
+
+			if (previous_fingerprints[i] != NULL && context.fingerprints[i] != NULL &&
+				strcmp(previous_fingerprints[i], context.fingerprints[i]) == 0)
+				continue;
+
+			refresh[i] = true;
+
+			/*
+			 * Reachability has changed, which may have caused messages to be
+			 * logged to the terminal.
+			 */
+			if (previous_fingerprints[i] == NULL || context.fingerprints[i] == NULL)
+				redraw_all = true;
+		}
+
+		/* a change in a node's state may affect the status of its downstream nodes */
+		for (i = 0; i < context.node_count; i++)
+		{
+			int			j;
+
+			if (refresh[i] == true || context.node_infos[i]->upstream_node_id == NO_UPSTREAM_NODE)
+				continue;
+
+			for (j = 0; j < context.node_count; j++)
+			{
+				if (context.node_infos[j]->node_id != context.node_infos[i]->upstream_node_id)
+					continue;
+
+				refresh[i] = refresh[j];
+				break;
+			}
+		}
+
+		for (i = 0; i < context.node_count; i++)
+		{
+			if (previous_fingerprints[i] != NULL)
+				pfree(previous_fingerprints[i]);
+
+			previous_fingerprints[i] = NULL;
+		}
+
+		for (i = 0; i < context.node_count; i++)
+		{
+			t_node_info *node_info = context.node_infos[i];
+
+			if (refresh[i] == false)
+				continue;
+
+			refresh_found = true;
+
+			/* the node's metadata, e.g. its role, may have changed */
+			if (PQstatus(conn) == CONNECTION_OK)
+			{
+				t_node_info node_record = T_NODE_INFO_INITIALIZER;
+
+				if (get_node_record(conn, node_info->node_id, &node_record) == RECORD_FOUND)
+				{
+					node_info->type = node_record.type;
+					node_info->upstream_node_id = node_record.upstream_node_id;
+					node_info->active = node_record.active;
+					node_info->priority = node_record.priority;
+					strncpy(node_info->location, node_record.location, sizeof(node_info->location));
+				}
+			}
+
+			(void) cluster_show_format_row(node_info, nodes, &warnings);
+
+			if (cluster_show_update_column_widths(node_info) == true)
+				redraw_all = true;
+		}
+
+		item_list_free(&warnings);
+
+		if (refresh_found == false)
+			continue;
+
+		if (is_tty == false)
+		{
+			/* not a terminal - append the updated status in full */
+			puts("");
+			print_status_header(SHOW_HEADER_COUNT, headers_show);
+
+			for (cell = nodes->head; cell; cell = cell->next)
+			{
+				cluster_show_print_row(cell->node_info);
+				puts("");
+			}
+		}
+		else if (redraw_all == true)
+		{
+			/* clear the screen and redraw from the top */
+			printf("\033[H\033[2J");
+			print_status_header(SHOW_HEADER_COUNT, headers_show);
+
+			for (cell = nodes->head; cell; cell = cell->next)
+			{
+				cluster_show_print_row(cell->node_info);
+				puts("");
+			}
+		}
+		else
+		{
+			/*
+			 * Redraw only the changed rows; the cursor is positioned on the
+			 * line following the last row.
+			 */
+			for (i = 0; i < context.node_count; i++)
+			{
+				int			lines = context.node_count - i;
+
+				if (refresh[i] == false)
+					continue;
+
+				printf("\033[%iA\r", lines);
+				cluster_show_print_row(context.node_infos[i]);
+				printf("\033[K\033[%iB\r", lines);
+			}
+		}
+	}
+}
+
+
+/*
+ * Callback for execute_query_parallel(): record the result of the
+ * "cluster show --watch" state query for the node; if the query
+ * failed, the connection is closed so it can be reestablished on
+ * the next iteration.
+ */
+static void
+cluster_show_process_watch_result(t_node_info *node_info, PGresult *res, void *arg)
+{
+	t_show_watch_context *context = (t_show_watch_context *) arg;
+	int			i;
+
+	for (i = 0; i < context->node_count; i++)
+	{
+		if (context->node_infos[i] == node_info)
+			break;
+	}
+
+	if (i == context->node_count)
+		return;
+
+	if (res == NULL || PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
+	{
+		close_connection(&node_info->conn);
+		node_info->node_status = NODE_STATUS_UNKNOWN;
+		return;
+	}
+
+	context->fingerprints[i] = pg_strdup(PQgetvalue(res, 0, 0));
+}
+
+
+/*
+ * CLUSTER EVENT
+ *
+ * Parameters:
+ *   --limit[=20]
+ *   --all
+ *   --node-[id|name]
+ *   --event
+ *   --csv
+ *   --compact
+ */
+
+void
+do_cluster_event(void)
+{
+	PGconn	   *conn = NULL;
+	PGresult   *res;
+	int			i = 0;
+	int			column_count = EVENT_HEADER_COUNT;
+
+	conn = establish_db_connection(config_file_options.conninfo, true);
+
+	res = get_event_records(conn,
+							runtime_options.node_id,
+							runtime_options.node_name,
+							runtime_options.event,
+							runtime_options.all,
+							runtime_options.limit);
+
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
+	{
+		log_error(_("unable to execute event query:\n  %s"),
+				  PQerrorMessage(conn));
+		PQclear(res);
+		PQfinish(conn);
+		exit(ERR_DB_QUERY);
+	}
+
+	if (PQntuples(res) == 0)
+	{
+		/* print this message directly, rather than as a log line */
+		printf(_("no matching events found\n"));
+		PQclear(res);
+		PQfinish(conn);
+		return;
+	}
+
+	strncpy(headers_event[EV_NODE_ID].title, _("Node ID"), MAXLEN);
+	strncpy(headers_event[EV_NODE_NAME].title, _("Name"), MAXLEN);
+	strncpy(headers_event[EV_EVENT].title, _("Event"), MAXLEN);
+	strncpy(headers_event[EV_SUCCESS].title, _("OK"), MAXLEN);
+	strncpy(headers_event[EV_TIMESTAMP].title, _("Timestamp"), MAXLEN);
+	strncpy(headers_event[EV_DETAILS].title, _("Details"), MAXLEN);
+
+	/*
+	 * If --compact or --csv provided, simply omit the "Details" column.
+	 * In --csv mode we'd need to quote/escape the contents "Details" column,
+	 * which is doable but which will remain a TODO for now.
+	 */
+	if (runtime_options.compact == true || runtime_options.output_mode == OM_CSV)
+		column_count --;
+
+	for (i = 0; i < column_count; i++)
+	{
+		headers_event[i].max_length = strlen(headers_event[i].title);
+	}
+
+	for (i = 0; i < PQntuples(res); i++)
+	{
+		int			j;
+
+		for (j = 0; j < column_count; j++)
+		{
+			headers_event[j].cur_length = strlen(PQgetvalue(res, i, j));
+			if (headers_event[j].cur_length > headers_event[j].max_length)
+			{
+				headers_event[j].max_length = headers_event[j].cur_length;
+			}
+		}
+
+	}
+
+	if (runtime_options.output_mode == OM_TEXT)
+	{
+		for (i = 0; i < column_count; i++)
+		{
+			if (i == 0)
+				printf(" ");
+			else
+				printf(" | ");
+
+			printf("%-*s",
+				   headers_event[i].max_length,
+				   headers_event[i].title);
+		}
+		printf("\n");
+		printf("-");
+		for (i = 0; i < column_count; i++)
+		{
+			int			j;
+
+			for (j = 0; j < headers_event[i].max_length; j++)
+				printf("-");
+
+			if (i < (column_count - 1))
+				printf("-+-");
+			else
+				printf("-");
+		}
+
+		printf("\n");
+	}
+
+	for (i = 0; i < PQntuples(res); i++)
+	{
+		int			j;
+
+		if (runtime_options.output_mode == OM_CSV)
+		{
+			for (j = 0; j < column_count; j++)
+			{
+				printf("%s", PQgetvalue(res, i, j));
+				if ((j + 1) < column_count)
+				{
+					printf(",");
+				}
+			}
+		}
+		else
+		{
+			printf(" ");
+			for (j = 0; j < column_count; j++)
+			{
+				printf("%-*s",
+					   headers_event[j].max_length,
+					   PQgetvalue(res, i, j));
+
+				if (j < (column_count - 1))
+					printf(" | ");
+			}
+		}
+
+		printf("\n");
+	}
+
+	PQclear(res);
+
+	PQfinish(conn);
+
+	if (runtime_options.output_mode == OM_TEXT)
+		puts("");
+}
+
+
+void
+do_cluster_crosscheck(void)
+{
+	int			i = 0,
+				n = 0;
+
+	t_node_status_cube cube;
+
+	bool		connection_error_found = false;
+	int			error_code = SUCCESS;
+	ItemList	warnings = {NULL, NULL};
+
+	n = build_cluster_crosscheck(&cube, &warnings, &error_code);
+
+	if (runtime_options.output_mode == OM_CSV)
+	{
+		for (i = 0; i < n; i++)
+		{
+			int j;
+			for (j = 0; j < n; j++)
+			{
+				int			max_node_status = cube_get_node_status(&cube, i, j);
+
+				printf("%i,%i,%i\n",
+					   cube.index.nodes[i].node_id,
+					   cube.index.nodes[j].node_id,
+					   max_node_status);
+
+				if (max_node_status == -1)
+				{
+					connection_error_found = true;
+				}
+			}
+
+		}
+	}
+	else
+	{
+		/* output header contains node name, node ID and one column for each node in the cluster */
+		struct ColHeader *headers_crosscheck = NULL;
+
+		int header_count = n + 2;
+		int header_id = 2;
+
+		headers_crosscheck = palloc0(sizeof(ColHeader) * header_count);
 
 		/* Initialize column headers  */
 		strncpy(headers_crosscheck[0].title, _("Name"), MAXLEN);
@@ -591,7 +1006,7 @@ do_cluster_crosscheck(void)
 
 		for (i = 0; i < n; i++)
 		{
-			maxlen_snprintf(headers_crosscheck[header_id].title, "%i", cube[i]->node_id);
+			maxlen_snprintf(headers_crosscheck[header_id].title, "%i", cube.index.nodes[i].node_id);
 			header_id++;
 		}
 
@@ -611,9 +1026,9 @@ do_cluster_crosscheck(void)
 
 		for (i = 0; i < n; i++)
 		{
-			if (strlen(cube[i]->node_name) > headers_crosscheck[0].max_length)
+			if (strlen(cube.index.nodes[i].node_name) > headers_crosscheck[0].max_length)
 			{
-				headers_crosscheck[0].max_length = strlen(cube[i]->node_name);
+				headers_crosscheck[0].max_length = strlen(cube.index.nodes[i].node_name);
 			}
 		}
 
@@ -625,39 +1040,15 @@ do_cluster_crosscheck(void)
 
 			printf(" %-*s | %-*i ",
 				   headers_crosscheck[0].max_length,
-				   cube[i]->node_name,
+				   cube.index.nodes[i].node_name,
 				   headers_crosscheck[1].max_length,
-				   cube[i]->node_id);
+				   cube.index.nodes[i].node_id);
 
 			for (column_node_ix = 0; column_node_ix < n; column_node_ix++)
 			{
-				int			max_node_status = -2;
-				int			node_ix = 0;
-
+				int			max_node_status = cube_get_node_status(&cube, i, column_node_ix);
 				char		c;
 
-				/*
-				 * The value of entry (i,j) is equal to the maximum value of all
-				 * the (i,j,k). Indeed:
-				 *
-				 * - if one of the (i,j,k) is 0 (node up), then 0 (the node is
-				 * up);
-				 *
-				 * - if the (i,j,k) are either -1 (down) or -2 (unknown), then -1
-				 * (the node is down);
-				 *
-				 * - if all the (i,j,k) are -2 (unknown), then -2 (the node is in
-				 * an unknown state).
-				 */
-
-				for (node_ix = 0; node_ix < n; node_ix++)
-				{
-					int			node_status = cube[node_ix]->matrix_list_rec[i]->node_status_list[column_node_ix]->node_status;
-
-					if (node_status > max_node_status)
-						max_node_status = node_status;
-				}
-
 				switch (max_node_status)
 				{
 					case -2:
@@ -692,28 +1083,8 @@ do_cluster_crosscheck(void)
 	}
 
 	/* clean up allocated cube array */
-	{
-		int			h,
-					j;
-
-		for (h = 0; h < n; h++)
-		{
-			for (i = 0; i < n; i++)
-			{
-				for (j = 0; j < n; j++)
-				{
-					free(cube[h]->matrix_list_rec[i]->node_status_list[j]);
-				}
-				free(cube[h]->matrix_list_rec[i]->node_status_list);
-				free(cube[h]->matrix_list_rec[i]);
-			}
-
-			free(cube[h]->matrix_list_rec);
-			free(cube[h]);
-		}
-
-		free(cube);
-	}
+	pfree(cube.status);
+	node_index_free(&cube.index);
 
 	/* errors detected by build_cluster_crosscheck() have priority */
 	if (connection_error_found == true)
@@ -731,6 +1102,8 @@ do_cluster_crosscheck(void)
  *
  * Parameters:
  *   --csv
+ *   --parallel
+ *   --timeout
  */
 void
 do_cluster_matrix()
@@ -739,13 +1112,13 @@ do_cluster_matrix()
 				j = 0,
 				n = 0;
 
-	t_node_matrix_rec **matrix_rec_list;
+	t_node_status_matrix matrix;
 
 	bool		connection_error_found = false;
 	int			error_code = SUCCESS;
 	ItemList	warnings = {NULL, NULL};
 
-	n = build_cluster_matrix(&matrix_rec_list, &warnings, &error_code);
+	n = build_cluster_matrix(&matrix, &warnings, &error_code);
 
 	if (runtime_options.output_mode == OM_CSV)
 	{
@@ -753,13 +1126,14 @@ do_cluster_matrix()
 		{
 			for (j = 0; j < n; j++)
 			{
+				int			node_status = matrix.status[i * n + j];
+
 				printf("%d,%d,%d\n",
-					   matrix_rec_list[i]->node_id,
-					   matrix_rec_list[i]->node_status_list[j]->node_id,
-					   matrix_rec_list[i]->node_status_list[j]->node_status);
+					   matrix.index.nodes[i].node_id,
+					   matrix.index.nodes[j].node_id,
+					   node_status);
 
-				if (matrix_rec_list[i]->node_status_list[j]->node_status == -2
-					|| matrix_rec_list[i]->node_status_list[j]->node_status == -1)
+				if (node_status == -2 || node_status == -1)
 				{
 					connection_error_found = true;
 				}
@@ -782,7 +1156,7 @@ do_cluster_matrix()
 
 		for (i = 0; i < n; i++)
 		{
-			maxlen_snprintf(headers_matrix[header_id].title, "%i", matrix_rec_list[i]->node_id);
+			maxlen_snprintf(headers_matrix[header_id].title, "%i", matrix.index.nodes[i].node_id);
 			header_id++;
 		}
 
@@ -803,9 +1177,9 @@ do_cluster_matrix()
 
 		for (i = 0; i < n; i++)
 		{
-			if (strlen(matrix_rec_list[i]->node_name) > headers_matrix[0].max_length)
+			if (strlen(matrix.index.nodes[i].node_name) > headers_matrix[0].max_length)
 			{
-				headers_matrix[0].max_length = strlen(matrix_rec_list[i]->node_name);
+				headers_matrix[0].max_length = strlen(matrix.index.nodes[i].node_name);
 			}
 		}
 
@@ -815,14 +1189,14 @@ do_cluster_matrix()
 		{
 			printf(" %-*s | %-*i ",
 				   headers_matrix[0].max_length,
-				   matrix_rec_list[i]->node_name,
+				   matrix.index.nodes[i].node_name,
 				   headers_matrix[1].max_length,
-				   matrix_rec_list[i]->node_id);
+				   matrix.index.nodes[i].node_id);
 			for (j = 0; j < n; j++)
 			{
 				char		c;
 
-				switch (matrix_rec_list[i]->node_status_list[j]->node_status)
+				switch (matrix.status[i * n + j])
 				{
 					case -2:
 						c = '?';
@@ -835,86 +1209,256 @@ do_cluster_matrix()
 						c = '*';
 						break;
 					default:
-						log_error("unexpected node status value %i", matrix_rec_list[i]->node_status_list[j]->node_status);
+						log_error("unexpected node status value %i", matrix.status[i * n + j]);
 						exit(ERR_INTERNAL);
 				}
 
-				printf("| %-*c ", headers_matrix[j + 2].max_length, c);
-			}
-			printf("\n");
-		}
+				printf("| %-*c ", headers_matrix[j + 2].max_length, c);
+			}
+			printf("\n");
+		}
+
+		pfree(headers_matrix);
+
+		if (warnings.head != NULL && runtime_options.terse == false)
+		{
+			log_warning(_("following problems detected:"));
+			print_item_list(&warnings);
+		}
+
+	}
+
+	pfree(matrix.status);
+	node_index_free(&matrix.index);
+
+	/* actual database connection errors have priority */
+	if (connection_error_found == true)
+	{
+		error_code = ERR_NODE_STATUS;
+	}
+
+	exit(error_code);
+}
+
+
+/*
+ * node_index_init()
+ *
+ * Assign each node in the list a dense index (its position in the list),
+ * and build a hash table to look up the index by node ID.
+ */
+static void
+node_index_init(t_node_index *index, NodeInfoList *nodes)
+{
+	NodeInfoListCell *cell = NULL;
+	int			i = 0;
+
+	index->node_count = nodes->node_count;
+	index->nodes = (t_matrix_node *) pg_malloc0(sizeof(t_matrix_node) * nodes->node_count);
+
+	/* keep the load factor at or below 0.5 */
+	index->slot_count = 2;
+	while (index->slot_count < nodes->node_count * 2)
+		index->slot_count <<= 1;
+
+	index->slots = (int *) pg_malloc0(sizeof(int) * index->slot_count);
+
+	for (cell = nodes->head; cell; cell = cell->next)
+	{
+		uint32		slot = ((uint32) cell->node_info->node_id * 2654435761U) & (index->slot_count - 1);
+
+		index->nodes[i].node_id = cell->node_info->node_id;
+		strncpy(index->nodes[i].node_name,
+				cell->node_info->node_name,
+				sizeof(index->nodes[i].node_name));
+
+		while (index->slots[slot] != 0)
+			slot = (slot + 1) & (index->slot_count - 1);
+
+		index->slots[slot] = i + 1;
+		i++;
+	}
+}
+
+
+/*
+ * node_index_lookup()
+ *
+ * Returns the dense index of the specified node, or -1 if not found.
+ */
+static int
+node_index_lookup(t_node_index *index, int node_id)
+{
+	uint32		slot = ((uint32) node_id * 2654435761U) & (index->slot_count - 1);
+
+	while (index->slots[slot] != 0)
+	{
+		int			i = index->slots[slot] - 1;
+
+		if (index->nodes[i].node_id == node_id)
+			return i;
+
+		slot = (slot + 1) & (index->slot_count - 1);
+	}
+
+	return -1;
+}
+
+
+static void
+node_index_free(t_node_index *index)
+{
+	pfree(index->nodes);
+	pfree(index->slots);
+}
+
+
+static void
+matrix_set_node_status(t_node_status_matrix *matrix, int node_id, int connection_node_id, int connection_status)
+{
+	int			n = matrix->index.node_count;
+	int			i = node_index_lookup(&matrix->index, node_id);
+	int			j = node_index_lookup(&matrix->index, connection_node_id);
 
-		pfree(headers_matrix);
+	if (i < 0 || j < 0)
+		return;
 
-		if (warnings.head != NULL && runtime_options.terse == false)
-		{
-			log_warning(_("following problems detected:"));
-			print_item_list(&warnings);
-		}
+	matrix->status[i * n + j] = (int8) connection_status;
+}
 
-	}
 
-	for (i = 0; i < n; i++)
+/*
+ * Callback for execute_commands_parallel(): parse the `repmgr cluster show --csv`
+ * output returned by the node identified by "task->id" into the matrix.
+ */
+static void
+matrix_process_task_output(t_command_task *task, void *arg)
+{
+	t_matrix_task_context *context = (t_matrix_task_context *) arg;
+	int			connection_node_id = task->id;
+	char	   *p = task->output.data;
+	int			j;
+
+	if (task->timed_out == true)
 	{
-		for (j = 0; j < n; j++)
-		{
-			free(matrix_rec_list[i]->node_status_list[j]);
-		}
-		free(matrix_rec_list[i]->node_status_list);
-		free(matrix_rec_list[i]);
+		item_list_append_format(context->warnings,
+								"node %i did not respond within %i seconds",
+								connection_node_id, runtime_options.timeout);
+		*context->error_code = ERR_BAD_SSH;
+		return;
 	}
 
-	free(matrix_rec_list);
-
-	/* actual database connection errors have priority */
-	if (connection_error_found == true)
+	/* no output returned - probably SSH error */
+	if (p[0] == '\0' || p[0] == '\n')
 	{
-		error_code = ERR_NODE_STATUS;
+		item_list_append_format(context->warnings,
+								"node %i inaccessible via SSH",
+								connection_node_id);
+		*context->error_code = ERR_BAD_SSH;
+		return;
 	}
 
-	exit(error_code);
+	for (j = 0; j < context->matrix->index.node_count; j++)
+	{
+		int			x = UNKNOWN_NODE_ID,
+					y;
+
+		if (sscanf(p, "%d,%d", &x, &y) != 2)
+		{
+			matrix_set_node_status(context->matrix,
+								   connection_node_id,
+								   x,
+								   -2);
+
+			item_list_append_format(context->warnings,
+									"unable to parse --csv output for node %i; output returned was:\n\"%s\"",
+									connection_node_id, p);
+			*context->error_code = ERR_INTERNAL;
+		}
+		else
+		{
+			matrix_set_node_status(context->matrix,
+								   connection_node_id,
+								   x,
+								   (y == -1) ? -1 : 0);
+		}
+
+		while (*p && (*p != '\n'))
+			p++;
+		if (*p == '\n')
+			p++;
+	}
 }
 
 
+/*
+ * Callback for execute_query_parallel(): populate the matrix row for the
+ * node with the connectivity information recorded by its repmgrd.
+ */
 static void
-matrix_set_node_status(t_node_matrix_rec **matrix_rec_list, int n, int node_id, int connection_node_id, int connection_status)
+matrix_process_connectivity_result(t_node_info *node_info, PGresult *res, void *arg)
 {
-	int			i,
-				j;
+	t_matrix_task_context *context = (t_matrix_task_context *) arg;
+	int			current_count = 0;
+	int			i;
+
+	if (node_info->node_id == context->local_node_id)
+		return;
 
-	for (i = 0; i < n; i++)
+	if (PQresultStatus(res) != PGRES_TUPLES_OK)
 	{
-		if (matrix_rec_list[i]->node_id == node_id)
-		{
-			for (j = 0; j < n; j++)
-			{
-				if (matrix_rec_list[i]->node_status_list[j]->node_id == connection_node_id)
-				{
-					matrix_rec_list[i]->node_status_list[j]->node_status = connection_status;
-					break;
-				}
-			}
-			break;
-		}
+		log_verbose(LOG_DEBUG, "unable to retrieve connectivity information from node %i",
+					node_info->node_id);
+		return;
+	}
+
+	for (i = 0; i < PQntuples(res); i++)
+	{
+		if (atoi(PQgetvalue(res, i, 2)) > context->max_age)
+			continue;
+
+		matrix_set_node_status(context->matrix,
+							   node_info->node_id,
+							   atoi(PQgetvalue(res, i, 0)),
+							   atobool(PQgetvalue(res, i, 1)) ? 0 : -1);
+		current_count++;
+	}
+
+	/* information incomplete or outdated - fall back to SSH */
+	if (current_count < context->matrix->index.node_count)
+	{
+		log_verbose(LOG_DEBUG, "no current connectivity information recorded on node %i",
+					node_info->node_id);
+		return;
 	}
+
+	i = node_index_lookup(&context->matrix->index, node_info->node_id);
+
+	if (i >= 0)
+		context->connectivity_found[i] = true;
+
+	log_verbose(LOG_INFO, _("retrieved connectivity information for node %i from repmgrd"),
+				node_info->node_id);
 }
 
 
 static int
-build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, int *error_code)
+build_cluster_matrix(t_node_status_matrix *matrix, ItemList *warnings, int *error_code)
 {
 	PGconn	   *conn = NULL;
-	int			i = 0,
-				j = 0;
+	int			i = 0;
 	int			local_node_id = UNKNOWN_NODE_ID;
 	int			node_count = 0;
 	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
 	NodeInfoListCell *cell = NULL;
 
 	PQExpBufferData command;
-	PQExpBufferData command_output;
+	PQExpBufferData ssh_command;
 
-	t_node_matrix_rec **matrix_rec_list;
+	t_command_task *tasks = NULL;
+	int			task_count = 0;
+	int			task_timeout = 0;
+	t_matrix_task_context context;
 
 	/* obtain node list from the database */
 	log_info(_("connecting to database"));
@@ -947,94 +1491,91 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 	}
 
 	/*
-	 * Allocate an empty matrix record list
+	 * Allocate an empty matrix
 	 *
 	 * -2 == NULL  ? -1 == Error x 0 == OK
 	 */
+	node_index_init(&matrix->index, &nodes);
 
-	matrix_rec_list = (t_node_matrix_rec **) pg_malloc0(sizeof(t_node_matrix_rec) * nodes.node_count);
-
-	i = 0;
-
-	/* Initialise matrix structure for each node */
-	for (cell = nodes.head; cell; cell = cell->next)
-	{
-		NodeInfoListCell *cell_j;
-
-		matrix_rec_list[i] = (t_node_matrix_rec *) pg_malloc0(sizeof(t_node_matrix_rec));
-
-		matrix_rec_list[i]->node_id = cell->node_info->node_id;
-		strncpy(matrix_rec_list[i]->node_name,
-				cell->node_info->node_name,
-				sizeof(matrix_rec_list[i]->node_name));
-
-		matrix_rec_list[i]->node_status_list = (t_node_status_rec **) pg_malloc0(sizeof(t_node_status_rec) * nodes.node_count);
+	matrix->status = (int8 *) pg_malloc(sizeof(int8) * nodes.node_count * nodes.node_count);
+	memset(matrix->status, -2, sizeof(int8) * nodes.node_count * nodes.node_count);
 
-		j = 0;
-
-		for (cell_j = nodes.head; cell_j; cell_j = cell_j->next)
-		{
-			matrix_rec_list[i]->node_status_list[j] = (t_node_status_rec *) pg_malloc0(sizeof(t_node_status_rec));
-			matrix_rec_list[i]->node_status_list[j]->node_id = cell_j->node_info->node_id;
-			matrix_rec_list[i]->node_status_list[j]->node_status = -2;	/* default unknown */
+	/*
+	 * Check which nodes we can connect to from this node; connections are
+	 * attempted concurrently.
+	 */
+	(void) establish_db_connections_parallel(&nodes,
+											 runtime_options.parallel,
+											 runtime_options.timeout);
 
-			j++;
-		}
+	context.matrix = matrix;
+	context.local_node_id = local_node_id;
+	context.connectivity_found = (bool *) pg_malloc0(sizeof(bool) * nodes.node_count);
+	context.warnings = warnings;
+	context.error_code = error_code;
 
-		i++;
+	/*
+	 * If repmgrd is recording connectivity information, retrieve it from all
+	 * reachable nodes concurrently; nodes which provide current information
+	 * for all other nodes don't need to be queried via SSH. Information not
+	 * updated within three times "connectivity_check_interval" is considered
+	 * stale.
+	 */
+	if (config_file_options.connectivity_check_interval > 0)
+	{
+		const char *sqlquery =
+			"SELECT node_id, reachable, "
+			"       EXTRACT(epoch FROM (pg_catalog.clock_timestamp() - last_checked))::INT AS age "
+			"  FROM repmgr.get_node_connectivity()";
+
+		context.max_age = config_file_options.connectivity_check_interval * 3;
+
+		(void) execute_query_parallel(&nodes,
+									  sqlquery,
+									  runtime_options.timeout,
+									  matrix_process_connectivity_result,
+									  &context);
 	}
 
-	/* Fetch `repmgr cluster show --csv` output for each node */
+	tasks = (t_command_task *) pg_malloc0(sizeof(t_command_task) * nodes.node_count);
+
 	i = 0;
 
-	for (cell = nodes.head; cell; cell = cell->next)
+	for (cell = nodes.head; cell; cell = cell->next, i++)
 	{
 		int			connection_status = 0;
 		t_conninfo_param_list remote_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
-		char	   *host = NULL,
-				   *p = NULL;
+		char	   *host = NULL;
 		int			connection_node_id = cell->node_info->node_id;
-		int			x,
-					y;
-		PGconn	   *node_conn = NULL;
-
-		initialize_conninfo_params(&remote_conninfo, false);
-		parse_conninfo_string(cell->node_info->conninfo,
-							  &remote_conninfo,
-							  NULL,
-							  false);
-
-		host = param_get(&remote_conninfo, "host");
-
-		node_conn = establish_db_connection_quiet(cell->node_info->conninfo);
 
 		connection_status =
-			(PQstatus(node_conn) == CONNECTION_OK) ? 0 : -1;
+			(PQstatus(cell->node_info->conn) == CONNECTION_OK) ? 0 : -1;
 
+		close_connection(&cell->node_info->conn);
 
-		matrix_set_node_status(matrix_rec_list,
-							   nodes.node_count,
+		matrix_set_node_status(matrix,
 							   local_node_id,
 							   connection_node_id,
 							   connection_status);
 
-
 		if (connection_status)
-		{
-			free_conninfo_params(&remote_conninfo);
-			PQfinish(node_conn);
-			node_conn = NULL;
 			continue;
-		}
 
 		/* We don't need to issue `cluster show --csv` for the local node */
 		if (connection_node_id == local_node_id)
-		{
-			free_conninfo_params(&remote_conninfo);
-			PQfinish(node_conn);
-			node_conn = NULL;
 			continue;
-		}
+
+		/* ... or for nodes where repmgrd provided the information */
+		if (context.connectivity_found[i] == true)
+			continue;
+
+		initialize_conninfo_params(&remote_conninfo, false);
+		parse_conninfo_string(cell->node_info->conninfo,
+							  &remote_conninfo,
+							  NULL,
+							  false);
+
+		host = param_get(&remote_conninfo, "host");
 
 		initPQExpBuffer(&command);
 
@@ -1050,6 +1591,25 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 		appendPQExpBufferStr(&command,
 							 " cluster show --csv --terse");
 
+		/*
+		 * Pass on any explicitly provided concurrency settings; these are
+		 * not recognised by older repmgr versions, and otherwise the remote
+		 * defaults are the same as ours.
+		 */
+		if (runtime_options.parallel_provided == true)
+		{
+			appendPQExpBuffer(&command,
+							  " --parallel=%i",
+							  runtime_options.parallel);
+		}
+
+		if (runtime_options.timeout_provided == true)
+		{
+			appendPQExpBuffer(&command,
+							  " --timeout=%i",
+							  runtime_options.timeout);
+		}
+
 		/*
 		 * Usually we'll want NOTICE as the log level, but if the user
 		 * explicitly provided one with --log-level, that will be passed
@@ -1062,67 +1622,45 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 		}
 		appendPQExpBufferChar(&command, '"');
 
-		log_verbose(LOG_DEBUG, "build_cluster_matrix(): executing:\n  %s", command.data);
+		initPQExpBuffer(&ssh_command);
 
-		initPQExpBuffer(&command_output);
+		make_remote_command(host,
+							runtime_options.remote_user,
+							command.data,
+							config_file_options.ssh_options,
+							&ssh_command);
 
-		(void) remote_command(host,
-							  runtime_options.remote_user,
-							  command.data,
-							  config_file_options.ssh_options,
-							  &command_output);
+		log_verbose(LOG_DEBUG, "build_cluster_matrix(): executing:\n  %s", ssh_command.data);
 
-		p = command_output.data;
+		init_command_task(&tasks[task_count++], connection_node_id, ssh_command.data);
 
+		termPQExpBuffer(&ssh_command);
 		termPQExpBuffer(&command);
+		free_conninfo_params(&remote_conninfo);
+	}
 
-		/* no output returned - probably SSH error */
-		if (p[0] == '\0' || p[0] == '\n')
-		{
-			item_list_append_format(warnings,
-									"node %i inaccessible via SSH",
-									connection_node_id);
-			*error_code = ERR_BAD_SSH;
-		}
-		else
-		{
-			for (j = 0; j < nodes.node_count; j++)
-			{
-				if (sscanf(p, "%d,%d", &x, &y) != 2)
-				{
-					matrix_set_node_status(matrix_rec_list,
-										   nodes.node_count,
-										   connection_node_id,
-										   x,
-										   -2);
-
-					item_list_append_format(warnings,
-											"unable to parse --csv output for node %i; output returned was:\n\"%s\"",
-											connection_node_id, p);
-					*error_code = ERR_INTERNAL;
-				}
-				else
-				{
-					matrix_set_node_status(matrix_rec_list,
-										   nodes.node_count,
-										   connection_node_id,
-										   x,
-										   (y == -1) ? -1 : 0);
-				}
+	/*
+	 * Execute `repmgr cluster show --csv` on each remaining reachable node
+	 * concurrently; matrix_process_task_output() will fill in the matrix as
+	 * each result arrives.
+	 *
+	 * The timeout must allow for the remote command's worst case, otherwise a
+	 * single unreachable node would cause every task to time out.
+	 */
+	task_timeout = cluster_show_task_timeout(nodes.node_count);
 
-				while (*p && (*p != '\n'))
-					p++;
-				if (*p == '\n')
-					p++;
-			}
-		}
+	(void) execute_commands_parallel(tasks,
+									 task_count,
+									 runtime_options.parallel,
+									 task_timeout,
+									 matrix_process_task_output,
+									 &context);
 
-		termPQExpBuffer(&command_output);
-		PQfinish(node_conn);
-		free_conninfo_params(&remote_conninfo);
-	}
+	for (i = 0; i < task_count; i++)
+		term_command_task(&tasks[i]);
 
-	*matrix_rec_dest = matrix_rec_list;
+	pfree(tasks);
+	pfree(context.connectivity_found);
 
 	node_count = nodes.node_count;
 	clear_node_info_list(&nodes);
@@ -1131,17 +1669,112 @@ build_cluster_matrix(t_node_matrix_rec ***matrix_rec_dest, ItemList *warnings, i
 }
 
 
+/*
+ * cluster_show_task_timeout()
+ *
+ * Time (in seconds) to allow for `repmgr cluster show` executed via SSH
+ * by build_cluster_matrix(): the remote command connects to all nodes in
+ * batches of --parallel nodes, each batch taking up to --timeout seconds
+ * if any node is unreachable, plus the SSH overhead.
+ */
+static int
+cluster_show_task_timeout(int node_count)
+{
+	return runtime_options.timeout * (1 + (node_count - 1) / runtime_options.parallel)
+		+ REMOTE_COMMAND_SSH_OVERHEAD;
+}
+
+
+/*
+ * cluster_matrix_task_timeout()
+ *
+ * Time (in seconds) to allow for `repmgr cluster matrix` executed via SSH
+ * by build_cluster_crosscheck(): the remote command's own connection phase
+ * and connectivity query (up to --timeout seconds each), followed by the
+ * `repmgr cluster show` tasks it executes, plus our own SSH overhead.
+ */
+static int
+cluster_matrix_task_timeout(int node_count)
+{
+	return runtime_options.timeout * 2
+		+ cluster_show_task_timeout(node_count)
+		+ REMOTE_COMMAND_SSH_OVERHEAD;
+}
+
+
+/*
+ * Callback for execute_commands_parallel(): parse the `repmgr cluster matrix --csv`
+ * output returned by the node identified by "task->id" into the cube.
+ */
+static void
+cube_process_task_output(t_command_task *task, void *arg)
+{
+	t_cube_task_context *context = (t_cube_task_context *) arg;
+	int			remote_node_id = task->id;
+	char	   *p = task->output.data;
+	int			j;
+
+	if (task->timed_out == true)
+	{
+		item_list_append_format(context->warnings,
+								"node %i did not respond within %i seconds",
+								remote_node_id, context->timeout);
+		*context->error_code = ERR_BAD_SSH;
+		return;
+	}
+
+	if (p[0] == '\0' || p[0] == '\n')
+	{
+		item_list_append_format(context->warnings,
+								"node %i inaccessible via SSH",
+								remote_node_id);
+		*context->error_code = ERR_BAD_SSH;
+		return;
+	}
+
+	for (j = 0; j < (context->cube->index.node_count * context->cube->index.node_count); j++)
+	{
+		int			matrix_rec_node_id = UNKNOWN_NODE_ID;
+		int			node_status_node_id = UNKNOWN_NODE_ID;
+		int			node_status;
+
+		if (sscanf(p, "%d,%d,%d", &matrix_rec_node_id, &node_status_node_id, &node_status) != 3)
+		{
+			cube_set_node_status(context->cube,
+								 remote_node_id,
+								 matrix_rec_node_id,
+								 node_status_node_id,
+								 -2);
+			*context->error_code = ERR_INTERNAL;
+		}
+		else
+		{
+			cube_set_node_status(context->cube,
+								 remote_node_id,
+								 matrix_rec_node_id,
+								 node_status_node_id,
+								 node_status);
+		}
+
+		while (*p && (*p != '\n'))
+			p++;
+		if (*p == '\n')
+			p++;
+	}
+}
+
+
 static int
-build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, int *error_code)
+build_cluster_crosscheck(t_node_status_cube *cube, ItemList *warnings, int *error_code)
 {
 	PGconn	   *conn = NULL;
-	int			h,
-				i,
-				j;
+	int			i;
 	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
 	NodeInfoListCell *cell = NULL;
 
-	t_node_status_cube **cube;
+	t_command_task *tasks = NULL;
+	int			task_count = 0;
+	t_cube_task_context context;
 
 	int			node_count = 0;
 
@@ -1174,64 +1807,20 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 	 *
 	 * -2 == NULL -1 == Error 0 == OK
 	 */
+	node_index_init(&cube->index, &nodes);
 
-	cube = (t_node_status_cube **) pg_malloc(sizeof(t_node_status_cube *) * nodes.node_count);
-
-	h = 0;
-
-	for (cell = nodes.head; cell; cell = cell->next)
-	{
-		NodeInfoListCell *cell_i = NULL;
-
-		cube[h] = (t_node_status_cube *) pg_malloc(sizeof(t_node_status_cube));
-		cube[h]->node_id = cell->node_info->node_id;
-		strncpy(cube[h]->node_name, cell->node_info->node_name, sizeof(cube[h]->node_name));
-
-		cube[h]->matrix_list_rec = (t_node_matrix_rec **) pg_malloc(sizeof(t_node_matrix_rec) * nodes.node_count);
-
-		i = 0;
-		for (cell_i = nodes.head; cell_i; cell_i = cell_i->next)
-		{
-			NodeInfoListCell *cell_j;
-
-			cube[h]->matrix_list_rec[i] = (t_node_matrix_rec *) pg_malloc0(sizeof(t_node_matrix_rec));
-			cube[h]->matrix_list_rec[i]->node_id = cell_i->node_info->node_id;
-
-			/* we don't need the name here */
-			cube[h]->matrix_list_rec[i]->node_name[0] = '\0';
-
-			cube[h]->matrix_list_rec[i]->node_status_list = (t_node_status_rec **) pg_malloc0(sizeof(t_node_status_rec *) * nodes.node_count);
-
-			j = 0;
-
-			for (cell_j = nodes.head; cell_j; cell_j = cell_j->next)
-			{
-				cube[h]->matrix_list_rec[i]->node_status_list[j] = (t_node_status_rec *) pg_malloc0(sizeof(t_node_status_rec));
-				cube[h]->matrix_list_rec[i]->node_status_list[j]->node_id = cell_j->node_info->node_id;
-				cube[h]->matrix_list_rec[i]->node_status_list[j]->node_status = -2; /* default unknown */
-
-				j++;
-			}
-
-			i++;
-		}
-
-		h++;
-	}
-
+	cube->status = (int8 *) pg_malloc(sizeof(int8) * nodes.node_count * nodes.node_count * nodes.node_count);
+	memset(cube->status, -2, sizeof(int8) * nodes.node_count * nodes.node_count * nodes.node_count);
 
 	/*
 	 * Build the connection cube
 	 */
-	i = 0;
+	tasks = (t_command_task *) pg_malloc0(sizeof(t_command_task) * nodes.node_count);
 
 	for (cell = nodes.head; cell; cell = cell->next)
 	{
 		int			remote_node_id = UNKNOWN_NODE_ID;
 		PQExpBufferData command;
-		PQExpBufferData command_output;
-
-		char	   *p = NULL;
 
 		remote_node_id = cell->node_info->node_id;
 
@@ -1253,18 +1842,33 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 								 " -L NOTICE");
 		}
 
-		initPQExpBuffer(&command_output);
+		/* pass on any explicitly provided concurrency settings */
+		if (runtime_options.parallel_provided == true)
+		{
+			appendPQExpBuffer(&command,
+							  " --parallel=%i",
+							  runtime_options.parallel);
+		}
+
+		if (runtime_options.timeout_provided == true)
+		{
+			appendPQExpBuffer(&command,
+							  " --timeout=%i",
+							  runtime_options.timeout);
+		}
 
-		if (cube[i]->node_id == config_file_options.node_id)
+		if (remote_node_id == config_file_options.node_id)
 		{
-			(void) local_command_simple(command.data,
-										&command_output);
+			log_verbose(LOG_DEBUG, "build_cluster_crosscheck(): executing\n  %s", command.data);
+
+			init_command_task(&tasks[task_count++], remote_node_id, command.data);
 		}
 		else
 		{
 			t_conninfo_param_list remote_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
 			char	   *host = NULL;
 			PQExpBufferData quoted_command;
+			PQExpBufferData ssh_command;
 
 			initPQExpBuffer(&quoted_command);
 			appendPQExpBuffer(&quoted_command,
@@ -1280,69 +1884,47 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 
 			host = param_get(&remote_conninfo, "host");
 
-			log_verbose(LOG_DEBUG, "build_cluster_crosscheck(): executing\n  %s", quoted_command.data);
+			initPQExpBuffer(&ssh_command);
+
+			make_remote_command(host,
+								runtime_options.remote_user,
+								quoted_command.data,
+								config_file_options.ssh_options,
+								&ssh_command);
 
-			(void) remote_command(host,
-								  runtime_options.remote_user,
-								  quoted_command.data,
-								  config_file_options.ssh_options,
-								  &command_output);
+			log_verbose(LOG_DEBUG, "build_cluster_crosscheck(): executing\n  %s", ssh_command.data);
+
+			init_command_task(&tasks[task_count++], remote_node_id, ssh_command.data);
 
 			free_conninfo_params(&remote_conninfo);
+			termPQExpBuffer(&ssh_command);
 			termPQExpBuffer(&quoted_command);
 		}
 
 		termPQExpBuffer(&command);
+	}
 
-		p = command_output.data;
-
-		if (p[0] == '\0' || p[0] == '\n')
-		{
-			item_list_append_format(warnings,
-									"node %i inaccessible via SSH",
-									remote_node_id);
-			termPQExpBuffer(&command_output);
-			*error_code = ERR_BAD_SSH;
-			continue;
-		}
-
-		for (j = 0; j < (nodes.node_count * nodes.node_count); j++)
-		{
-			int			matrix_rec_node_id;
-			int			node_status_node_id;
-			int			node_status;
-
-			if (sscanf(p, "%d,%d,%d", &matrix_rec_node_id, &node_status_node_id, &node_status) != 3)
-			{
-				cube_set_node_status(cube,
-									 nodes.node_count,
-									 remote_node_id,
-									 matrix_rec_node_id,
-									 node_status_node_id,
-									 -2);
-				*error_code = ERR_INTERNAL;
-			}
-			else
-			{
-				cube_set_node_status(cube,
-									 nodes.node_count,
-									 remote_node_id,
-									 matrix_rec_node_id,
-									 node_status_node_id,
-									 node_status);
-			}
+	/*
+	 * Each node executes `repmgr cluster matrix`, which itself needs to
+	 * connect to all nodes and execute `repmgr cluster show` on each of them,
+	 * so allow for that in the timeout applied to each task.
+	 */
+	context.cube = cube;
+	context.timeout = cluster_matrix_task_timeout(nodes.node_count);
+	context.warnings = warnings;
+	context.error_code = error_code;
 
-			while (*p && (*p != '\n'))
-				p++;
-			if (*p == '\n')
-				p++;
-		}
-		termPQExpBuffer(&command_output);
+	(void) execute_commands_parallel(tasks,
+									 task_count,
+									 runtime_options.parallel,
+									 context.timeout,
+									 cube_process_task_output,
+									 &context);
 
-		i++;
-	}
+	for (i = 0; i < task_count; i++)
+		term_command_task(&tasks[i]);
 
-	*dest_cube = cube;
+	pfree(tasks);
 
 	node_count = nodes.node_count;
 
@@ -1353,34 +1935,53 @@ build_cluster_crosscheck(t_node_status_cube ***dest_cube, ItemList *warnings, in
 
 
 static void
-cube_set_node_status(t_node_status_cube **cube, int n, int execute_node_id, int matrix_node_id, int connection_node_id, int connection_status)
+cube_set_node_status(t_node_status_cube *cube, int execute_node_id, int matrix_node_id, int connection_node_id, int connection_status)
 {
-	int			h,
-				i,
-				j;
+	int			n = cube->index.node_count;
+	int			h = node_index_lookup(&cube->index, execute_node_id);
+	int			i = node_index_lookup(&cube->index, matrix_node_id);
+	int			j = node_index_lookup(&cube->index, connection_node_id);
+
+	if (h < 0 || i < 0 || j < 0)
+		return;
 
+	cube->status[(i * n + j) * n + h] = (int8) connection_status;
+}
+
+
+/*
+ * cube_get_node_status()
+ *
+ * The value of entry (i,j) is equal to the maximum value of all
+ * the (i,j,k). Indeed:
+ *
+ * - if one of the (i,j,k) is 0 (node up), then 0 (the node is
+ * up);
+ *
+ * - if the (i,j,k) are either -1 (down) or -2 (unknown), then -1
+ * (the node is down);
+ *
+ * - if all the (i,j,k) are -2 (unknown), then -2 (the node is in
+ * an unknown state).
+ *
+ * The (i,j,k) are stored contiguously, so this is a simple linear
+ * reduction the compiler can vectorise.
+ */
+static int
+cube_get_node_status(t_node_status_cube *cube, int row, int column)
+{
+	int			n = cube->index.node_count;
+	const int8 *values = cube->status + (row * n + column) * n;
+	int8		max_node_status = -2;
+	int			k;
 
-	for (h = 0; h < n; h++)
+	for (k = 0; k < n; k++)
 	{
-		if (cube[h]->node_id == execute_node_id)
-		{
-			for (i = 0; i < n; i++)
-			{
-				if (cube[h]->matrix_list_rec[i]->node_id == matrix_node_id)
-				{
-					for (j = 0; j < n; j++)
-					{
-						if (cube[h]->matrix_list_rec[i]->node_status_list[j]->node_id == connection_node_id)
-						{
-							cube[h]->matrix_list_rec[i]->node_status_list[j]->node_status = connection_status;
-							break;
-						}
-					}
-					break;
-				}
-			}
-		}
+		if (values[k] > max_node_status)
+			max_node_status = values[k];
 	}
+
+	return max_node_status;
 }
 
 
@@ -1513,6 +2114,9 @@ do_cluster_help(void)
 	puts("");
 	printf(_("    --csv                     emit output as CSV (with a subset of fields)\n"));
 	printf(_("    --compact                 display only a subset of fields\n"));
+	printf(_("    --parallel=N              connect to at most N nodes concurrently (default: %i)\n"), DEFAULT_PARALLEL);
+	printf(_("    --timeout=VALUE           maximum time in seconds to wait for all node connections (default: %i)\n"), DEFAULT_TIMEOUT);
+	printf(_("    --watch=INTERVAL          refresh the displayed status every INTERVAL seconds\n"));
 	puts("");
 
 	printf(_("CLUSTER MATRIX\n"));
@@ -1522,6 +2126,8 @@ do_cluster_help(void)
 	printf(_("  Configuration file or database connection required.\n"));
 	puts("");
 	printf(_("    --csv                     emit output as CSV\n"));
+	printf(_("    --parallel=N              execute \"cluster show\" on at most N nodes concurrently (default: %i)\n"), DEFAULT_PARALLEL);
+	printf(_("    --timeout=VALUE           maximum time in seconds to wait for each node (default: %i)\n"), DEFAULT_TIMEOUT);
 	puts("");
 
 	printf(_("CLUSTER CROSSCHECK\n"));
@@ -1531,6 +2137,8 @@ do_cluster_help(void)
 	printf(_("  Configuration file or database connection required.\n"));
 	puts("");
 	printf(_("    --csv                     emit output as CSV\n"));
+	printf(_("    --parallel=N              execute \"cluster matrix\" on at most N nodes concurrently (default: %i)\n"), DEFAULT_PARALLEL);
+	printf(_("    --timeout=VALUE           maximum time in seconds to wait for each node (default: %i)\n"), DEFAULT_TIMEOUT);
 	puts("");
 
 
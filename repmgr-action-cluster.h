@@ -21,24 +21,45 @@
 
 
 
+/*
+ * Connection status between each pair of nodes, as determined by
+ * "cluster matrix" and "cluster crosscheck":
+ *
+ *   -2 == unknown, -1 == error, 0 == OK
+ *
+ * Each node is mapped to a dense index (its position in the node list)
+ * via a small open-addressing hash table keyed on node ID, and status
+ * values are stored in a single contiguous array.
+ */
 typedef struct
 {
 	int			node_id;
-	int			node_status;
-} t_node_status_rec;
+	char		node_name[NAMEDATALEN];
+} t_matrix_node;
 
 typedef struct
 {
-	int			node_id;
-	char		node_name[NAMEDATALEN];
-	t_node_status_rec **node_status_list;
-} t_node_matrix_rec;
+	int			node_count;
+	t_matrix_node *nodes;
+	int			slot_count;		/* always a power of two */
+	int		   *slots;			/* dense index + 1, or 0 if unused */
+} t_node_index;
 
+/* status[row * node_count + column] */
 typedef struct
 {
-	int			node_id;
-	char		node_name[NAMEDATALEN];
-	t_node_matrix_rec **matrix_list_rec;
+	t_node_index index;
+	int8	   *status;
+} t_node_status_matrix;
+
+/*
+ * status[(row * node_count + column) * node_count + reporting node], so the
+ * values reported by all nodes for any connection are adjacent
+ */
+typedef struct
+{
+	t_node_index index;
+	int8	   *status;
 } t_node_status_cube;
 
 
@@ -32,6 +32,9 @@
 #include "repmgr-action-node.h"
 #include "repmgr-action-standby.h"
 
+/* interval at which "node agent" checks for removal of "postmaster.pid" */
+#define AGENT_WAIT_SHUTDOWN_INTERVAL 10		/* milliseconds */
+
 static bool copy_file(const char *src_file, const char *dest_file);
 static void format_archive_dir(PQExpBufferData *archive_dir);
 static t_server_action parse_server_action(const char *action);
@@ -43,6 +46,8 @@ static void _do_node_service_list_actions(t_server_action action);
 static void _do_node_status_is_shutdown_cleanly(void);
 static void _do_node_archive_config(void);
 static void _do_node_restore_config(void);
+static int	_do_node_agent_wait_shutdown(int timeout_ms);
+static bool _do_node_agent_request_permitted(const char *request);
 
 static void do_node_check_replication_connection(void);
 static CheckStatus do_node_check_archive_ready(PGconn *conn, OutputMode mode, CheckStatusList *list_output);
@@ -3198,6 +3203,225 @@ do_node_control(void)
 }
 
 
+/*
+ * NODE AGENT
+ *
+ * For "internal" use by "standby switchover" (and potentially other
+ * operations executed from another node), which starts the agent once via
+ * SSH and submits all remote repmgr commands to it, rather than opening a
+ * new SSH connection for each command.
+ *
+ * Protocol (see also sysutils.h):
+ *
+ *   - on startup the agent emits "REPMGR-AGENT <protocol version> <repmgr version>"
+ *   - each request is a single line containing repmgr command line arguments,
+ *     e.g. "node check --archive-ready --optformat"
+ *   - each request is answered with "RESULT <exit code> <length>", followed
+ *     by exactly <length> bytes of output
+ *   - "WAIT-SHUTDOWN <milliseconds>" is handled by the agent itself: it
+ *     returns 0 as soon as "postmaster.pid" has been removed from the data
+ *     directory, 2 if the postmaster is no longer running but has left
+ *     "postmaster.pid" in place (e.g. after a crash), or 1 if neither has
+ *     happened within the timeout
+ *   - the session ends with "QUIT" or end of input
+ *
+ * Requests are executed with the same repmgr binary and configuration file
+ * as the agent itself, each in its own process, as the individual actions
+ * terminate via exit(). Only the actions needed by "standby switchover" are
+ * accepted (see _do_node_agent_request_permitted()); requests are passed to
+ * the shell, so output redirections such as "2>/dev/null" work as they do
+ * with a direct SSH invocation. Standard input is redirected from
+ * /dev/null, so a request cannot consume subsequent requests.
+ */
+
+void
+do_node_agent(void)
+{
+	t_node_info local_node_record = T_NODE_INFO_INITIALIZER;
+	PQExpBufferData request;
+	PQExpBufferData command;
+	PQExpBufferData output;
+	int			request_count = 0;
+
+	strncpy(local_node_record.config_file, config_file_path, sizeof(local_node_record.config_file));
+
+	printf("%s %i %i\n",
+		   REMOTE_AGENT_GREETING,
+		   REMOTE_AGENT_PROTOCOL_VERSION,
+		   REPMGR_VERSION_NUM);
+	fflush(stdout);
+
+	initPQExpBuffer(&request);
+	initPQExpBuffer(&command);
+	initPQExpBuffer(&output);
+
+	while (read_text_line(stdin, &request) == true)
+	{
+		FILE	   *fp = NULL;
+		char		chunk[MAXLEN];
+		size_t		len;
+		int			return_value = 127;
+
+		(void) trim(request.data);
+
+		if (request.data[0] == '\0')
+			continue;
+
+		if (strcmp(request.data, REMOTE_AGENT_QUIT) == 0)
+			break;
+
+		request_count++;
+
+		resetPQExpBuffer(&command);
+		resetPQExpBuffer(&output);
+
+		if (strncmp(request.data, REMOTE_AGENT_WAIT_SHUTDOWN, strlen(REMOTE_AGENT_WAIT_SHUTDOWN)) == 0)
+		{
+			int			timeout_ms = atoi(request.data + strlen(REMOTE_AGENT_WAIT_SHUTDOWN));
+
+			return_value = _do_node_agent_wait_shutdown(timeout_ms);
+		}
+		else if (_do_node_agent_request_permitted(request.data) == false)
+		{
+			log_warning(_("rejecting request %i:\n  %s"), request_count, request.data);
+
+			appendPQExpBuffer(&output, _("request not permitted: \"%s\"\n"), request.data);
+		}
+		else
+		{
+			make_remote_repmgr_path(&command, &local_node_record);
+			appendPQExpBuffer(&command, "%s < /dev/null", request.data);
+
+			log_verbose(LOG_DEBUG, "do_node_agent(): executing request %i:\n  %s",
+						request_count, command.data);
+
+			fflush(NULL);
+			fp = popen(command.data, "r");
+
+			if (fp == NULL)
+			{
+				log_error(_("unable to execute request:\n  %s"), command.data);
+				log_detail("%s", strerror(errno));
+			}
+			else
+			{
+				int			status;
+
+				while ((len = fread(chunk, 1, sizeof(chunk), fp)) > 0)
+					appendBinaryPQExpBuffer(&output, chunk, len);
+
+				status = pclose(fp);
+
+				if (status != -1 && WIFEXITED(status))
+					return_value = WEXITSTATUS(status);
+			}
+		}
+
+		printf("%s %i %i\n",
+			   REMOTE_AGENT_RESULT,
+			   return_value,
+			   (int) output.len);
+		fwrite(output.data, 1, output.len, stdout);
+
+		if (fflush(stdout) != 0)
+			break;
+	}
+
+	log_verbose(LOG_DEBUG, "do_node_agent(): %i requests executed", request_count);
+
+	termPQExpBuffer(&request);
+	termPQExpBuffer(&command);
+	termPQExpBuffer(&output);
+}
+
+
+/*
+ * Determine whether "request" may be executed by the agent: it must begin
+ * with one of the repmgr actions executed remotely by "standby switchover",
+ * and may not contain shell metacharacters other than those needed for
+ * output redirection.
+ */
+static bool
+_do_node_agent_request_permitted(const char *request)
+{
+	const char *permitted_actions[] = {
+		"node check",
+		"node service",
+		"node status",
+		"--version",
+		NULL
+	};
+	int			i;
+
+	if (strpbrk(request, ";&|`$()<\n") != NULL)
+		return false;
+
+	for (i = 0; permitted_actions[i] != NULL; i++)
+	{
+		size_t		len = strlen(permitted_actions[i]);
+
+		if (strncmp(request, permitted_actions[i], len) == 0
+			&& (request[len] == '\0' || request[len] == ' '))
+			return true;
+	}
+
+	return false;
+}
+
+
+/*
+ * Wait up to "timeout_ms" milliseconds for "postmaster.pid" to be removed,
+ * i.e. for PostgreSQL to complete its shutdown. As this only requires a
+ * stat() call, the file can be checked far more frequently than the
+ * caller could check via SSH.
+ *
+ * If the postmaster is no longer running but "postmaster.pid" is still
+ * present, it crashed or was killed and the file will not be removed, so
+ * return immediately and let the caller determine the node's status.
+ *
+ * Returns one of the REMOTE_AGENT_WAIT_SHUTDOWN_* result codes.
+ */
+static int
+_do_node_agent_wait_shutdown(int timeout_ms)
+{
+	char		pid_file[MAXPGPATH] = "";
+	struct stat statbuf;
+	int			elapsed_ms = 0;
+
+	snprintf(pid_file, MAXPGPATH, "%s/postmaster.pid", config_file_options.data_directory);
+
+	for (;;)
+	{
+		if (stat(pid_file, &statbuf) != 0 && errno == ENOENT)
+		{
+			log_verbose(LOG_DEBUG, "_do_node_agent_wait_shutdown(): \"%s\" removed after %i ms",
+						pid_file, elapsed_ms);
+			return REMOTE_AGENT_WAIT_SHUTDOWN_DONE;
+		}
+
+		/*
+		 * is_pg_running() also reports "not running" if the file was removed
+		 * after the check above, so check again before reporting a stale file.
+		 */
+		if (is_pg_running(config_file_options.data_directory) == PG_DIR_NOT_RUNNING)
+		{
+			if (stat(pid_file, &statbuf) != 0 && errno == ENOENT)
+				return REMOTE_AGENT_WAIT_SHUTDOWN_DONE;
+
+			log_verbose(LOG_DEBUG, "_do_node_agent_wait_shutdown(): postmaster not running but \"%s\" present after %i ms",
+						pid_file, elapsed_ms);
+			return REMOTE_AGENT_WAIT_SHUTDOWN_STALE;
+		}
+
+		if (elapsed_ms >= timeout_ms)
+			return REMOTE_AGENT_WAIT_SHUTDOWN_TIMEOUT;
+
+		pg_usleep(AGENT_WAIT_SHUTDOWN_INTERVAL * 1000L);
+		elapsed_ms += AGENT_WAIT_SHUTDOWN_INTERVAL;
+	}
+}
+
+
 /*
  * For "internal" use by `node rejoin` on the local node when
  * called by "standby switchover" from the remote node.
@@ -25,6 +25,7 @@ extern void do_node_check(void);
 extern void do_node_rejoin(void);
 extern void do_node_service(void);
 extern void do_node_control(void);
+extern void do_node_agent(void);
 
 extern void do_node_help(void);
 
@@ -231,7 +231,7 @@ do_service_status(void)
 		initPQExpBuffer(&node_status);
 		initPQExpBuffer(&upstream);
 
-		(void)format_node_status(cell->node_info, &node_status, &upstream, &warnings);
+		(void)format_node_status(cell->node_info, &node_status, &upstream, &warnings, NULL);
 		snprintf(repmgrd_info[i]->pg_running_text, sizeof(cell->node_info->details),
 				 "%s", node_status.data);
 
@@ -19,6 +19,7 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <ftw.h>
 #include <sys/stat.h>
 #include <time.h>
 #include <unistd.h>
@@ -49,6 +50,219 @@ typedef struct TablespaceDataList
 } TablespaceDataList;
 
 
+/* a node files are copied from in "--rsync-only" mode */
+typedef struct
+{
+	int			node_id;
+	char		host[MAXLEN];
+	char		data_directory[MAXPGPATH];
+	KeyValueList tablespaces;
+	PGconn	   *conn;
+} RsyncSource;
+
+/* a file to be copied, as listed by "rsync --list-only" */
+typedef struct
+{
+	char	   *path;
+	uint64		size;
+	bool		is_directory;
+} TransferFile;
+
+
+/* progress of the current clone, as tracked by the clone_progress_*() functions */
+typedef struct
+{
+	bool		active;
+	char		unit[MAXLEN];
+	uint64		unit_copied_bytes;
+	uint64		unit_total_bytes;
+	uint64		completed_bytes;
+	uint64		completed_total_bytes;
+	/* only reported by pg_basebackup; -1 otherwise */
+	int			tablespaces_copied;
+	int			tablespaces_total;
+	instr_time	start_time;
+	instr_time	last_report_time;
+	uint64		last_report_bytes;
+	double		elapsed_secs;
+	FILE	   *progress_file;
+} CloneProgress;
+
+/* state passed to rsync_tasks_progress_callback() */
+typedef struct
+{
+	uint64	   *task_bytes;
+	uint64		base_copied_bytes;
+	uint64		base_total_bytes;
+	uint64		total_bytes;
+} RsyncTasksProgress;
+
+#define CLONE_PROGRESS_INTERVAL 10
+
+/* candidate clone sources for --auto-source */
+typedef struct
+{
+	t_node_info *node_info;
+	bool		available;
+	bool		in_recovery;
+	XLogRecPtr	lsn;
+	int			wal_senders;
+	int			backups;
+	int			active_backends;
+	int			score;
+} CloneSourceCandidate;
+
+typedef struct
+{
+	CloneSourceCandidate *candidates;
+	int			candidate_count;
+} CloneSourceContext;
+
+/* --auto-source scoring; lower scores are better */
+#define AUTO_SOURCE_LOCATION_PENALTY 10000
+#define AUTO_SOURCE_PRIMARY_PENALTY 1000
+#define AUTO_SOURCE_BACKUP_WEIGHT 100
+#define AUTO_SOURCE_WAL_SENDER_WEIGHT 10
+#define AUTO_SOURCE_MAX_LAG_SCORE 5000	/* one point per MB of replay lag */
+
+/* hosts and clone sources for "standby provision" */
+typedef enum
+{
+	PROVISION_PENDING,
+	PROVISION_SUCCEEDED,
+	PROVISION_FAILED
+} ProvisionStatus;
+
+typedef struct
+{
+	char		host[MAXLEN];
+	ProvisionStatus status;
+} ProvisionTarget;
+
+typedef struct
+{
+	int			node_id;
+	char		name[MAXLEN];
+	char		conninfo[MAXLEN];
+} ProvisionSource;
+
+/* state of "--adaptive-rate" throttling */
+typedef struct
+{
+	bool		enabled;
+	int			pause_ms;
+	int64		last_checkpoint_count;
+	instr_time	last_sample_time;
+	/* copying is currently paused */
+	bool		paused;
+	/* start of the current pause, or of the current period of copying */
+	instr_time	phase_start_time;
+} AdaptiveRate;
+
+#define ADAPTIVE_RATE_SAMPLE_INTERVAL 5		/* seconds */
+#define ADAPTIVE_RATE_MIN_PAUSE 125			/* milliseconds */
+#define ADAPTIVE_RATE_MAX_PAUSE 4000		/* milliseconds */
+#define ADAPTIVE_RATE_RUN_PERIOD 1000		/* milliseconds */
+
+/* interval between polls of pg-backup-api's operation status */
+#define PG_BACKUPAPI_POLL_MIN_INTERVAL 500		/* milliseconds */
+#define PG_BACKUPAPI_POLL_MAX_INTERVAL 16000	/* milliseconds */
+
+/*
+ * remote repmgr commands executed by "standby switchover" on the demotion
+ * candidate; these are the requests submitted to "repmgr node agent"
+ */
+#define SWITCHOVER_DATA_DIRECTORY_CONFIG_CHECK "node check --data-directory-config --optformat -LINFO 2>/dev/null"
+#define SWITCHOVER_SUPERUSER_CHECK "node check --db-connection --superuser=%s --optformat -LINFO 2>/dev/null"
+#define SWITCHOVER_REPLICATION_CONFIG_OWNER_CHECK "node check --replication-config-owner --optformat -LINFO 2>/dev/null"
+#define SWITCHOVER_REPLICATION_CONNECTION_CHECK "node check --remote-node-id=%i --replication-connection"
+#define SWITCHOVER_ARCHIVE_READY_CHECK "node check --terse -LERROR --archive-ready --optformat"
+#define SWITCHOVER_SHUTDOWN_STATUS_CHECK "node status --is-shutdown-cleanly"
+
+/*
+ * wait loops in "standby switchover" poll with an interval starting at
+ * ADAPTIVE_POLL_MIN_INTERVAL, doubled after each poll up to
+ * ADAPTIVE_POLL_MAX_INTERVAL
+ */
+#define ADAPTIVE_POLL_MIN_INTERVAL 25		/* milliseconds */
+#define ADAPTIVE_POLL_MAX_INTERVAL 1000		/* milliseconds */
+
+/*
+ * maximum time the "node agent" on the demotion candidate is asked to wait
+ * for "postmaster.pid" to be removed, before the shutdown status is checked
+ * again by the usual means
+ */
+#define SWITCHOVER_AGENT_WAIT_SHUTDOWN_SLICE 1000	/* milliseconds */
+
+/*
+ * minimum time allowed for each response from the agent; if this (or
+ * "shutdown_check_timeout", if greater) is exceeded, the agent is stopped
+ * and remote commands are executed individually
+ */
+#define SWITCHOVER_AGENT_RESPONSE_TIMEOUT 60	/* seconds */
+
+/*
+ * time allowed for the SSH connection checks on all sibling nodes, which are
+ * executed concurrently
+ */
+#define SIBLING_SSH_CHECK_TIMEOUT 30		/* seconds */
+
+/*
+ * time allowed for the WAL receiver to restart after "standby follow" has
+ * changed "primary_conninfo" with a configuration reload
+ */
+#define FOLLOW_RELOAD_WAL_RECEIVER_TIMEOUT 10	/* seconds */
+
+/*
+ * assumptions used by switchover_estimate_downtime() for values which cannot
+ * be measured without performing the switchover
+ */
+#define SWITCHOVER_ESTIMATE_WRITE_RATE (64 * 1024 * 1024)	/* bytes per second */
+#define SWITCHOVER_ESTIMATE_REPLAY_RATE (32 * 1024 * 1024)	/* bytes per second */
+#define SWITCHOVER_ESTIMATE_PROMOTE_MS 2000
+#define SWITCHOVER_ESTIMATE_SAMPLES 5
+
+typedef struct
+{
+	instr_time	start_time;
+	int			timeout;		/* seconds */
+	long		interval_ms;
+	long		max_interval_ms;
+	int			last_logged_secs;
+} AdaptivePoll;
+
+/* phases of "standby switchover", timed for the event details and --report-json */
+typedef enum
+{
+	SWITCHOVER_PHASE_NONE = -1,
+	SWITCHOVER_PHASE_PRECHECKS,
+	SWITCHOVER_PHASE_PREPARE,
+	SWITCHOVER_PHASE_CHECKPOINT_AND_STOP,
+	SWITCHOVER_PHASE_SHUTDOWN_WAIT,
+	SWITCHOVER_PHASE_WAL_FLUSH,
+	SWITCHOVER_PHASE_PROMOTE,
+	SWITCHOVER_PHASE_REJOIN,
+	SWITCHOVER_PHASE_SIBLINGS_FOLLOW,
+	SWITCHOVER_PHASE_FINALIZE,
+	SWITCHOVER_PHASE_COUNT
+} SwitchoverPhase;
+
+typedef struct
+{
+	SwitchoverPhase current_phase;
+	SwitchoverPhase last_phase;
+	instr_time	start_time;
+	instr_time	phase_start_time;
+	bool		phase_executed[SWITCHOVER_PHASE_COUNT];
+	double		phase_ms[SWITCHOVER_PHASE_COUNT];
+	int			promotion_candidate_node_id;
+	int			demotion_candidate_node_id;
+	const char *result;
+	double		estimated_downtime_ms;
+	FILE	   *report_file;
+} SwitchoverTiming;
+
+
 typedef struct
 {
 	int			reachable_sibling_node_count;
@@ -88,6 +302,31 @@ static standy_clone_mode mode = pg_basebackup;
 /* used by barman mode */
 static char local_repmgr_tmp_directory[MAXPGPATH] = "";
 static char datadir_list_filename[MAXLEN] = "";
+static char clone_manifest_filename[MAXLEN] = "";
+static bool resume_clone = false;
+
+/* used by "--rsync-only" mode; the first entry is always the source node */
+static RsyncSource *rsync_sources = NULL;
+static int	rsync_source_count = 0;
+
+/* set if "--delta" was provided and the existing data directory can be reused */
+static bool delta_clone = false;
+
+static CloneProgress clone_progress;
+static SwitchoverTiming switchover_timing;
+
+static const char *switchover_phase_names[SWITCHOVER_PHASE_COUNT] = {
+	"prechecks",
+	"prepare",
+	"checkpoint_and_stop",
+	"shutdown_wait",
+	"wal_flush",
+	"promote",
+	"rejoin",
+	"siblings_follow",
+	"finalize"
+};
+static AdaptiveRate adaptive_rate;
 static char barman_command_buf[MAXLEN] = "";
 
 /*
@@ -115,6 +354,23 @@ static void initialise_direct_clone(t_node_info *local_node_record, t_node_info
 static int	run_basebackup(t_node_info *node_record);
 static int	run_file_backup(t_node_info *node_record);
 static int	run_pg_backupapi(t_node_info *node_record);
+static int	run_rsync_backup(t_node_info *node_record);
+
+static void check_rsync_sources(void);
+static void wait_for_rsync_sources(XLogRecPtr lsn);
+static void remove_rsync_source(int index);
+static bool copy_files_from_rsync_sources(const char *tablespace_oid, const char *dest_dir, int streams);
+static bool copy_wal_from_rsync_source(const char *labelfile, XLogRecPtr start_lsn, XLogRecPtr stop_lsn);
+static void make_rsync_host_string(const char *host, char *host_string);
+static void remove_unlisted_files(const char *dest_dir, TransferFile *files, int file_count);
+static int	remove_unlisted_file_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf);
+static void select_clone_source(void);
+static void clone_source_process_result(t_node_info *node_info, PGresult *res, void *arg);
+static bool get_provisioned_node_record(PGconn *primary_conn, NodeInfoList *existing_nodes, ProvisionSource *sources, int source_count, const char *host);
+static bool wait_for_pg_backupapi_operations(CURL *curl, operation_task **tasks, int task_count);
+static uint64 get_directory_size(const char *path);
+static int	directory_size_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf);
+static int	transfer_file_path_cmp(const void *a, const void *b);
 
 static void copy_configuration_files(bool delete_after_copy);
 
@@ -123,15 +379,54 @@ static void tablespace_data_append(TablespaceDataList *list, const char *name, c
 static void get_barman_property(char *dst, char *name, char *local_repmgr_directory);
 static int	get_tablespace_data_barman(char *, TablespaceDataList *);
 static char *make_barman_ssh_command(char *buf);
+static bool rsync_file_list(const char *file_list, const char *source_dir, const char *dest_dir, int streams);
+static bool rsync_file_list_parallel(const char *file_list, const char *source_dir, const char *dest_dir, int streams);
+static bool get_rsync_file_list(const char *command, TransferFile **files, int *file_count, uint64 *total_size);
+static void free_file_list(TransferFile *files, int file_count);
+static int	split_file_list(TransferFile *files, int file_count, int chunks, const char *chunk_prefix, uint64 *chunk_sizes);
+static bool run_rsync_tasks(t_command_task *tasks, int task_count, int max_parallel, uint64 total_size);
+static int	transfer_file_cmp(const void *a, const void *b);
+
+static void clone_progress_start(void);
+static void clone_progress_begin_unit(const char *unit);
+static void clone_progress_update(uint64 unit_copied_bytes, uint64 unit_total_bytes);
+static void clone_progress_end_unit(void);
+static void clone_progress_report(const char *event);
+static void clone_progress_finish(bool success);
+static void clone_progress_append_summary(PQExpBufferData *details);
+static bool get_last_output_line(PQExpBufferData *output, const char *marker, char *line, int line_len);
+static void rsync_tasks_progress_callback(t_command_task *tasks, int task_count, void *arg);
+static void basebackup_progress_callback(t_command_task *tasks, int task_count, void *arg);
+static void adaptive_rate_throttle(t_command_task *tasks, int task_count);
+static void make_rsync_bwlimit_option(int processes, char *buf);
+
+static void clone_manifest_init(const char *backup_id);
 
 static bool create_recovery_file(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, int server_version_num, char *dest, bool as_file);
 static void write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list);
+static bool _do_standby_follow_reload(PGconn *local_conn, t_node_info *local_node_record, t_conninfo_param_list *recovery_conninfo);
 
 static bool check_sibling_nodes(NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats);
 static bool check_free_wal_senders(int available_wal_senders, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success);
 static bool check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success);
 
-static void sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats);
+static void sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats, PQExpBufferData *details);
+static void sibling_follow_callback(t_command_task *task, void *arg);
+
+static void queue_switchover_prechecks(t_remote_agent *agent, PGconn *local_conn, PGconn *remote_conn, int local_node_id, int remote_repmgr_version);
+static bool switchover_remote_command(t_remote_agent *agent, t_node_info *remote_node_record, const char *remote_host, const char *request, PQExpBufferData *outputbuf);
+static void switchover_prepare(PGconn *local_conn, PGconn *superuser_conn, t_node_info *remote_node_record);
+static void switchover_estimate_downtime(PGconn *local_conn, t_remote_agent *agent, t_node_info *remote_node_record, const char *remote_host);
+static double time_switchover_remote_command(t_remote_agent *agent, t_node_info *remote_node_record, const char *remote_host);
+static void switchover_timing_start(void);
+static void adaptive_poll_start(AdaptivePoll *poll_state, int timeout);
+static bool adaptive_poll_wait(AdaptivePoll *poll_state);
+static int	adaptive_poll_elapsed(AdaptivePoll *poll_state);
+static bool adaptive_poll_log_due(AdaptivePoll *poll_state);
+static void switchover_phase_start(SwitchoverPhase phase);
+static void switchover_phase_end(void);
+static void switchover_timing_append(PQExpBufferData *buf);
+static void write_switchover_report(void);
 
 static t_remote_error_type parse_remote_error(const char *error);
 static CheckStatus parse_check_status(const char *status_str);
@@ -162,6 +457,15 @@ static CheckStatus parse_db_connection(const char *db_connection);
  *  --without-barman
  *  --replication-conf-only (--recovery-conf-only)
  *  --verify-backup (PostgreSQL 13 and later)
+ *  --parallel (Barman only)
+ *  --resume (Barman only)
+ *  --rsync-only
+ *  --rsync-sources
+ *  --delta
+ *  --progress-file
+ *  --max-rate
+ *  --adaptive-rate
+ *  --auto-source
  */
 
 void
@@ -236,6 +540,35 @@ do_standby_clone(void)
 		 */
 		check_barman_config();
 	}
+	else
+	{
+		if (runtime_options.parallel_provided == true && mode != parallel_rsync)
+		{
+			log_warning(_("--parallel is only effective when cloning from Barman or with --rsync-only"));
+		}
+
+		if (runtime_options.resume == true)
+		{
+			log_error(_("--resume can only be used when cloning from Barman"));
+			exit(ERR_BAD_CONFIG);
+		}
+	}
+
+	if (mode == parallel_rsync)
+	{
+		/* pg_verifybackup requires a backup manifest generated by pg_basebackup */
+		if (runtime_options.verify_backup == true)
+		{
+			log_error(_("--verify-backup option cannot be used together with --rsync-only"));
+			exit(ERR_BAD_CONFIG);
+		}
+
+		if (runtime_options.no_upstream_connection == true)
+		{
+			log_error(_("--no-upstream-connection option cannot be used together with --rsync-only"));
+			exit(ERR_BAD_CONFIG);
+		}
+	}
 
 	init_node_record(&local_node_record);
 	local_node_record.type = STANDBY;
@@ -340,6 +673,9 @@ do_standby_clone(void)
 		 * Will error out if source connection not possible and not in
 		 * "barman" mode.
 		 */
+		if (runtime_options.auto_source == true)
+			select_clone_source();
+
 		check_source_server();
 
 		if (runtime_options.verify_backup == true)
@@ -354,6 +690,22 @@ do_standby_clone(void)
 			}
 		}
 
+		/*
+		 * --rsync-only requires non-exclusive backups and temporary
+		 * replication slots, both of which are available from PostgreSQL 10
+		 */
+		if (mode == parallel_rsync)
+		{
+			if (PQserverVersion(source_conn) < 100000)
+			{
+				log_error(_("--rsync-only available for PostgreSQL 10 and later"));
+				exit(ERR_BAD_CONFIG);
+			}
+
+			/* will exit on error */
+			check_rsync_sources();
+		}
+
 		/* attempt to retrieve upstream node record */
 		record_status = get_node_record(source_conn,
 										upstream_node_id,
@@ -668,7 +1020,7 @@ do_standby_clone(void)
 			log_warning(_("unable to determine a valid upstream node id"));
 		}
 
-		if (mode == pg_basebackup && runtime_options.fast_checkpoint == false)
+		if ((mode == pg_basebackup || mode == parallel_rsync) && runtime_options.fast_checkpoint == false)
 		{
 			log_hint(_("consider using the -c/--fast-checkpoint option"));
 		}
@@ -689,12 +1041,55 @@ do_standby_clone(void)
 		exit(SUCCESS);
 	}
 
+	/* will exit if the progress file cannot be opened */
+	clone_progress_start();
+
+	if (runtime_options.adaptive_rate > 0)
+	{
+		if (mode == parallel_rsync)
+		{
+			memset(&adaptive_rate, 0, sizeof(AdaptiveRate));
+			adaptive_rate.enabled = true;
+			adaptive_rate.last_checkpoint_count = -1;
+		}
+		else if (mode == pg_basebackup)
+		{
+			/*
+			 * Pausing pg_basebackup would also pause its WAL streaming
+			 * process, risking "wal_sender_timeout" being exceeded.
+			 */
+			log_warning(_("--adaptive-rate has no effect when cloning with pg_basebackup"));
+			log_hint(_("use --max-rate to limit the rate of pg_basebackup's transfer"));
+		}
+		else
+		{
+			log_warning(_("--adaptive-rate has no effect when cloning from Barman"));
+			log_detail(_("the source node is not accessed while files are being copied"));
+		}
+	}
+
+	if (runtime_options.max_rate > 0 && mode == pg_backupapi)
+	{
+		log_warning(_("--max-rate is not supported when cloning with pg_backupapi"));
+	}
+
 	switch (mode)
 	{
 		case pg_basebackup:
 			initialise_direct_clone(&local_node_record, &upstream_node_record);
 			log_notice(_("starting backup (using pg_basebackup)..."));
 			break;
+		case parallel_rsync:
+			initialise_direct_clone(&local_node_record, &upstream_node_record);
+			if (delta_clone == true)
+			{
+				log_notice(_("starting backup (using rsync to update the existing data directory)..."));
+			}
+			else
+			{
+				log_notice(_("starting backup (using rsync)..."));
+			}
+			break;
 		case barman:
 			log_notice(_("retrieving backup from Barman..."));
 			break;
@@ -706,7 +1101,7 @@ do_standby_clone(void)
 			log_error(_("unknown clone mode"));
 	}
 
-	if (mode == pg_basebackup)
+	if (mode == pg_basebackup || mode == parallel_rsync)
 	{
 		if (runtime_options.fast_checkpoint == false)
 		{
@@ -719,6 +1114,9 @@ do_standby_clone(void)
 		case pg_basebackup:
 			r = run_basebackup(&local_node_record);
 			break;
+		case parallel_rsync:
+			r = run_rsync_backup(&local_node_record);
+			break;
 		case barman:
 			r = run_file_backup(&local_node_record);
 			break;
@@ -733,6 +1131,8 @@ do_standby_clone(void)
 	/* If the backup failed then exit */
 	if (r != SUCCESS)
 	{
+		clone_progress_finish(false);
+
 		/* If a replication slot was previously created, drop it */
 		if (config_file_options.use_replication_slots == true)
 		{
@@ -755,6 +1155,8 @@ do_standby_clone(void)
 		exit(r);
 	}
 
+	clone_progress_finish(true);
+
 	/*
 	 * Run pg_verifybackup here if requested, before any alterations are made
 	 * to the data directory.
@@ -852,6 +1254,9 @@ do_standby_clone(void)
 		case pg_backupapi:
 			log_notice(_("standby clone (from pg_backupapi) complete"));
 			break;
+		case parallel_rsync:
+			log_notice(_("standby clone (using rsync) complete"));
+			break;
 	}
 
 	/*
@@ -946,12 +1351,17 @@ do_standby_clone(void)
 		case pg_backupapi:
 			appendPQExpBufferStr(&event_details, "pg_backupapi");
 			break;
+		case parallel_rsync:
+			appendPQExpBufferStr(&event_details, delta_clone ? "rsync (delta)" : "rsync");
+			break;
 	}
 
 	appendPQExpBuffer(&event_details,
 					  _("; --force: %s"),
 					  runtime_options.force ? "Y" : "N");
 
+	clone_progress_append_summary(&event_details);
+
 	create_event_notification(primary_conn,
 							  &config_file_options,
 							  config_file_options.node_id,
@@ -1014,30 +1424,74 @@ check_barman_config(void)
 	 */
 	if (runtime_options.dry_run == false)
 	{
-		if (!create_pg_dir(local_data_directory, runtime_options.force))
-		{
-			log_error(_("unable to use directory %s"),
-					  local_data_directory);
-			log_hint(_("use -F/--force option to force this directory to be overwritten"));
-			exit(ERR_BAD_CONFIG);
-		}
-
-		/*
-		 * Create the local repmgr subdirectory
-		 */
-
 		maxlen_snprintf(local_repmgr_tmp_directory,
 						"%s/repmgr", local_data_directory);
 
 		maxlen_snprintf(datadir_list_filename,
 						"%s/data.txt", local_repmgr_tmp_directory);
 
-		if (!create_pg_dir(local_repmgr_tmp_directory, runtime_options.force))
+		maxlen_snprintf(clone_manifest_filename,
+						"%s/clone.manifest", local_repmgr_tmp_directory);
+
+		/*
+		 * If --resume was provided and an interrupted clone left a progress
+		 * manifest, retain the existing data directory contents.
+		 */
+		if (runtime_options.resume == true)
+		{
+			if (access(clone_manifest_filename, F_OK) == 0)
+			{
+				/*
+				 * The directory is not empty, so create_pg_dir() can't be used;
+				 * apply the checks relevant to an interrupted clone instead.
+				 */
+				if (is_pg_running(local_data_directory) == PG_DIR_RUNNING)
+				{
+					log_error(_("PostgreSQL is running in data directory \"%s\""),
+							  local_data_directory);
+					log_hint(_("--resume can only be used with the data directory of an interrupted clone"));
+					exit(ERR_BAD_CONFIG);
+				}
+
+				if (!set_dir_permissions(local_data_directory, UNKNOWN_SERVER_VERSION_NUM))
+				{
+					log_error(_("unable to use directory %s"),
+							  local_data_directory);
+					exit(ERR_BAD_CONFIG);
+				}
+
+				log_notice(_("resuming interrupted clone into data directory \"%s\""),
+						   local_data_directory);
+				resume_clone = true;
+			}
+			else
+			{
+				log_notice(_("no clone progress manifest found in \"%s\", starting new clone"),
+						   local_repmgr_tmp_directory);
+			}
+		}
+
+		if (resume_clone == false)
 		{
-			log_error(_("unable to create directory \"%s\""),
-					  local_repmgr_tmp_directory);
+			if (!create_pg_dir(local_data_directory, runtime_options.force))
+			{
+				log_error(_("unable to use directory %s"),
+						  local_data_directory);
+				log_hint(_("use -F/--force option to force this directory to be overwritten"));
+				exit(ERR_BAD_CONFIG);
+			}
 
-			exit(ERR_BAD_CONFIG);
+			/*
+			 * Create the local repmgr subdirectory
+			 */
+
+			if (!create_pg_dir(local_repmgr_tmp_directory, runtime_options.force))
+			{
+				log_error(_("unable to create directory \"%s\""),
+						  local_repmgr_tmp_directory);
+
+				exit(ERR_BAD_CONFIG);
+			}
 		}
 	}
 
@@ -1618,85 +2072,481 @@ _do_create_replication_conf(void)
 
 
 /*
- * do_standby_register()
+ * do_standby_provision()
+ *
+ * Clone, start and register a standby on each of the hosts provided with
+ * --hosts, using standbys which have already been provisioned as clone
+ * sources for the remaining hosts, so the primary is only read from once
+ * and the number of clone sources doubles (with the default of one clone
+ * per source) in each round.
+ *
+ * Each host must have a repmgr.conf file at the same location as the local
+ * node's, and be reachable via SSH. Each standby is attached to the primary,
+ * regardless of the node it was cloned from.
+ *
+ * Parameters:
+ *  --hosts
+ *  --parallel (number of concurrent clones from each source, default 1)
+ *  -c/--fast-checkpoint
+ *  --dry-run
  *
  * Event(s):
- *  - standby_register
- *  - standby_register_sync
+ *  - standby_provision
  */
-/*  XXX check --upstream-node-id works when re-registering */
-
 void
-do_standby_register(void)
+do_standby_provision(void)
 {
-	PGconn	   *conn = NULL;
+	PGconn	   *local_conn = NULL;
 	PGconn	   *primary_conn = NULL;
+	int			primary_node_id = UNKNOWN_NODE_ID;
+	t_node_info primary_node_record = T_NODE_INFO_INITIALIZER;
+	t_node_info remote_node_record = T_NODE_INFO_INITIALIZER;
+	NodeInfoList existing_nodes = T_NODE_INFO_LIST_INITIALIZER;
+
+	ProvisionTarget *targets = NULL;
+	int			target_count = 0;
+	ProvisionSource *sources = NULL;
+	int			source_count = 0;
+	int			pending_count = 0;
+	int			provisioned_count = 0;
+	int			clones_per_source = runtime_options.parallel_provided ? runtime_options.parallel : 1;
+	int			round = 0;
+	int			i;
 
-	bool		record_created = false;
-	t_node_info node_record = T_NODE_INFO_INITIALIZER;
-	RecordStatus record_status = RECORD_NOT_FOUND;
+	char	   *hosts = NULL;
+	char	   *host = NULL;
 
-	PQExpBufferData details;
+	PQExpBufferData event_details;
+	instr_time	start_time;
+	instr_time	elapsed_time;
 
-	/* so we can pass info about the primary to event notification scripts */
-	t_event_info event_info = T_EVENT_INFO_INITIALIZER;
-	t_node_info primary_node_record = T_NODE_INFO_INITIALIZER;
-	int primary_node_id = UNKNOWN_NODE_ID;
+	if (runtime_options.hosts[0] == '\0')
+	{
+		log_error(_("--hosts must be provided when executing STANDBY PROVISION"));
+		exit(ERR_BAD_CONFIG);
+	}
 
-	bool		dry_run_ok = true;
+	log_info(_("connecting to local node"));
+	local_conn = establish_db_connection(config_file_options.conninfo, true);
 
-	log_info(_("connecting to local node \"%s\" (ID: %i)"),
-			 config_file_options.node_name,
-			 config_file_options.node_id);
+	log_info(_("connecting to primary database"));
+	primary_conn = get_primary_connection(local_conn, &primary_node_id, NULL);
 
-	conn = establish_db_connection_quiet(config_file_options.conninfo);
+	if (PQstatus(primary_conn) != CONNECTION_OK)
+	{
+		log_error(_("unable to connect to primary server"));
+		PQfinish(local_conn);
+		exit(ERR_BAD_CONFIG);
+	}
+
+	if (get_node_record(primary_conn, primary_node_id, &primary_node_record) != RECORD_FOUND)
+	{
+		log_error(_("unable to retrieve record for primary node %i"), primary_node_id);
+		PQfinish(primary_conn);
+		PQfinish(local_conn);
+		exit(ERR_BAD_CONFIG);
+	}
 
 	/*
-	 * If unable to connect, and --force not provided, wait up to --wait-start
-	 * seconds (default: 0) for the node to become reachable.
-	 *
-	 * Not that if --force provided, we don't wait for the node to start, as
-	 * the normal use case will be re-registering an existing node, or
-	 * registering an inactive/not-yet-extant one; we'll do the
-	 * error handling for those cases in the next code block
+	 * Note the nodes which already exist, so each newly registered standby
+	 * can be identified by its host.
 	 */
-	if (PQstatus(conn) != CONNECTION_OK && runtime_options.force == false)
-	{
-		bool		conn_ok = false;
-		int			timer = 0;
+	get_all_node_records(primary_conn, &existing_nodes);
 
-		for (;;)
-		{
-			if (timer == runtime_options.wait_start)
-				break;
+	hosts = pg_strdup(runtime_options.hosts);
+	targets = pg_malloc0(sizeof(ProvisionTarget) * (strlen(hosts) / 2 + 1));
 
-			sleep(1);
+	for (host = strtok(hosts, ","); host != NULL; host = strtok(NULL, ","))
+	{
+		host = trim(host);
 
-			log_verbose(LOG_INFO, _("%i of %i connection attempts"),
-						timer + 1,
-						runtime_options.wait_start);
+		if (host[0] == '\0')
+			continue;
 
-			conn = establish_db_connection_quiet(config_file_options.conninfo);
+		strncpy(targets[target_count].host, host, MAXLEN - 1);
+		targets[target_count].status = PROVISION_PENDING;
+		target_count++;
+	}
 
-			if (PQstatus(conn) == CONNECTION_OK)
-			{
-				conn_ok = true;
-				break;
-			}
+	pfree(hosts);
 
-			timer++;
-		}
+	if (target_count == 0)
+	{
+		log_error(_("no hosts provided with --hosts"));
+		PQfinish(primary_conn);
+		PQfinish(local_conn);
+		exit(ERR_BAD_CONFIG);
+	}
 
-		if (conn_ok == true)
+	/* the remote repmgr.conf is expected at the same location as this node's */
+	strncpy(remote_node_record.config_file, config_file_path, MAXPGPATH);
+
+	for (i = 0; i < target_count; i++)
+	{
+		if (test_ssh_connection(targets[i].host, runtime_options.remote_user) != 0)
 		{
-			log_info(_("connected to local node \"%s\" (ID: %i) after %i seconds"),
-					 config_file_options.node_name,
-					 config_file_options.node_id,
-					 timer);
+			log_error(_("unable to connect via SSH to host \"%s\", user \"%s\""),
+					  targets[i].host, runtime_options.remote_user);
+			PQfinish(primary_conn);
+			PQfinish(local_conn);
+			exit(ERR_BAD_CONFIG);
 		}
 	}
 
-	/*
+	/* each provisioned standby becomes a source; the primary is the first */
+	sources = pg_malloc0(sizeof(ProvisionSource) * (target_count + 1));
+
+	sources[0].node_id = primary_node_id;
+	strncpy(sources[0].name, primary_node_record.node_name, MAXLEN);
+	strncpy(sources[0].conninfo, primary_node_record.conninfo, MAXLEN);
+	source_count = 1;
+
+	pending_count = target_count;
+
+	log_notice(_("provisioning %i standbys, with up to %i concurrent clones from each source"),
+			   target_count, clones_per_source);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	while (pending_count > 0)
+	{
+		t_command_task *tasks = NULL;
+		int		   *task_targets = NULL;
+		int			task_count = 0;
+		int			slots = source_count * clones_per_source;
+
+		round++;
+
+		tasks = pg_malloc0(sizeof(t_command_task) * slots);
+		task_targets = pg_malloc0(sizeof(int) * slots);
+
+		for (i = 0; i < target_count && task_count < slots; i++)
+		{
+			PQExpBufferData remote_command_str;
+			PQExpBufferData ssh_command;
+			ProvisionSource *source = &sources[task_count / clones_per_source];
+
+			if (targets[i].status != PROVISION_PENDING)
+				continue;
+
+			/* the commands are quoted so they are all executed on the remote host */
+			initPQExpBuffer(&remote_command_str);
+			appendPQExpBufferChar(&remote_command_str, '"');
+
+			/*
+			 * As in do_standby_switchover(), the source's connection string
+			 * is coerced into "param=value" format to simplify escaping.
+			 */
+			{
+				char	   *conninfo_normalized = normalize_conninfo_string(source->conninfo);
+
+				make_remote_repmgr_path(&remote_command_str, &remote_node_record);
+				appendPQExpBufferStr(&remote_command_str, "standby clone -d ");
+				appendDoubleQuotedRemoteShellString(&remote_command_str, conninfo_normalized);
+				appendPQExpBuffer(&remote_command_str,
+								  " --upstream-node-id=%i%s && ",
+								  primary_node_id,
+								  runtime_options.fast_checkpoint ? " --fast-checkpoint" : "");
+
+				pfree(conninfo_normalized);
+			}
+
+			make_remote_repmgr_path(&remote_command_str, &remote_node_record);
+			appendPQExpBufferStr(&remote_command_str,
+								 "node service --action=start && ");
+
+			make_remote_repmgr_path(&remote_command_str, &remote_node_record);
+			appendPQExpBuffer(&remote_command_str,
+							  "standby register --upstream-node-id=%i --wait-start=%i\"",
+							  primary_node_id,
+							  runtime_options.wait_start);
+
+			initPQExpBuffer(&ssh_command);
+			make_remote_command(targets[i].host,
+								runtime_options.remote_user,
+								remote_command_str.data,
+								config_file_options.ssh_options,
+								&ssh_command);
+
+			if (runtime_options.dry_run == true)
+			{
+				log_info(_("round %i: would clone host \"%s\" from \"%s\""),
+						 round, targets[i].host, source->name);
+			}
+			else
+			{
+				log_info(_("round %i: cloning host \"%s\" from \"%s\""),
+						 round, targets[i].host, source->name);
+			}
+
+			log_verbose(LOG_DEBUG, "do_standby_provision():\n  %s", ssh_command.data);
+
+			init_command_task(&tasks[task_count], i, ssh_command.data);
+			task_targets[task_count] = i;
+			task_count++;
+
+			termPQExpBuffer(&remote_command_str);
+			termPQExpBuffer(&ssh_command);
+		}
+
+		if (runtime_options.dry_run == false)
+			(void) execute_commands_parallel(tasks, task_count, task_count, 0, NULL, NULL);
+
+		for (i = 0; i < task_count; i++)
+		{
+			ProvisionTarget *target = &targets[task_targets[i]];
+
+			pending_count--;
+
+			if (runtime_options.dry_run == true)
+			{
+				target->status = PROVISION_SUCCEEDED;
+				sources[source_count].node_id = UNKNOWN_NODE_ID;
+				strncpy(sources[source_count].name, target->host, MAXLEN - 1);
+				source_count++;
+				continue;
+			}
+
+			if (tasks[i].success == false)
+			{
+				target->status = PROVISION_FAILED;
+				log_error(_("unable to provision standby on host \"%s\""), target->host);
+
+				if (tasks[i].output.data[0] != '\0')
+					log_detail("%s", tasks[i].output.data);
+
+				term_command_task(&tasks[i]);
+				continue;
+			}
+
+			term_command_task(&tasks[i]);
+
+			target->status = PROVISION_SUCCEEDED;
+			provisioned_count++;
+
+			if (get_provisioned_node_record(primary_conn, &existing_nodes, sources, source_count, target->host) == true)
+			{
+				log_notice(_("standby on host \"%s\" provisioned as node \"%s\""),
+						   target->host, sources[source_count].name);
+				source_count++;
+			}
+			else
+			{
+				log_warning(_("no new node record found for host \"%s\""), target->host);
+				log_detail(_("the standby will not be used as a clone source"));
+			}
+		}
+
+		pfree(tasks);
+		pfree(task_targets);
+	}
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+
+	clear_node_info_list(&existing_nodes);
+
+	if (runtime_options.dry_run == true)
+	{
+		log_info(_("%i standbys would be provisioned in %i rounds"), target_count, round);
+		pfree(targets);
+		pfree(sources);
+		PQfinish(primary_conn);
+		PQfinish(local_conn);
+		return;
+	}
+
+	initPQExpBuffer(&event_details);
+	appendPQExpBuffer(&event_details,
+					  _("%i of %i standbys provisioned in %i rounds (%.0f seconds)"),
+					  provisioned_count,
+					  target_count,
+					  round,
+					  INSTR_TIME_GET_DOUBLE(elapsed_time));
+
+	if (provisioned_count < target_count)
+	{
+		appendPQExpBufferStr(&event_details, _("; failed hosts:"));
+
+		for (i = 0; i < target_count; i++)
+		{
+			if (targets[i].status == PROVISION_FAILED)
+				appendPQExpBuffer(&event_details, " %s", targets[i].host);
+		}
+	}
+
+	create_event_notification(primary_conn,
+							  &config_file_options,
+							  config_file_options.node_id,
+							  "standby_provision",
+							  provisioned_count == target_count ? true : false,
+							  event_details.data);
+
+	if (provisioned_count == target_count)
+	{
+		log_notice("%s", event_details.data);
+	}
+	else
+	{
+		log_error("%s", event_details.data);
+	}
+
+	termPQExpBuffer(&event_details);
+
+	pfree(targets);
+	pfree(sources);
+	PQfinish(primary_conn);
+	PQfinish(local_conn);
+
+	if (provisioned_count < target_count)
+		exit(ERR_PROVISION_FAIL);
+}
+
+
+/*
+ * get_provisioned_node_record()
+ *
+ * Find the record of the standby registered by "standby provision" on
+ * "host", i.e. a node whose conninfo's host matches, which was not present
+ * in "existing_nodes" and is not one of the "source_count" entries of
+ * "sources", and store it in the next entry of "sources".
+ */
+static bool
+get_provisioned_node_record(PGconn *primary_conn, NodeInfoList *existing_nodes, ProvisionSource *sources, int source_count, const char *host)
+{
+	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *cell = NULL;
+	bool		found = false;
+
+	if (get_all_node_records(primary_conn, &nodes) == false)
+		return false;
+
+	for (cell = nodes.head; cell && found == false; cell = cell->next)
+	{
+		NodeInfoListCell *existing_cell = NULL;
+		char		node_host[MAXLEN] = "";
+		bool		existing = false;
+		int			i;
+
+		if (cell->node_info->type != STANDBY)
+			continue;
+
+		if (get_conninfo_value(cell->node_info->conninfo, "host", node_host) == false
+			|| strcmp(node_host, host) != 0)
+			continue;
+
+		for (existing_cell = existing_nodes->head; existing_cell; existing_cell = existing_cell->next)
+		{
+			if (existing_cell->node_info->node_id == cell->node_info->node_id)
+			{
+				existing = true;
+				break;
+			}
+		}
+
+		/* several standbys may have been provisioned on the same host */
+		for (i = 0; i < source_count && existing == false; i++)
+		{
+			if (sources[i].node_id == cell->node_info->node_id)
+				existing = true;
+		}
+
+		if (existing == true)
+			continue;
+
+		sources[source_count].node_id = cell->node_info->node_id;
+		strncpy(sources[source_count].name, cell->node_info->node_name, MAXLEN);
+		strncpy(sources[source_count].conninfo, cell->node_info->conninfo, MAXLEN);
+
+		found = true;
+	}
+
+	clear_node_info_list(&nodes);
+
+	return found;
+}
+
+
+/*
+ * do_standby_register()
+ *
+ * Event(s):
+ *  - standby_register
+ *  - standby_register_sync
+ */
+/*  XXX check --upstream-node-id works when re-registering */
+
+void
+do_standby_register(void)
+{
+	PGconn	   *conn = NULL;
+	PGconn	   *primary_conn = NULL;
+
+	bool		record_created = false;
+	t_node_info node_record = T_NODE_INFO_INITIALIZER;
+	RecordStatus record_status = RECORD_NOT_FOUND;
+
+	PQExpBufferData details;
+
+	/* so we can pass info about the primary to event notification scripts */
+	t_event_info event_info = T_EVENT_INFO_INITIALIZER;
+	t_node_info primary_node_record = T_NODE_INFO_INITIALIZER;
+	int primary_node_id = UNKNOWN_NODE_ID;
+
+	bool		dry_run_ok = true;
+
+	log_info(_("connecting to local node \"%s\" (ID: %i)"),
+			 config_file_options.node_name,
+			 config_file_options.node_id);
+
+	conn = establish_db_connection_quiet(config_file_options.conninfo);
+
+	/*
+	 * If unable to connect, and --force not provided, wait up to --wait-start
+	 * seconds (default: 0) for the node to become reachable.
+	 *
+	 * Not that if --force provided, we don't wait for the node to start, as
+	 * the normal use case will be re-registering an existing node, or
+	 * registering an inactive/not-yet-extant one; we'll do the
+	 * error handling for those cases in the next code block
+	 */
+	if (PQstatus(conn) != CONNECTION_OK && runtime_options.force == false)
+	{
+		bool		conn_ok = false;
+		int			timer = 0;
+
+		for (;;)
+		{
+			if (timer == runtime_options.wait_start)
+				break;
+
+			sleep(1);
+
+			log_verbose(LOG_INFO, _("%i of %i connection attempts"),
+						timer + 1,
+						runtime_options.wait_start);
+
+			conn = establish_db_connection_quiet(config_file_options.conninfo);
+
+			if (PQstatus(conn) == CONNECTION_OK)
+			{
+				conn_ok = true;
+				break;
+			}
+
+			timer++;
+		}
+
+		if (conn_ok == true)
+		{
+			log_info(_("connected to local node \"%s\" (ID: %i) after %i seconds"),
+					 config_file_options.node_name,
+					 config_file_options.node_id,
+					 timer);
+		}
+	}
+
+	/*
 	 * If still unable to connect, continue only if -F/--force provided,
 	 * and primary connection parameters provided.
 	 */
@@ -2633,7 +3483,7 @@ do_standby_promote(void)
 	 */
 	if (runtime_options.siblings_follow == true && sibling_nodes.node_count > 0)
 	{
-		sibling_nodes_follow(&local_node_record, &sibling_nodes, &sibling_nodes_stats);
+		sibling_nodes_follow(&local_node_record, &sibling_nodes, &sibling_nodes_stats, NULL);
 	}
 
 	clear_node_info_list(&sibling_nodes);
@@ -2645,9 +3495,11 @@ do_standby_promote(void)
 static void
 _do_standby_promote_internal(PGconn *conn)
 {
-	int			i;
 	bool		promote_success = false;
 	PQExpBufferData details;
+	AdaptivePoll poll_state;
+	instr_time	promote_start;
+	instr_time	promote_time;
 
 	RecoveryType recovery_type = RECTYPE_UNKNOWN;
 
@@ -2679,8 +3531,15 @@ _do_standby_promote_internal(PGconn *conn)
 	 * we'll poll the server until the default timeout (60 seconds)
 	 *
 	 * For PostgreSQL 12+, use the pg_promote() function, unless one of
-	 * "service_promote_command" or "use_pg_ctl_promote" is set.
+	 * "service_promote_command" or "use_pg_ctl_promote" is set; it waits
+	 * for the promotion to complete, so no polling is required.
 	 */
+	log_notice(_("waiting up to %i seconds (parameter \"promote_check_timeout\") for promotion to complete"),
+			   config_file_options.promote_check_timeout);
+
+	INSTR_TIME_SET_CURRENT(promote_start);
+	adaptive_poll_start(&poll_state, config_file_options.promote_check_timeout);
+
 	{
 		bool use_pg_promote = false;
 
@@ -2710,11 +3569,14 @@ _do_standby_promote_internal(PGconn *conn)
 					   local_node_record.node_id);
 
 			/*
-			 * We'll check for promotion success ourselves, but will abort
-			 * if some unrecoverable error prevented the function from being
-			 * executed.
+			 * pg_promote() returns true as soon as the promotion has
+			 * completed; if it returns false, either the promotion did not
+			 * complete within "promote_check_timeout", or an error prevented
+			 * the function from being executed, which is determined below.
 			 */
-			if (!promote_standby(conn, false, 0))
+			promote_success = promote_standby(conn, true, config_file_options.promote_check_timeout);
+
+			if (promote_success == false && adaptive_poll_elapsed(&poll_state) < config_file_options.promote_check_timeout)
 			{
 				log_error(_("unable to promote server from standby to primary"));
 				exit(ERR_PROMOTION_FAIL);
@@ -2741,10 +3603,13 @@ _do_standby_promote_internal(PGconn *conn)
 		}
 	}
 
-	log_notice(_("waiting up to %i seconds (parameter \"promote_check_timeout\") for promotion to complete"),
-			   config_file_options.promote_check_timeout);
+	/*
+	 * Otherwise poll the server, initially at short intervals so the
+	 * promotion is detected promptly, backing off to "promote_check_interval"
+	 */
+	poll_state.max_interval_ms = config_file_options.promote_check_interval * 1000L;
 
-	for (i = 0; i < config_file_options.promote_check_timeout; i += config_file_options.promote_check_interval)
+	while (promote_success == false)
 	{
 		recovery_type = get_recovery_type(conn);
 
@@ -2753,7 +3618,9 @@ _do_standby_promote_internal(PGconn *conn)
 			promote_success = true;
 			break;
 		}
-		sleep(config_file_options.promote_check_interval);
+
+		if (adaptive_poll_wait(&poll_state) == false)
+			break;
 	}
 
 	if (promote_success == false)
@@ -2774,7 +3641,11 @@ _do_standby_promote_internal(PGconn *conn)
 		}
 	}
 
-	log_verbose(LOG_INFO, _("standby promoted to primary after %i second(s)"), i);
+	INSTR_TIME_SET_CURRENT(promote_time);
+	INSTR_TIME_SUBTRACT(promote_time, promote_start);
+
+	log_verbose(LOG_INFO, _("standby promoted to primary after %.0f ms"),
+				INSTR_TIME_GET_MILLISEC(promote_time));
 
 	/* update node information to reflect new status */
 	if (update_node_record_set_primary(conn, config_file_options.node_id) == false)
@@ -3433,28 +4304,71 @@ do_standby_follow_internal(PGconn *primary_conn, PGconn *follow_target_conn, t_n
 	log_notice(_("setting node %i's upstream to node %i"),
 			   config_file_options.node_id, follow_target_node_record->node_id);
 
-	if (!create_recovery_file(&local_node_record,
-							  &recovery_conninfo,
-							  PQserverVersion(primary_conn),
-							  config_file_options.data_directory,
-							  true))
-	{
-		*error_code = general_error_code;
-		return false;
-	}
-
 	/*
-	 * start/restart the service
+	 * PostgreSQL 13 and later: if the node is running as a standby, change the
+	 * replication configuration with ALTER SYSTEM and reload it, so the node
+	 * follows the new upstream without a restart, retaining the contents of
+	 * shared buffers and client sessions. If this is not possible, fall back
+	 * to writing the configuration and signalling or restarting the server.
 	 */
-
+	if (PQserverVersion(primary_conn) >= 130000 && config_file_options.standby_follow_restart == false)
 	{
-		char		server_command[MAXLEN] = "";
-		bool		server_up = is_server_available(config_file_options.conninfo);
-		char	   *action = NULL;
-		bool		success;
-
-		PQExpBufferData output_buf;
-		initPQExpBuffer(&output_buf);
+		PGconn	   *local_conn = NULL;
+		bool		reloaded = false;
+
+		if (runtime_options.superuser[0] != '\0')
+		{
+			local_conn = establish_db_connection_with_replacement_param(config_file_options.conninfo,
+																		"user",
+																		runtime_options.superuser,
+																		false);
+		}
+		else
+		{
+			local_conn = establish_db_connection_quiet(config_file_options.conninfo);
+		}
+
+		if (PQstatus(local_conn) == CONNECTION_OK && get_recovery_type(local_conn) == RECTYPE_STANDBY)
+		{
+			if (can_alter_replication_config(local_conn) == true)
+			{
+				reloaded = _do_standby_follow_reload(local_conn, &local_node_record, &recovery_conninfo);
+			}
+			else
+			{
+				log_verbose(LOG_INFO, _("user \"%s\" is not permitted to change the replication configuration with ALTER SYSTEM"),
+							PQuser(local_conn));
+			}
+		}
+
+		PQfinish(local_conn);
+
+		if (reloaded == true)
+			goto cleanup;
+	}
+
+	if (!create_recovery_file(&local_node_record,
+							  &recovery_conninfo,
+							  PQserverVersion(primary_conn),
+							  config_file_options.data_directory,
+							  true))
+	{
+		*error_code = general_error_code;
+		return false;
+	}
+
+	/*
+	 * start/restart the service
+	 */
+
+	{
+		char		server_command[MAXLEN] = "";
+		bool		server_up = is_server_available(config_file_options.conninfo);
+		char	   *action = NULL;
+		bool		success;
+
+		PQExpBufferData output_buf;
+		initPQExpBuffer(&output_buf);
 
 		if (server_up == true)
 		{
@@ -3616,6 +4530,99 @@ cleanup:
 }
 
 
+/*
+ * _do_standby_follow_reload()
+ *
+ * PostgreSQL 13 and later: set "primary_conninfo" (and "primary_slot_name",
+ * if replication slots are in use) with ALTER SYSTEM and reload the
+ * configuration; PostgreSQL then restarts the WAL receiver with the new
+ * settings, without restarting the server.
+ *
+ * If the WAL receiver has not been restarted within
+ * FOLLOW_RELOAD_WAL_RECEIVER_TIMEOUT seconds, and a superuser connection is
+ * available, the WAL receiver is restarted explicitly.
+ *
+ * Returns false if the configuration could not be changed, in which case
+ * the caller should fall back to writing the configuration directly.
+ */
+static bool
+_do_standby_follow_reload(PGconn *local_conn, t_node_info *local_node_record, t_conninfo_param_list *recovery_conninfo)
+{
+	PQExpBufferData primary_conninfo_buf;
+	pid_t		wal_receiver_pid = UNKNOWN_PID;
+	pid_t		new_wal_receiver_pid = UNKNOWN_PID;
+	AdaptivePoll poll_state;
+
+	initPQExpBuffer(&primary_conninfo_buf);
+	write_primary_conninfo(&primary_conninfo_buf, recovery_conninfo);
+
+	wal_receiver_pid = get_wal_receiver_pid(local_conn);
+
+	log_notice(_("updating replication configuration with ALTER SYSTEM"));
+
+	if (alter_system_str(local_conn, "primary_conninfo", primary_conninfo_buf.data) == false)
+	{
+		termPQExpBuffer(&primary_conninfo_buf);
+		return false;
+	}
+
+	termPQExpBuffer(&primary_conninfo_buf);
+
+	if (config_file_options.use_replication_slots)
+	{
+		if (alter_system_str(local_conn, "primary_slot_name", local_node_record->slot_name) == false)
+			return false;
+	}
+
+	if (pg_reload_conf(local_conn) == false)
+		return false;
+
+	/*
+	 * The startup process restarts the WAL receiver when "primary_conninfo"
+	 * or "primary_slot_name" changes; if the WAL receiver was not running
+	 * (e.g. because the previous upstream is not available), any WAL
+	 * receiver now running was started with the new settings.
+	 */
+	adaptive_poll_start(&poll_state, FOLLOW_RELOAD_WAL_RECEIVER_TIMEOUT);
+
+	do
+	{
+		new_wal_receiver_pid = get_wal_receiver_pid(local_conn);
+
+		if (new_wal_receiver_pid == UNKNOWN_PID)
+			break;
+
+		if (new_wal_receiver_pid > 0 && new_wal_receiver_pid != wal_receiver_pid)
+		{
+			log_info(_("WAL receiver restarted with PID %i"), (int) new_wal_receiver_pid);
+			return true;
+		}
+	} while (adaptive_poll_wait(&poll_state) == true);
+
+	if (is_superuser_connection(local_conn, NULL) == false)
+	{
+		log_warning(_("WAL receiver was not restarted after %i seconds"),
+					FOLLOW_RELOAD_WAL_RECEIVER_TIMEOUT);
+		log_detail(_("the updated replication configuration will be applied when the WAL receiver next restarts"));
+		return true;
+	}
+
+	log_notice(_("WAL receiver was not restarted after %i seconds, restarting it explicitly"),
+			   FOLLOW_RELOAD_WAL_RECEIVER_TIMEOUT);
+
+	(void) disable_wal_receiver(local_conn);
+
+	new_wal_receiver_pid = enable_wal_receiver(local_conn, true);
+
+	if (new_wal_receiver_pid == UNKNOWN_PID)
+	{
+		log_warning(_("unable to confirm the WAL receiver has been restarted"));
+	}
+
+	return true;
+}
+
+
 /*
  * Perform a switchover by:
  *
@@ -3661,6 +4668,8 @@ do_standby_switchover(void)
 	RecoveryType recovery_type = RECTYPE_UNKNOWN;
 	PQExpBufferData remote_command_str;
 	PQExpBufferData command_output;
+	t_remote_agent remote_agent = T_REMOTE_AGENT_INITIALIZER;
+	AdaptivePoll poll_state;
 	PQExpBufferData node_rejoin_options;
 	PQExpBufferData logmsg;
 	PQExpBufferData detailmsg;
@@ -3702,6 +4711,8 @@ do_standby_switchover(void)
 	 */
 	sibling_nodes_stats.min_required_wal_senders = 1;
 
+	switchover_timing_start();
+
 	/*
 	 * SANITY CHECKS
 	 *
@@ -3858,6 +4869,7 @@ do_standby_switchover(void)
 	}
 
 	record_status = get_node_record(remote_conn, remote_node_id, &remote_node_record);
+	switchover_timing.demotion_candidate_node_id = remote_node_id;
 
 	if (record_status != RECORD_FOUND)
 	{
@@ -4060,147 +5072,189 @@ do_standby_switchover(void)
 		termPQExpBuffer(&msg);
 	}
 
-	/* check remote repmgr binary can be found */
+	/*
+	 * Start "repmgr node agent" on the demotion candidate, so the remote
+	 * repmgr commands needed from here on can be executed over a single SSH
+	 * connection. The agent reports its repmgr version when it starts, and
+	 * can only start if the expected configuration file exists.
+	 */
 	initPQExpBuffer(&remote_command_str);
 	make_remote_repmgr_path(&remote_command_str, &remote_node_record);
+	appendPQExpBufferStr(&remote_command_str, "node agent");
 
-	/*
-	 * Here we're executing an arbitrary repmgr command which is guaranteed to
-	 * succeed if repmgr is executed. We'll extract the actual version number in the
-	 * next step.
-	 */
-	appendPQExpBufferStr(&remote_command_str, "--version >/dev/null 2>&1 && echo \"1\" || echo \"0\"");
-	initPQExpBuffer(&command_output);
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
+	if (start_remote_agent(remote_host,
+						   runtime_options.remote_user,
+						   remote_command_str.data,
+						   config_file_options.ssh_options,
+						   Max(SWITCHOVER_AGENT_RESPONSE_TIMEOUT, config_file_options.shutdown_check_timeout),
+						   &remote_agent) == true)
+	{
+		remote_repmgr_version = remote_agent.repmgr_version;
 
-	termPQExpBuffer(&remote_command_str);
+		log_verbose(LOG_INFO, _("started \"%s node agent\" on \"%s\""),
+					progname(), remote_host);
+		log_debug(_("\"%s\" version on \"%s\" is %i"),
+				  progname(), remote_host, remote_repmgr_version);
 
-	if (command_success == false || command_output.data[0] == '0')
+		/* submit all prechecks at once, their results are read below */
+		queue_switchover_prechecks(&remote_agent,
+								   local_conn,
+								   remote_conn,
+								   local_node_record.node_id,
+								   remote_repmgr_version);
+	}
+	else
 	{
-		PQExpBufferData hint;
+		log_verbose(LOG_INFO, _("unable to start \"%s node agent\" on \"%s\", executing remote commands individually"),
+					progname(), remote_host);
+	}
 
-		log_error(_("unable to execute \"%s\" on \"%s\""),
-				  progname(), remote_host);
+	termPQExpBuffer(&remote_command_str);
 
-		if (strlen(command_output.data) > 2)
-			log_detail("%s", command_output.data);
+	if (remote_agent.active == false)
+	{
+		/* check remote repmgr binary can be found */
+		initPQExpBuffer(&remote_command_str);
+		make_remote_repmgr_path(&remote_command_str, &remote_node_record);
 
-		termPQExpBuffer(&command_output);
+		/*
+		 * Here we're executing an arbitrary repmgr command which is guaranteed to
+		 * succeed if repmgr is executed. We'll extract the actual version number in the
+		 * next step.
+		 */
+		appendPQExpBufferStr(&remote_command_str, "--version >/dev/null 2>&1 && echo \"1\" || echo \"0\"");
+		initPQExpBuffer(&command_output);
+		command_success = remote_command(remote_host,
+										 runtime_options.remote_user,
+										 remote_command_str.data,
+										 config_file_options.ssh_options,
+										 &command_output);
 
-		initPQExpBuffer(&hint);
-		appendPQExpBufferStr(&hint,
-							 _("check \"pg_bindir\" is set to the correct path in \"repmgr.conf\"; current value: "));
+		termPQExpBuffer(&remote_command_str);
 
-		if (strlen(config_file_options.pg_bindir))
+		if (command_success == false || command_output.data[0] == '0')
 		{
-			appendPQExpBuffer(&hint,
-							  "\"%s\"", config_file_options.pg_bindir);
-		}
-		else
-		{
-			appendPQExpBufferStr(&hint,
-								 "(not set)");
-		}
-
-		log_hint("%s", hint.data);
+			PQExpBufferData hint;
 
-		termPQExpBuffer(&hint);
+			log_error(_("unable to execute \"%s\" on \"%s\""),
+					  progname(), remote_host);
 
-		PQfinish(remote_conn);
-		PQfinish(local_conn);
+			if (strlen(command_output.data) > 2)
+				log_detail("%s", command_output.data);
 
-		exit(ERR_BAD_CONFIG);
-	}
+			termPQExpBuffer(&command_output);
 
-	termPQExpBuffer(&command_output);
+			initPQExpBuffer(&hint);
+			appendPQExpBufferStr(&hint,
+								 _("check \"pg_bindir\" is set to the correct path in \"repmgr.conf\"; current value: "));
 
-	/*
-	 * Now we're sure the binary can be executed, fetch its version number.
-	 */
-	initPQExpBuffer(&remote_command_str);
-	make_remote_repmgr_path(&remote_command_str, &remote_node_record);
+			if (strlen(config_file_options.pg_bindir))
+			{
+				appendPQExpBuffer(&hint,
+								  "\"%s\"", config_file_options.pg_bindir);
+			}
+			else
+			{
+				appendPQExpBufferStr(&hint,
+									 "(not set)");
+			}
 
-	appendPQExpBufferStr(&remote_command_str, "--version 2>/dev/null");
-	initPQExpBuffer(&command_output);
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
+			log_hint("%s", hint.data);
 
-	termPQExpBuffer(&remote_command_str);
+			termPQExpBuffer(&hint);
 
-	if (command_success == true)
-	{
-		remote_repmgr_version = parse_repmgr_version(command_output.data);
-		if (remote_repmgr_version == UNKNOWN_REPMGR_VERSION_NUM)
-		{
-			log_error(_("unable to parse \"%s\"'s reported version on \"%s\""),
-					  progname(), remote_host);
 			PQfinish(remote_conn);
 			PQfinish(local_conn);
+
 			exit(ERR_BAD_CONFIG);
 		}
-		log_debug(_("\"%s\" version on \"%s\" is %i"),
-				  progname(), remote_host, remote_repmgr_version );
-
-	}
-	else
-	{
-		log_error(_("unable to execute \"%s\" on \"%s\""),
-				  progname(), remote_host);
-
-		if (strlen(command_output.data) > 2)
-			log_detail("%s", command_output.data);
 
 		termPQExpBuffer(&command_output);
 
-		PQfinish(remote_conn);
-		PQfinish(local_conn);
+		/*
+		 * Now we're sure the binary can be executed, fetch its version number.
+		 */
+		initPQExpBuffer(&remote_command_str);
+		make_remote_repmgr_path(&remote_command_str, &remote_node_record);
 
-		exit(ERR_BAD_CONFIG);
-	}
+		appendPQExpBufferStr(&remote_command_str, "--version 2>/dev/null");
+		initPQExpBuffer(&command_output);
+		command_success = remote_command(remote_host,
+										 runtime_options.remote_user,
+										 remote_command_str.data,
+										 config_file_options.ssh_options,
+										 &command_output);
 
-	termPQExpBuffer(&command_output);
+		termPQExpBuffer(&remote_command_str);
 
-	/*
-	 * Check if the expected remote repmgr.conf file exists
-	 */
-	initPQExpBuffer(&remote_command_str);
+		if (command_success == true)
+		{
+			remote_repmgr_version = parse_repmgr_version(command_output.data);
+			if (remote_repmgr_version == UNKNOWN_REPMGR_VERSION_NUM)
+			{
+				log_error(_("unable to parse \"%s\"'s reported version on \"%s\""),
+						  progname(), remote_host);
+				PQfinish(remote_conn);
+				PQfinish(local_conn);
+				exit(ERR_BAD_CONFIG);
+			}
+			log_debug(_("\"%s\" version on \"%s\" is %i"),
+					  progname(), remote_host, remote_repmgr_version );
 
-	appendPQExpBuffer(&remote_command_str,
-					  "test -f %s && echo 1 || echo 0",
-					  remote_node_record.config_file);
-	initPQExpBuffer(&command_output);
+		}
+		else
+		{
+			log_error(_("unable to execute \"%s\" on \"%s\""),
+					  progname(), remote_host);
 
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
+			if (strlen(command_output.data) > 2)
+				log_detail("%s", command_output.data);
 
-	termPQExpBuffer(&remote_command_str);
+			termPQExpBuffer(&command_output);
 
-	if (command_success == false || command_output.data[0] == '0')
-	{
-		log_error(_("expected configuration file not found on the demotion candidate \"%s\" (ID: %i)"),
-				  remote_node_record.node_name,
-				  remote_node_record.node_id);
-		log_detail(_("registered configuration file is \"%s\""),
-				   remote_node_record.config_file);
-		log_hint(_("ensure the configuration file is in the expected location, or re-register \"%s\" to update the configuration file location"),
-				  remote_node_record.node_name);
+			PQfinish(remote_conn);
+			PQfinish(local_conn);
 
-		PQfinish(remote_conn);
-		PQfinish(local_conn);
+			exit(ERR_BAD_CONFIG);
+		}
 
 		termPQExpBuffer(&command_output);
 
-		exit(ERR_BAD_CONFIG);
+		/*
+		 * Check if the expected remote repmgr.conf file exists
+		 */
+		initPQExpBuffer(&remote_command_str);
+
+		appendPQExpBuffer(&remote_command_str,
+						  "test -f %s && echo 1 || echo 0",
+						  remote_node_record.config_file);
+		initPQExpBuffer(&command_output);
+
+		command_success = remote_command(remote_host,
+										 runtime_options.remote_user,
+										 remote_command_str.data,
+										 config_file_options.ssh_options,
+										 &command_output);
+
+		termPQExpBuffer(&remote_command_str);
+
+		if (command_success == false || command_output.data[0] == '0')
+		{
+			log_error(_("expected configuration file not found on the demotion candidate \"%s\" (ID: %i)"),
+					  remote_node_record.node_name,
+					  remote_node_record.node_id);
+			log_detail(_("registered configuration file is \"%s\""),
+					   remote_node_record.config_file);
+			log_hint(_("ensure the configuration file is in the expected location, or re-register \"%s\" to update the configuration file location"),
+					  remote_node_record.node_name);
+
+			PQfinish(remote_conn);
+			PQfinish(local_conn);
+
+			termPQExpBuffer(&command_output);
+
+			exit(ERR_BAD_CONFIG);
+		}
 	}
 
 
@@ -4211,24 +5265,17 @@ do_standby_switchover(void)
 	 * directory after the remote (demotion candidate) has shut down.
 	 */
 
-	initPQExpBuffer(&remote_command_str);
-	make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-
 	/*
 	 * --data-directory-config is available from repmgr 4.3; it will fail
 	 * if the remote repmgr is an earlier version, but the version should match
 	 * anyway.
 	 */
-	appendPQExpBufferStr(&remote_command_str, "node check --data-directory-config --optformat -LINFO 2>/dev/null");
-
 	initPQExpBuffer(&command_output);
-	command_success = remote_command(remote_host,
-									 runtime_options.remote_user,
-									 remote_command_str.data,
-									 config_file_options.ssh_options,
-									 &command_output);
-
-	termPQExpBuffer(&remote_command_str);
+	command_success = switchover_remote_command(&remote_agent,
+												&remote_node_record,
+												remote_host,
+												SWITCHOVER_DATA_DIRECTORY_CONFIG_CHECK,
+												&command_output);
 
 	if (command_success == false)
 	{
@@ -4338,18 +5385,16 @@ do_standby_switchover(void)
 		CheckStatus status = CHECK_STATUS_UNKNOWN;
 
 		initPQExpBuffer(&remote_command_str);
-		make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-
 		appendPQExpBuffer(&remote_command_str,
-						  "node check --db-connection --superuser=%s --optformat -LINFO 2>/dev/null",
+						  SWITCHOVER_SUPERUSER_CHECK,
 						  runtime_options.superuser);
 
 		initPQExpBuffer(&command_output);
-		command_success = remote_command(remote_host,
-										 runtime_options.remote_user,
-										 remote_command_str.data,
-										 config_file_options.ssh_options,
-										 &command_output);
+		command_success = switchover_remote_command(&remote_agent,
+													&remote_node_record,
+													remote_host,
+													remote_command_str.data,
+													&command_output);
 
 		termPQExpBuffer(&remote_command_str);
 
@@ -4417,19 +5462,12 @@ do_standby_switchover(void)
 
 	if (PQserverVersion(local_conn) >= 120000 && remote_repmgr_version >= 50100)
 	{
-		initPQExpBuffer(&remote_command_str);
-		make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-
-		appendPQExpBufferStr(&remote_command_str, "node check --replication-config-owner --optformat -LINFO 2>/dev/null");
-
 		initPQExpBuffer(&command_output);
-		command_success = remote_command(remote_host,
-										 runtime_options.remote_user,
-										 remote_command_str.data,
-										 config_file_options.ssh_options,
-										 &command_output);
-
-		termPQExpBuffer(&remote_command_str);
+		command_success = switchover_remote_command(&remote_agent,
+													&remote_node_record,
+													remote_host,
+													SWITCHOVER_REPLICATION_CONFIG_OWNER_CHECK,
+													&command_output);
 
 		if (command_success == false)
 		{
@@ -4512,18 +5550,17 @@ do_standby_switchover(void)
 	/* check demotion candidate can make replication connection to promotion candidate */
 	{
 		initPQExpBuffer(&remote_command_str);
-		make_remote_repmgr_path(&remote_command_str, &remote_node_record);
 		appendPQExpBuffer(&remote_command_str,
-						  "node check --remote-node-id=%i --replication-connection",
+						  SWITCHOVER_REPLICATION_CONNECTION_CHECK,
 						  local_node_record.node_id);
 
 		initPQExpBuffer(&command_output);
 
-		command_success = remote_command(remote_host,
-										 runtime_options.remote_user,
-										 remote_command_str.data,
-										 config_file_options.ssh_options,
-										 &command_output);
+		command_success = switchover_remote_command(&remote_agent,
+													&remote_node_record,
+													remote_host,
+													remote_command_str.data,
+													&command_output);
 
 		termPQExpBuffer(&remote_command_str);
 
@@ -4566,20 +5603,13 @@ do_standby_switchover(void)
 			int			threshold = 0;
 			t_remote_error_type remote_error = REMOTE_ERROR_NONE;
 
-			initPQExpBuffer(&remote_command_str);
-			make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-			appendPQExpBufferStr(&remote_command_str,
-								 "node check --terse -LERROR --archive-ready --optformat");
-
 			initPQExpBuffer(&command_output);
 
-			command_success = remote_command(remote_host,
-											 runtime_options.remote_user,
-											 remote_command_str.data,
-											 config_file_options.ssh_options,
-											 &command_output);
-
-			termPQExpBuffer(&remote_command_str);
+			command_success = switchover_remote_command(&remote_agent,
+														&remote_node_record,
+														remote_host,
+														SWITCHOVER_ARCHIVE_READY_CHECK,
+														&command_output);
 
 			if (command_success == true)
 			{
@@ -4974,6 +6004,11 @@ do_standby_switchover(void)
 	/*
 	 * Sanity checks completed - prepare for the switchover
 	 */
+	switchover_phase_start(SWITCHOVER_PHASE_PREPARE);
+
+	switchover_prepare(local_conn, superuser_conn, &remote_node_record);
+
+	switchover_phase_start(SWITCHOVER_PHASE_CHECKPOINT_AND_STOP);
 
 	if (runtime_options.dry_run == true)
 	{
@@ -5006,8 +6041,6 @@ do_standby_switchover(void)
 	initPQExpBuffer(&remote_command_str);
 	initPQExpBuffer(&command_output);
 
-	make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-
 	if (runtime_options.dry_run == true)
 	{
 		appendPQExpBufferStr(&remote_command_str,
@@ -5032,11 +6065,11 @@ do_standby_switchover(void)
 
 	/* XXX handle failure */
 
-	(void) remote_command(remote_host,
-						  runtime_options.remote_user,
-						  remote_command_str.data,
-						  config_file_options.ssh_options,
-						  &command_output);
+	(void) switchover_remote_command(&remote_agent,
+									 &remote_node_record,
+									 remote_host,
+									 remote_command_str.data,
+									 &command_output);
 
 	termPQExpBuffer(&remote_command_str);
 
@@ -5062,6 +6095,8 @@ do_standby_switchover(void)
 		log_info(_("parameter \"shutdown_check_timeout\" is set to %i seconds"),
 				 config_file_options.shutdown_check_timeout);
 
+		switchover_estimate_downtime(local_conn, &remote_agent, &remote_node_record, remote_host);
+
 		clear_node_info_list(&sibling_nodes);
 
 		key_value_list_free(&remote_config_files);
@@ -5074,6 +6109,7 @@ do_standby_switchover(void)
 		}
 
 		log_info(_("prerequisites for executing STANDBY SWITCHOVER are met"));
+		switchover_timing.result = "success";
 
 		exit(SUCCESS);
 	}
@@ -5081,15 +6117,67 @@ do_standby_switchover(void)
 	termPQExpBuffer(&command_output);
 	shutdown_success = false;
 
+	switchover_phase_start(SWITCHOVER_PHASE_SHUTDOWN_WAIT);
+
 	/* loop for timeout waiting for current primary to stop */
 
-	for (i = 0; i < config_file_options.shutdown_check_timeout; i++)
+	adaptive_poll_start(&poll_state, config_file_options.shutdown_check_timeout);
+
+	/*
+	 * If the agent is available, it paces the loop by waiting on the demotion
+	 * candidate for up to SWITCHOVER_AGENT_WAIT_SHUTDOWN_SLICE milliseconds
+	 * in each iteration, so keep the loop's own sleep to a minimum.
+	 */
+	if (remote_agent.active == true)
+		poll_state.max_interval_ms = ADAPTIVE_POLL_MIN_INTERVAL;
+
+	do
 	{
 		/* Check whether primary is available */
 		PGPing		ping_res;
+		bool		log_due = false;
+
+		/*
+		 * Have the agent wait for PostgreSQL to remove "postmaster.pid", which
+		 * it can detect within a few milliseconds; it returns immediately if
+		 * the postmaster is no longer running but left the file in place. In
+		 * either case the shutdown status is then confirmed as usual below.
+		 */
+		if (remote_agent.active == true)
+		{
+			PQExpBufferData request;
+			int			wait_result = -1;
+
+			initPQExpBuffer(&request);
+			appendPQExpBuffer(&request, "%s %i",
+							  REMOTE_AGENT_WAIT_SHUTDOWN,
+							  SWITCHOVER_AGENT_WAIT_SHUTDOWN_SLICE);
+
+			if (remote_agent_command(&remote_agent, request.data, NULL, &wait_result) == true
+				&& wait_result != REMOTE_AGENT_WAIT_SHUTDOWN_TIMEOUT)
+			{
+				log_verbose(LOG_DEBUG, "postmaster on demotion candidate %s after %i seconds",
+							wait_result == REMOTE_AGENT_WAIT_SHUTDOWN_DONE
+							? "removed \"postmaster.pid\""
+							: "no longer running but \"postmaster.pid\" present",
+							adaptive_poll_elapsed(&poll_state));
+			}
+
+			termPQExpBuffer(&request);
 
-		log_info(_("checking for primary shutdown; %i of %i attempts (\"shutdown_check_timeout\")"),
-				 i + 1, config_file_options.shutdown_check_timeout);
+			/* agent session failed; the loop must now pace itself */
+			if (remote_agent.active == false)
+				poll_state.max_interval_ms = ADAPTIVE_POLL_MAX_INTERVAL;
+		}
+
+		log_due = adaptive_poll_log_due(&poll_state);
+
+		if (log_due == true)
+		{
+			log_info(_("checking for primary shutdown; %i of %i seconds (\"shutdown_check_timeout\")"),
+					 adaptive_poll_elapsed(&poll_state),
+					 config_file_options.shutdown_check_timeout);
+		}
 
 		ping_res = PQping(remote_conninfo);
 
@@ -5105,20 +6193,13 @@ do_standby_switchover(void)
 			 * return the last checkpoint LSN.
 			 */
 
-			initPQExpBuffer(&remote_command_str);
-			make_remote_repmgr_path(&remote_command_str, &remote_node_record);
-			appendPQExpBufferStr(&remote_command_str,
-								 "node status --is-shutdown-cleanly");
-
 			initPQExpBuffer(&command_output);
 
-			command_success = remote_command(remote_host,
-											 runtime_options.remote_user,
-											 remote_command_str.data,
-											 config_file_options.ssh_options,
-											 &command_output);
-
-			termPQExpBuffer(&remote_command_str);
+			command_success = switchover_remote_command(&remote_agent,
+														&remote_node_record,
+														remote_host,
+														SWITCHOVER_SHUTDOWN_STATUS_CHECK,
+														&command_output);
 
 			if (command_success == true)
 			{
@@ -5149,7 +6230,7 @@ do_standby_switchover(void)
 					shutdown_success = true;
 					break;
 				}
-				else if (status == NODE_STATUS_SHUTTING_DOWN)
+				else if (status == NODE_STATUS_SHUTTING_DOWN && log_due == true)
 				{
 					log_info(_("remote node is still shutting down"));
 				}
@@ -5157,10 +6238,10 @@ do_standby_switchover(void)
 
 			termPQExpBuffer(&command_output);
 		}
+	} while (adaptive_poll_wait(&poll_state) == true);
 
-		log_debug("sleeping 1 second until next check");
-		sleep(1);
-	}
+	/* no further commands will be executed via the agent */
+	stop_remote_agent(&remote_agent);
 
 	if (shutdown_success == false)
 	{
@@ -5187,6 +6268,8 @@ do_standby_switchover(void)
 		log_verbose(LOG_INFO, _("successfully reconnected to local node"));
 	}
 
+	switchover_phase_start(SWITCHOVER_PHASE_WAL_FLUSH);
+
 	init_replication_info(&replication_info);
 	/*
 	 * Compare standby's last WAL receive location with the primary's last
@@ -5196,7 +6279,9 @@ do_standby_switchover(void)
 	{
 		bool notice_emitted = false;
 
-		for (i = 0; i < config_file_options.wal_receive_check_timeout; i++)
+		adaptive_poll_start(&poll_state, config_file_options.wal_receive_check_timeout);
+
+		do
 		{
 			get_replication_info(local_conn, STANDBY, &replication_info);
 			if (replication_info.last_wal_receive_lsn >= remote_last_checkpoint_lsn)
@@ -5214,10 +6299,13 @@ do_standby_switchover(void)
 				notice_emitted = true;
 			}
 
-			log_info(_("sleeping %i of maximum %i seconds waiting for standby to flush received WAL to disk"),
-					 i + 1, config_file_options.wal_receive_check_timeout);
-			sleep(1);
-		}
+			if (adaptive_poll_log_due(&poll_state) == true)
+			{
+				log_info(_("waited %i of maximum %i seconds for standby to flush received WAL to disk"),
+						 adaptive_poll_elapsed(&poll_state),
+						 config_file_options.wal_receive_check_timeout);
+			}
+		} while (adaptive_poll_wait(&poll_state) == true);
 	}
 
 	if (replication_info.last_wal_receive_lsn < remote_last_checkpoint_lsn)
@@ -5242,6 +6330,8 @@ do_standby_switchover(void)
 			  format_lsn(replication_info.last_wal_receive_lsn),
 			  format_lsn(remote_last_checkpoint_lsn));
 
+	switchover_phase_start(SWITCHOVER_PHASE_PROMOTE);
+
 	/*
 	 * optionally add a delay before promoting the standby; this is mainly
 	 * useful for testing (e.g. for reappearance of the original primary) and
@@ -5307,6 +6397,8 @@ do_standby_switchover(void)
 		}
 	}
 
+	switchover_phase_start(SWITCHOVER_PHASE_REJOIN);
+
 	/*
 	 * Execute "repmgr node rejoin" to create recovery.conf and start the
 	 * remote server. Additionally execute "pg_rewind", if required and
@@ -5556,6 +6648,24 @@ do_standby_switchover(void)
 						  detailmsg.data);
 	}
 
+	/*
+	 * If --siblings-follow specified, attempt to make them follow the new
+	 * primary; this is done before the event notification is created so the
+	 * result for each sibling can be recorded in the event details.
+	 */
+	if (runtime_options.siblings_follow == true && sibling_nodes.node_count > 0)
+	{
+		switchover_phase_start(SWITCHOVER_PHASE_SIBLINGS_FOLLOW);
+		sibling_nodes_follow(&local_node_record, &sibling_nodes, &sibling_nodes_stats, &event_details);
+	}
+
+	clear_node_info_list(&sibling_nodes);
+
+	/* record the time taken by each phase up to and including sibling follow */
+	switchover_phase_end();
+	appendPQExpBufferChar(&event_details, '\n');
+	switchover_timing_append(&event_details);
+
 
 	create_event_notification_extended(local_conn,
 									   &config_file_options,
@@ -5571,34 +6681,37 @@ do_standby_switchover(void)
 	termPQExpBuffer(&command_output);
 
 
-	/*
-	 * If --siblings-follow specified, attempt to make them follow the new
-	 * primary
-	 */
-	if (runtime_options.siblings_follow == true && sibling_nodes.node_count > 0)
-	{
-		sibling_nodes_follow(&local_node_record, &sibling_nodes, &sibling_nodes_stats);
-	}
-
-	clear_node_info_list(&sibling_nodes);
-
 	/*
 	 * Clean up remote node (primary demoted to standby). It's possible that the node is
 	 * still starting up, so poll for a while until we get a connection.
 	 */
+	switchover_phase_start(SWITCHOVER_PHASE_FINALIZE);
+
+	remote_conn = NULL;
 
-	for (i = 0; i < config_file_options.standby_reconnect_timeout; i++)
+	adaptive_poll_start(&poll_state, config_file_options.standby_reconnect_timeout);
+
+	do
 	{
-		remote_conn = establish_db_connection(remote_node_record.conninfo, false);
+		/* PQping() is cheap, and quiet while the node is starting up */
+		if (PQping(remote_node_record.conninfo) == PQPING_OK)
+		{
+			remote_conn = establish_db_connection(remote_node_record.conninfo, false);
 
-		if (PQstatus(remote_conn) == CONNECTION_OK)
-			break;
+			if (PQstatus(remote_conn) == CONNECTION_OK)
+				break;
 
-		log_info(_("sleeping 1 second; %i of %i attempts (\"standby_reconnect_timeout\") to reconnect to demoted primary"),
-				 i + 1,
-				 config_file_options.standby_reconnect_timeout);
-		sleep(1);
-	}
+			PQfinish(remote_conn);
+			remote_conn = NULL;
+		}
+
+		if (adaptive_poll_log_due(&poll_state) == true)
+		{
+			log_info(_("waiting to reconnect to demoted primary; %i of %i seconds (\"standby_reconnect_timeout\")"),
+					 adaptive_poll_elapsed(&poll_state),
+					 config_file_options.standby_reconnect_timeout);
+		}
+	} while (adaptive_poll_wait(&poll_state) == true);
 
 	/* check new standby (old primary) is reachable */
 	if (PQstatus(remote_conn) != CONNECTION_OK)
@@ -5747,6 +6860,19 @@ do_standby_switchover(void)
 		clear_node_info_list(&all_nodes);
 	}
 
+	switchover_phase_end();
+
+	{
+		PQExpBufferData timings;
+
+		initPQExpBuffer(&timings);
+		switchover_timing_append(&timings);
+		log_info("%s", timings.data);
+		termPQExpBuffer(&timings);
+	}
+
+	switchover_timing.result = switchover_success == true ? "success" : "incomplete";
+
 	if (switchover_success == true)
 	{
 		log_notice(_("STANDBY SWITCHOVER has completed successfully"));
@@ -5762,6 +6888,232 @@ do_standby_switchover(void)
 }
 
 
+/*
+ * select_clone_source()
+ *
+ * With --auto-source, retrieve the node records from the node specified
+ * with the connection parameters, query all active primary and standby
+ * nodes in parallel, and replace the host and port in the source
+ * connection parameters with those of the most suitable clone source.
+ *
+ * Candidates are scored (lower is better) according to:
+ *
+ * - location: nodes in a different location to this node's are only
+ *   selected if no node in the same location is available, to avoid
+ *   cross-datacentre traffic
+ * - role: standbys are preferred over the primary, to avoid adding I/O
+ *   load to the primary
+ * - activity: concurrent base backups, WAL senders and active sessions
+ * - replication lag: a standby's replay lag behind the primary, so the
+ *   new standby does not start significantly behind
+ */
+static void
+select_clone_source(void)
+{
+	PGconn	   *conn = NULL;
+	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *cell = NULL;
+	CloneSourceContext context;
+	CloneSourceCandidate *best = NULL;
+	XLogRecPtr	primary_lsn = InvalidXLogRecPtr;
+	PQExpBufferData query;
+	char		host[MAXLEN] = "";
+	char		port[MAXLEN] = "";
+	int			server_version_num = UNKNOWN_SERVER_VERSION_NUM;
+	int			i = 0;
+
+	log_info(_("retrieving node records to select a clone source"));
+
+	conn = establish_db_connection_by_params(&source_conninfo, false);
+
+	if (PQstatus(conn) != CONNECTION_OK)
+	{
+		log_error(_("unable to connect to the node specified to retrieve node records from"));
+		PQfinish(conn);
+		exit(ERR_DB_CONN);
+	}
+
+	server_version_num = PQserverVersion(conn);
+
+	if (get_all_node_records(conn, &nodes) == false || nodes.node_count == 0)
+	{
+		log_error(_("unable to retrieve node records"));
+		log_hint(_("--auto-source requires a connection to a registered node"));
+		PQfinish(conn);
+		exit(ERR_BAD_CONFIG);
+	}
+
+	PQfinish(conn);
+
+	context.candidate_count = nodes.node_count;
+	context.candidates = pg_malloc0(sizeof(CloneSourceCandidate) * nodes.node_count);
+
+	for (cell = nodes.head; cell; cell = cell->next)
+		context.candidates[i++].node_info = cell->node_info;
+
+	(void) establish_db_connections_parallel(&nodes,
+											 nodes.node_count,
+											 runtime_options.timeout);
+
+	initPQExpBuffer(&query);
+
+	if (server_version_num >= 100000)
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT pg_catalog.pg_is_in_recovery(), "
+							 "       CASE WHEN pg_catalog.pg_is_in_recovery() "
+							 "         THEN pg_catalog.pg_last_wal_replay_lsn() "
+							 "         ELSE pg_catalog.pg_current_wal_lsn() "
+							 "       END, "
+							 "       (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_replication), "
+							 "       (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_replication "
+							 "         WHERE state = 'backup'), "
+							 "       (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_activity "
+							 "         WHERE state = 'active' AND backend_type = 'client backend' "
+							 "           AND pid != pg_catalog.pg_backend_pid()) ");
+	}
+	else
+	{
+		appendPQExpBufferStr(&query,
+							 "SELECT pg_catalog.pg_is_in_recovery(), "
+							 "       CASE WHEN pg_catalog.pg_is_in_recovery() "
+							 "         THEN pg_catalog.pg_last_xlog_replay_location() "
+							 "         ELSE pg_catalog.pg_current_xlog_location() "
+							 "       END, "
+							 "       (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_replication), "
+							 "       (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_replication "
+							 "         WHERE state = 'backup'), "
+							 "       (SELECT pg_catalog.count(*) FROM pg_catalog.pg_stat_activity "
+							 "         WHERE state = 'active' AND pid != pg_catalog.pg_backend_pid()) ");
+	}
+
+	log_debug("select_clone_source():\n%s", query.data);
+
+	(void) execute_query_parallel(&nodes, query.data, runtime_options.timeout,
+								  clone_source_process_result, &context);
+
+	termPQExpBuffer(&query);
+
+	for (i = 0; i < context.candidate_count; i++)
+	{
+		if (context.candidates[i].available == true && context.candidates[i].in_recovery == false)
+			primary_lsn = context.candidates[i].lsn;
+	}
+
+	for (i = 0; i < context.candidate_count; i++)
+	{
+		CloneSourceCandidate *candidate = &context.candidates[i];
+		t_node_info *node_info = candidate->node_info;
+		uint64		lag_mb = 0;
+
+		close_connection(&node_info->conn);
+
+		if (candidate->available == false)
+		{
+			log_verbose(LOG_INFO, _("node \"%s\" (ID: %i) is not available as a clone source"),
+						node_info->node_name, node_info->node_id);
+			continue;
+		}
+
+		if (candidate->in_recovery == true && primary_lsn != InvalidXLogRecPtr && primary_lsn > candidate->lsn)
+			lag_mb = (primary_lsn - candidate->lsn) / (1024 * 1024);
+
+		candidate->score = candidate->backups * AUTO_SOURCE_BACKUP_WEIGHT
+			+ candidate->wal_senders * AUTO_SOURCE_WAL_SENDER_WEIGHT
+			+ candidate->active_backends
+			+ (int) Min(lag_mb, AUTO_SOURCE_MAX_LAG_SCORE);
+
+		if (candidate->in_recovery == false)
+			candidate->score += AUTO_SOURCE_PRIMARY_PENALTY;
+
+		if (strcmp(node_info->location, config_file_options.location) != 0)
+			candidate->score += AUTO_SOURCE_LOCATION_PENALTY;
+
+		log_info(_("candidate node \"%s\" (ID: %i): location \"%s\", %s, %lu MB behind primary, "
+				   "%i WAL senders (%i base backups), %i active sessions; score %i"),
+				 node_info->node_name,
+				 node_info->node_id,
+				 node_info->location,
+				 candidate->in_recovery ? "standby" : "primary",
+				 lag_mb,
+				 candidate->wal_senders,
+				 candidate->backups,
+				 candidate->active_backends,
+				 candidate->score);
+
+		if (best == NULL || candidate->score < best->score)
+			best = candidate;
+	}
+
+	if (best == NULL)
+	{
+		log_error(_("no suitable clone source found"));
+		log_hint(_("provide the clone source with -h/--host and omit --auto-source"));
+		exit(ERR_BAD_CONFIG);
+	}
+
+	log_notice(_("selected node \"%s\" (ID: %i) as clone source"),
+			   best->node_info->node_name, best->node_info->node_id);
+
+	/* retain any other parameters (user, dbname etc.) provided by the user */
+	if (get_conninfo_value(best->node_info->conninfo, "host", host) == true)
+	{
+		param_set(&source_conninfo, "host", host);
+		strncpy(runtime_options.host, host, MAXLEN);
+	}
+
+	if (get_conninfo_value(best->node_info->conninfo, "port", port) == true)
+	{
+		param_set(&source_conninfo, "port", port);
+		strncpy(runtime_options.port, port, MAXLEN);
+	}
+
+	pfree(context.candidates);
+	clear_node_info_list(&nodes);
+}
+
+
+/*
+ * Callback for execute_query_parallel(): record the state of a candidate
+ * clone source.
+ */
+static void
+clone_source_process_result(t_node_info *node_info, PGresult *res, void *arg)
+{
+	CloneSourceContext *context = (CloneSourceContext *) arg;
+	CloneSourceCandidate *candidate = NULL;
+	int			i;
+
+	for (i = 0; i < context->candidate_count; i++)
+	{
+		if (context->candidates[i].node_info == node_info)
+		{
+			candidate = &context->candidates[i];
+			break;
+		}
+	}
+
+	if (candidate == NULL)
+		return;
+
+	if (res == NULL || PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) != 1)
+		return;
+
+	/* only active primaries and standbys, other than this node, are eligible */
+	if (node_info->active == false
+		|| (node_info->type != PRIMARY && node_info->type != STANDBY)
+		|| node_info->node_id == config_file_options.node_id)
+		return;
+
+	candidate->in_recovery = (strcmp(PQgetvalue(res, 0, 0), "t") == 0) ? true : false;
+	candidate->lsn = parse_lsn(PQgetvalue(res, 0, 1));
+	candidate->wal_senders = atoi(PQgetvalue(res, 0, 2));
+	candidate->backups = atoi(PQgetvalue(res, 0, 3));
+	candidate->active_backends = atoi(PQgetvalue(res, 0, 4));
+	candidate->available = true;
+}
+
+
 static void
 check_source_server()
 {
@@ -5969,7 +7321,39 @@ check_source_server()
 	 * Note: a previous call to check_dir() will have checked whether it contains
 	 * a running PostgreSQL instance.
 	 */
-	if (is_pg_dir(local_data_directory))
+	if (is_pg_dir(local_data_directory) && runtime_options.delta == true)
+	{
+		uint64		local_system_identifier = get_system_identifier(local_data_directory);
+
+		/*
+		 * A data directory from another cluster can be overwritten with
+		 * -F/--force, but there is no point in comparing its contents.
+		 */
+		if (local_system_identifier != system_identifier(source_conn))
+		{
+			if (runtime_options.force == false)
+			{
+				log_error(_("target data directory does not belong to the source node's replication cluster"));
+				log_detail(_("target data directory is \"%s\""), local_data_directory);
+				log_hint(_("use -F/--force to overwrite the existing data directory"));
+				PQfinish(source_conn);
+				exit(ERR_BAD_CONFIG);
+			}
+
+			log_warning(_("target data directory does not belong to the source node's replication cluster and will be overwritten"));
+		}
+		else
+		{
+			delta_clone = true;
+
+			if (runtime_options.dry_run == true)
+			{
+				log_info(_("existing data directory \"%s\" will be updated from the source node"),
+						 local_data_directory);
+			}
+		}
+	}
+	else if (is_pg_dir(local_data_directory))
 	{
 		const char *msg = _("target data directory appears to be a PostgreSQL data directory");
 		const char *hint = _("use -F/--force to overwrite the existing data directory");
@@ -6703,10 +8087,11 @@ initialise_direct_clone(t_node_info *local_node_record, t_node_info *upstream_no
 {
 	/*
 	 * Check the destination data directory can be used (in Barman mode, this
-	 * directory will already have been created)
+	 * directory will already have been created; with --delta, the existing
+	 * directory's contents will be updated)
 	 */
 
-	if (!create_pg_dir(local_data_directory, runtime_options.force))
+	if (delta_clone == false && !create_pg_dir(local_data_directory, runtime_options.force))
 	{
 		log_error(_("unable to use directory \"%s\""),
 				  local_data_directory);
@@ -6830,8 +8215,8 @@ run_basebackup(t_node_info *node_record)
 {
 	PQExpBufferData params;
 	PQExpBufferData script;
+	t_command_task task;
 
-	int			r = SUCCESS;
 
 	TablespaceListCell *cell = NULL;
 	t_basebackup_options backup_options = T_BASEBACKUP_OPTIONS_INITIALIZER;
@@ -6993,6 +8378,11 @@ run_basebackup(t_node_info *node_record)
 
 	termPQExpBuffer(&params);
 
+	if (runtime_options.max_rate > 0)
+	{
+		appendPQExpBuffer(&script, " --max-rate=%ik", runtime_options.max_rate);
+	}
+
 	if (runtime_options.dry_run == true)
 	{
 		log_info(_("would execute:\n  %s"), script.data);
@@ -7000,18 +8390,54 @@ run_basebackup(t_node_info *node_record)
 		return SUCCESS;
 	}
 
+	/*
+	 * pg_basebackup's progress report (written to stderr) is used to track
+	 * the clone's progress; any other output is logged if it fails.
+	 */
+	appendPQExpBufferStr(&script, " --progress 2>&1");
+
 	log_info(_("executing:\n  %s"), script.data);
 
+	init_command_task(&task, 0, script.data);
+	termPQExpBuffer(&script);
+
+	clone_progress_begin_unit("base backup");
+
+	(void) execute_commands_parallel_progress(&task, 1, 1, 1000,
+											  basebackup_progress_callback, NULL);
+
+	basebackup_progress_callback(&task, 1, NULL);
+
 	/*
 	 * As of 9.4, pg_basebackup only ever returns 0 or 1
 	 */
+	if (task.success == false)
+	{
+		PQExpBufferData output;
+		char	   *line = NULL;
 
-	r = system(script.data);
+		initPQExpBuffer(&output);
 
-	termPQExpBuffer(&script);
+		for (line = strtok(task.output.data, "\r\n"); line != NULL; line = strtok(NULL, "\r\n"))
+		{
+			if (strstr(line, " kB (") == NULL)
+				appendPQExpBuffer(&output, "%s\n", line);
+		}
+
+		log_error(_("pg_basebackup failed (return value: %i)"), task.return_value);
+
+		if (output.len > 0)
+			log_detail("%s", output.data);
+
+		termPQExpBuffer(&output);
+		term_command_task(&task);
 
-	if (r != 0)
 		return ERR_BAD_BASEBACKUP;
+	}
+
+	term_command_task(&task);
+
+	clone_progress_end_unit();
 
 	/* check connections are still available */
 	(void)connection_ping_reconnect(primary_conn);
@@ -7165,6 +8591,9 @@ run_file_backup(t_node_info *local_node_record)
 	PQExpBufferData tablespace_map;
 	bool		tablespace_map_rewrite = false;
 
+	/* number of concurrent rsync processes to use for each file list */
+	int			transfer_streams = runtime_options.parallel_provided ? runtime_options.parallel : 1;
+
 	/* For the foreseeable future, no other modes are supported */
 	Assert(mode == barman);
 	if (mode == barman)
@@ -7178,21 +8607,27 @@ run_file_backup(t_node_info *local_node_record)
 		get_barman_property(basebackups_directory, "basebackups_directory", local_repmgr_tmp_directory);
 
 		/*
-		 * Read the list of backup files into a local file. In the process:
+		 * Stream the list of backup files into one local file per unit
+		 * (data directory and each tablespace), in a single pass. In the
+		 * process:
 		 *
 		 * - determine the backup ID
 		 * - check, and remove, the prefix
 		 * - detect tablespaces
 		 * - filter files in one list per tablespace
+		 *
+		 * Lines are read with read_text_line(), so there is no limit on the
+		 * length of Barman's paths.
 		 */
 		{
 			FILE	   *fi;		/* input stream */
 			FILE	   *fd;		/* output for data.txt */
-			char		prefix[MAXLEN] = "";
-			char		output[MAXLEN] = "";
+			PQExpBufferData prefix;
+			PQExpBufferData output;
 			int			n = 0;
 			char	   *p = NULL,
 					   *q = NULL;
+			int			list_status = 0;
 
 			maxlen_snprintf(command, "%s list-files --target=data %s latest",
 							make_barman_ssh_command(barman_command_buf),
@@ -7214,19 +8649,22 @@ run_file_backup(t_node_info *local_node_record)
 				exit(ERR_BARMAN);
 			}
 
-			maxlen_snprintf(prefix, "%s/", basebackups_directory);
+			initPQExpBuffer(&prefix);
+			initPQExpBuffer(&output);
+
+			appendPQExpBuffer(&prefix, "%s/", basebackups_directory);
 
-			while (fgets(output, MAXLEN, fi) != NULL)
+			while (read_text_line(fi, &output) == true)
 			{
 				/*
 				 * Remove prefix
 				 */
-				p = string_skip_prefix(prefix, output);
+				p = string_skip_prefix(prefix.data, output.data);
 
 				if (p == NULL)
 				{
 					log_error("unexpected output from \"barman list-files\"");
-					log_detail("%s", output);
+					log_detail("%s", output.data);
 					exit(ERR_BARMAN);
 				}
 
@@ -7236,23 +8674,20 @@ run_file_backup(t_node_info *local_node_record)
 				if (!strcmp(backup_id, ""))
 				{
 					FILE	   *fi2;
+					PQExpBufferData backup_info_line;
 
 					n = strcspn(p, "/");
 
-					strncpy(backup_id, p, n);
-
-					strncat(prefix, backup_id, MAXLEN - 1);
-					strncat(prefix, "/", MAXLEN - 1);
-					p = string_skip_prefix(backup_id, p);
-
-					if (p == NULL)
+					if (n == 0 || n >= MAXLEN || p[n] != '/')
 					{
 						log_error("unexpected output from \"barman list-files\"");
-						log_detail("%s", output);
+						log_detail("%s", output.data);
 						exit(ERR_BARMAN);
 					}
 
-					p = string_skip_prefix("/", p);
+					strncpy(backup_id, p, n);
+
+					appendPQExpBuffer(&prefix, "%s/", backup_id);
 
 					/*
 					 * Copy backup.info
@@ -7278,19 +8713,25 @@ run_file_backup(t_node_info *local_node_record)
 						log_error("cannot open file: %s", filename);
 						exit(ERR_INTERNAL);
 					}
-					while (fgets(buf, MAXLEN, fi2) != NULL)
+
+					/* the "tablespaces" line is unbounded in length */
+					initPQExpBuffer(&backup_info_line);
+
+					while (read_text_line(fi2, &backup_info_line) == true)
 					{
-						q = string_skip_prefix("tablespaces=", buf);
-						if (q != NULL && strncmp(q, "None\n", 5))
+						q = string_skip_prefix("tablespaces=", backup_info_line.data);
+						if (q != NULL && strcmp(q, "None") != 0)
 						{
 							get_tablespace_data_barman(q, &tablespace_list);
 						}
-						q = string_skip_prefix("version=", buf);
+						q = string_skip_prefix("version=", backup_info_line.data);
 						if (q != NULL)
 						{
 							source_server_version_num = strtol(q, NULL, 10);
 						}
 					}
+
+					termPQExpBuffer(&backup_info_line);
 					fclose(fi2);
 					unlink(filename);
 
@@ -7309,37 +8750,61 @@ run_file_backup(t_node_info *local_node_record)
 				if ((q = string_skip_prefix("data/", p)) != NULL)
 				{
 					fputs(q, fd);
+					fputc('\n', fd);
 					continue;
 				}
 
 				/*
-				 * Filter other files (i.e. tablespaces)
+				 * Filter other files (i.e. tablespaces); the first path
+				 * component is the tablespace OID.
 				 */
+				n = strcspn(p, "/");
+
+				if (p[n] != '/')
+					continue;
+
 				for (cell_t = tablespace_list.head; cell_t; cell_t = cell_t->next)
 				{
-					if ((q = string_skip_prefix(cell_t->oid, p)) != NULL && *q == '/')
+					if (strlen(cell_t->oid) != n || strncmp(cell_t->oid, p, n) != 0)
+						continue;
+
+					if (cell_t->fptr == NULL)
 					{
+						maxlen_snprintf(filename, "%s/%s.txt", local_repmgr_tmp_directory, cell_t->oid);
+						cell_t->fptr = fopen(filename, "w");
 						if (cell_t->fptr == NULL)
 						{
-							maxlen_snprintf(filename, "%s/%s.txt", local_repmgr_tmp_directory, cell_t->oid);
-							cell_t->fptr = fopen(filename, "w");
-							if (cell_t->fptr == NULL)
-							{
-								log_error("cannot open file: %s", filename);
-								exit(ERR_INTERNAL);
-							}
+							log_error("cannot open file: %s", filename);
+							exit(ERR_INTERNAL);
 						}
-						fputs(q + 1, cell_t->fptr);
-						break;
 					}
+					fputs(p + n + 1, cell_t->fptr);
+					fputc('\n', cell_t->fptr);
+					break;
 				}
 			}
 
 			fclose(fd);
 
-			pclose(fi);
+			list_status = pclose(fi);
+
+			termPQExpBuffer(&prefix);
+			termPQExpBuffer(&output);
+
+			if (list_status != 0)
+			{
+				log_error(_("unable to retrieve the list of backup files from Barman"));
+				log_detail(_("\"barman list-files\" exited with status %i"), WEXITSTATUS(list_status));
+				exit(ERR_BARMAN);
+			}
 		}
 
+		/*
+		 * Record the backup being cloned, or if resuming, verify it is the
+		 * same backup as the interrupted clone was copying.
+		 */
+		clone_manifest_init(backup_id);
+
 		/* For 9.5 and greater, create our own tablespace_map file */
 		if (source_server_version_num >= 90500)
 		{
@@ -7364,17 +8829,17 @@ run_file_backup(t_node_info *local_node_record)
 		/*
 		 * Copy all backup files from the Barman server
 		 */
-		maxlen_snprintf(command,
-						"rsync --progress -a --files-from=%s %s:%s/%s/data %s",
-						datadir_list_filename,
-						config_file_options.barman_host,
-						basebackups_directory,
-						backup_id,
-						local_data_directory);
+		maxlen_snprintf(buf, "%s/%s/data", basebackups_directory, backup_id);
+
+		clone_progress_begin_unit("data directory");
+
+		if (rsync_file_list(datadir_list_filename, buf, local_data_directory, transfer_streams) == false)
+		{
+			log_error(_("unable to copy data directory files from Barman"));
+			exit(ERR_BARMAN);
+		}
 
-		(void) local_command(
-							 command,
-							 NULL);
+		clone_progress_end_unit();
 
 		unlink(datadir_list_filename);
 
@@ -7463,6 +8928,15 @@ run_file_backup(t_node_info *local_node_record)
 
 				maxlen_snprintf(filename, "%s/%s", local_data_directory, dirs[i]);
 
+				/* directory or symlink already created by the interrupted clone */
+				if (resume_clone == true)
+				{
+					struct stat statbuf;
+
+					if (lstat(filename, &statbuf) == 0)
+						continue;
+				}
+
 				/*
 				 * If --waldir/--xlogdir specified in "pg_basebackup_options",
 				 * create a symlink rather than make a directory.
@@ -7542,24 +9016,28 @@ run_file_backup(t_node_info *local_node_record)
 			if (cell_t->fptr != NULL)	/* cell_t->fptr == NULL iff the tablespace is
 										 * empty */
 			{
+				char		unit[MAXLEN] = "";
+
 				/* close the file to ensure the contents are flushed to disk */
 				fclose(cell_t->fptr);
 
-				maxlen_snprintf(command,
-								"rsync --progress -a --files-from=%s/%s.txt %s:%s/%s/%s %s",
-								local_repmgr_tmp_directory,
-								cell_t->oid,
-								config_file_options.barman_host,
-								basebackups_directory,
-								backup_id,
-								cell_t->oid,
-								tblspc_dir_dest);
-				(void) local_command(command,
-									 NULL);
 				maxlen_snprintf(filename,
 								"%s/%s.txt",
 								local_repmgr_tmp_directory,
 								cell_t->oid);
+				maxlen_snprintf(buf, "%s/%s/%s", basebackups_directory, backup_id, cell_t->oid);
+
+				maxlen_snprintf(unit, "tablespace %s", cell_t->oid);
+				clone_progress_begin_unit(unit);
+
+				if (rsync_file_list(filename, buf, tblspc_dir_dest, transfer_streams) == false)
+				{
+					log_error(_("unable to copy files for tablespace with OID %s from Barman"), cell_t->oid);
+					exit(ERR_BARMAN);
+				}
+
+				clone_progress_end_unit();
+
 				unlink(filename);
 			}
 		}
@@ -7786,929 +9264,3875 @@ stop_backup:
 
 
 /*
- * Perform a call to pg_backupapi endpoint to ask barman to write the backup
- * for us. This will ensure that no matter the format on-disk of new backups,
- * barman will always find a way how to read and write them.
- * From repmgr 4 this is only used for Barman backups.
+ * run_rsync_backup()
+ *
+ * Clone the source node's data directory with rsync ("--rsync-only" mode),
+ * within a non-exclusive backup started on the source node:
+ *
+ *  - a temporary replication slot is created on the source node to retain
+ *    the WAL generated while the backup is in progress
+ *  - files are copied with up to --parallel concurrent rsync processes;
+ *    relation files are copied from the source node and any standbys
+ *    provided with --rsync-sources
+ *  - global/pg_control is copied after all other files
+ *  - the backup is stopped, and "backup_label" written from the value
+ *    returned by the source node; "tablespace_map" is generated locally
+ *    to reflect any "tablespace_mapping" settings
+ *  - the WAL segments needed to make the clone consistent are copied
  */
 static int
-run_pg_backupapi(t_node_info *local_node_record)
+run_rsync_backup(t_node_info *local_node_record)
 {
-	int r = ERR_PGBACKUPAPI_SERVICE;
-	long http_return_code = 0;
-	short seconds_to_sleep = 3;
-	operation_task *task = malloc(sizeof(operation_task));
-	CURL *curl = curl_easy_init();
-	CURLcode ret;
+	int			r = SUCCESS;
+	int			streams = runtime_options.parallel_provided ? runtime_options.parallel : 1;
+	char		slot_name[MAXLEN] = "";
+	char		host_string[MAXLEN] = "";
+	char		command[MAXLEN] = "";
+	char		filename[MAXPGPATH] = "";
+	KeyValueList tablespace_locations = {NULL, NULL};
+	KeyValueListCell *cell = NULL;
+	PQExpBufferData tablespace_map;
+	PQExpBufferData labelfile;
+	PQExpBufferData spcmapfile;
+	XLogRecPtr	start_lsn = InvalidXLogRecPtr;
+	XLogRecPtr	stop_lsn = InvalidXLogRecPtr;
+	bool		backup_started = false;
+	FILE	   *fp = NULL;
 
-	check_pg_backupapi_standby_clone_options();
+	initPQExpBuffer(&tablespace_map);
+	initPQExpBuffer(&labelfile);
+	initPQExpBuffer(&spcmapfile);
 
-	task->host = malloc(strlen(config_file_options.pg_backupapi_host)+1);
-	task->remote_ssh_command = malloc(strlen(config_file_options.pg_backupapi_remote_ssh_command)+1);
-	task->node_name = malloc(strlen(config_file_options.pg_backupapi_node_name)+1);
-	task->operation_type = malloc(strlen(DEFAULT_STANDBY_PG_BACKUPAPI_OP_TYPE)+1);
-	task->backup_id = malloc(strlen(config_file_options.pg_backupapi_backup_id)+1);
-	task->destination_directory = malloc(strlen(local_data_directory)+1);
+	maxlen_snprintf(local_repmgr_tmp_directory,
+					"%s/repmgr", local_data_directory);
 
-	task->operation_id = malloc(MAX_BUFFER_LENGTH);
-	task->operation_status = malloc(MAX_BUFFER_LENGTH);
+	if (!create_pg_dir(local_repmgr_tmp_directory, false))
+	{
+		log_error(_("unable to create temporary directory \"%s\""),
+				  local_repmgr_tmp_directory);
+		return ERR_BAD_RSYNC;
+	}
 
-	strcpy(task->host, config_file_options.pg_backupapi_host);
-	strcpy(task->remote_ssh_command, config_file_options.pg_backupapi_remote_ssh_command);
-	strcpy(task->node_name, config_file_options.pg_backupapi_node_name);
-	strcpy(task->operation_type, DEFAULT_STANDBY_PG_BACKUPAPI_OP_TYPE);
-	strcpy(task->backup_id, config_file_options.pg_backupapi_backup_id);
-	strcpy(task->destination_directory, local_data_directory);
-	strcpy(task->operation_id, "\0");
+	/*
+	 * The temporary slot ensures the WAL needed to make the clone consistent
+	 * is retained on the source node until it has been copied; it will be
+	 * dropped automatically if repmgr exits before the clone completes.
+	 */
+	maxlen_snprintf(slot_name, "repmgr_clone_%i", (int) getpid());
 
-	ret = create_new_task(curl, task);
+	if (create_temporary_replication_slot_sql(source_conn, slot_name) == false)
+	{
+		r = ERR_BAD_BASEBACKUP;
+		goto cleanup;
+	}
 
-	if ((ret != CURLE_OK) || (strlen(task->operation_id) == 0)) {
-		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_return_code);
-		if (499 > http_return_code && http_return_code >= 400) {
-			log_error("Cannot find backup '%s' for node '%s'.", task->backup_id, task->node_name);
-		} else {
-			log_error("whilst reaching out pg_backup service: %s\n", curl_easy_strerror(ret));
-		}
-        }
-	else
+	if (get_tablespace_locations(source_conn, &tablespace_locations) == false)
 	{
-		log_info("Success creating the task: operation id '%s'", task->operation_id);
+		r = ERR_BAD_BASEBACKUP;
+		goto cleanup;
+	}
 
-		//We call init again because previous call included POST calls
-		curl_easy_cleanup(curl);
-		curl = curl_easy_init();
-		while (true)
-		{
-			ret = get_status_of_operation(curl, task);
-			if (strlen(task->operation_status) == 0) {
-				log_info("Retrying...");
-			}
-			else
-			{
-				log_info("status %s", task->operation_status);
-			}
-			if (strcmp(task->operation_status, "FAILED") == 0) {
-				break;
-			}
-			if (strcmp(task->operation_status, "DONE") == 0) {
-				r = SUCCESS;
-				break;
-			}
+	start_lsn = start_backup(source_conn, "repmgr standby clone", runtime_options.fast_checkpoint);
 
-			sleep(seconds_to_sleep);
-		}
+	if (start_lsn == InvalidXLogRecPtr)
+	{
+		r = ERR_BAD_BASEBACKUP;
+		goto cleanup;
 	}
 
-	curl_easy_cleanup(curl);
-	free(task);
-	return r;
-}
+	backup_started = true;
 
-/*
- * pg_backupapi mode is enabled when config_file_options.pg_backupapi_host is set hence, we
- * should also check the other required variables too.
- */
+	log_verbose(LOG_INFO, _("backup started at %X/%X"), format_lsn(start_lsn));
 
-void check_pg_backupapi_standby_clone_options() {
+	/* will remove any sources which have no restartpoint at or after start_lsn */
+	wait_for_rsync_sources(start_lsn);
 
-	bool error = false;
+	clone_progress_begin_unit("data directory");
 
-	if (*config_file_options.pg_backupapi_remote_ssh_command == '\0') {
-		log_hint("Check config: remote ssh command is required");
-		error = true;
-	}
-	if (*config_file_options.pg_backupapi_node_name == '\0') {
-		log_hint("Check config: node name is required");
-		error = true;
-	}
-	if (*config_file_options.pg_backupapi_backup_id == '\0') {
-		log_hint("Check config: backup_id is required");
-		error = true;
+	if (copy_files_from_rsync_sources(NULL, local_data_directory, streams) == false)
+	{
+		r = ERR_BAD_RSYNC;
+		goto stop_backup;
 	}
 
-	if (error == true) {
-		log_error("Please fix the errors and try again");
-		exit(ERR_BAD_CONFIG);
-	}
+	clone_progress_end_unit();
 
-}
+	for (cell = tablespace_locations.head; cell; cell = cell->next)
+	{
+		char		tablespace_dir[MAXPGPATH] = "";
+		char		unit[MAXLEN] = "";
+		TablespaceListCell *mapping = NULL;
 
+		strncpy(tablespace_dir, cell->value, MAXPGPATH);
+
+		for (mapping = config_file_options.tablespace_mapping.head; mapping; mapping = mapping->next)
+		{
+			if (strcmp(mapping->old_dir, cell->value) == 0)
+			{
+				strncpy(tablespace_dir, mapping->new_dir, MAXPGPATH);
+				break;
+			}
+		}
 
+		/* with --delta, an existing tablespace directory will be updated */
+		if (delta_clone == true && check_dir(tablespace_dir) == DIR_NOT_EMPTY)
+		{
+			log_verbose(LOG_INFO, _("updating existing tablespace directory \"%s\""),
+						tablespace_dir);
+		}
+		else if (!create_pg_dir(tablespace_dir, runtime_options.force))
+		{
+			log_error(_("unable to create tablespace directory \"%s\""),
+					  tablespace_dir);
+			r = ERR_BAD_RSYNC;
+			goto stop_backup;
+		}
 
-static char *
-make_barman_ssh_command(char *buf)
-{
-	static char config_opt[MAXLEN] = "";
+		log_info(_("copying tablespace %s (\"%s\") to \"%s\""),
+				 cell->key, cell->value, tablespace_dir);
 
-	if (strlen(config_file_options.barman_config))
-		maxlen_snprintf(config_opt,
-						" --config=%s",
-						config_file_options.barman_config);
+		maxlen_snprintf(unit, "tablespace %s", cell->key);
+		clone_progress_begin_unit(unit);
 
-	maxlen_snprintf(buf,
-					"ssh %s barman%s",
-					config_file_options.barman_host,
-					config_opt);
+		if (copy_files_from_rsync_sources(cell->key, tablespace_dir, streams) == false)
+		{
+			r = ERR_BAD_RSYNC;
+			goto stop_backup;
+		}
 
-	return buf;
-}
+		clone_progress_end_unit();
 
+		appendPQExpBuffer(&tablespace_map,
+						  "%s %s\n", cell->key, tablespace_dir);
+	}
 
-static int
-get_tablespace_data_barman(char *tablespace_data_barman,
-						   TablespaceDataList *tablespace_list)
-{
 	/*
-	 * Example: [('main', 24674, '/var/lib/postgresql/tablespaces/9.5/main'),
-	 * ('alt', 24678, '/var/lib/postgresql/tablespaces/9.5/alt')]
+	 * pg_control must be copied after all other files; --ignore-times
+	 * ensures an existing copy is always replaced with --delta.
 	 */
+	make_rsync_host_string(rsync_sources[0].host, host_string);
 
-	char		name[MAXLEN] = "";
-	char		oid[MAXLEN] = "";
-	char		location[MAXPGPATH] = "";
-	char	   *p = tablespace_data_barman;
-	int			i = 0;
-
-	tablespace_list->head = NULL;
-	tablespace_list->tail = NULL;
+	maxlen_snprintf(command,
+					"rsync -a --ignore-times %s:%s/global/pg_control %s/global/",
+					host_string,
+					rsync_sources[0].data_directory,
+					local_data_directory);
 
-	p = string_skip_prefix("[", p);
-	if (p == NULL)
-		return -1;
+	if (local_command(command, NULL) == false)
+	{
+		log_error(_("unable to copy \"global/pg_control\" from the source node"));
+		r = ERR_BAD_RSYNC;
+		goto stop_backup;
+	}
 
-	while (*p == '(')
+	/*
+	 * If the source node is a standby, files copied from other standbys may
+	 * reflect WAL the source node has not yet replayed; ensure the backup's
+	 * end point is not earlier than any of them.
+	 */
+	if (rsync_source_count > 1 && get_recovery_type(source_conn) == RECTYPE_STANDBY)
 	{
-		p = string_skip_prefix("('", p);
-		if (p == NULL)
-			return -1;
+		XLogRecPtr	max_lsn = InvalidXLogRecPtr;
+		int			i;
 
-		i = strcspn(p, "'");
-		strncpy(name, p, i);
-		name[i] = 0;
+		for (i = 1; i < rsync_source_count; i++)
+		{
+			XLogRecPtr	replay_lsn = get_last_wal_replay_location(rsync_sources[i].conn);
 
-		p = string_skip_prefix("', ", p + i);
-		if (p == NULL)
-			return -1;
+			if (replay_lsn == InvalidXLogRecPtr)
+			{
+				log_error(_("unable to determine replay location of node %i"),
+						  rsync_sources[i].node_id);
+				r = ERR_BAD_BASEBACKUP;
+				goto stop_backup;
+			}
 
-		i = strcspn(p, ",");
-		strncpy(oid, p, i);
-		oid[i] = 0;
+			if (replay_lsn > max_lsn)
+				max_lsn = replay_lsn;
+		}
 
-		p = string_skip_prefix(", '", p + i);
-		if (p == NULL)
-			return -1;
+		for (i = 0; i < config_file_options.wal_receive_check_timeout; i++)
+		{
+			if (get_last_wal_replay_location(source_conn) >= max_lsn)
+				break;
 
-		i = strcspn(p, "'");
-		strncpy(location, p, i);
-		location[i] = 0;
+			sleep(1);
+		}
 
-		p = string_skip_prefix("')", p + i);
-		if (p == NULL)
-			return -1;
+		if (i == config_file_options.wal_receive_check_timeout)
+		{
+			log_error(_("source node has not replayed up to %X/%X"),
+					  format_lsn(max_lsn));
+			log_detail(_("waited %i seconds (parameter \"wal_receive_check_timeout\")"),
+					   config_file_options.wal_receive_check_timeout);
+			r = ERR_BAD_BASEBACKUP;
+			goto stop_backup;
+		}
+	}
 
-		tablespace_data_append(tablespace_list, name, oid, location);
+stop_backup:
 
-		if (*p == ']')
-			break;
+	stop_lsn = stop_backup(source_conn, &labelfile, &spcmapfile);
+	backup_started = false;
 
-		p = string_skip_prefix(", ", p);
-		if (p == NULL)
-			return -1;
+	if (r != SUCCESS)
+		goto cleanup;
+
+	if (stop_lsn == InvalidXLogRecPtr)
+	{
+		r = ERR_BAD_BASEBACKUP;
+		goto cleanup;
 	}
 
-	return SUCCESS;
-}
+	log_verbose(LOG_INFO, _("backup stopped at %X/%X"), format_lsn(stop_lsn));
 
+	maxlen_snprintf(filename, "%s/backup_label", local_data_directory);
 
-void
-get_barman_property(char *dst, char *name, char *local_repmgr_directory)
-{
-	PQExpBufferData command_output;
-	char		buf[MAXLEN] = "";
-	char		command[MAXLEN] = "";
-	char	   *p = NULL;
+	fp = fopen(filename, "w");
 
-	initPQExpBuffer(&command_output);
+	if (fp == NULL || fputs(labelfile.data, fp) == EOF)
+	{
+		log_error(_("unable to write file \"%s\""), filename);
+		log_detail("%s", strerror(errno));
+		if (fp != NULL)
+			fclose(fp);
+		r = ERR_BAD_BASEBACKUP;
+		goto cleanup;
+	}
 
-	maxlen_snprintf(command,
-					"grep \"^[[:space:]]%s:\" %s/show-server.txt",
-					name, local_repmgr_tmp_directory);
-	(void) local_command(command, &command_output);
+	fclose(fp);
 
-	maxlen_snprintf(buf, "\t%s: ", name);
-	p = string_skip_prefix(buf, command_output.data);
-	if (p == NULL)
+	/*
+	 * tablespace_map is generated here rather than taken from the backup,
+	 * as tablespaces may have been relocated with "tablespace_mapping".
+	 */
+	if (tablespace_map.data[0] != '\0')
 	{
-		log_error("unexpected output from Barman: %s",
-				  command_output.data);
-		exit(ERR_INTERNAL);
-	}
+		maxlen_snprintf(filename, "%s/tablespace_map", local_data_directory);
 
-	strncpy(dst, p, MAXLEN);
-	string_remove_trailing_newlines(dst);
+		fp = fopen(filename, "w");
 
-	termPQExpBuffer(&command_output);
-}
+		if (fp == NULL || fputs(tablespace_map.data, fp) == EOF)
+		{
+			log_error(_("unable to write file \"%s\""), filename);
+			log_detail("%s", strerror(errno));
+			if (fp != NULL)
+				fclose(fp);
+			r = ERR_BAD_BASEBACKUP;
+			goto cleanup;
+		}
 
+		fclose(fp);
+	}
 
+	if (copy_wal_from_rsync_source(labelfile.data, start_lsn, stop_lsn) == false)
+	{
+		r = ERR_BAD_RSYNC;
+		goto cleanup;
+	}
+
+cleanup:
+
+	if (backup_started == true)
+		(void) stop_backup(source_conn, &labelfile, &spcmapfile);
+
+	if (slot_name[0] != '\0')
+		(void) drop_replication_slot_sql(source_conn, slot_name);
+
+	rmtree(local_repmgr_tmp_directory, true);
+
+	/* connections to any additional sources are no longer needed */
+	while (rsync_source_count > 1)
+	{
+		rsync_source_count--;
+		key_value_list_free(&rsync_sources[rsync_source_count].tablespaces);
+		PQfinish(rsync_sources[rsync_source_count].conn);
+	}
+
+	key_value_list_free(&tablespace_locations);
+	termPQExpBuffer(&tablespace_map);
+	termPQExpBuffer(&labelfile);
+	termPQExpBuffer(&spcmapfile);
+
+	return r;
+}
+
+
+/*
+ * check_rsync_sources()
+ *
+ * Initialise the list of nodes to copy files from in "--rsync-only" mode.
+ * The first entry is always the source node; any standbys listed in
+ * --rsync-sources are added if they can be used (otherwise a warning is
+ * emitted and the node skipped).
+ *
+ * Exits if the source node itself cannot be used.
+ */
 static void
-copy_configuration_files(bool delete_after_copy)
+check_rsync_sources(void)
 {
-	int			i,
-				r;
-	t_configfile_info *file = NULL;
-	char	   *host = NULL;
+	char	   *sources = NULL;
+	char	   *node_id_str = NULL;
+	uint64		source_system_identifier = system_identifier(source_conn);
+	int			max_sources = 1;
+	char	   *p = NULL;
 
-	/* get host from upstream record */
-	host = param_get(&recovery_conninfo, "host");
+	if (runtime_options.host[0] == '\0')
+	{
+		log_error(_("--rsync-only requires the source node's host to be provided with -h/--host"));
+		exit(ERR_BAD_CONFIG);
+	}
 
-	if (host == NULL)
-		host = runtime_options.host;
+	for (p = runtime_options.rsync_sources; *p != '\0'; p++)
+	{
+		if (*p == ',')
+			max_sources++;
+	}
 
-	log_notice(_("copying external configuration files from upstream node \"%s\""), host);
+	if (runtime_options.rsync_sources[0] != '\0')
+		max_sources++;
 
-	for (i = 0; i < config_files.entries; i++)
+	rsync_sources = pg_malloc0(sizeof(RsyncSource) * max_sources);
+
+	rsync_sources[0].node_id = UNKNOWN_NODE_ID;
+	strncpy(rsync_sources[0].host, runtime_options.host, MAXLEN);
+	rsync_sources[0].conn = source_conn;
+
+	if (get_pg_setting(source_conn, "data_directory", rsync_sources[0].data_directory) == false)
 	{
-		PQExpBufferData dest_path;
+		log_error(_("unable to determine the source node's data directory"));
+		exit(ERR_BAD_CONFIG);
+	}
 
-		file = config_files.files[i];
+	if (get_tablespace_locations(source_conn, &rsync_sources[0].tablespaces) == false)
+	{
+		log_error(_("unable to retrieve tablespace information from the source node"));
+		exit(ERR_BAD_CONFIG);
+	}
 
-		/*
-		 * Skip files in the data directory - these will be copied during the
-		 * main backup
-		 */
-		if (file->in_data_directory == true)
-			continue;
+	if (test_ssh_connection(rsync_sources[0].host, runtime_options.remote_user) != 0)
+	{
+		log_error(_("remote host \"%s\" is not reachable via SSH"),
+				  rsync_sources[0].host);
+		exit(ERR_BAD_CONFIG);
+	}
 
-		initPQExpBuffer(&dest_path);
+	rsync_source_count = 1;
 
-		if (runtime_options.copy_external_config_files_destination == CONFIG_FILE_SAMEPATH)
+	if (runtime_options.rsync_sources[0] == '\0')
+		return;
+
+	sources = pg_strdup(runtime_options.rsync_sources);
+
+	for (node_id_str = strtok(sources, ","); node_id_str != NULL; node_id_str = strtok(NULL, ","))
+	{
+		RsyncSource *source = &rsync_sources[rsync_source_count];
+		t_node_info node_record = T_NODE_INFO_INITIALIZER;
+		ItemList	errors = {NULL, NULL};
+		int			node_id = repmgr_atoi(node_id_str, "--rsync-sources", &errors, MIN_NODE_ID);
+		RecordStatus record_status = RECORD_NOT_FOUND;
+
+		if (errors.head != NULL)
 		{
-			appendPQExpBufferStr(&dest_path, file->filepath);
+			print_error_list(&errors, LOG_ERR);
+			exit(ERR_BAD_CONFIG);
 		}
-		else
+
+		record_status = get_node_record(source_conn, node_id, &node_record);
+
+		if (record_status != RECORD_FOUND)
 		{
-			appendPQExpBuffer(&dest_path,
-							  "%s/%s",
-							  local_data_directory,
-							  file->filename);
+			log_warning(_("no record found for node %i, skipping"), node_id);
+			continue;
 		}
 
-		r = copy_remote_files(runtime_options.host, runtime_options.remote_user,
-							  file->filepath, dest_path.data, false, source_server_version_num);
+		source->node_id = node_id;
+		source->conn = establish_db_connection(node_record.conninfo, false);
 
-		/*
-		 * TODO: collate errors into list
-		 */
+		if (PQstatus(source->conn) != CONNECTION_OK)
+		{
+			log_warning(_("unable to connect to node %i, skipping"), node_id);
+			PQfinish(source->conn);
+			continue;
+		}
 
-		if (WEXITSTATUS(r))
+		if (get_recovery_type(source->conn) != RECTYPE_STANDBY)
 		{
-			log_error(_("standby clone: unable to copy config file \"%s\""),
-					  file->filename);
-			log_hint(_("see preceding messages for details"));
+			log_warning(_("node %i is not a standby, skipping"), node_id);
+			PQfinish(source->conn);
+			continue;
+		}
 
-			if (runtime_options.force == false)
-				exit(ERR_BAD_RSYNC);
+		if (system_identifier(source->conn) != source_system_identifier)
+		{
+			log_warning(_("node %i is not part of the source node's replication cluster, skipping"),
+						node_id);
+			PQfinish(source->conn);
+			continue;
 		}
 
-		/*
-		 * This is to check we can actually copy the files before running the
-		 * main clone operation
-		 */
-		if (delete_after_copy == true)
+		if (get_conninfo_value(node_record.conninfo, "host", source->host) == false || source->host[0] == '\0')
 		{
-			/* this is very unlikely to happen, but log in case it does */
-			if (unlink(dest_path.data) < 0 && errno != ENOENT)
-			{
-				log_warning(_("unable to delete %s"), dest_path.data);
-				log_detail("%s", strerror(errno));
-			}
+			log_warning(_("unable to determine host for node %i, skipping"), node_id);
+			PQfinish(source->conn);
+			continue;
 		}
 
-		termPQExpBuffer(&dest_path);
+		if (get_pg_setting(source->conn, "data_directory", source->data_directory) == false
+			|| get_tablespace_locations(source->conn, &source->tablespaces) == false)
+		{
+			log_warning(_("unable to retrieve data directory locations for node %i, skipping"),
+						node_id);
+			key_value_list_free(&source->tablespaces);
+			PQfinish(source->conn);
+			continue;
+		}
+
+		if (test_ssh_connection(source->host, runtime_options.remote_user) != 0)
+		{
+			log_warning(_("host \"%s\" (node %i) is not reachable via SSH, skipping"),
+						source->host, node_id);
+			key_value_list_free(&source->tablespaces);
+			PQfinish(source->conn);
+			continue;
+		}
+
+		log_verbose(LOG_INFO, _("node %i (host \"%s\") will be used as an rsync source"),
+					node_id, source->host);
+
+		rsync_source_count++;
 	}
 
-	return;
+	pfree(sources);
 }
 
 
+/*
+ * wait_for_rsync_sources()
+ *
+ * Ensure each standby listed in --rsync-sources has written all changes
+ * made before the backup's start location "lsn" (the redo location of
+ * the backup's checkpoint) to its data files; files copied from a standby
+ * which has not done so could miss those changes.
+ *
+ * Having replayed up to "lsn" is not sufficient, as the standby may not yet
+ * have written the corresponding buffers; once the backup's checkpoint has
+ * been replayed, CHECKPOINT is executed on the standby to create a
+ * restartpoint, which must have a redo location not earlier than "lsn".
+ *
+ * Standbys for which this cannot be confirmed within "wal_receive_check_timeout"
+ * seconds are removed from the source list, and their share of the files
+ * will be copied from the source node.
+ */
 static void
-tablespace_data_append(TablespaceDataList *list, const char *name, const char *oid, const char *location)
+wait_for_rsync_sources(XLogRecPtr lsn)
 {
-	TablespaceDataListCell *cell = NULL;
-	int oid_len = strlen(oid);
-	int name_len = strlen(name);
-	int location_len = strlen(location);
-	cell = (TablespaceDataListCell *) pg_malloc0(sizeof(TablespaceDataListCell));
+	AdaptivePoll poll_state;
+	bool	   *ready = NULL;
+	int			pending = 0;
+	int			i = 1;
 
-	if (cell == NULL)
+	while (i < rsync_source_count)
 	{
-		log_error(_("unable to allocate memory; terminating"));
-		exit(ERR_OUT_OF_MEMORY);
+		if (PQserverVersion(rsync_sources[i].conn) < 90600)
+		{
+			log_warning(_("unable to verify the restartpoint location of node %i, skipping"),
+						rsync_sources[i].node_id);
+			log_detail(_("PostgreSQL 9.6 or later is required"));
+			remove_rsync_source(i);
+			continue;
+		}
+
+		if (can_execute_checkpoint(rsync_sources[i].conn) == false)
+		{
+			log_warning(_("unable to execute CHECKPOINT on node %i, skipping"),
+						rsync_sources[i].node_id);
+			log_hint(_("the connection user must be a superuser or a member of \"pg_checkpoint\""));
+			remove_rsync_source(i);
+			continue;
+		}
+
+		i++;
 	}
 
-	cell->oid = pg_malloc0(1 + oid_len);
-	cell->name = pg_malloc0(1 + name_len);
-	cell->location = pg_malloc0(1 + location_len);
+	if (rsync_source_count <= 1)
+		return;
 
-	strncpy(cell->oid, oid, oid_len);
-	strncpy(cell->name, name, name_len);
-	strncpy(cell->location, location, location_len);
+	ready = pg_malloc0(sizeof(bool) * rsync_source_count);
+	pending = rsync_source_count - 1;
 
-	if (list->tail)
-		list->tail->next = cell;
-	else
-		list->head = cell;
+	adaptive_poll_start(&poll_state, config_file_options.wal_receive_check_timeout);
 
-	list->tail = cell;
-}
+	do
+	{
+		for (i = 1; i < rsync_source_count; i++)
+		{
+			XLogRecPtr	replay_lsn = InvalidXLogRecPtr;
+			XLogRecPtr	redo_lsn = InvalidXLogRecPtr;
 
+			if (ready[i] == true)
+				continue;
 
+			replay_lsn = get_last_wal_replay_location(rsync_sources[i].conn);
 
-/*
- * check_primary_standby_version_match()
- *
- * Check server versions of supplied connections are compatible for
- * replication purposes.
- *
- * Exits on error.
- */
-static void
-check_primary_standby_version_match(PGconn *conn, PGconn *primary_conn)
-{
-	char		standby_version[MAXVERSIONSTR] = "";
-	int			standby_version_num = UNKNOWN_SERVER_VERSION_NUM;
+			if (replay_lsn == InvalidXLogRecPtr || replay_lsn < lsn)
+				continue;
 
-	char		primary_version[MAXVERSIONSTR] = "";
-	int			primary_version_num = UNKNOWN_SERVER_VERSION_NUM;
+			/*
+			 * The restartpoint can only be created once the backup's
+			 * checkpoint record, which follows its redo location, has been
+			 * replayed; until then the redo location will be earlier than
+			 * "lsn", and we'll try again.
+			 */
+			checkpoint(rsync_sources[i].conn);
 
-	standby_version_num = check_server_version(conn, "standby", true, standby_version);
+			redo_lsn = get_last_checkpoint_redo_lsn(rsync_sources[i].conn);
 
-	/* Verify that primary is a supported server version */
-	primary_version_num = check_server_version(conn, "primary", false, primary_version);
-	if (primary_version_num < 0)
-	{
-		PQfinish(conn);
-		PQfinish(primary_conn);
-		exit(ERR_BAD_CONFIG);
-	}
+			if (redo_lsn != InvalidXLogRecPtr && redo_lsn >= lsn)
+			{
+				log_verbose(LOG_INFO, _("node %i has a restartpoint at %X/%X"),
+							rsync_sources[i].node_id, format_lsn(redo_lsn));
+				ready[i] = true;
+				pending--;
+			}
+		}
 
-	/* primary and standby version should match */
-	if ((primary_version_num / 100) != (standby_version_num / 100))
+		if (pending == 0)
+			break;
+	} while (adaptive_poll_wait(&poll_state) == true);
+
+	/* remove in reverse order, as removal moves the subsequent entries */
+	for (i = rsync_source_count - 1; i >= 1; i--)
 	{
-		PQfinish(conn);
-		PQfinish(primary_conn);
-		log_error(_("PostgreSQL versions on primary (%s) and standby (%s) must match"),
-				  primary_version, standby_version);
-		exit(ERR_BAD_CONFIG);
+		if (ready[i] == true)
+			continue;
+
+		log_warning(_("node %i has no restartpoint at or after %X/%X, skipping"),
+					rsync_sources[i].node_id, format_lsn(lsn));
+		log_detail(_("waited %i seconds (parameter \"wal_receive_check_timeout\")"),
+				   config_file_options.wal_receive_check_timeout);
+
+		remove_rsync_source(i);
 	}
+
+	pfree(ready);
 }
 
 
+/*
+ * remove_rsync_source()
+ *
+ * Remove the specified additional source from the list of rsync sources.
+ */
 static void
-check_recovery_type(PGconn *conn)
+remove_rsync_source(int index)
 {
-	RecoveryType recovery_type = get_recovery_type(conn);
+	int			i;
 
-	if (recovery_type != RECTYPE_STANDBY)
-	{
-		if (recovery_type == RECTYPE_PRIMARY)
-		{
-			log_error(_("this node should be a standby (%s)"),
-					  config_file_options.conninfo);
-			PQfinish(conn);
-			exit(ERR_BAD_CONFIG);
-		}
-		else
-		{
-			log_error(_("connection to node (%s) lost"),
-					  config_file_options.conninfo);
-			PQfinish(conn);
-			exit(ERR_DB_CONN);
-		}
-	}
-}
+	key_value_list_free(&rsync_sources[index].tablespaces);
+	PQfinish(rsync_sources[index].conn);
+
+	for (i = index + 1; i < rsync_source_count; i++)
+		rsync_sources[i - 1] = rsync_sources[i];
 
+	rsync_source_count--;
+}
 
 
 /*
- * Creates recovery configuration for a standby.
+ * copy_files_from_rsync_sources()
  *
- * A database connection pointer is required for escaping primary_conninfo
- * parameters. When cloning from Barman and --no-upstream-connection supplied,
- * this might not be available.
+ * Copy the data directory (if "tablespace_oid" is NULL) or the specified
+ * tablespace from the rsync sources to "dest_dir", using up to "streams"
+ * concurrent rsync processes.
+ *
+ * Directories and non-relation files are always copied from the source
+ * node; relation files are split by size into chunks, which are distributed
+ * across all sources containing the directory.
  */
 static bool
-create_recovery_file(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, int server_version_num, char *dest, bool as_file)
+copy_files_from_rsync_sources(const char *tablespace_oid, const char *dest_dir, int streams)
 {
-	PQExpBufferData recovery_file_buf;
-	PQExpBufferData primary_conninfo_buf;
-	char		recovery_file_path[MAXPGPATH] = "";
-	FILE	   *recovery_file;
-	mode_t		um;
-
-	KeyValueList recovery_config = {NULL, NULL};
-	KeyValueListCell *cell = NULL;
-
-	initPQExpBuffer(&primary_conninfo_buf);
+	PQExpBufferData rsync_flags;
+	char		command[MAXLEN] = "";
+	char		bwlimit_option[MAXLEN] = "";
+	char		host_string[MAXLEN] = "";
+	char		common_prefix[MAXPGPATH] = "";
+	char		relation_prefix[MAXPGPATH] = "";
+	char		chunk_filename[MAXPGPATH] = "";
+	const char *copy_flags = NULL;
+	const char **source_dirs = NULL;
+	int		   *source_index = NULL;
+	int			usable_sources = 0;
+	TransferFile *files = NULL;
+	int			file_count = 0;
+	uint64		total_size = 0;
+	TransferFile *common_files = NULL;
+	int			common_count = 0;
+	TransferFile *relation_files = NULL;
+	int			relation_count = 0;
+	uint64	   *chunk_sizes = NULL;
+	int			common_chunks = 0;
+	int			relation_chunks = 0;
+	t_command_task *tasks = NULL;
+	int			task_count = 0;
+	bool		success = true;
+	int			i;
 
-	/* standby_mode = 'on' (Pg 11 and earlier) */
-	if (server_version_num < 120000)
-	{
-		key_value_list_set(&recovery_config,
-						   "standby_mode", "on");
-	}
+	initPQExpBuffer(&rsync_flags);
 
-	/* primary_conninfo = '...' */
-	write_primary_conninfo(&primary_conninfo_buf, primary_conninfo);
-	key_value_list_set(&recovery_config,
-					   "primary_conninfo", primary_conninfo_buf.data);
+	append_rsync_exclude_options(&rsync_flags,
+								 tablespace_oid == NULL ? true : false,
+								 PQserverVersion(source_conn));
 
 	/*
-	 * recovery_target_timeline = 'latest'
-	 *
-	 * PostgreSQL 11 and earlier only; 'latest' is the default from PostgreSQL 12.
+	 * In addition to the files excluded by copy_remote_files(), the contents
+	 * of these directories are not required in a base backup.
 	 */
-
-	if (server_version_num < 120000)
+	if (tablespace_oid == NULL)
 	{
-		key_value_list_set(&recovery_config,
-						   "recovery_target_timeline", "latest");
+		appendPQExpBufferStr(&rsync_flags,
+							 " --exclude=backup_label --exclude=tablespace_map"
+							 " --exclude=pg_replslot/* --exclude=pg_dynshmem/*"
+							 " --exclude=pg_notify/* --exclude=pg_serial/*"
+							 " --exclude=pg_snapshots/* --exclude=pg_subtrans/*"
+							 " --exclude=pg_tblspc/*");
 	}
 
-	/* recovery_min_apply_delay = ... (optional) */
-	if (config_file_options.recovery_min_apply_delay_provided == true)
+	/* determine which sources contain the directory being copied */
+	source_dirs = pg_malloc0(sizeof(char *) * rsync_source_count);
+	source_index = pg_malloc0(sizeof(int) * rsync_source_count);
+
+	for (i = 0; i < rsync_source_count; i++)
 	{
-		key_value_list_set(&recovery_config,
-						   "recovery_min_apply_delay", config_file_options.recovery_min_apply_delay);
+		const char *source_dir = NULL;
+
+		if (tablespace_oid == NULL)
+			source_dir = rsync_sources[i].data_directory;
+		else
+			source_dir = key_value_list_get(&rsync_sources[i].tablespaces, tablespace_oid);
+
+		if (source_dir == NULL)
+			continue;
+
+		source_dirs[usable_sources] = source_dir;
+		source_index[usable_sources] = i;
+		usable_sources++;
 	}
 
-	/* primary_slot_name = '...' (optional, for 9.4 and later) */
-	if (config_file_options.use_replication_slots)
+	/* the source node always contains the directory */
+	if (usable_sources == 0 || source_index[0] != 0)
 	{
-		key_value_list_set(&recovery_config,
-						   "primary_slot_name", node_record->slot_name);
+		log_error(_("unable to determine source directory for tablespace %s"),
+				  tablespace_oid);
+		success = false;
+		goto cleanup;
 	}
 
+	copy_flags = config_file_options.rsync_options[0] != '\0'
+		? config_file_options.rsync_options
+		: "-a";
+
 	/*
-	 * If restore_command is set, we use it as restore_command in
-	 * recovery.conf
+	 * --copy-dirlinks ensures a symlinked "pg_wal" directory is created as
+	 * a directory on the standby
 	 */
-	if (config_file_options.restore_command[0] != '\0')
+	make_rsync_host_string(rsync_sources[0].host, host_string);
+
+	maxlen_snprintf(command,
+					"rsync -a --copy-dirlinks --list-only%s %s:%s/",
+					rsync_flags.data,
+					host_string,
+					source_dirs[0]);
+
+	if (get_rsync_file_list(command, &files, &file_count, &total_size) == false)
 	{
-		char	   *escaped = escape_recovery_conf_value(config_file_options.restore_command);
+		log_error(_("unable to retrieve list of files to copy from the source node"));
+		log_detail("%s", command);
+		free_file_list(files, file_count);
+		success = false;
+		goto cleanup;
+	}
 
-		key_value_list_set(&recovery_config,
-						  "restore_command", escaped);
-		free(escaped);
+	/*
+	 * With --delta, remove any files from the existing directory which
+	 * are not present on the source node; rsync's quick check (size and
+	 * modification time) and delta-transfer algorithm will then ensure
+	 * only changed files, and only the changed blocks within those files,
+	 * are copied. --inplace avoids rewriting an entire file when only some
+	 * of its blocks have changed.
+	 */
+	if (delta_clone == true)
+		remove_unlisted_files(dest_dir, files, file_count);
+
+	/*
+	 * Relation files are those in the "base" directory, or anywhere in a
+	 * tablespace directory.
+	 */
+	common_files = pg_malloc0(sizeof(TransferFile) * (file_count + 1));
+	relation_files = pg_malloc0(sizeof(TransferFile) * (file_count + 1));
+
+	for (i = 0; i < file_count; i++)
+	{
+		if (files[i].is_directory == false
+			&& (tablespace_oid != NULL || strncmp(files[i].path, "base/", 5) == 0))
+			relation_files[relation_count++] = files[i];
+		else
+			common_files[common_count++] = files[i];
 	}
 
-	/* archive_cleanup_command (optional) */
-	if (config_file_options.archive_cleanup_command[0] != '\0')
+	maxlen_snprintf(common_prefix, "%s/common", local_repmgr_tmp_directory);
+	maxlen_snprintf(relation_prefix, "%s/relation", local_repmgr_tmp_directory);
+
+	chunk_sizes = pg_malloc0(sizeof(uint64) * streams);
+
+	common_chunks = split_file_list(common_files, common_count, streams, common_prefix, chunk_sizes);
+	relation_chunks = split_file_list(relation_files, relation_count, streams, relation_prefix, chunk_sizes);
+
+	tasks = pg_malloc0(sizeof(t_command_task) * (common_chunks + relation_chunks));
+
+	make_rsync_bwlimit_option(streams, bwlimit_option);
+
+	for (i = 0; i < common_chunks; i++)
 	{
-		char	   *escaped = escape_recovery_conf_value(config_file_options.archive_cleanup_command);
+		maxlen_snprintf(chunk_filename, "%s.%i", common_prefix, i);
+		maxlen_snprintf(command,
+						"rsync %s%s%s --copy-dirlinks --info=progress2 --files-from=%s %s:%s/ %s",
+						copy_flags,
+						delta_clone ? " --inplace" : "",
+						bwlimit_option,
+						chunk_filename,
+						host_string,
+						source_dirs[0],
+						dest_dir);
 
-		key_value_list_set(&recovery_config,
-						  "archive_cleanup_command", escaped);
-		free(escaped);
+		init_command_task(&tasks[task_count], task_count, command);
+		task_count++;
 	}
 
-	/*
-	 * Caller requests the generated file to be written into a buffer
-	 */
-	if (as_file == false)
+	for (i = 0; i < relation_chunks; i++)
 	{
-		/* create file in buffer */
-		initPQExpBuffer(&recovery_file_buf);
+		int			source = i % usable_sources;
 
-		for (cell = recovery_config.head; cell; cell = cell->next)
-		{
-			appendPQExpBuffer(&recovery_file_buf,
-							  "%s = '%s'\n",
-							  cell->key, cell->value);
-		}
+		make_rsync_host_string(rsync_sources[source_index[source]].host, host_string);
 
-		maxlen_snprintf(dest, "%s", recovery_file_buf.data);
+		maxlen_snprintf(chunk_filename, "%s.%i", relation_prefix, i);
+		maxlen_snprintf(command,
+						"rsync %s%s%s --copy-dirlinks --info=progress2 --files-from=%s %s:%s/ %s",
+						copy_flags,
+						delta_clone ? " --inplace" : "",
+						bwlimit_option,
+						chunk_filename,
+						host_string,
+						source_dirs[source],
+						dest_dir);
 
-		termPQExpBuffer(&recovery_file_buf);
+		init_command_task(&tasks[task_count], task_count, command);
+		task_count++;
+	}
 
-		return true;
+	if (delta_clone == true)
+	{
+		log_info(_("comparing %i files (%lu bytes) with %i node(s) using up to %i rsync processes"),
+				 file_count, total_size, usable_sources, streams);
+	}
+	else
+	{
+		log_info(_("copying %i files (%lu bytes) from %i node(s) using up to %i rsync processes"),
+				 file_count, total_size, usable_sources, streams);
 	}
 
-	/*
-	 * PostgreSQL 12 and later: modify postgresql.auto.conf
-	 */
-	if (server_version_num >= 120000)
+	success = run_rsync_tasks(tasks, task_count, streams, total_size);
+
+	for (i = 0; i < common_chunks; i++)
 	{
-		if (modify_auto_conf(dest, &recovery_config) == false)
-		{
-			return false;
-		}
+		maxlen_snprintf(chunk_filename, "%s.%i", common_prefix, i);
+		unlink(chunk_filename);
+	}
 
-		if (write_standby_signal(dest) == false)
-		{
-			return false;
-		}
+	for (i = 0; i < relation_chunks; i++)
+	{
+		maxlen_snprintf(chunk_filename, "%s.%i", relation_prefix, i);
+		unlink(chunk_filename);
+	}
 
-		return true;
+	pfree(tasks);
+	pfree(chunk_sizes);
+	pfree(common_files);
+	pfree(relation_files);
+
+	/* the file paths are owned by "files" */
+	free_file_list(files, file_count);
+
+cleanup:
+	pfree(source_dirs);
+	pfree(source_index);
+	termPQExpBuffer(&rsync_flags);
+
+	return success;
+}
+
+
+/*
+ * copy_wal_from_rsync_source()
+ *
+ * Copy the WAL segments between the backup's start and stop locations
+ * from the source node's WAL directory, where they are retained by the
+ * temporary replication slot created for the clone.
+ */
+static bool
+copy_wal_from_rsync_source(const char *labelfile, XLogRecPtr start_lsn, XLogRecPtr stop_lsn)
+{
+	char		wal_list_filename[MAXPGPATH] = "";
+	char		command[MAXLEN] = "";
+	char		host_string[MAXLEN] = "";
+	char		start_wal_file[MAXLEN] = "";
+	const char *p = NULL;
+	uint32		hi = 0;
+	uint32		lo = 0;
+	unsigned int tli = 0;
+	uint64		wal_segment_size = get_wal_segment_size(source_conn);
+	uint64		segments_per_id = 0;
+	uint64		segno = 0;
+	FILE	   *fp = NULL;
+	bool		success = true;
+
+	if (wal_segment_size == 0)
+	{
+		log_error(_("unable to determine the source node's WAL segment size"));
+		return false;
 	}
 
-	/*
-	 * PostgreSQL 11 and earlier: write recovery.conf
-	 */
-	maxpath_snprintf(recovery_file_path, "%s/%s", dest, RECOVERY_COMMAND_FILE);
-	log_debug("create_recovery_file(): creating \"%s\"...",
-			  recovery_file_path);
+	p = strstr(labelfile, "START WAL LOCATION:");
 
-	/* Set umask to 0600 */
-	um = umask((~(S_IRUSR | S_IWUSR)) & (S_IRWXG | S_IRWXO));
-	recovery_file = fopen(recovery_file_path, "w");
-	umask(um);
+	if (p == NULL
+		|| sscanf(p, "START WAL LOCATION: %X/%X (file %24s)", &hi, &lo, start_wal_file) != 3
+		|| sscanf(start_wal_file, "%08X", &tli) != 1)
+	{
+		log_error(_("unable to parse backup label"));
+		log_detail("%s", labelfile);
+		return false;
+	}
 
-	if (recovery_file == NULL)
+	maxlen_snprintf(wal_list_filename, "%s/wal.txt", local_repmgr_tmp_directory);
+
+	fp = fopen(wal_list_filename, "w");
+
+	if (fp == NULL)
 	{
-		log_error(_("unable to create recovery.conf file at \"%s\""),
-				  recovery_file_path);
+		log_error(_("unable to create file \"%s\""), wal_list_filename);
 		log_detail("%s", strerror(errno));
-
 		return false;
 	}
 
-	for (cell = recovery_config.head; cell; cell = cell->next)
+	segments_per_id = UINT64CONST(0x100000000) / wal_segment_size;
+
+	for (segno = start_lsn / wal_segment_size; segno <= (stop_lsn - 1) / wal_segment_size; segno++)
 	{
-		initPQExpBuffer(&recovery_file_buf);
-		appendPQExpBuffer(&recovery_file_buf,
-						  "%s = '%s'\n",
-						  cell->key, cell->value);
+		fprintf(fp, "%08X%08X%08X\n",
+				tli,
+				(uint32) (segno / segments_per_id),
+				(uint32) (segno % segments_per_id));
+	}
 
-		log_debug("recovery.conf line: %s", recovery_file_buf.data);
+	/* a standby on a timeline other than the first needs the history file */
+	if (tli > 1)
+		fprintf(fp, "%08X.history\n", tli);
 
-		if (fputs(recovery_file_buf.data, recovery_file) == EOF)
-		{
-			log_error(_("unable to write to recovery file at \"%s\""), recovery_file_path);
-			fclose(recovery_file);
-			termPQExpBuffer(&recovery_file_buf);
-			return false;
-		}
+	fclose(fp);
 
-		termPQExpBuffer(&recovery_file_buf);
+	make_rsync_host_string(rsync_sources[0].host, host_string);
+
+	maxlen_snprintf(command,
+					"rsync -a --files-from=%s %s:%s/pg_wal/ %s/pg_wal/",
+					wal_list_filename,
+					host_string,
+					rsync_sources[0].data_directory,
+					local_data_directory);
+
+	log_info(_("copying WAL from %X/%X to %X/%X"),
+			 format_lsn(start_lsn),
+			 format_lsn(stop_lsn));
+
+	if (local_command(command, NULL) == false)
+	{
+		log_error(_("unable to copy WAL from the source node"));
+		log_detail("%s", command);
+		success = false;
 	}
 
+	unlink(wal_list_filename);
 
-	fclose(recovery_file);
+	return success;
+}
 
-	return true;
+
+static void
+make_rsync_host_string(const char *host, char *host_string)
+{
+	if (runtime_options.remote_user[0] == '\0')
+		maxlen_snprintf(host_string, "%s", host);
+	else
+		maxlen_snprintf(host_string, "%s@%s", runtime_options.remote_user, host);
 }
 
 
+/* used by remove_unlisted_files(), as nftw() does not pass a caller-supplied argument */
+static TransferFile *unlisted_files_source = NULL;
+static int	unlisted_files_source_count = 0;
+static size_t unlisted_files_dest_dir_len = 0;
+
+/*
+ * remove_unlisted_files()
+ *
+ * Remove any files and directories in "dest_dir" which are not present in
+ * "files" (the contents of the corresponding directory on the source node,
+ * as listed by "rsync --list-only"), with the exception of repmgr's own
+ * temporary directory.
+ *
+ * As files excluded from the copy are not listed, this also clears the
+ * contents of directories such as "pg_wal" and "pg_replslot", and
+ * removes any stale "backup_label" or "tablespace_map" files.
+ *
+ * Note that "files" is sorted by path in the process.
+ */
 static void
-write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list)
+remove_unlisted_files(const char *dest_dir, TransferFile *files, int file_count)
 {
-	PQExpBufferData conninfo_buf;
-	bool		application_name_provided = false;
-	bool		password_provided = false;
-	int			c;
-	char	   *escaped = NULL;
-	t_conninfo_param_list env_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
+	qsort(files, file_count, sizeof(TransferFile), transfer_file_path_cmp);
 
-	initialize_conninfo_params(&env_conninfo, true);
+	unlisted_files_source = files;
+	unlisted_files_source_count = file_count;
+	unlisted_files_dest_dir_len = strlen(dest_dir);
 
-	initPQExpBuffer(&conninfo_buf);
+	nftw(dest_dir, remove_unlisted_file_callback, 64, FTW_DEPTH | FTW_PHYS);
 
-	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
-	{
-		/*
-		 * Skip empty settings and ones which don't make any sense in
-		 * recovery.conf
-		 */
-		if (strcmp(param_list->keywords[c], "dbname") == 0 ||
-			strcmp(param_list->keywords[c], "replication") == 0 ||
-			(param_list->values[c] == NULL) ||
-			(param_list->values[c] != NULL && param_list->values[c][0] == '\0'))
-			continue;
+	unlisted_files_source = NULL;
+	unlisted_files_source_count = 0;
+}
 
-		/* only include "password" if explicitly requested */
-		if (strcmp(param_list->keywords[c], "password") == 0)
-		{
-			password_provided = true;
-		}
 
-		if (conninfo_buf.len != 0)
-			appendPQExpBufferChar(&conninfo_buf, ' ');
+static int
+remove_unlisted_file_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
+{
+	TransferFile key;
 
-		if (strcmp(param_list->keywords[c], "application_name") == 0)
-			application_name_provided = true;
+	/* the top-level directory itself */
+	if (ftwbuf->level == 0)
+		return 0;
 
-		appendPQExpBuffer(&conninfo_buf, "%s=", param_list->keywords[c]);
-		appendConnStrVal(&conninfo_buf, param_list->values[c]);
-	}
+	if (strncmp(fpath, local_repmgr_tmp_directory, strlen(local_repmgr_tmp_directory)) == 0)
+		return 0;
 
-	/* "application_name" not provided - default to repmgr node name */
-	if (application_name_provided == false)
-	{
-		if (strlen(config_file_options.node_name))
-		{
-			appendPQExpBufferStr(&conninfo_buf, " application_name=");
-			appendConnStrVal(&conninfo_buf, config_file_options.node_name);
-		}
-		else
-		{
-			appendPQExpBufferStr(&conninfo_buf, " application_name=repmgr");
-		}
-	}
+	key.path = (char *) fpath + unlisted_files_dest_dir_len + 1;
 
-	/* no password provided explicitly  */
-	if (password_provided == false)
-	{
-		if (config_file_options.use_primary_conninfo_password == true)
-		{
-			const char *password = param_get(&env_conninfo, "password");
+	if (bsearch(&key, unlisted_files_source, unlisted_files_source_count,
+				sizeof(TransferFile), transfer_file_path_cmp) != NULL)
+		return 0;
 
-			if (password != NULL)
-			{
-				appendPQExpBufferStr(&conninfo_buf, " password=");
-				appendConnStrVal(&conninfo_buf, password);
-			}
-		}
-	}
+	log_verbose(LOG_DEBUG, "remove_unlisted_file_callback(): removing \"%s\"", fpath);
 
-	/* passfile provided as configuration option */
-	if (config_file_options.passfile[0] != '\0')
+	if (remove(fpath) != 0)
 	{
-		/* check if the libpq we're using supports "passfile=" */
-		if (has_passfile() == true)
-		{
-			appendPQExpBufferStr(&conninfo_buf, " passfile=");
-			appendConnStrVal(&conninfo_buf, config_file_options.passfile);
-		}
+		log_warning(_("unable to remove \"%s\""), fpath);
+		log_detail("%s", strerror(errno));
 	}
 
-	escaped = escape_recovery_conf_value(conninfo_buf.data);
+	return 0;
+}
 
-	appendPQExpBufferStr(dest, escaped);
 
-	free(escaped);
-	free_conninfo_params(&env_conninfo);
-	termPQExpBuffer(&conninfo_buf);
+/*
+ * qsort()/bsearch() comparator for TransferFile, sorting by path
+ */
+static int
+transfer_file_path_cmp(const void *a, const void *b)
+{
+	const TransferFile *file_a = (const TransferFile *) a;
+	const TransferFile *file_b = (const TransferFile *) b;
+
+	return strcmp(file_a->path, file_b->path);
 }
 
 
 /*
- * For "standby promote" and "standby follow", check for sibling nodes.
- * If "--siblings-follow" was specified, fill the provided SiblingNodeStats
- * struct with some aggregate info about the nodes for later
- * decision making.
+ * wait_for_pg_backupapi_operations()
+ *
+ * Poll pg-backup-api until each of the provided operations has completed,
+ * using the same handle (and therefore connection) for each request; any
+ * number of concurrent operations can be waited for.
+ *
+ * The interval between polls starts at PG_BACKUPAPI_POLL_MIN_INTERVAL and
+ * doubles, up to PG_BACKUPAPI_POLL_MAX_INTERVAL, while no operation's
+ * status changes. As pg-backup-api does not report the progress of an
+ * operation, the volume of data present in the destination directories
+ * is reported instead.
+ *
+ * Returns true if all operations completed successfully.
  */
 static bool
-check_sibling_nodes(NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats)
+wait_for_pg_backupapi_operations(CURL *curl, operation_task **tasks, int task_count)
 {
-	char		host[MAXLEN] = "";
-	NodeInfoListCell *cell;
-	int			r;
-
-	/*
-	 * If --siblings-follow not specified, warn about any extant
-	 * siblings which will not follow the new primary
-	 */
+	char	  **last_status = pg_malloc0(sizeof(char *) * task_count);
+	bool	   *finished = pg_malloc0(sizeof(bool) * task_count);
+	int			finished_count = 0;
+	int			failed_count = 0;
+	long		interval_ms = PG_BACKUPAPI_POLL_MIN_INTERVAL;
+	int			i;
 
-	if (runtime_options.siblings_follow == false)
+	while (true)
 	{
-		if (sibling_nodes->node_count > 0)
+		bool		status_changed = false;
+		uint64		restored_bytes = 0;
+
+		for (i = 0; i < task_count; i++)
 		{
-			PQExpBufferData nodes;
+			CURLcode	ret;
 
-			initPQExpBuffer(&nodes);
+			if (finished[i] == true)
+				continue;
 
-			for (cell = sibling_nodes->head; cell; cell = cell->next)
-			{
-				appendPQExpBuffer(&nodes,
-								  "  %s (node ID: %i",
-								  cell->node_info->node_name,
-								  cell->node_info->node_id);
+			strcpy(tasks[i]->operation_status, "");
 
-				if (cell->node_info->type == WITNESS)
-				{
-					appendPQExpBufferStr(&nodes,
-										 ", witness server");
-				}
-				appendPQExpBufferChar(&nodes,
-									  ')');
-				if (cell->next)
-					appendPQExpBufferStr(&nodes, "\n");
+			ret = get_status_of_operation(curl, tasks[i]);
+
+			if (ret != CURLE_OK || strlen(tasks[i]->operation_status) == 0)
+			{
+				log_info(_("unable to retrieve status of operation \"%s\", retrying..."),
+						 tasks[i]->operation_id);
+
+				if (ret != CURLE_OK)
+					log_detail("%s", curl_easy_strerror(ret));
+
+				continue;
+			}
+
+			if (last_status[i] == NULL || strcmp(last_status[i], tasks[i]->operation_status) != 0)
+			{
+				log_info(_("operation \"%s\" (destination \"%s\"): status %s"),
+						 tasks[i]->operation_id,
+						 tasks[i]->destination_directory,
+						 tasks[i]->operation_status);
+
+				if (last_status[i] != NULL)
+					pfree(last_status[i]);
+
+				last_status[i] = pg_strdup(tasks[i]->operation_status);
+				status_changed = true;
+			}
+
+			if (strcmp(tasks[i]->operation_status, "FAILED") == 0)
+			{
+				log_error(_("operation \"%s\" failed"), tasks[i]->operation_id);
+				finished[i] = true;
+				finished_count++;
+				failed_count++;
+			}
+			else if (strcmp(tasks[i]->operation_status, "DONE") == 0)
+			{
+				finished[i] = true;
+				finished_count++;
 			}
+		}
+
+		if (finished_count == task_count)
+			break;
+
+		for (i = 0; i < task_count; i++)
+			restored_bytes += get_directory_size(tasks[i]->destination_directory);
+
+		clone_progress_update(restored_bytes, 0);
+
+		if (status_changed == true)
+			interval_ms = PG_BACKUPAPI_POLL_MIN_INTERVAL;
+		else if (interval_ms * 2 <= PG_BACKUPAPI_POLL_MAX_INTERVAL)
+			interval_ms *= 2;
+		else
+			interval_ms = PG_BACKUPAPI_POLL_MAX_INTERVAL;
+
+		log_verbose(LOG_DEBUG, "wait_for_pg_backupapi_operations(): sleeping %li ms", interval_ms);
+
+		pg_usleep(interval_ms * 1000L);
+	}
+
+	for (i = 0; i < task_count; i++)
+	{
+		if (last_status[i] != NULL)
+			pfree(last_status[i]);
+	}
+
+	pfree(last_status);
+	pfree(finished);
+
+	return failed_count == 0 ? true : false;
+}
+
+
+/* used by get_directory_size(), as nftw() does not pass a caller-supplied argument */
+static uint64 directory_size = 0;
+
+/*
+ * get_directory_size()
+ *
+ * Return the total size of the regular files in "path"; symbolic links
+ * are not followed.
+ */
+static uint64
+get_directory_size(const char *path)
+{
+	directory_size = 0;
+
+	nftw(path, directory_size_callback, 64, FTW_PHYS);
+
+	return directory_size;
+}
+
+
+static int
+directory_size_callback(const char *fpath, const struct stat *sb, int typeflag, struct FTW *ftwbuf)
+{
+	if (typeflag == FTW_F)
+		directory_size += sb->st_size;
+
+	return 0;
+}
+
+
+/*
+ * Perform a call to pg_backupapi endpoint to ask barman to write the backup
+ * for us. This will ensure that no matter the format on-disk of new backups,
+ * barman will always find a way how to read and write them.
+ * From repmgr 4 this is only used for Barman backups.
+ */
+static int
+run_pg_backupapi(t_node_info *local_node_record)
+{
+	int r = ERR_PGBACKUPAPI_SERVICE;
+	long http_return_code = 0;
+	operation_task *task = malloc(sizeof(operation_task));
+	CURL *curl = NULL;
+	CURLcode ret;
+
+	check_pg_backupapi_standby_clone_options();
+
+	curl = init_pg_backupapi_handle();
+	if (curl == NULL)
+	{
+		log_error(_("unable to initialise connection to pg-backup-api"));
+		free(task);
+		return r;
+	}
+
+	task->host = malloc(strlen(config_file_options.pg_backupapi_host)+1);
+	task->remote_ssh_command = malloc(strlen(config_file_options.pg_backupapi_remote_ssh_command)+1);
+	task->node_name = malloc(strlen(config_file_options.pg_backupapi_node_name)+1);
+	task->operation_type = malloc(strlen(DEFAULT_STANDBY_PG_BACKUPAPI_OP_TYPE)+1);
+	task->backup_id = malloc(strlen(config_file_options.pg_backupapi_backup_id)+1);
+	task->destination_directory = malloc(strlen(local_data_directory)+1);
+
+	task->operation_id = malloc(MAX_BUFFER_LENGTH);
+	task->operation_status = malloc(MAX_BUFFER_LENGTH);
+
+	strcpy(task->host, config_file_options.pg_backupapi_host);
+	strcpy(task->remote_ssh_command, config_file_options.pg_backupapi_remote_ssh_command);
+	strcpy(task->node_name, config_file_options.pg_backupapi_node_name);
+	strcpy(task->operation_type, DEFAULT_STANDBY_PG_BACKUPAPI_OP_TYPE);
+	strcpy(task->backup_id, config_file_options.pg_backupapi_backup_id);
+	strcpy(task->destination_directory, local_data_directory);
+	strcpy(task->operation_id, "\0");
+
+	ret = create_new_task(curl, task);
+
+	if ((ret != CURLE_OK) || (strlen(task->operation_id) == 0)) {
+		curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_return_code);
+		if (499 > http_return_code && http_return_code >= 400) {
+			log_error("Cannot find backup '%s' for node '%s'.", task->backup_id, task->node_name);
+		} else {
+			log_error("whilst reaching out pg_backup service: %s\n", curl_easy_strerror(ret));
+		}
+        }
+	else
+	{
+		log_info("Success creating the task: operation id '%s'", task->operation_id);
+
+		clone_progress_begin_unit("pg-backup-api restore");
+
+		if (wait_for_pg_backupapi_operations(curl, &task, 1) == true)
+		{
+			clone_progress_end_unit();
+			r = SUCCESS;
+		}
+	}
+
+	curl_easy_cleanup(curl);
+	free(task);
+	return r;
+}
+
+/*
+ * pg_backupapi mode is enabled when config_file_options.pg_backupapi_host is set hence, we
+ * should also check the other required variables too.
+ */
+
+void check_pg_backupapi_standby_clone_options() {
+
+	bool error = false;
+
+	if (*config_file_options.pg_backupapi_remote_ssh_command == '\0') {
+		log_hint("Check config: remote ssh command is required");
+		error = true;
+	}
+	if (*config_file_options.pg_backupapi_node_name == '\0') {
+		log_hint("Check config: node name is required");
+		error = true;
+	}
+	if (*config_file_options.pg_backupapi_backup_id == '\0') {
+		log_hint("Check config: backup_id is required");
+		error = true;
+	}
+
+	if (error == true) {
+		log_error("Please fix the errors and try again");
+		exit(ERR_BAD_CONFIG);
+	}
+
+}
+
+
+
+static char *
+make_barman_ssh_command(char *buf)
+{
+	static char config_opt[MAXLEN] = "";
+
+	if (strlen(config_file_options.barman_config))
+		maxlen_snprintf(config_opt,
+						" --config=%s",
+						config_file_options.barman_config);
+
+	maxlen_snprintf(buf,
+					"ssh %s barman%s",
+					config_file_options.barman_host,
+					config_opt);
+
+	return buf;
+}
+
+
+static int
+get_tablespace_data_barman(char *tablespace_data_barman,
+						   TablespaceDataList *tablespace_list)
+{
+	/*
+	 * Example: [('main', 24674, '/var/lib/postgresql/tablespaces/9.5/main'),
+	 * ('alt', 24678, '/var/lib/postgresql/tablespaces/9.5/alt')]
+	 */
+
+	char		name[MAXLEN] = "";
+	char		oid[MAXLEN] = "";
+	char		location[MAXPGPATH] = "";
+	char	   *p = tablespace_data_barman;
+	int			i = 0;
+
+	tablespace_list->head = NULL;
+	tablespace_list->tail = NULL;
+
+	p = string_skip_prefix("[", p);
+	if (p == NULL)
+		return -1;
+
+	while (*p == '(')
+	{
+		p = string_skip_prefix("('", p);
+		if (p == NULL)
+			return -1;
+
+		i = strcspn(p, "'");
+		if (i >= sizeof(name))
+			return -1;
+		strncpy(name, p, i);
+		name[i] = 0;
+
+		p = string_skip_prefix("', ", p + i);
+		if (p == NULL)
+			return -1;
+
+		i = strcspn(p, ",");
+		if (i >= sizeof(oid))
+			return -1;
+		strncpy(oid, p, i);
+		oid[i] = 0;
+
+		p = string_skip_prefix(", '", p + i);
+		if (p == NULL)
+			return -1;
+
+		i = strcspn(p, "'");
+		if (i >= sizeof(location))
+			return -1;
+		strncpy(location, p, i);
+		location[i] = 0;
+
+		p = string_skip_prefix("')", p + i);
+		if (p == NULL)
+			return -1;
+
+		tablespace_data_append(tablespace_list, name, oid, location);
+
+		if (*p == ']')
+			break;
+
+		p = string_skip_prefix(", ", p);
+		if (p == NULL)
+			return -1;
+	}
+
+	return SUCCESS;
+}
+
+
+void
+get_barman_property(char *dst, char *name, char *local_repmgr_directory)
+{
+	PQExpBufferData command_output;
+	char		buf[MAXLEN] = "";
+	char		command[MAXLEN] = "";
+	char	   *p = NULL;
+
+	initPQExpBuffer(&command_output);
+
+	maxlen_snprintf(command,
+					"grep \"^[[:space:]]%s:\" %s/show-server.txt",
+					name, local_repmgr_tmp_directory);
+	(void) local_command(command, &command_output);
+
+	maxlen_snprintf(buf, "\t%s: ", name);
+	p = string_skip_prefix(buf, command_output.data);
+	if (p == NULL)
+	{
+		log_error("unexpected output from Barman: %s",
+				  command_output.data);
+		exit(ERR_INTERNAL);
+	}
+
+	strncpy(dst, p, MAXLEN);
+	string_remove_trailing_newlines(dst);
+
+	termPQExpBuffer(&command_output);
+}
+
+
+/*
+ * rsync_file_list()
+ *
+ * Copy the files listed in "file_list", which are relative to "source_dir"
+ * on the Barman host, to "dest_dir".
+ *
+ * If "streams" is greater than 1, the files will be copied using multiple
+ * concurrent rsync processes.
+ */
+static bool
+rsync_file_list(const char *file_list, const char *source_dir, const char *dest_dir, int streams)
+{
+	char		command[MAXLEN] = "";
+	char		bwlimit_option[MAXLEN] = "";
+	t_command_task task;
+
+	if (streams > 1)
+		return rsync_file_list_parallel(file_list, source_dir, dest_dir, streams);
+
+	make_rsync_bwlimit_option(1, bwlimit_option);
+
+	maxlen_snprintf(command,
+					"rsync --info=progress2 -a%s --files-from=%s %s:%s %s",
+					bwlimit_option,
+					file_list,
+					config_file_options.barman_host,
+					source_dir,
+					dest_dir);
+
+	init_command_task(&task, 0, command);
+
+	return run_rsync_tasks(&task, 1, 1, 0);
+}
+
+
+/*
+ * rsync_file_list_parallel()
+ *
+ * Copy the files listed in "file_list" with up to "streams" concurrent
+ * rsync processes.
+ *
+ * The size of each file is first obtained with "rsync --list-only", and
+ * the list split into one chunk per stream with split_file_list().
+ *
+ * If the file sizes cannot be determined, the files will be copied with
+ * a single rsync process.
+ */
+static bool
+rsync_file_list_parallel(const char *file_list, const char *source_dir, const char *dest_dir, int streams)
+{
+	char		command[MAXLEN] = "";
+	char		bwlimit_option[MAXLEN] = "";
+	char		chunk_filename[MAXPGPATH] = "";
+	TransferFile *files = NULL;
+	int			file_count = 0;
+	uint64		total_size = 0;
+	uint64	   *chunk_sizes = NULL;
+	t_command_task *tasks = NULL;
+	int			chunk_count = 0;
+	bool		success = true;
+	int			i;
+
+	maxlen_snprintf(command,
+					"rsync -a --list-only --files-from=%s %s:%s",
+					file_list,
+					config_file_options.barman_host,
+					source_dir);
+
+	if (get_rsync_file_list(command, &files, &file_count, &total_size) == false || file_count == 0)
+	{
+		free_file_list(files, file_count);
+
+		log_warning(_("unable to determine file sizes with \"rsync --list-only\""));
+		log_detail(_("falling back to a single rsync process"));
+		return rsync_file_list(file_list, source_dir, dest_dir, 1);
+	}
+
+	chunk_sizes = pg_malloc0(sizeof(uint64) * streams);
+
+	chunk_count = split_file_list(files, file_count, streams, file_list, chunk_sizes);
+
+	free_file_list(files, file_count);
+
+	tasks = pg_malloc0(sizeof(t_command_task) * chunk_count);
+
+	make_rsync_bwlimit_option(streams, bwlimit_option);
+
+	for (i = 0; i < chunk_count; i++)
+	{
+		log_debug("rsync_file_list_parallel(): chunk %i contains %lu bytes", i, chunk_sizes[i]);
+
+		maxlen_snprintf(chunk_filename, "%s.%i", file_list, i);
+		maxlen_snprintf(command,
+						"rsync --info=progress2 -a%s --files-from=%s %s:%s %s",
+						bwlimit_option,
+						chunk_filename,
+						config_file_options.barman_host,
+						source_dir,
+						dest_dir);
+
+		init_command_task(&tasks[i], i, command);
+	}
+
+	log_info(_("copying %i files (%lu bytes) using %i rsync processes"),
+			 file_count, total_size, chunk_count);
+
+	success = run_rsync_tasks(tasks, chunk_count, chunk_count, total_size);
+
+	for (i = 0; i < chunk_count; i++)
+	{
+		maxlen_snprintf(chunk_filename, "%s.%i", file_list, i);
+		unlink(chunk_filename);
+	}
+
+	pfree(tasks);
+	pfree(chunk_sizes);
+
+	return success;
+}
+
+
+/*
+ * get_rsync_file_list()
+ *
+ * Execute the provided "rsync --list-only" command, and store the path
+ * and size of each listed entry (excluding the top-level directory).
+ *
+ * Returns false if the command could not be executed or failed.
+ */
+static bool
+get_rsync_file_list(const char *command, TransferFile **files, int *file_count, uint64 *total_size)
+{
+	PQExpBufferData line;
+	FILE	   *fi = NULL;
+	int			files_allocated = 0;
+
+	*files = NULL;
+	*file_count = 0;
+	*total_size = 0;
+
+	log_verbose(LOG_DEBUG, "executing:\n  %s", command);
+
+	fi = popen(command, "r");
+	if (fi == NULL)
+	{
+		log_warning(_("unable to execute command:\n  %s"), command);
+		return false;
+	}
+
+	/*
+	 * Each line has the form:
+	 *
+	 *   -rw------- 8,192 2021/01/01 12:00:00 base/1/1259
+	 *
+	 * Depending on the rsync version and locale, the size may contain
+	 * digit grouping separators. The path is separated from the time field
+	 * by a single space, and is taken verbatim from there, as it may itself
+	 * begin with whitespace.
+	 */
+	initPQExpBuffer(&line);
+
+	while (read_text_line(fi, &line) == true)
+	{
+		char		perms[MAXLEN] = "";
+		char		size_str[MAXLEN] = "";
+		char		date_str[MAXLEN] = "";
+		char		time_str[MAXLEN] = "";
+		int			path_offset = 0;
+		uint64		size = 0;
+		char	   *p = NULL;
+
+		if (sscanf(line.data, "%1023s %1023s %1023s %1023s%n", perms, size_str, date_str, time_str, &path_offset) != 4
+			|| line.data[path_offset] != ' ' || line.data[path_offset + 1] == '\0')
+			continue;
+
+		path_offset++;
+
+		if (strcmp(line.data + path_offset, ".") == 0)
+			continue;
+
+		for (p = size_str; *p != '\0'; p++)
+		{
+			if (isdigit((unsigned char) *p))
+				size = size * 10 + (*p - '0');
+		}
+
+		if (*file_count == files_allocated)
+		{
+			files_allocated = files_allocated ? files_allocated * 2 : 1024;
+			*files = pg_realloc(*files, sizeof(TransferFile) * files_allocated);
+		}
+
+		(*files)[*file_count].path = pg_strdup(line.data + path_offset);
+		(*files)[*file_count].size = size;
+		(*files)[*file_count].is_directory = (perms[0] == 'd') ? true : false;
+		*total_size += size;
+		(*file_count)++;
+	}
+
+	termPQExpBuffer(&line);
+
+	if (pclose(fi) != 0)
+		return false;
+
+	return true;
+}
+
+
+static void
+free_file_list(TransferFile *files, int file_count)
+{
+	int			i;
+
+	for (i = 0; i < file_count; i++)
+		pfree(files[i].path);
+
+	if (files != NULL)
+		pfree(files);
+}
+
+
+/*
+ * split_file_list()
+ *
+ * Split the provided files into up to "chunks" lists, written to files
+ * named "<chunk_prefix>.<n>". Largest files are assigned first, each to
+ * the chunk with the least data, so that each chunk contains approximately
+ * the same volume of data. The volume of each chunk is stored in
+ * "chunk_sizes".
+ *
+ * Note that "files" is sorted in the process.
+ *
+ * Returns the number of chunks created.
+ */
+static int
+split_file_list(TransferFile *files, int file_count, int chunks, const char *chunk_prefix, uint64 *chunk_sizes)
+{
+	char		chunk_filename[MAXPGPATH] = "";
+	FILE	  **chunk_files = NULL;
+	int			i;
+
+	if (chunks > file_count)
+		chunks = file_count;
+
+	if (chunks < 1)
+		return 0;
+
+	/* largest files first */
+	qsort(files, file_count, sizeof(TransferFile), transfer_file_cmp);
+
+	chunk_files = pg_malloc0(sizeof(FILE *) * chunks);
+
+	for (i = 0; i < chunks; i++)
+	{
+		chunk_sizes[i] = 0;
+
+		maxlen_snprintf(chunk_filename, "%s.%i", chunk_prefix, i);
+
+		chunk_files[i] = fopen(chunk_filename, "w");
+		if (chunk_files[i] == NULL)
+		{
+			log_error(_("unable to create file \"%s\""), chunk_filename);
+			log_detail("%s", strerror(errno));
+			exit(ERR_INTERNAL);
+		}
+	}
+
+	for (i = 0; i < file_count; i++)
+	{
+		int			chunk = 0;
+		int			j;
+
+		for (j = 1; j < chunks; j++)
+		{
+			if (chunk_sizes[j] < chunk_sizes[chunk])
+				chunk = j;
+		}
+
+		fprintf(chunk_files[chunk], "%s\n", files[i].path);
+		chunk_sizes[chunk] += files[i].size;
+	}
+
+	for (i = 0; i < chunks; i++)
+		fclose(chunk_files[i]);
+
+	pfree(chunk_files);
+
+	return chunks;
+}
+
+
+/*
+ * run_rsync_tasks()
+ *
+ * Execute the provided rsync commands, with at most "max_parallel" running
+ * concurrently, and log the aggregate throughput. The tasks are freed.
+ *
+ * The commands should include "--info=progress2"; the volume of data
+ * copied is added to the current clone progress unit, with "total_size"
+ * (if known) added to the unit's total.
+ *
+ * rsync's exit code 24 ("some files vanished before they could be
+ * transferred") is not treated as an error, as files may be removed from
+ * a running server while it is being copied.
+ *
+ * Returns false if any command failed.
+ */
+static bool
+run_rsync_tasks(t_command_task *tasks, int task_count, int max_parallel, uint64 total_size)
+{
+	instr_time	start_time;
+	instr_time	elapsed_time;
+	double		elapsed_secs = 0;
+	RsyncTasksProgress progress;
+	uint64		copied_bytes = 0;
+	bool		success = true;
+	int			i;
+
+	progress.task_bytes = pg_malloc0(sizeof(uint64) * task_count);
+	progress.base_copied_bytes = clone_progress.unit_copied_bytes;
+	progress.base_total_bytes = clone_progress.unit_total_bytes;
+	progress.total_bytes = total_size;
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	/*
+	 * rsync's output is processed every second, or more often with
+	 * --adaptive-rate so pauses can be ended on time; progress is reported
+	 * less often
+	 */
+	if (adaptive_rate.enabled == true)
+	{
+		adaptive_rate.paused = false;
+		INSTR_TIME_SET_CURRENT(adaptive_rate.phase_start_time);
+	}
+
+	(void) execute_commands_parallel_progress(tasks, task_count, max_parallel,
+											  adaptive_rate.enabled ? ADAPTIVE_RATE_MIN_PAUSE : 1000,
+											  rsync_tasks_progress_callback, &progress);
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+	elapsed_secs = INSTR_TIME_GET_DOUBLE(elapsed_time);
+
+	/* process any output received after the last progress callback */
+	rsync_tasks_progress_callback(tasks, task_count, &progress);
+
+	for (i = 0; i < task_count; i++)
+		copied_bytes += progress.task_bytes[i];
+
+	/* in case rsync did not report its progress */
+	if (copied_bytes == 0)
+		copied_bytes = total_size;
+
+	clone_progress.unit_copied_bytes = progress.base_copied_bytes + copied_bytes;
+	clone_progress.unit_total_bytes = progress.base_total_bytes + (total_size > 0 ? total_size : copied_bytes);
+
+	pfree(progress.task_bytes);
+
+	for (i = 0; i < task_count; i++)
+	{
+		if (tasks[i].success == false && tasks[i].return_value != 24)
+		{
+			log_error(_("rsync process %i of %i failed (return value: %i)"),
+					  i + 1, task_count, tasks[i].return_value);
+			log_detail("%s", tasks[i].command);
+			success = false;
+		}
+
+		term_command_task(&tasks[i]);
+	}
+
+	if (success == true)
+	{
+		log_info(_("copied %lu bytes in %.1f seconds (%.1f MB/s)"),
+				 copied_bytes,
+				 elapsed_secs,
+				 elapsed_secs > 0 ? ((double) copied_bytes / (1024 * 1024)) / elapsed_secs : 0);
+	}
+
+	return success;
+}
+
+
+/*
+ * qsort() comparator for TransferFile, sorting by size in descending order
+ */
+static int
+transfer_file_cmp(const void *a, const void *b)
+{
+	const TransferFile *file_a = (const TransferFile *) a;
+	const TransferFile *file_b = (const TransferFile *) b;
+
+	if (file_a->size > file_b->size)
+		return -1;
+
+	if (file_a->size < file_b->size)
+		return 1;
+
+	return 0;
+}
+
+
+/*
+ * clone_progress_start()
+ *
+ * Start tracking the progress of the clone, and open the file provided
+ * with --progress-file (if any), to which progress is written as one JSON
+ * object per line.
+ */
+static void
+clone_progress_start(void)
+{
+	memset(&clone_progress, 0, sizeof(CloneProgress));
+
+	clone_progress.tablespaces_copied = -1;
+	clone_progress.tablespaces_total = -1;
+
+	INSTR_TIME_SET_CURRENT(clone_progress.start_time);
+	clone_progress.last_report_time = clone_progress.start_time;
+
+	if (runtime_options.progress_file[0] != '\0')
+	{
+		clone_progress.progress_file = fopen(runtime_options.progress_file, "w");
+
+		if (clone_progress.progress_file == NULL)
+		{
+			log_error(_("unable to open progress file \"%s\""),
+					  runtime_options.progress_file);
+			log_detail("%s", strerror(errno));
+			exit(ERR_BAD_CONFIG);
+		}
+	}
+
+	clone_progress.active = true;
+}
+
+
+/*
+ * clone_progress_begin_unit()
+ *
+ * Start tracking a unit of the clone, e.g. the data directory or a
+ * tablespace.
+ */
+static void
+clone_progress_begin_unit(const char *unit)
+{
+	strncpy(clone_progress.unit, unit, MAXLEN);
+	clone_progress.unit_copied_bytes = 0;
+	clone_progress.unit_total_bytes = 0;
+}
+
+
+/*
+ * clone_progress_update()
+ *
+ * Record the volume of data copied so far for the current unit, and the
+ * total volume of data in the unit (if known), and report progress if
+ * CLONE_PROGRESS_INTERVAL seconds have passed since the last report.
+ */
+static void
+clone_progress_update(uint64 unit_copied_bytes, uint64 unit_total_bytes)
+{
+	instr_time	elapsed_time;
+
+	if (clone_progress.active == false)
+		return;
+
+	clone_progress.unit_copied_bytes = unit_copied_bytes;
+	clone_progress.unit_total_bytes = unit_total_bytes;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, clone_progress.last_report_time);
+
+	if (INSTR_TIME_GET_DOUBLE(elapsed_time) >= CLONE_PROGRESS_INTERVAL)
+		clone_progress_report("progress");
+}
+
+
+static void
+clone_progress_end_unit(void)
+{
+	if (clone_progress.active == false)
+		return;
+
+	clone_progress_report("unit_complete");
+
+	clone_progress.completed_bytes += clone_progress.unit_copied_bytes;
+	clone_progress.completed_total_bytes += clone_progress.unit_total_bytes;
+	clone_progress.unit_copied_bytes = 0;
+	clone_progress.unit_total_bytes = 0;
+}
+
+
+/*
+ * clone_progress_report()
+ *
+ * Log the current progress of the clone, and write it to the progress file
+ * (if any) as a JSON object, e.g.:
+ *
+ *   {"event": "progress", "unit": "data directory", "unit_bytes_copied": 1048576, ...}
+ *
+ * The overall total only includes units started so far, unless it has been
+ * determined in advance (e.g. by pg_basebackup).
+ */
+static void
+clone_progress_report(const char *event)
+{
+	instr_time	now;
+	instr_time	elapsed_time;
+	instr_time	interval_time;
+	double		elapsed_secs = 0;
+	double		interval_secs = 0;
+	uint64		copied_bytes = clone_progress.completed_bytes + clone_progress.unit_copied_bytes;
+	uint64		total_bytes = clone_progress.completed_total_bytes + clone_progress.unit_total_bytes;
+	double		average_rate = 0;
+	double		current_rate = 0;
+	char		eta_str[MAXLEN] = "null";
+
+	INSTR_TIME_SET_CURRENT(now);
+
+	elapsed_time = now;
+	INSTR_TIME_SUBTRACT(elapsed_time, clone_progress.start_time);
+	elapsed_secs = INSTR_TIME_GET_DOUBLE(elapsed_time);
+
+	interval_time = now;
+	INSTR_TIME_SUBTRACT(interval_time, clone_progress.last_report_time);
+	interval_secs = INSTR_TIME_GET_DOUBLE(interval_time);
+
+	if (elapsed_secs > 0)
+		average_rate = (double) copied_bytes / elapsed_secs;
+
+	if (interval_secs > 0 && copied_bytes >= clone_progress.last_report_bytes)
+		current_rate = (double) (copied_bytes - clone_progress.last_report_bytes) / interval_secs;
+
+	if (total_bytes > copied_bytes && average_rate > 0)
+		maxlen_snprintf(eta_str, "%.0f", (double) (total_bytes - copied_bytes) / average_rate);
+
+	if (strcmp(event, "progress") == 0 && total_bytes == 0)
+	{
+		log_info(_("%s: %lu MB copied, %.1f MB/s"),
+				 clone_progress.unit,
+				 copied_bytes / (1024 * 1024),
+				 current_rate / (1024 * 1024));
+	}
+	else if (strcmp(event, "progress") == 0)
+	{
+		log_info(_("%s: %lu of %lu MB copied; total %lu of %lu MB, %.1f MB/s, ETA %s seconds"),
+				 clone_progress.unit,
+				 clone_progress.unit_copied_bytes / (1024 * 1024),
+				 clone_progress.unit_total_bytes / (1024 * 1024),
+				 copied_bytes / (1024 * 1024),
+				 total_bytes / (1024 * 1024),
+				 current_rate / (1024 * 1024),
+				 strcmp(eta_str, "null") == 0 ? "unknown" : eta_str);
+	}
+
+	if (clone_progress.progress_file != NULL)
+	{
+		fprintf(clone_progress.progress_file,
+				"{\"event\": \"%s\", \"unit\": \"%s\", "
+				"\"unit_bytes_copied\": %lu, \"unit_bytes_total\": %lu, "
+				"\"bytes_copied\": %lu, \"bytes_total\": %lu, ",
+				event,
+				clone_progress.unit,
+				clone_progress.unit_copied_bytes,
+				clone_progress.unit_total_bytes,
+				copied_bytes,
+				total_bytes);
+
+		if (clone_progress.tablespaces_total >= 0)
+		{
+			fprintf(clone_progress.progress_file,
+					"\"tablespaces_copied\": %i, \"tablespaces_total\": %i, ",
+					clone_progress.tablespaces_copied,
+					clone_progress.tablespaces_total);
+		}
+
+		fprintf(clone_progress.progress_file,
+				"\"elapsed_seconds\": %.1f, \"current_bytes_per_second\": %.0f, "
+				"\"average_bytes_per_second\": %.0f, \"eta_seconds\": %s}\n",
+				elapsed_secs,
+				current_rate,
+				average_rate,
+				eta_str);
+
+		fflush(clone_progress.progress_file);
+	}
+
+	clone_progress.last_report_time = now;
+	clone_progress.last_report_bytes = copied_bytes;
+}
+
+
+/*
+ * clone_progress_finish()
+ *
+ * Report the final outcome of the clone, and close the progress file.
+ */
+static void
+clone_progress_finish(bool success)
+{
+	instr_time	elapsed_time;
+
+	if (clone_progress.active == false)
+		return;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, clone_progress.start_time);
+	clone_progress.elapsed_secs = INSTR_TIME_GET_DOUBLE(elapsed_time);
+
+	clone_progress_report(success ? "complete" : "failed");
+
+	if (clone_progress.progress_file != NULL)
+	{
+		fclose(clone_progress.progress_file);
+		clone_progress.progress_file = NULL;
+	}
+
+	clone_progress.active = false;
+}
+
+
+/*
+ * clone_progress_append_summary()
+ *
+ * Append a summary of the volume of data copied and the average throughput
+ * to "details" (the "standby_clone" event details).
+ */
+static void
+clone_progress_append_summary(PQExpBufferData *details)
+{
+	double		elapsed_secs = clone_progress.elapsed_secs;
+
+	if (clone_progress.completed_bytes > 0)
+	{
+		appendPQExpBuffer(details,
+						  _("; copied %lu bytes in %.1f seconds (%.1f MB/s)"),
+						  clone_progress.completed_bytes,
+						  elapsed_secs,
+						  elapsed_secs > 0 ? ((double) clone_progress.completed_bytes / (1024 * 1024)) / elapsed_secs : 0);
+	}
+	else
+	{
+		appendPQExpBuffer(details,
+						  _("; completed in %.1f seconds"),
+						  elapsed_secs);
+	}
+}
+
+
+/*
+ * get_last_output_line()
+ *
+ * Find the last complete line (terminated by a newline or carriage return,
+ * as used by progress output on a terminal) in "output" which contains
+ * "marker", and copy it to "line".
+ *
+ * Returns false if no such line was found.
+ */
+static bool
+get_last_output_line(PQExpBufferData *output, const char *marker, char *line, int line_len)
+{
+	int			end = (int) output->len - 1;
+
+	/* ignore any incomplete line */
+	while (end >= 0 && output->data[end] != '\n' && output->data[end] != '\r')
+		end--;
+
+	while (end > 0)
+	{
+		int			start = end - 1;
+		int			len = 0;
+
+		while (start >= 0 && output->data[start] != '\n' && output->data[start] != '\r')
+			start--;
+
+		len = end - start - 1;
+
+		if (len > 0 && len < line_len)
+		{
+			memcpy(line, output->data + start + 1, len);
+			line[len] = '\0';
+
+			if (strstr(line, marker) != NULL)
+				return true;
+		}
+
+		end = start;
+	}
+
+	return false;
+}
+
+
+/*
+ * rsync_tasks_progress_callback()
+ *
+ * Executed periodically while rsync processes started by run_rsync_tasks()
+ * are running. Each process is executed with "--info=progress2", which
+ * reports the total volume of data transferred in the form:
+ *
+ *     1,234,567  12%   10.50MB/s    0:00:10
+ *
+ * Output which has been processed is discarded, as rsync may report its
+ * progress many times per second.
+ */
+static void
+rsync_tasks_progress_callback(t_command_task *tasks, int task_count, void *arg)
+{
+	RsyncTasksProgress *progress = (RsyncTasksProgress *) arg;
+	uint64		copied_bytes = 0;
+	int			i;
+
+	for (i = 0; i < task_count; i++)
+	{
+		char		line[MAXLEN] = "";
+		char	   *p = NULL;
+
+		if (get_last_output_line(&tasks[i].output, "%", line, sizeof(line)) == true)
+		{
+			uint64		bytes = 0;
+			int			last = (int) tasks[i].output.len - 1;
+
+			for (p = line; *p == ' '; p++)
+				;
+
+			for (; isdigit((unsigned char) *p) || *p == ',' || *p == '.'; p++)
+			{
+				if (isdigit((unsigned char) *p))
+					bytes = bytes * 10 + (*p - '0');
+			}
+
+			if (bytes > progress->task_bytes[i])
+				progress->task_bytes[i] = bytes;
+
+			/* discard processed output, retaining any incomplete line */
+			while (last >= 0 && tasks[i].output.data[last] != '\n' && tasks[i].output.data[last] != '\r')
+				last--;
+
+			if (last >= 0)
+			{
+				tasks[i].output.len -= last + 1;
+				memmove(tasks[i].output.data, tasks[i].output.data + last + 1, tasks[i].output.len);
+				tasks[i].output.data[tasks[i].output.len] = '\0';
+			}
+		}
+
+		copied_bytes += progress->task_bytes[i];
+	}
+
+	clone_progress_update(progress->base_copied_bytes + copied_bytes,
+						  progress->base_total_bytes + progress->total_bytes);
+
+	adaptive_rate_throttle(tasks, task_count);
+}
+
+
+/*
+ * basebackup_progress_callback()
+ *
+ * Executed periodically while pg_basebackup is running with "--progress",
+ * which reports progress in the form:
+ *
+ *   12345/67890 kB (18%), 0/2 tablespaces
+ */
+static void
+basebackup_progress_callback(t_command_task *tasks, int task_count, void *arg)
+{
+	char		line[MAXLEN] = "";
+	uint64		copied_kb = 0;
+	uint64		total_kb = 0;
+	int			tablespaces_copied = 0;
+	int			tablespaces_total = 0;
+
+	if (get_last_output_line(&tasks[0].output, " kB (", line, sizeof(line)) == false)
+		return;
+
+	if (sscanf(line, " %lu/%lu kB (%*d%%), %d/%d",
+			   &copied_kb, &total_kb, &tablespaces_copied, &tablespaces_total) != 4)
+		return;
+
+	clone_progress.tablespaces_copied = tablespaces_copied;
+	clone_progress.tablespaces_total = tablespaces_total;
+
+	clone_progress_update(copied_kb * 1024, total_kb * 1024);
+}
+
+
+/*
+ * adaptive_rate_throttle()
+ *
+ * With --adaptive-rate, executed from the rsync progress callback (every
+ * ADAPTIVE_RATE_MIN_PAUSE milliseconds) while files are being copied from
+ * the source node.
+ *
+ * Every ADAPTIVE_RATE_SAMPLE_INTERVAL seconds, the source node is checked
+ * for signs the clone is affecting production workloads: a standby's replay
+ * lag exceeding the value of --adaptive-rate, or a checkpoint having been
+ * requested (typically due to "max_wal_size" being reached). If either is
+ * detected, the time copying is paused after each ADAPTIVE_RATE_RUN_PERIOD
+ * milliseconds of transfer is doubled (up to ADAPTIVE_RATE_MAX_PAUSE
+ * milliseconds); otherwise it is halved.
+ *
+ * The rsync processes are paused with SIGSTOP and resumed with SIGCONT
+ * by a later call once the pause has elapsed, so their output continues
+ * to be read in the meantime.
+ */
+static void
+adaptive_rate_throttle(t_command_task *tasks, int task_count)
+{
+	instr_time	elapsed_time;
+
+	if (adaptive_rate.enabled == false)
+		return;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, adaptive_rate.last_sample_time);
+
+	if (INSTR_TIME_GET_DOUBLE(elapsed_time) >= ADAPTIVE_RATE_SAMPLE_INTERVAL)
+	{
+		int			lag_seconds = get_max_downstream_replay_lag_seconds(source_conn);
+		int64		checkpoint_count = get_requested_checkpoint_count(source_conn);
+		PQExpBufferData reason;
+
+		initPQExpBuffer(&reason);
+
+		if (lag_seconds > runtime_options.adaptive_rate)
+		{
+			appendPQExpBuffer(&reason,
+							  _("standby replay lag of %i seconds"),
+							  lag_seconds);
+		}
+
+		if (adaptive_rate.last_checkpoint_count >= 0 && checkpoint_count > adaptive_rate.last_checkpoint_count)
+		{
+			if (reason.len > 0)
+				appendPQExpBufferStr(&reason, ", ");
+
+			appendPQExpBufferStr(&reason, _("checkpoint requested"));
+		}
+
+		adaptive_rate.last_checkpoint_count = checkpoint_count;
+
+		if (reason.len > 0)
+		{
+			int			pause_ms = adaptive_rate.pause_ms > 0 ? adaptive_rate.pause_ms * 2 : ADAPTIVE_RATE_MIN_PAUSE;
+
+			if (pause_ms > ADAPTIVE_RATE_MAX_PAUSE)
+				pause_ms = ADAPTIVE_RATE_MAX_PAUSE;
+
+			if (pause_ms != adaptive_rate.pause_ms)
+			{
+				log_notice(_("reducing clone rate: %s on source node"), reason.data);
+				log_detail(_("copying will pause for %i ms after each second of transfer"), pause_ms);
+			}
+
+			adaptive_rate.pause_ms = pause_ms;
+		}
+		else if (adaptive_rate.pause_ms > 0)
+		{
+			adaptive_rate.pause_ms /= 2;
+
+			if (adaptive_rate.pause_ms < ADAPTIVE_RATE_MIN_PAUSE)
+			{
+				adaptive_rate.pause_ms = 0;
+				log_notice(_("resuming clone at full rate"));
+			}
+		}
+
+		termPQExpBuffer(&reason);
+
+		INSTR_TIME_SET_CURRENT(adaptive_rate.last_sample_time);
+	}
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, adaptive_rate.phase_start_time);
+
+	if (adaptive_rate.paused == true)
+	{
+		if (INSTR_TIME_GET_MILLISEC(elapsed_time) >= adaptive_rate.pause_ms)
+		{
+			signal_command_tasks(tasks, task_count, SIGCONT);
+			adaptive_rate.paused = false;
+			INSTR_TIME_SET_CURRENT(adaptive_rate.phase_start_time);
+		}
+	}
+	else if (adaptive_rate.pause_ms > 0 && INSTR_TIME_GET_MILLISEC(elapsed_time) >= ADAPTIVE_RATE_RUN_PERIOD)
+	{
+		signal_command_tasks(tasks, task_count, SIGSTOP);
+		adaptive_rate.paused = true;
+		INSTR_TIME_SET_CURRENT(adaptive_rate.phase_start_time);
+	}
+}
+
+
+/*
+ * make_rsync_bwlimit_option()
+ *
+ * With --max-rate, generate an rsync "--bwlimit" option which divides the
+ * maximum rate between "processes" concurrent rsync processes.
+ */
+static void
+make_rsync_bwlimit_option(int processes, char *buf)
+{
+	int			bwlimit = 0;
+
+	buf[0] = '\0';
+
+	if (runtime_options.max_rate == 0)
+		return;
+
+	if (processes < 1)
+		processes = 1;
+
+	bwlimit = runtime_options.max_rate / processes;
+
+	if (bwlimit < 1)
+		bwlimit = 1;
+
+	maxlen_snprintf(buf, " --bwlimit=%i", bwlimit);
+}
+
+
+/*
+ * clone_manifest_init()
+ *
+ * The clone progress manifest, stored in local_repmgr_tmp_directory, records
+ * the Barman backup being cloned:
+ *
+ *   backup_id <backup ID>
+ *
+ * When starting a new clone, create the manifest; when resuming, verify the
+ * interrupted clone was copying the same backup.
+ *
+ * Note that no record is kept of which files have been copied; when
+ * resuming, rsync is executed for all files, and will skip those which
+ * are already present with the same size and modification time. As rsync
+ * writes each file to a temporary file which is only renamed once the
+ * transfer is complete, an incompletely copied file will not match.
+ */
+static void
+clone_manifest_init(const char *backup_id)
+{
+	FILE	   *fp = NULL;
+
+	if (resume_clone == true)
+	{
+		char		line[MAXLEN] = "";
+		char		manifest_backup_id[MAXLEN] = "";
+
+		fp = fopen(clone_manifest_filename, "r");
+		if (fp == NULL)
+		{
+			log_error(_("unable to open clone progress manifest \"%s\""), clone_manifest_filename);
+			log_detail("%s", strerror(errno));
+			exit(ERR_INTERNAL);
+		}
+
+		if (fgets(line, sizeof(line), fp) == NULL ||
+			sscanf(line, "backup_id %1023s", manifest_backup_id) != 1)
+		{
+			fclose(fp);
+			log_error(_("unable to parse clone progress manifest \"%s\""), clone_manifest_filename);
+			log_hint(_("use -F/--force without --resume to start a new clone"));
+			exit(ERR_BAD_CONFIG);
+		}
+
+		fclose(fp);
+
+		if (strcmp(manifest_backup_id, backup_id) != 0)
+		{
+			log_error(_("interrupted clone was copying a different Barman backup"));
+			log_detail(_("clone progress manifest contains backup ID \"%s\", latest backup ID is \"%s\""),
+					   manifest_backup_id, backup_id);
+			log_hint(_("use -F/--force without --resume to start a new clone"));
+			exit(ERR_BAD_CONFIG);
+		}
+
+		log_verbose(LOG_INFO, _("resuming clone of Barman backup \"%s\""), backup_id);
+		return;
+	}
+
+	fp = fopen(clone_manifest_filename, "w");
+	if (fp == NULL)
+	{
+		log_error(_("unable to create clone progress manifest \"%s\""), clone_manifest_filename);
+		log_detail("%s", strerror(errno));
+		exit(ERR_INTERNAL);
+	}
+
+	fprintf(fp, "backup_id %s\n", backup_id);
+	fclose(fp);
+}
+
+
+static void
+copy_configuration_files(bool delete_after_copy)
+{
+	int			i,
+				r;
+	t_configfile_info *file = NULL;
+	char	   *host = NULL;
+
+	/* get host from upstream record */
+	host = param_get(&recovery_conninfo, "host");
+
+	if (host == NULL)
+		host = runtime_options.host;
+
+	log_notice(_("copying external configuration files from upstream node \"%s\""), host);
+
+	for (i = 0; i < config_files.entries; i++)
+	{
+		PQExpBufferData dest_path;
+
+		file = config_files.files[i];
+
+		/*
+		 * Skip files in the data directory - these will be copied during the
+		 * main backup
+		 */
+		if (file->in_data_directory == true)
+			continue;
+
+		initPQExpBuffer(&dest_path);
+
+		if (runtime_options.copy_external_config_files_destination == CONFIG_FILE_SAMEPATH)
+		{
+			appendPQExpBufferStr(&dest_path, file->filepath);
+		}
+		else
+		{
+			appendPQExpBuffer(&dest_path,
+							  "%s/%s",
+							  local_data_directory,
+							  file->filename);
+		}
+
+		r = copy_remote_files(runtime_options.host, runtime_options.remote_user,
+							  file->filepath, dest_path.data, false, source_server_version_num);
+
+		/*
+		 * TODO: collate errors into list
+		 */
+
+		if (WEXITSTATUS(r))
+		{
+			log_error(_("standby clone: unable to copy config file \"%s\""),
+					  file->filename);
+			log_hint(_("see preceding messages for details"));
+
+			if (runtime_options.force == false)
+				exit(ERR_BAD_RSYNC);
+		}
+
+		/*
+		 * This is to check we can actually copy the files before running the
+		 * main clone operation
+		 */
+		if (delete_after_copy == true)
+		{
+			/* this is very unlikely to happen, but log in case it does */
+			if (unlink(dest_path.data) < 0 && errno != ENOENT)
+			{
+				log_warning(_("unable to delete %s"), dest_path.data);
+				log_detail("%s", strerror(errno));
+			}
+		}
+
+		termPQExpBuffer(&dest_path);
+	}
+
+	return;
+}
+
+
+static void
+tablespace_data_append(TablespaceDataList *list, const char *name, const char *oid, const char *location)
+{
+	TablespaceDataListCell *cell = NULL;
+	int oid_len = strlen(oid);
+	int name_len = strlen(name);
+	int location_len = strlen(location);
+	cell = (TablespaceDataListCell *) pg_malloc0(sizeof(TablespaceDataListCell));
+
+	if (cell == NULL)
+	{
+		log_error(_("unable to allocate memory; terminating"));
+		exit(ERR_OUT_OF_MEMORY);
+	}
+
+	cell->oid = pg_malloc0(1 + oid_len);
+	cell->name = pg_malloc0(1 + name_len);
+	cell->location = pg_malloc0(1 + location_len);
+
+	strncpy(cell->oid, oid, oid_len);
+	strncpy(cell->name, name, name_len);
+	strncpy(cell->location, location, location_len);
+
+	if (list->tail)
+		list->tail->next = cell;
+	else
+		list->head = cell;
+
+	list->tail = cell;
+}
+
+
+
+/*
+ * check_primary_standby_version_match()
+ *
+ * Check server versions of supplied connections are compatible for
+ * replication purposes.
+ *
+ * Exits on error.
+ */
+static void
+check_primary_standby_version_match(PGconn *conn, PGconn *primary_conn)
+{
+	char		standby_version[MAXVERSIONSTR] = "";
+	int			standby_version_num = UNKNOWN_SERVER_VERSION_NUM;
+
+	char		primary_version[MAXVERSIONSTR] = "";
+	int			primary_version_num = UNKNOWN_SERVER_VERSION_NUM;
+
+	standby_version_num = check_server_version(conn, "standby", true, standby_version);
+
+	/* Verify that primary is a supported server version */
+	primary_version_num = check_server_version(conn, "primary", false, primary_version);
+	if (primary_version_num < 0)
+	{
+		PQfinish(conn);
+		PQfinish(primary_conn);
+		exit(ERR_BAD_CONFIG);
+	}
+
+	/* primary and standby version should match */
+	if ((primary_version_num / 100) != (standby_version_num / 100))
+	{
+		PQfinish(conn);
+		PQfinish(primary_conn);
+		log_error(_("PostgreSQL versions on primary (%s) and standby (%s) must match"),
+				  primary_version, standby_version);
+		exit(ERR_BAD_CONFIG);
+	}
+}
+
+
+static void
+check_recovery_type(PGconn *conn)
+{
+	RecoveryType recovery_type = get_recovery_type(conn);
+
+	if (recovery_type != RECTYPE_STANDBY)
+	{
+		if (recovery_type == RECTYPE_PRIMARY)
+		{
+			log_error(_("this node should be a standby (%s)"),
+					  config_file_options.conninfo);
+			PQfinish(conn);
+			exit(ERR_BAD_CONFIG);
+		}
+		else
+		{
+			log_error(_("connection to node (%s) lost"),
+					  config_file_options.conninfo);
+			PQfinish(conn);
+			exit(ERR_DB_CONN);
+		}
+	}
+}
+
+
+
+/*
+ * Creates recovery configuration for a standby.
+ *
+ * A database connection pointer is required for escaping primary_conninfo
+ * parameters. When cloning from Barman and --no-upstream-connection supplied,
+ * this might not be available.
+ */
+static bool
+create_recovery_file(t_node_info *node_record, t_conninfo_param_list *primary_conninfo, int server_version_num, char *dest, bool as_file)
+{
+	PQExpBufferData recovery_file_buf;
+	PQExpBufferData primary_conninfo_buf;
+	char		recovery_file_path[MAXPGPATH] = "";
+	FILE	   *recovery_file;
+	mode_t		um;
+
+	KeyValueList recovery_config = {NULL, NULL};
+	KeyValueListCell *cell = NULL;
+
+	initPQExpBuffer(&primary_conninfo_buf);
+
+	/* standby_mode = 'on' (Pg 11 and earlier) */
+	if (server_version_num < 120000)
+	{
+		key_value_list_set(&recovery_config,
+						   "standby_mode", "on");
+	}
+
+	/* primary_conninfo = '...' */
+	write_primary_conninfo(&primary_conninfo_buf, primary_conninfo);
+	key_value_list_set(&recovery_config,
+					   "primary_conninfo", primary_conninfo_buf.data);
+
+	/*
+	 * recovery_target_timeline = 'latest'
+	 *
+	 * PostgreSQL 11 and earlier only; 'latest' is the default from PostgreSQL 12.
+	 */
+
+	if (server_version_num < 120000)
+	{
+		key_value_list_set(&recovery_config,
+						   "recovery_target_timeline", "latest");
+	}
+
+	/* recovery_min_apply_delay = ... (optional) */
+	if (config_file_options.recovery_min_apply_delay_provided == true)
+	{
+		key_value_list_set(&recovery_config,
+						   "recovery_min_apply_delay", config_file_options.recovery_min_apply_delay);
+	}
+
+	/* primary_slot_name = '...' (optional, for 9.4 and later) */
+	if (config_file_options.use_replication_slots)
+	{
+		key_value_list_set(&recovery_config,
+						   "primary_slot_name", node_record->slot_name);
+	}
+
+	/*
+	 * If restore_command is set, we use it as restore_command in
+	 * recovery.conf
+	 */
+	if (config_file_options.restore_command[0] != '\0')
+	{
+		char	   *escaped = escape_recovery_conf_value(config_file_options.restore_command);
+
+		key_value_list_set(&recovery_config,
+						  "restore_command", escaped);
+		free(escaped);
+	}
+
+	/* archive_cleanup_command (optional) */
+	if (config_file_options.archive_cleanup_command[0] != '\0')
+	{
+		char	   *escaped = escape_recovery_conf_value(config_file_options.archive_cleanup_command);
+
+		key_value_list_set(&recovery_config,
+						  "archive_cleanup_command", escaped);
+		free(escaped);
+	}
+
+	/*
+	 * Caller requests the generated file to be written into a buffer
+	 */
+	if (as_file == false)
+	{
+		/* create file in buffer */
+		initPQExpBuffer(&recovery_file_buf);
+
+		for (cell = recovery_config.head; cell; cell = cell->next)
+		{
+			appendPQExpBuffer(&recovery_file_buf,
+							  "%s = '%s'\n",
+							  cell->key, cell->value);
+		}
+
+		maxlen_snprintf(dest, "%s", recovery_file_buf.data);
+
+		termPQExpBuffer(&recovery_file_buf);
+
+		return true;
+	}
+
+	/*
+	 * PostgreSQL 12 and later: modify postgresql.auto.conf
+	 */
+	if (server_version_num >= 120000)
+	{
+		if (modify_auto_conf(dest, &recovery_config) == false)
+		{
+			return false;
+		}
+
+		if (write_standby_signal(dest) == false)
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	/*
+	 * PostgreSQL 11 and earlier: write recovery.conf
+	 */
+	maxpath_snprintf(recovery_file_path, "%s/%s", dest, RECOVERY_COMMAND_FILE);
+	log_debug("create_recovery_file(): creating \"%s\"...",
+			  recovery_file_path);
+
+	/* Set umask to 0600 */
+	um = umask((~(S_IRUSR | S_IWUSR)) & (S_IRWXG | S_IRWXO));
+	recovery_file = fopen(recovery_file_path, "w");
+	umask(um);
+
+	if (recovery_file == NULL)
+	{
+		log_error(_("unable to create recovery.conf file at \"%s\""),
+				  recovery_file_path);
+		log_detail("%s", strerror(errno));
+
+		return false;
+	}
+
+	for (cell = recovery_config.head; cell; cell = cell->next)
+	{
+		initPQExpBuffer(&recovery_file_buf);
+		appendPQExpBuffer(&recovery_file_buf,
+						  "%s = '%s'\n",
+						  cell->key, cell->value);
+
+		log_debug("recovery.conf line: %s", recovery_file_buf.data);
+
+		if (fputs(recovery_file_buf.data, recovery_file) == EOF)
+		{
+			log_error(_("unable to write to recovery file at \"%s\""), recovery_file_path);
+			fclose(recovery_file);
+			termPQExpBuffer(&recovery_file_buf);
+			return false;
+		}
+
+		termPQExpBuffer(&recovery_file_buf);
+	}
+
+
+	fclose(recovery_file);
+
+	return true;
+}
+
+
+static void
+write_primary_conninfo(PQExpBufferData *dest, t_conninfo_param_list *param_list)
+{
+	PQExpBufferData conninfo_buf;
+	bool		application_name_provided = false;
+	bool		password_provided = false;
+	int			c;
+	char	   *escaped = NULL;
+	t_conninfo_param_list env_conninfo = T_CONNINFO_PARAM_LIST_INITIALIZER;
+
+	initialize_conninfo_params(&env_conninfo, true);
+
+	initPQExpBuffer(&conninfo_buf);
+
+	for (c = 0; c < param_list->size && param_list->keywords[c] != NULL; c++)
+	{
+		/*
+		 * Skip empty settings and ones which don't make any sense in
+		 * recovery.conf
+		 */
+		if (strcmp(param_list->keywords[c], "dbname") == 0 ||
+			strcmp(param_list->keywords[c], "replication") == 0 ||
+			(param_list->values[c] == NULL) ||
+			(param_list->values[c] != NULL && param_list->values[c][0] == '\0'))
+			continue;
+
+		/* only include "password" if explicitly requested */
+		if (strcmp(param_list->keywords[c], "password") == 0)
+		{
+			password_provided = true;
+		}
+
+		if (conninfo_buf.len != 0)
+			appendPQExpBufferChar(&conninfo_buf, ' ');
+
+		if (strcmp(param_list->keywords[c], "application_name") == 0)
+			application_name_provided = true;
+
+		appendPQExpBuffer(&conninfo_buf, "%s=", param_list->keywords[c]);
+		appendConnStrVal(&conninfo_buf, param_list->values[c]);
+	}
+
+	/* "application_name" not provided - default to repmgr node name */
+	if (application_name_provided == false)
+	{
+		if (strlen(config_file_options.node_name))
+		{
+			appendPQExpBufferStr(&conninfo_buf, " application_name=");
+			appendConnStrVal(&conninfo_buf, config_file_options.node_name);
+		}
+		else
+		{
+			appendPQExpBufferStr(&conninfo_buf, " application_name=repmgr");
+		}
+	}
+
+	/* no password provided explicitly  */
+	if (password_provided == false)
+	{
+		if (config_file_options.use_primary_conninfo_password == true)
+		{
+			const char *password = param_get(&env_conninfo, "password");
+
+			if (password != NULL)
+			{
+				appendPQExpBufferStr(&conninfo_buf, " password=");
+				appendConnStrVal(&conninfo_buf, password);
+			}
+		}
+	}
+
+	/* passfile provided as configuration option */
+	if (config_file_options.passfile[0] != '\0')
+	{
+		/* check if the libpq we're using supports "passfile=" */
+		if (has_passfile() == true)
+		{
+			appendPQExpBufferStr(&conninfo_buf, " passfile=");
+			appendConnStrVal(&conninfo_buf, config_file_options.passfile);
+		}
+	}
+
+	escaped = escape_recovery_conf_value(conninfo_buf.data);
+
+	appendPQExpBufferStr(dest, escaped);
+
+	free(escaped);
+	free_conninfo_params(&env_conninfo);
+	termPQExpBuffer(&conninfo_buf);
+}
+
+
+/*
+ * For "standby promote" and "standby follow", check for sibling nodes.
+ * If "--siblings-follow" was specified, fill the provided SiblingNodeStats
+ * struct with some aggregate info about the nodes for later
+ * decision making.
+ */
+static bool
+check_sibling_nodes(NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats)
+{
+	char		host[MAXLEN] = "";
+	NodeInfoListCell *cell;
+	t_command_task *tasks = NULL;
+	int			task_count = 0;
+
+	/*
+	 * If --siblings-follow not specified, warn about any extant
+	 * siblings which will not follow the new primary
+	 */
+
+	if (runtime_options.siblings_follow == false)
+	{
+		if (sibling_nodes->node_count > 0)
+		{
+			PQExpBufferData nodes;
+
+			initPQExpBuffer(&nodes);
+
+			for (cell = sibling_nodes->head; cell; cell = cell->next)
+			{
+				appendPQExpBuffer(&nodes,
+								  "  %s (node ID: %i",
+								  cell->node_info->node_name,
+								  cell->node_info->node_id);
+
+				if (cell->node_info->type == WITNESS)
+				{
+					appendPQExpBufferStr(&nodes,
+										 ", witness server");
+				}
+				appendPQExpBufferChar(&nodes,
+									  ')');
+				if (cell->next)
+					appendPQExpBufferStr(&nodes, "\n");
+			}
+
+			log_warning(_("%i sibling nodes found, but option \"--siblings-follow\" not specified"),
+						sibling_nodes->node_count);
+			log_detail(_("these nodes will remain attached to the current primary:\n%s"), nodes.data);
+
+			termPQExpBuffer(&nodes);
+		}
+
+		return true;
+	}
+
+	log_verbose(LOG_INFO, _("%i active sibling nodes found"),
+				sibling_nodes->node_count);
+
+	if (sibling_nodes->node_count == 0)
+	{
+		log_warning(_("option \"--sibling-nodes\" specified, but no sibling nodes exist"));
+		return true;
+	}
+
+	/*
+	 * Check SSH connectivity to all siblings concurrently, so the time taken
+	 * does not increase with the number of siblings; as with
+	 * test_ssh_connection(), "true" may be located in either directory on
+	 * the remote host.
+	 */
+	tasks = pg_malloc0(sizeof(t_command_task) * sibling_nodes->node_count);
+
+	for (cell = sibling_nodes->head; cell; cell = cell->next)
+	{
+		PQExpBufferData ssh_command;
+
+		/* get host from node record */
+		get_conninfo_value(cell->node_info->conninfo, "host", host);
+
+		initPQExpBuffer(&ssh_command);
+		make_remote_command(host,
+							runtime_options.remote_user,
+							"\"/bin/true 2>/dev/null || /usr/bin/true\" 2>/dev/null",
+							config_file_options.ssh_options,
+							&ssh_command);
+
+		init_command_task(&tasks[task_count], task_count, ssh_command.data);
+		task_count++;
+
+		termPQExpBuffer(&ssh_command);
+	}
+
+	(void) execute_commands_parallel(tasks, task_count, task_count,
+									 SIBLING_SSH_CHECK_TIMEOUT, NULL, NULL);
+
+	task_count = 0;
+
+	for (cell = sibling_nodes->head; cell; cell = cell->next)
+	{
+		t_command_task *task = &tasks[task_count++];
+
+		if (task->success == false)
+		{
+			get_conninfo_value(cell->node_info->conninfo, "host", host);
+
+			if (task->timed_out == true)
+			{
+				log_warning(_("SSH connection to remote host \"%s\" timed out after %i seconds"),
+							host, SIBLING_SSH_CHECK_TIMEOUT);
+			}
+			else
+			{
+				log_warning(_("unable to connect to remote host \"%s\" via SSH"), host);
+			}
+
+			cell->node_info->reachable = false;
+			sibling_nodes_stats->unreachable_sibling_node_count++;
+		}
+		else
+		{
+			cell->node_info->reachable = true;
+			sibling_nodes_stats->reachable_sibling_node_count++;
+			sibling_nodes_stats->min_required_wal_senders++;
+
+			if (cell->node_info->slot_name[0] != '\0')
+			{
+				sibling_nodes_stats->reachable_sibling_nodes_with_slot_count++;
+				sibling_nodes_stats->min_required_free_slots++;
+			}
+		}
+
+		term_command_task(task);
+	}
+
+	pfree(tasks);
+
+	if (sibling_nodes_stats->unreachable_sibling_node_count > 0)
+	{
+		if (runtime_options.force == false)
+		{
+			log_error(_("%i of %i sibling nodes unreachable via SSH:"),
+					  sibling_nodes_stats->unreachable_sibling_node_count,
+					  sibling_nodes->node_count);
+		}
+		else
+		{
+			log_warning(_("%i of %i sibling nodes unreachable via SSH:"),
+						sibling_nodes_stats->unreachable_sibling_node_count,
+						sibling_nodes->node_count);
+		}
+
+		/* display list of unreachable sibling nodes */
+		for (cell = sibling_nodes->head; cell; cell = cell->next)
+		{
+			if (cell->node_info->reachable == true)
+				continue;
+			log_detail("  %s (ID: %i)",
+					   cell->node_info->node_name,
+					   cell->node_info->node_id);
+		}
+
+		if (runtime_options.force == false)
+		{
+			log_hint(_("use -F/--force to proceed in any case"));
+			return false;
+		}
+
+		if (runtime_options.dry_run == true)
+		{
+			log_detail(_("F/--force specified, would proceed anyway"));
+		}
+		else
+		{
+			log_detail(_("F/--force specified, proceeding anyway"));
+		}
+	}
+	else
+	{
+		char	   *msg = _("all sibling nodes are reachable via SSH");
+
+		if (runtime_options.dry_run == true)
+		{
+			log_info("%s", msg);
+		}
+		else
+		{
+			log_verbose(LOG_INFO, "%s", msg);
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+check_free_wal_senders(int available_wal_senders, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success)
+{
+	if (available_wal_senders < sibling_nodes_stats->min_required_wal_senders)
+	{
+		if (runtime_options.force == false || runtime_options.dry_run == true)
+		{
+			log_error(_("insufficient free walsenders on promotion candidate"));
+			log_detail(_("at least %i walsenders required but only %i free walsenders on promotion candidate"),
+					   sibling_nodes_stats->min_required_wal_senders,
+					   available_wal_senders);
+			log_hint(_("increase parameter \"max_wal_senders\" or use -F/--force to proceed in any case"));
+
+			if (runtime_options.dry_run == true)
+			{
+				*dry_run_success = false;
+			}
+			else
+			{
+				return false;
+			}
+		}
+		else
+		{
+			log_warning(_("insufficient free walsenders on promotion candidate"));
+			log_detail(_("at least %i walsenders required but only %i free walsender(s) on promotion candidate"),
+					   sibling_nodes_stats->min_required_wal_senders,
+					   available_wal_senders);
+			return false;
+		}
+	}
+	else
+	{
+		if (runtime_options.dry_run == true)
+		{
+			log_info(_("%i walsenders required, %i available"),
+					 sibling_nodes_stats->min_required_wal_senders,
+					 available_wal_senders);
+		}
+	}
+
+	return true;
+}
+
+
+static bool
+check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success)
+{
+	if (sibling_nodes_stats->min_required_free_slots > 0 )
+	{
+		int available_slots = local_node_record->max_replication_slots -
+			local_node_record->active_replication_slots;
+
+		log_debug("minimum of %i free slots (%i for siblings) required; %i available",
+				  sibling_nodes_stats->min_required_free_slots,
+				  sibling_nodes_stats->reachable_sibling_nodes_with_slot_count,
+				  available_slots);
+
+		if (available_slots < sibling_nodes_stats->min_required_free_slots)
+		{
+			if (runtime_options.force == false || runtime_options.dry_run == true)
+			{
+				log_error(_("insufficient free replication slots to attach all nodes"));
+				log_detail(_("at least %i additional replication slots required but only %i free slots available on promotion candidate"),
+						   sibling_nodes_stats->min_required_free_slots,
+						   available_slots);
+				log_hint(_("increase parameter \"max_replication_slots\" or use -F/--force to proceed in any case"));
+
+				if (runtime_options.dry_run == true)
+				{
+					*dry_run_success = false;
+				}
+				else
+				{
+					return false;
+				}
+			}
+		}
+		else
+		{
+			if (runtime_options.dry_run == true)
+			{
+				log_info(_("%i replication slots required, %i available"),
+						 sibling_nodes_stats->min_required_free_slots,
+						 available_slots);
+			}
+		}
+	}
+
+	return true;
+}
+
+
+/*
+ * queue_switchover_prechecks()
+ *
+ * Submit the remote prechecks executed by "standby switchover" to the
+ * agent in a single batch; the conditions must match those under which
+ * the respective checks are executed. Results which are not read are
+ * discarded by remote_agent_command().
+ */
+static void
+queue_switchover_prechecks(t_remote_agent *agent, PGconn *local_conn, PGconn *remote_conn, int local_node_id, int remote_repmgr_version)
+{
+	PQExpBufferData request;
+
+	initPQExpBuffer(&request);
+
+	(void) remote_agent_send(agent, SWITCHOVER_DATA_DIRECTORY_CONFIG_CHECK);
+
+	if (runtime_options.superuser[0] != '\0')
+	{
+		appendPQExpBuffer(&request,
+						  SWITCHOVER_SUPERUSER_CHECK,
+						  runtime_options.superuser);
+		(void) remote_agent_send(agent, request.data);
+	}
+
+	if (PQserverVersion(local_conn) >= 120000 && remote_repmgr_version >= 50100)
+		(void) remote_agent_send(agent, SWITCHOVER_REPLICATION_CONFIG_OWNER_CHECK);
+
+	resetPQExpBuffer(&request);
+	appendPQExpBuffer(&request,
+					  SWITCHOVER_REPLICATION_CONNECTION_CHECK,
+					  local_node_id);
+	(void) remote_agent_send(agent, request.data);
+
+	if (guc_set(remote_conn, "archive_mode", "!=", "off"))
+		(void) remote_agent_send(agent, SWITCHOVER_ARCHIVE_READY_CHECK);
+
+	termPQExpBuffer(&request);
+}
+
+
+/*
+ * switchover_remote_command()
+ *
+ * Execute a repmgr command on the demotion candidate; "request" is the
+ * command line without the repmgr binary and configuration file. The
+ * command is executed via the agent if available, otherwise (or if the
+ * agent session fails) via a separate SSH connection.
+ */
+static bool
+switchover_remote_command(t_remote_agent *agent, t_node_info *remote_node_record, const char *remote_host, const char *request, PQExpBufferData *outputbuf)
+{
+	PQExpBufferData remote_command_str;
+	bool		success = false;
+
+	if (agent->active == true)
+	{
+		if (remote_agent_command(agent, request, outputbuf, NULL) == true)
+			return true;
+
+		log_warning(_("\"%s node agent\" session on \"%s\" failed, executing remote commands individually"),
+					progname(), remote_host);
+
+		if (outputbuf != NULL)
+			resetPQExpBuffer(outputbuf);
+	}
+
+	initPQExpBuffer(&remote_command_str);
+	make_remote_repmgr_path(&remote_command_str, remote_node_record);
+	appendPQExpBufferStr(&remote_command_str, request);
+
+	success = remote_command(remote_host,
+							 runtime_options.remote_user,
+							 remote_command_str.data,
+							 config_file_options.ssh_options,
+							 outputbuf);
+
+	termPQExpBuffer(&remote_command_str);
+
+	return success;
+}
+
+
+/*
+ * switchover_prepare()
+ *
+ * Reduce the time the cluster is unavailable for writes: before the
+ * demotion candidate is shut down, issue a CHECKPOINT there (so the
+ * shutdown checkpoint has little to do), then wait up to
+ * "switchover_prepare_timeout" seconds for the promotion candidate's receive
+ * and replay lag to drop below "switchover_prepare_lag_bytes" and
+ * "switchover_prepare_lag_seconds" (so little WAL remains to be streamed
+ * and replayed after shutdown). Once the primary's checkpoint has been
+ * replayed, a CHECKPOINT on the promotion candidate creates a restartpoint,
+ * reducing the work of the checkpoint following promotion.
+ *
+ * Failure to complete any of these steps is not an error, as the
+ * subsequent shutdown and WAL checks do not depend on them.
+ */
+static void
+switchover_prepare(PGconn *local_conn, PGconn *superuser_conn, t_node_info *remote_node_record)
+{
+	PGconn	   *remote_conn = NULL;
+	PGconn	   *checkpoint_conn = NULL;
+	PGconn	   *remote_superuser_conn = NULL;
+	ReplInfo	replication_info;
+	XLogRecPtr	primary_lsn = InvalidXLogRecPtr;
+	uint64		receive_lag_bytes = 0;
+	uint64		replay_lag_bytes = 0;
+	bool		lag_acceptable = false;
+	AdaptivePoll poll_state;
+
+	if (config_file_options.switchover_prepare_timeout == 0)
+	{
+		log_verbose(LOG_DEBUG, "\"switchover_prepare_timeout\" is 0, skipping prepare phase");
+		return;
+	}
+
+	if (runtime_options.dry_run == true)
+	{
+		log_info(_("would issue CHECKPOINT on node \"%s\" (ID: %i) and wait up to %i seconds (\"switchover_prepare_timeout\") for replication lag to drop below %i bytes and %i seconds"),
+				 remote_node_record->node_name,
+				 remote_node_record->node_id,
+				 config_file_options.switchover_prepare_timeout,
+				 config_file_options.switchover_prepare_lag_bytes,
+				 config_file_options.switchover_prepare_lag_seconds);
+		return;
+	}
+
+	/* the connection used for the prechecks has been closed at this point */
+	remote_conn = establish_db_connection(remote_node_record->conninfo, false);
+
+	if (PQstatus(remote_conn) != CONNECTION_OK)
+	{
+		log_warning(_("unable to connect to node \"%s\" (ID: %i), skipping prepare phase"),
+					remote_node_record->node_name,
+					remote_node_record->node_id);
+		PQfinish(remote_conn);
+		return;
+	}
+
+	/* CHECKPOINT on the demotion candidate */
+	if (can_execute_checkpoint(remote_conn) == true)
+	{
+		checkpoint_conn = remote_conn;
+	}
+	else if (runtime_options.superuser[0] != '\0')
+	{
+		remote_superuser_conn = establish_db_connection_with_replacement_param(remote_node_record->conninfo,
+																			   "user",
+																			   runtime_options.superuser,
+																			   false);
+
+		if (PQstatus(remote_superuser_conn) == CONNECTION_OK)
+			checkpoint_conn = remote_superuser_conn;
+	}
+
+	if (checkpoint_conn != NULL)
+	{
+		log_notice(_("issuing CHECKPOINT on node \"%s\" (ID: %i)"),
+				   remote_node_record->node_name,
+				   remote_node_record->node_id);
+		checkpoint(checkpoint_conn);
+	}
+	else
+	{
+		log_info(_("unable to issue CHECKPOINT on node \"%s\" (ID: %i) before shutdown"),
+				 remote_node_record->node_name,
+				 remote_node_record->node_id);
+		log_detail(_("the CHECKPOINT will be issued by the shutdown command"));
+	}
+
+	if (remote_superuser_conn != NULL)
+		PQfinish(remote_superuser_conn);
+
+	/* wait for the promotion candidate to catch up */
+	init_replication_info(&replication_info);
+
+	adaptive_poll_start(&poll_state, config_file_options.switchover_prepare_timeout);
+
+	do
+	{
+		primary_lsn = get_primary_current_lsn(remote_conn);
+
+		if (primary_lsn == InvalidXLogRecPtr || get_replication_info(local_conn, STANDBY, &replication_info) == false)
+			break;
+
+		receive_lag_bytes = primary_lsn > replication_info.last_wal_receive_lsn
+			? primary_lsn - replication_info.last_wal_receive_lsn : 0;
+		replay_lag_bytes = primary_lsn > replication_info.last_wal_replay_lsn
+			? primary_lsn - replication_info.last_wal_replay_lsn : 0;
+
+		log_verbose(LOG_DEBUG, "switchover_prepare(): receive lag %lu bytes, replay lag %lu bytes, %i seconds",
+					receive_lag_bytes,
+					replay_lag_bytes,
+					replication_info.replication_lag_time);
+
+		if (receive_lag_bytes <= (uint64) config_file_options.switchover_prepare_lag_bytes
+			&& replay_lag_bytes <= (uint64) config_file_options.switchover_prepare_lag_bytes
+			&& replication_info.replication_lag_time <= config_file_options.switchover_prepare_lag_seconds)
+		{
+			lag_acceptable = true;
+			break;
+		}
+
+		if (adaptive_poll_log_due(&poll_state) == true)
+		{
+			log_info(_("waiting for replication lag to drop (receive lag %lu bytes, replay lag %lu bytes); %i of %i seconds (\"switchover_prepare_timeout\")"),
+					 receive_lag_bytes,
+					 replay_lag_bytes,
+					 adaptive_poll_elapsed(&poll_state),
+					 config_file_options.switchover_prepare_timeout);
+		}
+	} while (adaptive_poll_wait(&poll_state) == true);
+
+	if (lag_acceptable == false)
+	{
+		log_warning(_("replication lag did not drop below %i bytes and %i seconds within %i seconds"),
+					config_file_options.switchover_prepare_lag_bytes,
+					config_file_options.switchover_prepare_lag_seconds,
+					config_file_options.switchover_prepare_timeout);
+		log_detail(_("receive lag is %lu bytes, replay lag is %lu bytes; continuing with switchover"),
+				   receive_lag_bytes,
+				   replay_lag_bytes);
+		PQfinish(remote_conn);
+		return;
+	}
+
+	PQfinish(remote_conn);
+
+	log_info(_("replication lag is %lu bytes"), replay_lag_bytes);
+
+	/* CHECKPOINT on the promotion candidate, which creates a restartpoint */
+	checkpoint_conn = superuser_conn != NULL ? superuser_conn : local_conn;
+
+	if (can_execute_checkpoint(checkpoint_conn) == true)
+	{
+		log_notice(_("issuing CHECKPOINT on node \"%s\" (ID: %i)"),
+				   config_file_options.node_name,
+				   config_file_options.node_id);
+		checkpoint(checkpoint_conn);
+	}
+}
+
+
+/*
+ * switchover_estimate_downtime()
+ *
+ * For --dry-run, estimate how long the cluster will be unavailable for
+ * writes, i.e. from issuing the shutdown command on the demotion candidate
+ * until the promotion candidate has been promoted. This consists of:
+ *
+ *  - round trips to the demotion candidate for the shutdown command and
+ *    the shutdown status check (measured)
+ *  - writing dirty buffers in the shutdown checkpoint (measured with
+ *    "pg_buffercache" if installed, otherwise estimated from the WAL
+ *    generated since the last checkpoint, up to "shared_buffers")
+ *  - replaying any WAL the promotion candidate has not yet replayed
+ *    (measured)
+ *  - promotion (taken from the phase timings of recent switchovers)
+ *
+ * If the prepare phase is enabled, the CHECKPOINT it issues writes the
+ * dirty buffers before the demotion candidate is shut down, and the
+ * replication lag is reduced to "switchover_prepare_lag_bytes", so only
+ * WAL generated after that remains; this is assumed to be no more than
+ * "switchover_prepare_lag_bytes".
+ *
+ * Write and replay rates are estimated with SWITCHOVER_ESTIMATE_WRITE_RATE
+ * and SWITCHOVER_ESTIMATE_REPLAY_RATE, so the result is an indication only.
+ */
+static void
+switchover_estimate_downtime(PGconn *local_conn, t_remote_agent *agent, t_node_info *remote_node_record, const char *remote_host)
+{
+	PGconn	   *remote_conn = NULL;
+	t_remote_agent no_agent = T_REMOTE_AGENT_INITIALIZER;
+	ReplInfo	replication_info;
+	XLogRecPtr	primary_lsn = InvalidXLogRecPtr;
+	XLogRecPtr	checkpoint_lsn = InvalidXLogRecPtr;
+	uint64		receive_lag_bytes = 0;
+	uint64		replay_lag_bytes = 0;
+	int64		checkpoint_distance = -1;
+	int64		dirty_bytes = -1;
+	int64		flush_bytes = 0;
+	uint64		replay_bytes = 0;
+	int			shared_buffers = 0;
+	int			promote_ms = -1;
+	int			promote_samples = 0;
+	double		ssh_rtt_ms = -1;
+	double		agent_rtt_ms = -1;
+	double		command_rtt_ms = 0;
+	double		flush_ms = 0;
+	double		replay_ms = 0;
+	double		total_ms = 0;
+	bool		prepare_enabled = config_file_options.switchover_prepare_timeout > 0;
+
+	remote_conn = establish_db_connection(remote_node_record->conninfo, false);
+
+	if (PQstatus(remote_conn) != CONNECTION_OK)
+	{
+		log_warning(_("unable to connect to node \"%s\" (ID: %i), unable to estimate switchover downtime"),
+					remote_node_record->node_name,
+					remote_node_record->node_id);
+		PQfinish(remote_conn);
+		return;
+	}
+
+	/* round trip times; the agent is used for remote commands if available */
+	ssh_rtt_ms = time_switchover_remote_command(&no_agent, remote_node_record, remote_host);
+
+	if (agent->active == true)
+	{
+		agent_rtt_ms = time_switchover_remote_command(agent, remote_node_record, remote_host);
+		command_rtt_ms = agent_rtt_ms;
+	}
+	else
+	{
+		command_rtt_ms = ssh_rtt_ms;
+	}
+
+	/* replication lag */
+	init_replication_info(&replication_info);
+
+	primary_lsn = get_primary_current_lsn(remote_conn);
+
+	if (primary_lsn != InvalidXLogRecPtr && get_replication_info(local_conn, STANDBY, &replication_info) == true)
+	{
+		receive_lag_bytes = primary_lsn > replication_info.last_wal_receive_lsn
+			? primary_lsn - replication_info.last_wal_receive_lsn : 0;
+		replay_lag_bytes = primary_lsn > replication_info.last_wal_replay_lsn
+			? primary_lsn - replication_info.last_wal_replay_lsn : 0;
+	}
+
+	/* checkpoint distance and dirty buffers on the demotion candidate */
+	checkpoint_lsn = get_last_checkpoint_lsn(remote_conn);
+
+	if (primary_lsn != InvalidXLogRecPtr && checkpoint_lsn != InvalidXLogRecPtr && primary_lsn >= checkpoint_lsn)
+		checkpoint_distance = (int64) (primary_lsn - checkpoint_lsn);
+
+	dirty_bytes = get_dirty_buffer_bytes(remote_conn);
+
+	if (dirty_bytes >= 0)
+	{
+		flush_bytes = dirty_bytes;
+	}
+	else if (checkpoint_distance >= 0)
+	{
+		flush_bytes = checkpoint_distance;
+
+		if (get_pg_setting_int(remote_conn, "shared_buffers", &shared_buffers) == true
+			&& flush_bytes > (int64) shared_buffers * BLCKSZ)
+			flush_bytes = (int64) shared_buffers * BLCKSZ;
+	}
+
+	PQfinish(remote_conn);
+
+	/* promotion time from recent switchovers */
+	promote_ms = get_switchover_promote_duration(local_conn, SWITCHOVER_ESTIMATE_SAMPLES, &promote_samples);
+
+	if (promote_ms < 0)
+		promote_ms = SWITCHOVER_ESTIMATE_PROMOTE_MS;
+
+	/* model */
+	replay_bytes = replay_lag_bytes;
+
+	if (prepare_enabled == true)
+	{
+		if (flush_bytes > config_file_options.switchover_prepare_lag_bytes)
+			flush_bytes = config_file_options.switchover_prepare_lag_bytes;
+
+		if (replay_bytes > (uint64) config_file_options.switchover_prepare_lag_bytes)
+			replay_bytes = config_file_options.switchover_prepare_lag_bytes;
+	}
+
+	flush_ms = (double) flush_bytes * 1000 / SWITCHOVER_ESTIMATE_WRITE_RATE;
+	replay_ms = (double) replay_bytes * 1000 / SWITCHOVER_ESTIMATE_REPLAY_RATE;
+
+	/* shutdown command, and shutdown status check */
+	total_ms = (command_rtt_ms * 2) + flush_ms + replay_ms + promote_ms;
+
+	switchover_timing.estimated_downtime_ms = total_ms;
+
+	log_info(_("receive lag is %lu bytes, replay lag is %lu bytes"),
+			 receive_lag_bytes, replay_lag_bytes);
+
+	if (checkpoint_distance >= 0)
+	{
+		log_info(_("%lu bytes of WAL generated on node \"%s\" since the last checkpoint"),
+				 (uint64) checkpoint_distance,
+				 remote_node_record->node_name);
+	}
+
+	if (dirty_bytes >= 0)
+	{
+		log_info(_("%lu bytes of dirty buffers on node \"%s\""),
+				 (uint64) dirty_bytes,
+				 remote_node_record->node_name);
+	}
+	else
+	{
+		log_info(_("extension \"pg_buffercache\" not available on node \"%s\", estimating dirty buffers from WAL generated since the last checkpoint"),
+				 remote_node_record->node_name);
+	}
+
+	if (ssh_rtt_ms >= 0)
+		log_info(_("remote command round trip via SSH: %.0f ms"), ssh_rtt_ms);
+
+	if (agent_rtt_ms >= 0)
+		log_info(_("remote command round trip via agent: %.0f ms"), agent_rtt_ms);
+
+	if (promote_samples > 0)
+	{
+		log_info(_("average promotion time in the last %i switchovers: %i ms"),
+				 promote_samples, promote_ms);
+	}
+	else
+	{
+		log_info(_("no previous switchover timings found, assuming promotion time of %i ms"),
+				 promote_ms);
+	}
+
+	log_notice(_("estimated time unavailable for writes: %.0f ms"), total_ms);
+	log_detail(_("remote commands %.0f ms, shutdown checkpoint %.0f ms, WAL replay %.0f ms, promotion %i ms%s"),
+			   command_rtt_ms * 2,
+			   flush_ms,
+			   replay_ms,
+			   promote_ms,
+			   prepare_enabled == true ? " (after prepare phase)" : "");
+}
+
+
+/*
+ * time_switchover_remote_command()
+ *
+ * Return the time in milliseconds taken to execute a trivial repmgr
+ * command on the remote node, or -1 if it could not be executed.
+ */
+static double
+time_switchover_remote_command(t_remote_agent *agent, t_node_info *remote_node_record, const char *remote_host)
+{
+	PQExpBufferData command_output;
+	instr_time	start_time;
+	instr_time	elapsed_time;
+	bool		success = false;
+
+	initPQExpBuffer(&command_output);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	success = switchover_remote_command(agent,
+										remote_node_record,
+										remote_host,
+										"--version",
+										&command_output);
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+
+	termPQExpBuffer(&command_output);
+
+	if (success == false)
+		return -1;
+
+	return INSTR_TIME_GET_MILLISEC(elapsed_time);
+}
+
+
+/*
+ * adaptive_poll_start()
+ *
+ * Start a wait loop of up to "timeout" seconds; used as:
+ *
+ *   adaptive_poll_start(&poll_state, timeout);
+ *   do
+ *   {
+ *       if (condition met)
+ *           break;
+ *   } while (adaptive_poll_wait(&poll_state) == true);
+ *
+ * Polling initially every ADAPTIVE_POLL_MIN_INTERVAL milliseconds means a
+ * condition which is met quickly is detected quickly, while backing off to
+ * ADAPTIVE_POLL_MAX_INTERVAL (or "max_interval_ms", if changed after this
+ * function is called) avoids excessive load on longer waits.
+ */
+static void
+adaptive_poll_start(AdaptivePoll *poll_state, int timeout)
+{
+	INSTR_TIME_SET_CURRENT(poll_state->start_time);
+	poll_state->timeout = timeout;
+	poll_state->interval_ms = ADAPTIVE_POLL_MIN_INTERVAL;
+	poll_state->max_interval_ms = ADAPTIVE_POLL_MAX_INTERVAL;
+	poll_state->last_logged_secs = -1;
+}
+
+
+/*
+ * adaptive_poll_wait()
+ *
+ * Sleep until the next poll; returns false without sleeping if the
+ * timeout has expired. The final sleep is shortened so the last poll takes
+ * place when the timeout expires.
+ */
+static bool
+adaptive_poll_wait(AdaptivePoll *poll_state)
+{
+	instr_time	elapsed_time;
+	double		remaining_ms;
+	long		sleep_ms = poll_state->interval_ms;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, poll_state->start_time);
+
+	remaining_ms = ((double) poll_state->timeout * 1000) - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+	if (remaining_ms <= 0)
+		return false;
+
+	if (remaining_ms < sleep_ms)
+		sleep_ms = (long) remaining_ms + 1;
+
+	pg_usleep(sleep_ms * 1000L);
+
+	if (poll_state->interval_ms * 2 <= poll_state->max_interval_ms)
+		poll_state->interval_ms *= 2;
+	else
+		poll_state->interval_ms = poll_state->max_interval_ms;
+
+	return true;
+}
+
+
+static int
+adaptive_poll_elapsed(AdaptivePoll *poll_state)
+{
+	instr_time	elapsed_time;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, poll_state->start_time);
+
+	return (int) INSTR_TIME_GET_DOUBLE(elapsed_time);
+}
+
+
+/*
+ * adaptive_poll_log_due()
+ *
+ * Returns true at most once per elapsed second, so progress messages are
+ * emitted at the same rate as with the previous one-second polling.
+ */
+static bool
+adaptive_poll_log_due(AdaptivePoll *poll_state)
+{
+	int			elapsed_secs = adaptive_poll_elapsed(poll_state);
+
+	if (elapsed_secs <= poll_state->last_logged_secs)
+		return false;
+
+	poll_state->last_logged_secs = elapsed_secs;
 
-			log_warning(_("%i sibling nodes found, but option \"--siblings-follow\" not specified"),
-						sibling_nodes->node_count);
-			log_detail(_("these nodes will remain attached to the current primary:\n%s"), nodes.data);
+	return true;
+}
 
-			termPQExpBuffer(&nodes);
-		}
 
-		return true;
-	}
+/*
+ * switchover_timing_start()
+ *
+ * Start timing "standby switchover", beginning with the prechecks phase.
+ * If --report-json was provided, the report file is opened here, so an
+ * unusable path is reported before any action is taken, and written
+ * when repmgr exits, so the report also covers an aborted switchover.
+ */
+static void
+switchover_timing_start(void)
+{
+	memset(&switchover_timing, 0, sizeof(SwitchoverTiming));
 
-	log_verbose(LOG_INFO, _("%i active sibling nodes found"),
-				sibling_nodes->node_count);
+	switchover_timing.current_phase = SWITCHOVER_PHASE_NONE;
+	switchover_timing.last_phase = SWITCHOVER_PHASE_NONE;
+	switchover_timing.promotion_candidate_node_id = config_file_options.node_id;
+	switchover_timing.demotion_candidate_node_id = UNKNOWN_NODE_ID;
+	switchover_timing.result = "failed";
+	switchover_timing.estimated_downtime_ms = -1;
 
-	if (sibling_nodes->node_count == 0)
-	{
-		log_warning(_("option \"--sibling-nodes\" specified, but no sibling nodes exist"));
-		return true;
-	}
+	INSTR_TIME_SET_CURRENT(switchover_timing.start_time);
 
-	for (cell = sibling_nodes->head; cell; cell = cell->next)
+	if (runtime_options.report_json[0] != '\0')
 	{
-		/* get host from node record */
-		get_conninfo_value(cell->node_info->conninfo, "host", host);
-		r = test_ssh_connection(host, runtime_options.remote_user);
+		switchover_timing.report_file = fopen(runtime_options.report_json, "w");
 
-		if (r != 0)
+		if (switchover_timing.report_file == NULL)
 		{
-			cell->node_info->reachable = false;
-			sibling_nodes_stats->unreachable_sibling_node_count++;
+			log_error(_("unable to open report file \"%s\""),
+					  runtime_options.report_json);
+			log_detail("%s", strerror(errno));
+			exit(ERR_BAD_CONFIG);
 		}
-		else
-		{
-			cell->node_info->reachable = true;
-			sibling_nodes_stats->reachable_sibling_node_count++;
-			sibling_nodes_stats->min_required_wal_senders++;
 
-			if (cell->node_info->slot_name[0] != '\0')
-			{
-				sibling_nodes_stats->reachable_sibling_nodes_with_slot_count++;
-				sibling_nodes_stats->min_required_free_slots++;
-			}
+		if (atexit(write_switchover_report) != 0)
+		{
+			log_warning(_("unable to register handler to write report file \"%s\""),
+						runtime_options.report_json);
 		}
 	}
 
-	if (sibling_nodes_stats->unreachable_sibling_node_count > 0)
-	{
-		if (runtime_options.force == false)
-		{
-			log_error(_("%i of %i sibling nodes unreachable via SSH:"),
-					  sibling_nodes_stats->unreachable_sibling_node_count,
-					  sibling_nodes->node_count);
-		}
-		else
-		{
-			log_warning(_("%i of %i sibling nodes unreachable via SSH:"),
-						sibling_nodes_stats->unreachable_sibling_node_count,
-						sibling_nodes->node_count);
-		}
+	switchover_phase_start(SWITCHOVER_PHASE_PRECHECKS);
+}
 
-		/* display list of unreachable sibling nodes */
-		for (cell = sibling_nodes->head; cell; cell = cell->next)
-		{
-			if (cell->node_info->reachable == true)
-				continue;
-			log_detail("  %s (ID: %i)",
-					   cell->node_info->node_name,
-					   cell->node_info->node_id);
-		}
 
-		if (runtime_options.force == false)
-		{
-			log_hint(_("use -F/--force to proceed in any case"));
-			return false;
-		}
+/*
+ * switchover_phase_start()
+ *
+ * End the current phase (if any) and start timing the provided phase.
+ */
+static void
+switchover_phase_start(SwitchoverPhase phase)
+{
+	switchover_phase_end();
 
-		if (runtime_options.dry_run == true)
-		{
-			log_detail(_("F/--force specified, would proceed anyway"));
-		}
-		else
-		{
-			log_detail(_("F/--force specified, proceeding anyway"));
-		}
-	}
-	else
-	{
-		char	   *msg = _("all sibling nodes are reachable via SSH");
+	switchover_timing.current_phase = phase;
+	switchover_timing.last_phase = phase;
+	switchover_timing.phase_executed[phase] = true;
 
-		if (runtime_options.dry_run == true)
-		{
-			log_info("%s", msg);
-		}
-		else
-		{
-			log_verbose(LOG_INFO, "%s", msg);
-		}
-	}
+	INSTR_TIME_SET_CURRENT(switchover_timing.phase_start_time);
 
-	return true;
+	log_verbose(LOG_DEBUG, "switchover phase \"%s\" started",
+				switchover_phase_names[phase]);
 }
 
 
-static bool
-check_free_wal_senders(int available_wal_senders, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success)
+static void
+switchover_phase_end(void)
 {
-	if (available_wal_senders < sibling_nodes_stats->min_required_wal_senders)
-	{
-		if (runtime_options.force == false || runtime_options.dry_run == true)
-		{
-			log_error(_("insufficient free walsenders on promotion candidate"));
-			log_detail(_("at least %i walsenders required but only %i free walsenders on promotion candidate"),
-					   sibling_nodes_stats->min_required_wal_senders,
-					   available_wal_senders);
-			log_hint(_("increase parameter \"max_wal_senders\" or use -F/--force to proceed in any case"));
+	instr_time	elapsed_time;
+	SwitchoverPhase phase = switchover_timing.current_phase;
 
-			if (runtime_options.dry_run == true)
-			{
-				*dry_run_success = false;
-			}
-			else
-			{
-				return false;
-			}
-		}
-		else
-		{
-			log_warning(_("insufficient free walsenders on promotion candidate"));
-			log_detail(_("at least %i walsenders required but only %i free walsender(s) on promotion candidate"),
-					   sibling_nodes_stats->min_required_wal_senders,
-					   available_wal_senders);
-			return false;
-		}
-	}
-	else
+	if (phase == SWITCHOVER_PHASE_NONE)
+		return;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, switchover_timing.phase_start_time);
+
+	switchover_timing.phase_ms[phase] += INSTR_TIME_GET_MILLISEC(elapsed_time);
+	switchover_timing.current_phase = SWITCHOVER_PHASE_NONE;
+
+	log_verbose(LOG_DEBUG, "switchover phase \"%s\" completed in %.0f ms",
+				switchover_phase_names[phase],
+				switchover_timing.phase_ms[phase]);
+}
+
+
+/*
+ * switchover_timing_append()
+ *
+ * Append the elapsed time of each completed phase to "buf", e.g. for
+ * the "standby_switchover" event details.
+ */
+static void
+switchover_timing_append(PQExpBufferData *buf)
+{
+	int			phase;
+	bool		first = true;
+
+	appendPQExpBufferStr(buf, "phase timings:");
+
+	for (phase = 0; phase < SWITCHOVER_PHASE_COUNT; phase++)
 	{
-		if (runtime_options.dry_run == true)
-		{
-			log_info(_("%i walsenders required, %i available"),
-					 sibling_nodes_stats->min_required_wal_senders,
-					 available_wal_senders);
-		}
-	}
+		if (switchover_timing.phase_executed[phase] == false)
+			continue;
 
-	return true;
+		appendPQExpBuffer(buf, "%s %s %.0f ms",
+						  first == true ? "" : ",",
+						  switchover_phase_names[phase],
+						  switchover_timing.phase_ms[phase]);
+		first = false;
+	}
 }
 
 
-static bool
-check_free_slots(t_node_info *local_node_record, SiblingNodeStats *sibling_nodes_stats, bool *dry_run_success)
+/*
+ * write_switchover_report()
+ *
+ * Write the timing of each executed phase to the file provided with
+ * --report-json; registered with atexit() by switchover_timing_start(), as
+ * "standby switchover" terminates via exit() on most error paths. Output
+ * looks like:
+ *
+ *   {"promotion_candidate_node_id": 2, "demotion_candidate_node_id": 1,
+ *    "dry_run": false, "result": "success", "last_phase": "finalize",
+ *    "total_ms": 12345, "phases": [{"phase": "prechecks", "elapsed_ms": 2345}, ...]}
+ */
+static void
+write_switchover_report(void)
 {
-	if (sibling_nodes_stats->min_required_free_slots > 0 )
+	instr_time	elapsed_time;
+	int			phase;
+	bool		first = true;
+	FILE	   *fp = switchover_timing.report_file;
+
+	if (fp == NULL)
+		return;
+
+	switchover_phase_end();
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, switchover_timing.start_time);
+
+	fprintf(fp,
+			"{\"promotion_candidate_node_id\": %i, \"demotion_candidate_node_id\": %i, "
+			"\"dry_run\": %s, \"result\": \"%s\", \"last_phase\": ",
+			switchover_timing.promotion_candidate_node_id,
+			switchover_timing.demotion_candidate_node_id,
+			runtime_options.dry_run == true ? "true" : "false",
+			switchover_timing.result);
+
+	if (switchover_timing.last_phase == SWITCHOVER_PHASE_NONE)
+		fprintf(fp, "null");
+	else
+		fprintf(fp, "\"%s\"", switchover_phase_names[switchover_timing.last_phase]);
+
+	fprintf(fp, ", \"total_ms\": %.0f, ",
+			INSTR_TIME_GET_MILLISEC(elapsed_time));
+
+	if (switchover_timing.estimated_downtime_ms >= 0)
+		fprintf(fp, "\"estimated_downtime_ms\": %.0f, ",
+				switchover_timing.estimated_downtime_ms);
+
+	fprintf(fp, "\"phases\": [");
+
+	for (phase = 0; phase < SWITCHOVER_PHASE_COUNT; phase++)
 	{
-		int available_slots = local_node_record->max_replication_slots -
-			local_node_record->active_replication_slots;
+		if (switchover_timing.phase_executed[phase] == false)
+			continue;
 
-		log_debug("minimum of %i free slots (%i for siblings) required; %i available",
-				  sibling_nodes_stats->min_required_free_slots,
-				  sibling_nodes_stats->reachable_sibling_nodes_with_slot_count,
-				  available_slots);
+		fprintf(fp, "%s{\"phase\": \"%s\", \"elapsed_ms\": %.0f}",
+				first == true ? "" : ", ",
+				switchover_phase_names[phase],
+				switchover_timing.phase_ms[phase]);
+		first = false;
+	}
 
-		if (available_slots < sibling_nodes_stats->min_required_free_slots)
-		{
-			if (runtime_options.force == false || runtime_options.dry_run == true)
-			{
-				log_error(_("insufficient free replication slots to attach all nodes"));
-				log_detail(_("at least %i additional replication slots required but only %i free slots available on promotion candidate"),
-						   sibling_nodes_stats->min_required_free_slots,
-						   available_slots);
-				log_hint(_("increase parameter \"max_replication_slots\" or use -F/--force to proceed in any case"));
+	fprintf(fp, "]}\n");
 
-				if (runtime_options.dry_run == true)
-				{
-					*dry_run_success = false;
-				}
-				else
-				{
-					return false;
-				}
-			}
-		}
-		else
-		{
-			if (runtime_options.dry_run == true)
-			{
-				log_info(_("%i replication slots required, %i available"),
-						 sibling_nodes_stats->min_required_free_slots,
-						 available_slots);
-			}
-		}
+	if (fclose(fp) != 0)
+	{
+		log_warning(_("unable to write report file \"%s\""),
+					runtime_options.report_json);
+		log_detail("%s", strerror(errno));
 	}
 
-	return true;
+	switchover_timing.report_file = NULL;
 }
 
 
+/*
+ * sibling_nodes_follow()
+ *
+ * Instruct each reachable sibling node to follow the new primary (or, for a
+ * witness, to re-register with it). The remote commands are executed
+ * concurrently, up to "siblings_follow_max_parallel" at a time, so all
+ * siblings are repointed in roughly the time it takes a single node to
+ * follow; each is given up to "siblings_follow_timeout" seconds.
+ *
+ * If "details" is provided, a summary of the result for each sibling is
+ * appended to it for inclusion in the event notification.
+ */
 static void
-sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats)
+sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes, SiblingNodeStats *sibling_nodes_stats, PQExpBufferData *details)
 {
 	int			failed_follow_count = 0;
+	int			task_count = 0;
+	int			i;
 	char		host[MAXLEN] = "";
 	NodeInfoListCell *cell = NULL;
-	PQExpBufferData remote_command_str;
-	PQExpBufferData command_output;
+	t_command_task *tasks = NULL;
+	t_node_info **task_nodes = NULL;
 
 	log_notice(_("executing STANDBY FOLLOW on %i of %i siblings"),
 			   sibling_nodes->node_count - sibling_nodes_stats->unreachable_sibling_node_count,
 			   sibling_nodes->node_count);
 
+	tasks = pg_malloc0(sizeof(t_command_task) * sibling_nodes->node_count);
+	task_nodes = pg_malloc0(sizeof(t_node_info *) * sibling_nodes->node_count);
+
 	for (cell = sibling_nodes->head; cell; cell = cell->next)
 	{
-		bool		success = false;
+		PQExpBufferData remote_command_str;
+		PQExpBufferData ssh_command;
 
 		/* skip nodes previously determined as unreachable */
 		if (cell->node_info->reachable == false)
@@ -8747,37 +13171,56 @@ sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes
 								 "standby follow 2>/dev/null && echo \"1\" || echo \"0\"");
 		}
 		get_conninfo_value(cell->node_info->conninfo, "host", host);
-		log_debug("executing:\n  %s", remote_command_str.data);
 
-		initPQExpBuffer(&command_output);
+		initPQExpBuffer(&ssh_command);
+		make_remote_command(host,
+							runtime_options.remote_user,
+							remote_command_str.data,
+							config_file_options.ssh_options,
+							&ssh_command);
+
+		log_debug("executing:\n  %s", ssh_command.data);
 
-		success = remote_command(host,
-								 runtime_options.remote_user,
-								 remote_command_str.data,
-								 config_file_options.ssh_options,
-								 &command_output);
+		init_command_task(&tasks[task_count], task_count, ssh_command.data);
+		task_nodes[task_count] = cell->node_info;
+		task_count++;
 
 		termPQExpBuffer(&remote_command_str);
+		termPQExpBuffer(&ssh_command);
+	}
 
-		if (success == false || command_output.data[0] == '0')
-		{
-			if (cell->node_info->type == WITNESS)
-			{
-				log_warning(_("WITNESS REGISTER failed on node \"%s\""),
-							cell->node_info->node_name);
-			}
-			else
-			{
-				log_warning(_("STANDBY FOLLOW failed on node \"%s\""),
-							cell->node_info->node_name);
-			}
+	(void) execute_commands_parallel(tasks, task_count,
+									 config_file_options.siblings_follow_max_parallel,
+									 config_file_options.siblings_follow_timeout,
+									 sibling_follow_callback, task_nodes);
+
+	if (details != NULL && task_count > 0)
+		appendPQExpBufferStr(details, "\nsibling nodes:");
+
+	for (i = 0; i < task_count; i++)
+	{
+		/* the command outputs "1" on success, "0" on failure */
+		bool		success = tasks[i].timed_out == false && tasks[i].output.data[0] == '1';
 
+		if (success == false)
 			failed_follow_count++;
+
+		if (details != NULL)
+		{
+			appendPQExpBuffer(details, "%s \"%s\" (ID: %i) %s %i ms",
+							  i == 0 ? " " : ", ",
+							  task_nodes[i]->node_name,
+							  task_nodes[i]->node_id,
+							  success == true ? "followed in" : (tasks[i].timed_out == true ? "timed out after" : "failed after"),
+							  tasks[i].elapsed_ms);
 		}
 
-		termPQExpBuffer(&command_output);
+		term_command_task(&tasks[i]);
 	}
 
+	pfree(tasks);
+	pfree(task_nodes);
+
 	if (failed_follow_count == 0)
 	{
 		log_info(_("STANDBY FOLLOW successfully executed on all reachable sibling nodes"));
@@ -8795,6 +13238,41 @@ sibling_nodes_follow(t_node_info *local_node_record, NodeInfoList *sibling_nodes
 }
 
 
+/*
+ * sibling_follow_callback()
+ *
+ * Report the result for each sibling node as soon as its command completes.
+ */
+static void
+sibling_follow_callback(t_command_task *task, void *arg)
+{
+	t_node_info **task_nodes = (t_node_info **) arg;
+	t_node_info *node_info = task_nodes[task->id];
+	const char *action = node_info->type == WITNESS ? "WITNESS REGISTER" : "STANDBY FOLLOW";
+
+	if (task->timed_out == true)
+	{
+		log_warning(_("%s timed out on node \"%s\" after %i seconds (\"siblings_follow_timeout\")"),
+					action,
+					node_info->node_name,
+					config_file_options.siblings_follow_timeout);
+	}
+	else if (task->output.data[0] != '1')
+	{
+		log_warning(_("%s failed on node \"%s\""),
+					action,
+					node_info->node_name);
+	}
+	else
+	{
+		log_info(_("%s executed on node \"%s\" in %i ms"),
+				 action,
+				 node_info->node_name,
+				 task->elapsed_ms);
+	}
+}
+
+
 
 static t_remote_error_type
 parse_remote_error(const char *error)
@@ -9213,6 +13691,7 @@ do_standby_help(void)
 
 	printf(_("Usage:\n"));
 	printf(_("    %s [OPTIONS] standby clone\n"), progname());
+	printf(_("    %s [OPTIONS] standby provision\n"), progname());
 	printf(_("    %s [OPTIONS] standby register\n"), progname());
 	printf(_("    %s [OPTIONS] standby unregister\n"), progname());
 	printf(_("    %s [OPTIONS] standby promote\n"), progname());
@@ -9227,12 +13706,23 @@ do_standby_help(void)
 	puts("");
 	printf(_("  -d, --dbname=conninfo               conninfo of the upstream node to use for cloning.\n"));
 	printf(_("  -c, --fast-checkpoint               force fast checkpoint\n"));
+	printf(_("  --adaptive-rate[=SECONDS]           reduce the clone rate while standbys of the source node lag by more than\n" \
+			 "                                        SECONDS (default: %i), or checkpoints are requested\n"), DEFAULT_ADAPTIVE_RATE_MAX_LAG);
+	printf(_("  --auto-source                       select the least loaded node as clone source, preferring standbys\n" \
+			 "                                        in the same location as this node\n"));
 	printf(_("  --copy-external-config-files[={samepath|pgdata}]\n" \
 			 "                                      copy configuration files located outside the \n" \
 			 "                                        data directory to the same path on the standby (default) or to the\n" \
 			 "                                        PostgreSQL data directory\n"));
 	printf(_("  --dry-run                           perform checks but don't actually clone the standby\n"));
+	printf(_("  --max-rate=RATE                     limit the transfer rate to RATE kB/s (suffix \"M\" for MB/s)\n"));
 	printf(_("  --no-upstream-connection            when using Barman, do not connect to upstream node\n"));
+	printf(_("  --parallel=N                        when using Barman or --rsync-only, copy files with N concurrent rsync processes\n"));
+	printf(_("  --progress-file=FILE                write clone progress to FILE in JSON format\n"));
+	printf(_("  --resume                            when using Barman, resume an interrupted clone\n"));
+	printf(_("  --rsync-only                        clone using rsync within a non-exclusive backup, rather than pg_basebackup\n"));
+	printf(_("  --rsync-sources=NODE_ID[,...]       with --rsync-only, also copy relation files from the specified standbys\n"));
+	printf(_("  --delta                             update an existing data directory with rsync, copying only changed files\n"));
 	printf(_("  -R, --remote-user=USERNAME          database server username for SSH operations (default: \"%s\")\n"), runtime_options.username);
 	printf(_("  --replication-user                  user to make replication connections with (optional, not usually required)\n"));
 	printf(_("  -S, --superuser=USERNAME            superuser to use, if repmgr user is not superuser\n"));
@@ -9249,6 +13739,20 @@ do_standby_help(void)
 
 	puts("");
 
+	printf(_("STANDBY PROVISION\n"));
+	puts("");
+	printf(_("  \"standby provision\" clones, starts and registers standbys on the specified hosts, using\n" \
+			 "  already provisioned standbys as clone sources for the remaining hosts.\n"));
+	puts("");
+	printf(_("  --hosts=HOST[,HOST...]              hosts to provision standbys on\n"));
+	printf(_("  -c, --fast-checkpoint               force fast checkpoint\n"));
+	printf(_("  --dry-run                           show how the standbys would be provisioned\n"));
+	printf(_("  --parallel=N                        number of concurrent clones from each source (default: 1)\n"));
+	printf(_("  -R, --remote-user=USERNAME          database server username for SSH operations (default: \"%s\")\n"), runtime_options.username);
+	printf(_("  --wait-start=VALUE                  wait for each standby to start (timeout in seconds, default %i)\n"), DEFAULT_WAIT_START);
+
+	puts("");
+
 	printf(_("STANDBY REGISTER\n"));
 	puts("");
 	printf(_("  \"standby register\" registers the standby node.\n"));
@@ -9303,6 +13807,7 @@ do_standby_help(void)
 	printf(_("  -R, --remote-user=USERNAME          database server username for SSH operations (default: \"%s\")\n"), runtime_options.username);
 	printf(_("  -S, --superuser=USERNAME            superuser to use, if repmgr user is not superuser\n"));
 	printf(_("  --repmgrd-no-pause                  don't pause repmgrd\n"));
+	printf(_("  --report-json=FILE                  write the time taken by each phase to FILE in JSON format\n"));
 	printf(_("  --siblings-follow                   have other standbys follow new primary\n"));
 
 	puts("");
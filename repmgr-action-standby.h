@@ -20,6 +20,7 @@
 #define _REPMGR_ACTION_STANDBY_H_
 
 extern void do_standby_clone(void);
+extern void do_standby_provision(void);
 extern void do_standby_register(void);
 extern void do_standby_unregister(void);
 extern void do_standby_promote(void);
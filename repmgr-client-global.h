@@ -38,6 +38,8 @@ typedef struct
 	bool		host_param_provided;
 	bool		limit_provided;
 	bool		wait_provided;
+	bool		parallel_provided;
+	bool		timeout_provided;
 
 	/* general configuration options */
 	char		config_file[MAXPGPATH];
@@ -90,6 +92,13 @@ typedef struct
 	bool		without_barman;
 	bool		replication_conf_only;
 	bool		verify_backup;
+	bool		resume;
+	char		rsync_sources[MAXLEN];
+	bool		delta;
+	char		progress_file[MAXPGPATH];
+	int			max_rate;
+	int			adaptive_rate;
+	bool		auto_source;
 
 	/* "standby clone"/"standby follow" options */
 	int			upstream_node_id;
@@ -106,6 +115,10 @@ typedef struct
 	bool		siblings_follow;
 	bool		repmgrd_no_pause;
 	bool		repmgrd_force_unpause;
+	char		report_json[MAXPGPATH];
+
+	/* "standby provision" options */
+	char		hosts[MAXLEN];
 
 	/* "node status" options */
 	bool		is_shutdown_cleanly;
@@ -134,6 +147,11 @@ typedef struct
 	bool		list_actions;
 	bool		checkpoint;
 
+	/* "cluster show", "cluster matrix" and "cluster crosscheck" options */
+	int			parallel;
+	int			timeout;
+	int			watch;
+
 	/* "cluster event" options */
 	bool		all;
 	char		event[MAXLEN];
@@ -151,7 +169,7 @@ typedef struct
 
 #define T_RUNTIME_OPTIONS_INITIALIZER { \
 		/* configuration metadata */ \
-		false, false, false, false, false,	\
+		false, false, false, false, false, false, false,	\
 		/* general configuration options */	\
 		"", false, false, "", -1, false, false, false, false, \
 		/* logging options */ \
@@ -166,13 +184,15 @@ typedef struct
 		UNKNOWN_NODE_ID, "", "", UNKNOWN_NODE_ID, \
 		/* "standby clone" options */ \
 		false, CONFIG_FILE_SAMEPATH, false, false, false, "", "", "", \
-		false, false, false, \
+		false, false, false, false, "", false, "", 0, 0, false, \
 		/* "standby clone"/"standby follow" options */ \
 		NO_UPSTREAM_NODE, \
 		/* "standby register" options */ \
 		false, -1, DEFAULT_WAIT_START,   \
 		/* "standby switchover" options */ \
-		false, false, "", false, false, false,	\
+		false, false, "", false, false, false, "", \
+		/* "standby provision" options */ \
+		"", \
 		/* "node status" options */ \
 		false, \
 		/* "node check" options */ \
@@ -181,6 +201,8 @@ typedef struct
 		"", \
 		/* "node service" options */ \
 		"", false, false, false,  \
+		/* "cluster show" options */ \
+		DEFAULT_PARALLEL, DEFAULT_TIMEOUT, 0, \
 		/* "cluster event" options */ \
 		false, "", CLUSTER_EVENT_LIMIT,	\
 		/* "cluster cleanup" options */ \
@@ -194,7 +216,8 @@ typedef enum
 {
 	barman,
 	pg_basebackup,
-	pg_backupapi
+	pg_backupapi,
+	parallel_rsync
 } standy_clone_mode;
 
 typedef enum
@@ -264,6 +287,7 @@ extern standy_clone_mode get_standby_clone_mode(void);
 
 extern int copy_remote_files(char *host, char *remote_user, char *remote_path,
 				  char *local_path, bool is_directory, int server_version_num);
+extern void append_rsync_exclude_options(PQExpBufferData *rsync_flags, bool is_data_directory, int server_version_num);
 
 extern void print_error_list(ItemList *error_list, int log_level);
 
@@ -275,7 +299,7 @@ extern void make_remote_repmgr_path(PQExpBufferData *outputbuf, t_node_info *rem
 extern void make_repmgrd_path(PQExpBufferData *output_buf);
 
 /* display functions */
-extern bool format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBufferData *upstream, ItemList *warnings);
+extern bool format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBufferData *upstream, ItemList *warnings, NodeInfoList *node_list);
 extern void print_help_header(void);
 extern void print_status_header(int cols, ColHeader *headers);
 
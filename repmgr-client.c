@@ -110,6 +110,10 @@ static PGconn *_get_replication_slot_connection(PGconn *conn,
 												char *replication_user,
 												bool *use_replication_protocol);
 
+static PGconn *_get_upstream_connection(t_node_info *upstream_node_record,
+										NodeInfoList *node_list,
+										bool *reused);
+
 int
 main(int argc, char **argv)
 {
@@ -458,6 +462,70 @@ main(int argc, char **argv)
 				runtime_options.verify_backup = true;
 				break;
 
+			case OPT_RESUME:
+				runtime_options.resume = true;
+				break;
+
+			case OPT_RSYNC_ONLY:
+				runtime_options.rsync_only = true;
+				break;
+
+			case OPT_RSYNC_SOURCES:
+				strncpy(runtime_options.rsync_sources, optarg, MAXLEN);
+				break;
+
+			case OPT_DELTA:
+				runtime_options.delta = true;
+				break;
+
+			case OPT_PROGRESS_FILE:
+				strncpy(runtime_options.progress_file, optarg, MAXPGPATH);
+				break;
+
+				/* --max-rate=RATE[k|M], in kilobytes per second (as pg_basebackup) */
+			case OPT_MAX_RATE:
+				{
+					char	   *suffix = NULL;
+					long		max_rate = strtol(optarg, &suffix, 10);
+
+					if (strcmp(suffix, "M") == 0)
+						max_rate *= 1024;
+					else if (*suffix != '\0' && strcmp(suffix, "k") != 0)
+						max_rate = -1;
+
+					if (suffix == optarg || max_rate < 32 || max_rate > 1024 * 1024)
+					{
+						item_list_append(&cli_errors,
+										 _("value provided for \"--max-rate\" must be between 32 kB/s and 1024 MB/s"));
+					}
+					else
+					{
+						runtime_options.max_rate = (int) max_rate;
+					}
+				}
+				break;
+
+				/* --adaptive-rate(=SECONDS) */
+			case OPT_ADAPTIVE_RATE:
+				if (optarg != NULL)
+					runtime_options.adaptive_rate = repmgr_atoi(optarg, "--adaptive-rate", &cli_errors, 1);
+				else
+					runtime_options.adaptive_rate = DEFAULT_ADAPTIVE_RATE_MAX_LAG;
+				break;
+
+			case OPT_AUTO_SOURCE:
+				runtime_options.auto_source = true;
+				break;
+
+				/*----------------------------
+				 * "standby provision" options
+				 *----------------------------
+				 */
+
+			case OPT_HOSTS:
+				strncpy(runtime_options.hosts, optarg, MAXLEN);
+				break;
+
 				/*---------------------------
 				 * "standby register" options
 				 *---------------------------
@@ -506,6 +574,10 @@ main(int argc, char **argv)
 				runtime_options.repmgrd_force_unpause = true;
 				break;
 
+			case OPT_REPORT_JSON:
+				strncpy(runtime_options.report_json, optarg, MAXPGPATH);
+				break;
+
 				/*----------------------
 				 * "node status" options
 				 *----------------------
@@ -602,6 +674,25 @@ main(int argc, char **argv)
 				runtime_options.checkpoint = true;
 				break;
 
+				/*-----------------------
+				 * "cluster show" options
+				 *-----------------------
+				 */
+
+			case OPT_PARALLEL:
+				runtime_options.parallel = repmgr_atoi(optarg, "--parallel", &cli_errors, 1);
+				runtime_options.parallel_provided = true;
+				break;
+
+			case OPT_TIMEOUT:
+				runtime_options.timeout = repmgr_atoi(optarg, "--timeout", &cli_errors, 1);
+				runtime_options.timeout_provided = true;
+				break;
+
+			case OPT_WATCH:
+				runtime_options.watch = repmgr_atoi(optarg, "--watch", &cli_errors, 1);
+				break;
+
 				/*------------------------
 				 * "cluster event" options
 				 *------------------------
@@ -906,6 +997,8 @@ main(int argc, char **argv)
 
 			if (strcasecmp(repmgr_action, "CLONE") == 0)
 				action = STANDBY_CLONE;
+			else if (strcasecmp(repmgr_action, "PROVISION") == 0)
+				action = STANDBY_PROVISION;
 			else if (strcasecmp(repmgr_action, "REGISTER") == 0)
 				action = STANDBY_REGISTER;
 			else if (strcasecmp(repmgr_action, "UNREGISTER") == 0)
@@ -954,6 +1047,8 @@ main(int argc, char **argv)
 				action = NODE_SERVICE;
 			else if (strcasecmp(repmgr_action, "CONTROL") == 0)
 				action = NODE_CONTROL;
+			else if (strcasecmp(repmgr_action, "AGENT") == 0)
+				action = NODE_AGENT;
 		}
 
 		else if (strcasecmp(repmgr_command, "CLUSTER") == 0)
@@ -1381,6 +1476,9 @@ main(int argc, char **argv)
 		case STANDBY_CLONE:
 			do_standby_clone();
 			break;
+		case STANDBY_PROVISION:
+			do_standby_provision();
+			break;
 		case STANDBY_REGISTER:
 			do_standby_register();
 			break;
@@ -1421,6 +1519,9 @@ main(int argc, char **argv)
 		case NODE_CONTROL:
 			do_node_control();
 			break;
+		case NODE_AGENT:
+			do_node_agent();
+			break;
 
 			/* CLUSTER */
 		case CLUSTER_SHOW:
@@ -1568,6 +1669,16 @@ check_cli_parameters(const int action)
 			}
 			break;
 
+		case STANDBY_PROVISION:
+			{
+				if (runtime_options.hosts[0] == '\0')
+				{
+					item_list_append(&cli_errors,
+									 _("--hosts must be provided when executing STANDBY PROVISION"));
+				}
+			}
+			break;
+
 		case STANDBY_FOLLOW:
 			{
 				/*
@@ -1809,6 +1920,135 @@ check_cli_parameters(const int action)
 		}
 	}
 
+	if (runtime_options.parallel_provided)
+	{
+		switch (action)
+		{
+			case STANDBY_CLONE:
+			case STANDBY_PROVISION:
+			case CLUSTER_SHOW:
+			case CLUSTER_MATRIX:
+			case CLUSTER_CROSSCHECK:
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--parallel not required when executing %s"),
+										action_name(action));
+		}
+	}
+
+	if (runtime_options.timeout_provided)
+	{
+		switch (action)
+		{
+			case CLUSTER_SHOW:
+			case CLUSTER_MATRIX:
+			case CLUSTER_CROSSCHECK:
+				break;
+			default:
+				item_list_append_format(&cli_warnings,
+										_("--timeout not required when executing %s"),
+										action_name(action));
+		}
+	}
+
+	if (runtime_options.watch > 0)
+	{
+		if (action != CLUSTER_SHOW)
+		{
+			item_list_append_format(&cli_warnings,
+									_("--watch not required when executing %s"),
+									action_name(action));
+		}
+		else if (runtime_options.csv == true)
+		{
+			item_list_append(&cli_errors,
+							 _("--watch cannot be used together with --csv"));
+		}
+	}
+
+	if (runtime_options.rsync_sources[0] != '\0')
+	{
+		if (action != STANDBY_CLONE)
+		{
+			item_list_append_format(&cli_warnings,
+									_("--rsync-sources not required when executing %s"),
+									action_name(action));
+		}
+		else if (runtime_options.rsync_only == false && runtime_options.delta == false)
+		{
+			item_list_append(&cli_errors,
+							 _("--rsync-sources can only be used together with --rsync-only or --delta"));
+		}
+	}
+
+	if (runtime_options.delta == true && action != STANDBY_CLONE)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--delta not required when executing %s"),
+								action_name(action));
+	}
+
+	if (runtime_options.progress_file[0] != '\0' && action != STANDBY_CLONE)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--progress-file not required when executing %s"),
+								action_name(action));
+	}
+
+	if (runtime_options.max_rate > 0 && action != STANDBY_CLONE)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--max-rate not required when executing %s"),
+								action_name(action));
+	}
+
+	if (runtime_options.adaptive_rate > 0 && action != STANDBY_CLONE)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--adaptive-rate not required when executing %s"),
+								action_name(action));
+	}
+
+	if (runtime_options.auto_source == true)
+	{
+		if (action != STANDBY_CLONE)
+		{
+			item_list_append_format(&cli_warnings,
+									_("--auto-source not required when executing %s"),
+									action_name(action));
+		}
+		else if (runtime_options.no_upstream_connection == true)
+		{
+			item_list_append(&cli_errors,
+							 _("--auto-source cannot be used with --no-upstream-connection"));
+		}
+	}
+
+	if (runtime_options.hosts[0] != '\0' && action != STANDBY_PROVISION)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--hosts not required when executing %s"),
+								action_name(action));
+	}
+
+	if (runtime_options.rsync_only == true && action != STANDBY_CLONE)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--rsync-only not required when executing %s"),
+								action_name(action));
+	}
+
+	if (runtime_options.resume == true)
+	{
+		if (action != STANDBY_CLONE)
+		{
+			item_list_append_format(&cli_warnings,
+									_("--resume not required when executing %s"),
+									action_name(action));
+		}
+	}
+
 	if (runtime_options.all)
 	{
 		switch (action)
@@ -1971,6 +2211,7 @@ check_cli_parameters(const int action)
 			case PRIMARY_REGISTER:
 			case PRIMARY_UNREGISTER:
 			case STANDBY_CLONE:
+			case STANDBY_PROVISION:
 			case STANDBY_REGISTER:
 			case STANDBY_FOLLOW:
 			case STANDBY_SWITCHOVER:
@@ -2043,6 +2284,13 @@ check_cli_parameters(const int action)
 		}
 	}
 
+	if (runtime_options.report_json[0] != '\0' && action != STANDBY_SWITCHOVER)
+	{
+		item_list_append_format(&cli_warnings,
+								_("--report-json not required when executing %s"),
+								action_name(action));
+	}
+
 	/* --siblings-follow */
 	if (runtime_options.siblings_follow == true)
 	{
@@ -2082,12 +2330,45 @@ check_cli_parameters(const int action)
 }
 
 
+/*
+ * Return a connection to the provided upstream node, reusing an existing
+ * connection from "node_list" if possible. "reused" is set to true if the
+ * returned connection belongs to "node_list" and must not be closed by the
+ * caller.
+ */
+static PGconn *
+_get_upstream_connection(t_node_info *upstream_node_record, NodeInfoList *node_list, bool *reused)
+{
+	NodeInfoListCell *cell = NULL;
+
+	*reused = false;
+
+	if (node_list != NULL)
+	{
+		for (cell = node_list->head; cell; cell = cell->next)
+		{
+			if (cell->node_info->node_id == upstream_node_record->node_id)
+			{
+				*reused = true;
+				return cell->node_info->conn;
+			}
+		}
+	}
+
+	return establish_db_connection_quiet(upstream_node_record->conninfo);
+}
+
+
 /*
  * Generate formatted node status output for display by "cluster show" and
  * "service status".
+ *
+ * If "node_list" is provided, any connections already established to the
+ * nodes it contains will be used when checking a node's upstream, rather
+ * than opening a new connection for each node.
  */
 bool
-format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBufferData *upstream, ItemList *warnings)
+format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBufferData *upstream, ItemList *warnings, NodeInfoList *node_list)
 {
 	bool error_found = false;
 	t_node_info remote_node_rec = T_NODE_INFO_INITIALIZER;
@@ -2102,11 +2383,18 @@ format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBu
 	}
 	else
 	{
-		/* check if node is reachable, but just not letting us in */
-		if (is_server_available_quiet(node_info->conninfo))
-			node_info->node_status = NODE_STATUS_REJECTED;
-		else
-			node_info->node_status = NODE_STATUS_DOWN;
+		/*
+		 * Check if node is reachable, but just not letting us in; the caller
+		 * may already have determined that the node is down, e.g. because a
+		 * connection attempt timed out, in which case we won't ping it again.
+		 */
+		if (node_info->node_status != NODE_STATUS_DOWN)
+		{
+			if (is_server_available_quiet(node_info->conninfo))
+				node_info->node_status = NODE_STATUS_REJECTED;
+			else
+				node_info->node_status = NODE_STATUS_DOWN;
+		}
 
 		node_info->recovery_type = RECTYPE_UNKNOWN;
 	}
@@ -2384,7 +2672,8 @@ format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBu
 			}
 			else
 			{
-				PGconn *upstream_conn = establish_db_connection_quiet(upstream_node_rec.conninfo);
+				bool		upstream_conn_reused = false;
+				PGconn	   *upstream_conn = _get_upstream_connection(&upstream_node_rec, node_list, &upstream_conn_reused);
 
 				if (PQstatus(upstream_conn) != CONNECTION_OK)
 				{
@@ -2397,7 +2686,8 @@ format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBu
 											upstream_node_rec.node_id);
 				}
 
-				PQfinish(upstream_conn);
+				if (upstream_conn_reused == false)
+					PQfinish(upstream_conn);
 			}
 		}
 
@@ -2429,7 +2719,8 @@ format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBu
 			}
 			else
 			{
-				PGconn *upstream_conn = establish_db_connection_quiet(upstream_node_rec.conninfo);
+				bool		upstream_conn_reused = false;
+				PGconn	   *upstream_conn = _get_upstream_connection(&upstream_node_rec, node_list, &upstream_conn_reused);
 
 				if (PQstatus(upstream_conn) != CONNECTION_OK)
 				{
@@ -2445,7 +2736,8 @@ format_node_status(t_node_info *node_info, PQExpBufferData *node_status, PQExpBu
 					attached_to_upstream = is_downstream_node_attached(upstream_conn, node_info->node_name, &replication_state);
 				}
 
-				PQfinish(upstream_conn);
+				if (upstream_conn_reused == false)
+					PQfinish(upstream_conn);
 			}
 
 			if (attached_to_upstream == NODE_ATTACHED_UNKNOWN)
@@ -2536,6 +2828,8 @@ action_name(const int action)
 			return "STANDBY FOLLOW";
 		case STANDBY_SWITCHOVER:
 			return "STANDBY SWITCHOVER";
+		case STANDBY_PROVISION:
+			return "STANDBY PROVISION";
 
 		case WITNESS_REGISTER:
 			return "WITNESS REGISTER";
@@ -2552,6 +2846,8 @@ action_name(const int action)
 			return "NODE SERVICE";
 		case NODE_CONTROL:
 			return "NODE CONTROL";
+		case NODE_AGENT:
+			return "NODE AGENT";
 
 		case CLUSTER_SHOW:
 			return "CLUSTER SHOW";
@@ -2680,7 +2976,7 @@ do_help(void)
 
 	printf(_("Usage:\n"));
 	printf(_("    %s [OPTIONS] primary {register|unregister}\n"), progname());
-	printf(_("    %s [OPTIONS] standby {register|unregister|clone|promote|follow|switchover}\n"), progname());
+	printf(_("    %s [OPTIONS] standby {register|unregister|clone|provision|promote|follow|switchover}\n"), progname());
 	printf(_("    %s [OPTIONS] node    {status|check|rejoin|service}\n"), progname());
 	printf(_("    %s [OPTIONS] cluster {show|event|matrix|crosscheck|cleanup}\n"), progname());
 	printf(_("    %s [OPTIONS] witness {register|unregister}\n"), progname());
@@ -3098,7 +3394,10 @@ get_standby_clone_mode(void)
 {
 	standy_clone_mode mode;
 
-	if (*config_file_options.barman_host != '\0' && runtime_options.without_barman == false)
+	/* --delta is only supported when cloning with rsync */
+	if (runtime_options.rsync_only == true || runtime_options.delta == true)
+		mode = parallel_rsync;
+	else if (*config_file_options.barman_host != '\0' && runtime_options.without_barman == false)
 		mode = barman;
 	else {
 		if (*config_file_options.pg_backupapi_host != '\0') {
@@ -3161,53 +3460,12 @@ copy_remote_files(char *host, char *remote_user, char *remote_path,
 	 * When copying the main PGDATA directory, certain files and contents of
 	 * certain directories need to be excluded.
 	 *
-	 * See function 'sendDir()' in 'src/backend/replication/basebackup.c' -
-	 * we're basically simulating what pg_basebackup does, but with rsync
-	 * rather than the BASEBACKUP replication protocol command.
-	 *
 	 * *However* currently we'll always copy the contents of the 'pg_replslot'
 	 * directory and delete later if appropriate.
 	 */
 	if (is_directory)
 	{
-		/* Files which we don't want */
-		appendPQExpBufferStr(&rsync_flags,
-							 " --exclude=postmaster.pid --exclude=postmaster.opts --exclude=global/pg_control");
-
-		appendPQExpBufferStr(&rsync_flags,
-							 " --exclude=recovery.conf --exclude=recovery.done");
-
-		/*
-		 * Ideally we'd use PG_AUTOCONF_FILENAME from utils/guc.h, but
-		 * that has too many dependencies for a mere client program.
-		 */
-		appendPQExpBuffer(&rsync_flags, " --exclude=%s.tmp",
-						  PG_AUTOCONF_FILENAME);
-
-		/* Temporary files which we don't want, if they exist */
-		appendPQExpBuffer(&rsync_flags, " --exclude=%s*",
-						  PG_TEMP_FILE_PREFIX);
-
-		/* Directories which we don't want */
-
-		if (server_version_num >= 100000)
-		{
-			appendPQExpBufferStr(&rsync_flags,
-								 " --exclude=pg_wal/* --exclude=log/*");
-		}
-		else
-		{
-			appendPQExpBufferStr(&rsync_flags,
-								 " --exclude=pg_xlog/* --exclude=pg_log/*");
-		}
-
-		/*
-		 * From PostgreSQL 15, the core server no longer uses pg_stat_tmp,
-		 * but some extensions (e.g. pg_stat_statements) may still do, so
-		 * keep excluding it.
-		 */
-		appendPQExpBufferStr(&rsync_flags,
-							 " --exclude=pg_stat_tmp/*");
+		append_rsync_exclude_options(&rsync_flags, true, server_version_num);
 
 		maxlen_snprintf(script, "rsync %s %s:%s/* %s",
 						rsync_flags.data, host_string, remote_path, local_path);
@@ -3235,6 +3493,63 @@ copy_remote_files(char *host, char *remote_user, char *remote_path,
 
 
 
+/*
+ * append_rsync_exclude_options()
+ *
+ * Append the rsync options needed to exclude files which should not be
+ * copied from a running server's data directory (if "is_data_directory"
+ * is true) or tablespace directory.
+ *
+ * See function 'sendDir()' in 'src/backend/replication/basebackup.c' -
+ * we're basically simulating what pg_basebackup does, but with rsync
+ * rather than the BASEBACKUP replication protocol command.
+ */
+void
+append_rsync_exclude_options(PQExpBufferData *rsync_flags, bool is_data_directory, int server_version_num)
+{
+	/* Temporary files which we don't want, if they exist */
+	appendPQExpBuffer(rsync_flags, " --exclude=%s*",
+					  PG_TEMP_FILE_PREFIX);
+
+	if (is_data_directory == false)
+		return;
+
+	/* Files which we don't want */
+	appendPQExpBufferStr(rsync_flags,
+						 " --exclude=postmaster.pid --exclude=postmaster.opts --exclude=global/pg_control");
+
+	appendPQExpBufferStr(rsync_flags,
+						 " --exclude=recovery.conf --exclude=recovery.done");
+
+	/*
+	 * Ideally we'd use PG_AUTOCONF_FILENAME from utils/guc.h, but
+	 * that has too many dependencies for a mere client program.
+	 */
+	appendPQExpBuffer(rsync_flags, " --exclude=%s.tmp",
+					  PG_AUTOCONF_FILENAME);
+
+	/* Directories which we don't want */
+
+	if (server_version_num >= 100000)
+	{
+		appendPQExpBufferStr(rsync_flags,
+							 " --exclude=pg_wal/* --exclude=log/*");
+	}
+	else
+	{
+		appendPQExpBufferStr(rsync_flags,
+							 " --exclude=pg_xlog/* --exclude=pg_log/*");
+	}
+
+	/*
+	 * From PostgreSQL 15, the core server no longer uses pg_stat_tmp,
+	 * but some extensions (e.g. pg_stat_statements) may still do, so
+	 * keep excluding it.
+	 */
+	appendPQExpBufferStr(rsync_flags,
+						 " --exclude=pg_stat_tmp/*");
+}
+
 
 void
 make_remote_repmgr_path(PQExpBufferData *output_buf, t_node_info *remote_node_record)
@@ -49,6 +49,8 @@
 #define SERVICE_UNPAUSE		   23
 #define DAEMON_START 		   24
 #define DAEMON_STOP 		   25
+#define STANDBY_PROVISION	   26
+#define NODE_AGENT			   27
 
 /* command line options without short versions */
 #define OPT_HELP						   1001
@@ -101,6 +103,19 @@
 #define OPT_VERIFY_BACKUP				   1048
 #define OPT_RECOVERY_MIN_APPLY_DELAY       1049
 #define OPT_REPMGRD						   1050
+#define OPT_PARALLEL					   1051
+#define OPT_TIMEOUT						   1052
+#define OPT_WATCH						   1053
+#define OPT_RESUME						   1054
+#define OPT_RSYNC_ONLY					   1055
+#define OPT_RSYNC_SOURCES				   1056
+#define OPT_DELTA						   1057
+#define OPT_PROGRESS_FILE				   1058
+#define OPT_MAX_RATE					   1059
+#define OPT_ADAPTIVE_RATE				   1060
+#define OPT_HOSTS						   1061
+#define OPT_AUTO_SOURCE					   1062
+#define OPT_REPORT_JSON					   1063
 
 /* These options are for internal use only */
 #define OPT_CONFIG_ARCHIVE_DIR			   2001
@@ -166,6 +181,18 @@ static struct option long_options[] =
 	{"without-barman", no_argument, NULL, OPT_WITHOUT_BARMAN},
 	{"replication-conf-only", no_argument, NULL, OPT_REPLICATION_CONF_ONLY},
 	{"verify-backup", no_argument, NULL, OPT_VERIFY_BACKUP },
+	{"resume", no_argument, NULL, OPT_RESUME},
+	{"rsync-only", no_argument, NULL, OPT_RSYNC_ONLY},
+	{"rsync-sources", required_argument, NULL, OPT_RSYNC_SOURCES},
+	{"delta", no_argument, NULL, OPT_DELTA},
+	{"progress-file", required_argument, NULL, OPT_PROGRESS_FILE},
+	{"max-rate", required_argument, NULL, OPT_MAX_RATE},
+	{"adaptive-rate", optional_argument, NULL, OPT_ADAPTIVE_RATE},
+	{"auto-source", no_argument, NULL, OPT_AUTO_SOURCE},
+
+/* "standby provision" options */
+	{"hosts", required_argument, NULL, OPT_HOSTS},
+
 	{"recovery-min-apply-delay", required_argument, NULL, OPT_RECOVERY_MIN_APPLY_DELAY },
 	/* deprecate this once Pg11 and earlier are unsupported */
 	{"recovery-conf-only", no_argument, NULL, OPT_REPLICATION_CONF_ONLY},
@@ -182,6 +209,7 @@ static struct option long_options[] =
 	{"siblings-follow", no_argument, NULL, OPT_SIBLINGS_FOLLOW},
 	{"repmgrd-no-pause", no_argument, NULL, OPT_REPMGRD_NO_PAUSE},
 	{"repmgrd-force-unpause", no_argument, NULL, OPT_REPMGRD_FORCE_UNPAUSE},
+	{"report-json", required_argument, NULL, OPT_REPORT_JSON},
 
 /* "node status" options */
 	{"is-shutdown-cleanly", no_argument, NULL, OPT_IS_SHUTDOWN_CLEANLY},
@@ -211,6 +239,11 @@ static struct option long_options[] =
 	{"list-actions", no_argument, NULL, OPT_LIST_ACTIONS},
 	{"checkpoint", no_argument, NULL, OPT_CHECKPOINT},
 
+/* "cluster show", "cluster matrix" and "cluster crosscheck" options */
+	{"parallel", required_argument, NULL, OPT_PARALLEL},
+	{"timeout", required_argument, NULL, OPT_TIMEOUT},
+	{"watch", required_argument, NULL, OPT_WATCH},
+
 /* "cluster event" options */
 	{"all", no_argument, NULL, OPT_ALL},
 	{"event", required_argument, NULL, OPT_EVENT},
@@ -23,6 +23,8 @@
 
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
 #include "access/xlog.h"
 #include "miscadmin.h"
 #include "replication/walreceiver.h"
@@ -52,6 +54,9 @@
 #define REPMGRD_STATE_FILE PGSTAT_STAT_PERMANENT_DIRECTORY "/repmgrd_state.txt"
 #define REPMGRD_STATE_FILE_BUF_SIZE 128
 
+/* maximum number of nodes for which repmgrd can record connectivity */
+#define MAX_NODE_CONNECTIVITY_RECORDS 128
+
 PG_MODULE_MAGIC;
 
 typedef enum
@@ -61,6 +66,14 @@ typedef enum
 	CANDIDATE_NODE
 } NodeState;
 
+typedef struct NodeConnectivity
+{
+	int			node_id;
+	bool		reachable;
+	int			rtt_us;			/* round-trip time in microseconds, -1 if unknown */
+	TimestampTz last_checked;
+} NodeConnectivity;
+
 typedef struct repmgrdSharedState
 {
 	LWLockId	lock;			/* protects search/modification */
@@ -76,6 +89,9 @@ typedef struct repmgrdSharedState
 	int			current_electoral_term;
 	int			candidate_node_id;
 	bool		follow_new_primary;
+	/* connectivity to other nodes, as seen by repmgrd */
+	int			node_connectivity_count;
+	NodeConnectivity node_connectivity[MAX_NODE_CONNECTIVITY_RECORDS];
 } repmgrdSharedState;
 
 static repmgrdSharedState *shared_state = NULL;
@@ -110,6 +126,8 @@ PG_FUNCTION_INFO_V1(repmgrd_is_running);
 PG_FUNCTION_INFO_V1(repmgrd_pause);
 PG_FUNCTION_INFO_V1(repmgrd_is_paused);
 PG_FUNCTION_INFO_V1(repmgr_get_wal_receiver_pid);
+PG_FUNCTION_INFO_V1(repmgr_set_node_connectivity);
+PG_FUNCTION_INFO_V1(repmgr_get_node_connectivity);
 
 
 /*
@@ -203,6 +221,7 @@ repmgr_shmem_startup(void)
 		shared_state->voting_status = VS_NO_VOTE;
 		shared_state->candidate_node_id = UNKNOWN_NODE_ID;
 		shared_state->follow_new_primary = false;
+		shared_state->node_connectivity_count = 0;
 	}
 
 	LWLockRelease(AddinShmemInitLock);
@@ -727,3 +746,147 @@ repmgr_get_wal_receiver_pid(PG_FUNCTION_ARGS)
 
 	PG_RETURN_INT32(wal_receiver_pid);
 }
+
+
+/* =========================== */
+/* node connectivity functions */
+/* =========================== */
+
+/*
+ * Record whether the specified node was reachable from the local node
+ * when last checked by repmgrd, and the round-trip time in microseconds
+ * (-1 if not known).
+ *
+ * If no free slot is available, the record checked least recently is
+ * replaced.
+ */
+Datum
+repmgr_set_node_connectivity(PG_FUNCTION_ARGS)
+{
+	int			node_id = UNKNOWN_NODE_ID;
+	bool		reachable = false;
+	int			rtt_us = -1;
+	int			i;
+	int			slot = -1;
+
+	if (!shared_state)
+		PG_RETURN_VOID();
+
+	node_id = PG_GETARG_INT32(0);
+	reachable = PG_GETARG_BOOL(1);
+	rtt_us = PG_GETARG_INT32(2);
+
+	LWLockAcquire(shared_state->lock, LW_EXCLUSIVE);
+
+	for (i = 0; i < shared_state->node_connectivity_count; i++)
+	{
+		if (shared_state->node_connectivity[i].node_id == node_id)
+		{
+			slot = i;
+			break;
+		}
+	}
+
+	if (slot == -1)
+	{
+		if (shared_state->node_connectivity_count < MAX_NODE_CONNECTIVITY_RECORDS)
+		{
+			slot = shared_state->node_connectivity_count++;
+		}
+		else
+		{
+			slot = 0;
+
+			for (i = 1; i < shared_state->node_connectivity_count; i++)
+			{
+				if (shared_state->node_connectivity[i].last_checked < shared_state->node_connectivity[slot].last_checked)
+					slot = i;
+			}
+		}
+	}
+
+	shared_state->node_connectivity[slot].node_id = node_id;
+	shared_state->node_connectivity[slot].reachable = reachable;
+	shared_state->node_connectivity[slot].rtt_us = rtt_us;
+	shared_state->node_connectivity[slot].last_checked = GetCurrentTimestamp();
+
+	LWLockRelease(shared_state->lock);
+
+	PG_RETURN_VOID();
+}
+
+
+/*
+ * Return the connectivity records stored by repmgrd, one row per node.
+ */
+Datum
+repmgr_get_node_connectivity(PG_FUNCTION_ARGS)
+{
+	FuncCallContext *funcctx;
+	NodeConnectivity *records;
+
+	if (SRF_IS_FIRSTCALL())
+	{
+		MemoryContext oldcontext;
+		TupleDesc	tupdesc;
+
+		funcctx = SRF_FIRSTCALL_INIT();
+		oldcontext = MemoryContextSwitchTo(funcctx->multi_call_memory_ctx);
+
+		if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+			elog(ERROR, "return type must be a row type");
+
+		funcctx->tuple_desc = BlessTupleDesc(tupdesc);
+
+		/* take a copy of the records, so the lock is held only briefly */
+		records = (NodeConnectivity *) palloc0(sizeof(NodeConnectivity) * MAX_NODE_CONNECTIVITY_RECORDS);
+
+		if (shared_state)
+		{
+			LWLockAcquire(shared_state->lock, LW_SHARED);
+			funcctx->max_calls = shared_state->node_connectivity_count;
+			memcpy(records,
+				   shared_state->node_connectivity,
+				   sizeof(NodeConnectivity) * funcctx->max_calls);
+			LWLockRelease(shared_state->lock);
+		}
+
+		funcctx->user_fctx = records;
+
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	funcctx = SRF_PERCALL_SETUP();
+	records = (NodeConnectivity *) funcctx->user_fctx;
+
+	if (funcctx->call_cntr < funcctx->max_calls)
+	{
+		NodeConnectivity *record = &records[funcctx->call_cntr];
+		Datum		values[4];
+		bool		nulls[4];
+		HeapTuple	tuple;
+
+		memset(nulls, 0, sizeof(nulls));
+
+		values[0] = Int32GetDatum(record->node_id);
+		values[1] = BoolGetDatum(record->reachable);
+
+		if (record->rtt_us < 0)
+		{
+			values[2] = (Datum) 0;
+			nulls[2] = true;
+		}
+		else
+		{
+			values[2] = Int32GetDatum(record->rtt_us);
+		}
+
+		values[3] = TimestampTzGetDatum(record->last_checked);
+
+		tuple = heap_form_tuple(funcctx->tuple_desc, values, nulls);
+
+		SRF_RETURN_NEXT(funcctx, HeapTupleGetDatum(tuple));
+	}
+
+	SRF_RETURN_DONE(funcctx);
+}
@@ -102,6 +102,9 @@
  * Default command line option parameter values
  */
 #define DEFAULT_WAIT_START                   30  /* seconds */
+#define DEFAULT_PARALLEL                     8   /* concurrent node operations */
+#define DEFAULT_TIMEOUT                      10  /* seconds */
+#define DEFAULT_ADAPTIVE_RATE_MAX_LAG        10  /* seconds */
 
 /*
  * Default configuration file parameter values - ensure repmgr.conf.sample
@@ -126,6 +129,11 @@
 #define DEFAULT_REPLICATION_LAG_CRITICAL     600 /* seconds */
 #define DEFAULT_WITNESS_SYNC_INTERVAL        15  /* seconds */
 #define DEFAULT_WAL_RECEIVE_CHECK_TIMEOUT    30  /* seconds */
+#define DEFAULT_SWITCHOVER_PREPARE_TIMEOUT   30  /* seconds */
+#define DEFAULT_SWITCHOVER_PREPARE_LAG_BYTES 1048576 /* bytes */
+#define DEFAULT_SWITCHOVER_PREPARE_LAG_SECONDS 1 /* seconds */
+#define DEFAULT_SIBLINGS_FOLLOW_MAX_PARALLEL 8
+#define DEFAULT_SIBLINGS_FOLLOW_TIMEOUT      120 /* seconds */
 #define DEFAULT_LOCATION                     "default"
 #define DEFAULT_PRIORITY                     100
 #define DEFAULT_MONITORING_INTERVAL          2	 /* seconds */
@@ -148,6 +156,9 @@
 #define DEFAULT_CHILD_NODES_CONNECTED_MIN_COUNT -1
 #define DEFAULT_CHILD_NODES_CONNECTED_INCLUDE_WITNESS false
 #define DEFAULT_CHILD_NODES_DISCONNECT_TIMEOUT 30 /* seconds */
+#define DEFAULT_CONNECTIVITY_CHECK_INTERVAL  0   /* seconds */
+#define DEFAULT_PREWARM_INTERVAL             0   /* seconds */
+#define DEFAULT_PREWARM_MIN_PRIORITY         100
 #define DEFAULT_SSH_OPTIONS                  "-q -o ConnectTimeout=10"
 
 
@@ -82,6 +82,21 @@ typedef struct t_child_node_info_list
 	0 \
 }
 
+/*
+ * Buffers on the primary with at least this usage count are considered part
+ * of its hot set; at most PREWARM_MAX_RANGES ranges of consecutive blocks are
+ * loaded into the standby's shared buffers per "prewarm_interval".
+ */
+#define PREWARM_MIN_USAGECOUNT 3
+#define PREWARM_MAX_RANGES 10000
+
+/*
+ * "statement_timeout" (in seconds) for capturing the hot set on the primary;
+ * if no result has been received within twice this time, e.g. because the
+ * primary has become unresponsive, the capture is abandoned.
+ */
+#define PREWARM_CAPTURE_TIMEOUT 30
+
 static PGconn *upstream_conn = NULL;
 static PGconn *primary_conn = NULL;
 
@@ -94,6 +109,15 @@ static instr_time last_monitoring_update;
 
 static bool child_nodes_disconnect_command_executed = false;
 
+/* state of buffer prewarming, which is spread over monitoring loop iterations */
+static BufferRangeList prewarm_ranges = T_BUFFER_RANGE_LIST_INITIALIZER;
+static int	prewarm_next_range = 0;
+static PGconn *prewarm_conn = NULL;
+static PGconn *prewarm_capture_conn = NULL;
+static PGresult *prewarm_res = NULL;
+static int64 prewarm_blocks_loaded = 0;
+static instr_time prewarm_interval_start;
+
 static ElectionResult do_election(NodeInfoList *sibling_nodes, int *new_primary_id);
 static const char *_print_election_result(ElectionResult result);
 
@@ -117,6 +141,11 @@ static bool do_witness_failover(void);
 
 static bool update_monitoring_history(void);
 
+static void prewarm_buffer_hot_set(void);
+static bool prewarm_next_database(void);
+static bool prewarm_query_complete(PGconn *conn);
+static void reset_prewarm_state(void);
+
 static void handle_sighup(PGconn **conn, t_server_type server_type);
 
 static const char *format_failover_state(FailoverState failover_state);
@@ -350,6 +379,7 @@ monitor_streaming_primary(void)
 {
 	instr_time	log_status_interval_start;
 	instr_time	child_nodes_check_interval_start;
+	instr_time	connectivity_check_interval_start;
 	t_child_node_info_list local_child_nodes = T_CHILD_NODE_INFO_LIST_INITIALIZER;
 
 	reset_node_voting_status();
@@ -393,6 +423,7 @@ monitor_streaming_primary(void)
 
 	INSTR_TIME_SET_CURRENT(log_status_interval_start);
 	INSTR_TIME_SET_CURRENT(child_nodes_check_interval_start);
+	INSTR_TIME_SET_CURRENT(connectivity_check_interval_start);
 	local_node_info.node_status = NODE_STATUS_UP;
 
 	/*
@@ -652,6 +683,18 @@ loop:
 			}
 		}
 
+		/* record connectivity to other nodes, if requested */
+		if (config_file_options.connectivity_check_interval > 0 && PQstatus(local_conn) == CONNECTION_OK)
+		{
+			int			connectivity_check_interval_elapsed = calculate_elapsed(connectivity_check_interval_start);
+
+			if (connectivity_check_interval_elapsed >= config_file_options.connectivity_check_interval)
+			{
+				update_node_connectivity(local_conn);
+				INSTR_TIME_SET_CURRENT(connectivity_check_interval_start);
+			}
+		}
+
 		if (got_SIGHUP)
 		{
 			handle_sighup(&local_conn, PRIMARY);
@@ -1355,6 +1398,7 @@ monitor_streaming_standby(void)
 {
 	RecordStatus record_status;
 	instr_time	log_status_interval_start;
+	instr_time	connectivity_check_interval_start;
 
 	MonitoringState local_monitoring_state = MS_NORMAL;
 	instr_time	local_degraded_monitoring_start;
@@ -1545,6 +1589,7 @@ monitor_streaming_standby(void)
 
 	monitoring_state = MS_NORMAL;
 	INSTR_TIME_SET_CURRENT(log_status_interval_start);
+	INSTR_TIME_SET_CURRENT(connectivity_check_interval_start);
 	upstream_node_info.node_status = NODE_STATUS_UP;
 
 	while (true)
@@ -2276,6 +2321,30 @@ loop:
 			}
 		}
 
+		/* record connectivity to other nodes, if requested */
+		if (config_file_options.connectivity_check_interval > 0 && PQstatus(local_conn) == CONNECTION_OK)
+		{
+			int			connectivity_check_interval_elapsed = calculate_elapsed(connectivity_check_interval_start);
+
+			if (connectivity_check_interval_elapsed >= config_file_options.connectivity_check_interval)
+			{
+				update_node_connectivity(local_conn);
+				INSTR_TIME_SET_CURRENT(connectivity_check_interval_start);
+			}
+		}
+
+		/* load the primary's most frequently used buffers, if requested */
+		if (config_file_options.prewarm_interval > 0 && monitoring_state == MS_NORMAL)
+		{
+			prewarm_buffer_hot_set();
+		}
+		else if (config_file_options.prewarm_interval == 0
+				 && (prewarm_conn != NULL || prewarm_capture_conn != NULL))
+		{
+			/* prewarming was disabled by a configuration reload */
+			reset_prewarm_state();
+		}
+
 		if (got_SIGHUP)
 		{
 			handle_sighup(&local_conn, STANDBY);
@@ -2330,6 +2399,7 @@ monitor_streaming_witness(void)
 {
 	instr_time	log_status_interval_start;
 	instr_time	witness_sync_interval_start;
+	instr_time	connectivity_check_interval_start;
 
 	RecordStatus record_status;
 
@@ -2467,6 +2537,8 @@ monitor_streaming_witness(void)
 		upstream_node_info.node_status = NODE_STATUS_DOWN;
 	}
 
+	INSTR_TIME_SET_CURRENT(connectivity_check_interval_start);
+
 	while (true)
 	{
 		if (check_upstream_connection(&primary_conn, upstream_node_info.conninfo, NULL) == true)
@@ -2850,6 +2922,18 @@ loop:
 
 
 
+		/* record connectivity to other nodes, if requested */
+		if (config_file_options.connectivity_check_interval > 0 && PQstatus(local_conn) == CONNECTION_OK)
+		{
+			int			connectivity_check_interval_elapsed = calculate_elapsed(connectivity_check_interval_start);
+
+			if (connectivity_check_interval_elapsed >= config_file_options.connectivity_check_interval)
+			{
+				update_node_connectivity(local_conn);
+				INSTR_TIME_SET_CURRENT(connectivity_check_interval_start);
+			}
+		}
+
 		if (got_SIGHUP)
 		{
 			handle_sighup(&local_conn, WITNESS);
@@ -3265,6 +3349,228 @@ do_primary_failover(void)
 }
 
 
+/*
+ * prewarm_buffer_hot_set()
+ *
+ * Every "prewarm_interval" seconds, capture the primary's buffer hot set
+ * via "pg_buffercache" and load the corresponding blocks into the local
+ * node's shared buffers with "pg_prewarm", so that if this node is
+ * promoted, its cache contents resemble those of the former primary.
+ *
+ * The hot set is captured by an asynchronous query on a dedicated connection
+ * to the primary, and blocks are then loaded by an asynchronous query for
+ * each database in turn; this function is called on each iteration of the
+ * monitoring loop and does not wait for any of these queries to complete,
+ * so monitoring is not delayed.
+ *
+ * Only nodes with a priority of at least "prewarm_min_priority" (i.e.
+ * likely promotion candidates) are prewarmed.
+ */
+static void
+prewarm_buffer_hot_set(void)
+{
+	char		statement_timeout[MAXLEN] = "";
+
+	if (local_node_info.priority < config_file_options.prewarm_min_priority)
+	{
+		reset_prewarm_state();
+		return;
+	}
+
+	/* check for completion of the hot set capture */
+	if (prewarm_capture_conn != NULL)
+	{
+		if (prewarm_query_complete(prewarm_capture_conn) == false)
+		{
+			if (calculate_elapsed(prewarm_interval_start) < PREWARM_CAPTURE_TIMEOUT * 2)
+				return;
+
+			log_warning(_("no response to buffer hot set query after %i seconds, abandoning"),
+						PREWARM_CAPTURE_TIMEOUT * 2);
+			reset_prewarm_state();
+			return;
+		}
+
+		close_connection(&prewarm_capture_conn);
+
+		if (prewarm_res != NULL && parse_buffer_hot_set(prewarm_res, &prewarm_ranges) == true)
+		{
+			log_debug("prewarm_buffer_hot_set(): captured %i ranges in %i seconds",
+					  prewarm_ranges.range_count,
+					  calculate_elapsed(prewarm_interval_start));
+			prewarm_next_range = 0;
+			prewarm_blocks_loaded = 0;
+		}
+
+		PQclear(prewarm_res);
+		prewarm_res = NULL;
+	}
+
+	/* check for completion of the current prewarm query */
+	if (prewarm_conn != NULL)
+	{
+		if (prewarm_query_complete(prewarm_conn) == false)
+			return;
+
+		if (PQresultStatus(prewarm_res) == PGRES_TUPLES_OK)
+		{
+			prewarm_blocks_loaded += atol(PQgetvalue(prewarm_res, 0, 0));
+		}
+		else if (prewarm_res != NULL)
+		{
+			log_warning(_("unable to prewarm buffers in database \"%s\""),
+						PQdb(prewarm_conn));
+			log_detail("%s", PQresultErrorMessage(prewarm_res));
+		}
+
+		PQclear(prewarm_res);
+		prewarm_res = NULL;
+		close_connection(&prewarm_conn);
+	}
+
+	/* start prewarming the next database, if any remain */
+	while (prewarm_next_range < prewarm_ranges.range_count)
+	{
+		if (prewarm_next_database() == true)
+			return;
+	}
+
+	if (prewarm_ranges.range_count > 0)
+	{
+		log_verbose(LOG_INFO, _("prewarmed %lu blocks in %i ranges from the primary's buffer hot set"),
+					(uint64) prewarm_blocks_loaded,
+					prewarm_ranges.range_count);
+		clear_buffer_range_list(&prewarm_ranges);
+	}
+
+	if (!INSTR_TIME_IS_ZERO(prewarm_interval_start)
+		&& calculate_elapsed(prewarm_interval_start) < config_file_options.prewarm_interval)
+		return;
+
+	if (PQstatus(primary_conn) != CONNECTION_OK)
+		return;
+
+	INSTR_TIME_SET_CURRENT(prewarm_interval_start);
+
+	log_debug("prewarm_buffer_hot_set(): capturing buffer hot set from primary");
+
+	prewarm_capture_conn = duplicate_connection(primary_conn, NULL, false);
+
+	if (PQstatus(prewarm_capture_conn) != CONNECTION_OK)
+	{
+		log_warning(_("unable to connect to primary to capture buffer hot set"));
+		close_connection(&prewarm_capture_conn);
+		return;
+	}
+
+	maxlen_snprintf(statement_timeout, "%is", PREWARM_CAPTURE_TIMEOUT);
+
+	if (set_config(prewarm_capture_conn, "statement_timeout", statement_timeout) == false
+		|| send_buffer_hot_set_query(prewarm_capture_conn,
+									 PREWARM_MIN_USAGECOUNT,
+									 PREWARM_MAX_RANGES) == false)
+	{
+		close_connection(&prewarm_capture_conn);
+	}
+}
+
+
+/*
+ * prewarm_query_complete()
+ *
+ * Check without blocking whether the query sent on "conn" has completed;
+ * results are read as they become available and the last one retained in
+ * "prewarm_res", which is NULL on completion if no result could be received.
+ */
+static bool
+prewarm_query_complete(PGconn *conn)
+{
+	if (PQconsumeInput(conn) == 0)
+	{
+		log_warning(_("unable to receive query result from database \"%s\""),
+					PQdb(conn));
+		log_detail("%s", PQerrorMessage(conn));
+
+		PQclear(prewarm_res);
+		prewarm_res = NULL;
+		return true;
+	}
+
+	while (PQisBusy(conn) == 0)
+	{
+		PGresult   *res = PQgetResult(conn);
+
+		if (res == NULL)
+			return true;
+
+		PQclear(prewarm_res);
+		prewarm_res = res;
+	}
+
+	return false;
+}
+
+
+/*
+ * prewarm_next_database()
+ *
+ * Send the prewarm query for the ranges belonging to the next database in
+ * "prewarm_ranges" (which are grouped by database). Returns false if the
+ * database could not be prewarmed, in which case its ranges are skipped.
+ */
+static bool
+prewarm_next_database(void)
+{
+	int			first_range = prewarm_next_range;
+	int			range_count = 0;
+	const char *database = prewarm_ranges.ranges[first_range].database;
+
+	while (first_range + range_count < prewarm_ranges.range_count
+		   && strcmp(prewarm_ranges.ranges[first_range + range_count].database, database) == 0)
+		range_count++;
+
+	prewarm_next_range += range_count;
+
+	prewarm_conn = establish_db_connection_with_replacement_param(config_file_options.conninfo,
+																  "dbname",
+																  database,
+																  false);
+
+	if (PQstatus(prewarm_conn) != CONNECTION_OK)
+	{
+		log_warning(_("unable to connect to database \"%s\" to prewarm buffers"), database);
+		close_connection(&prewarm_conn);
+		return false;
+	}
+
+	if (send_prewarm_query(prewarm_conn, &prewarm_ranges, first_range, range_count) == false)
+	{
+		close_connection(&prewarm_conn);
+		return false;
+	}
+
+	return true;
+}
+
+
+static void
+reset_prewarm_state(void)
+{
+	if (prewarm_conn != NULL)
+		close_connection(&prewarm_conn);
+
+	if (prewarm_capture_conn != NULL)
+		close_connection(&prewarm_capture_conn);
+
+	PQclear(prewarm_res);
+	prewarm_res = NULL;
+
+	clear_buffer_range_list(&prewarm_ranges);
+	prewarm_next_range = 0;
+	prewarm_blocks_loaded = 0;
+}
+
+
 static bool
 update_monitoring_history(void)
 {
@@ -3632,6 +3938,9 @@ promote_self(void)
 	t_node_info failed_primary = T_NODE_INFO_INITIALIZER;
 	RecordStatus record_status;
 
+	/* stop any prewarming in progress; the cache contents are retained */
+	reset_prewarm_state();
+
 	/*
 	 * optionally add a delay before promoting the standby; this is mainly
 	 * useful for testing (e.g. for reappearance of the original primary) and
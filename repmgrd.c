@@ -20,6 +20,7 @@
 #include <stdio.h>
 #include <signal.h>
 #include <stdlib.h>
+#include <poll.h>
 #include <sys/stat.h>
 
 
@@ -31,6 +32,13 @@
 
 #define OPT_HELP	1
 
+/*
+ * Maximum time (in seconds) the connectivity check may take, including
+ * both connection attempts and round-trip time measurement; this is kept
+ * short as the check is executed from the monitoring loop.
+ */
+#define CONNECTIVITY_CHECK_TIMEOUT 2
+
 
 static char *config_file = NULL;
 static bool verbose = false;
@@ -62,6 +70,7 @@ static void daemonize_process(void);
 static void check_and_create_pid_file(const char *pid_file);
 
 static void start_monitoring(void);
+static void _measure_query_rtt(NodeInfoList *nodes, int *rtt_us, instr_time start_time, int timeout);
 
 
 #ifndef WIN32
@@ -71,6 +80,7 @@ static void handle_sighup(SIGNAL_ARGS);
 
 int			calculate_elapsed(instr_time start_time);
 void		update_registration(PGconn *conn);
+void		update_node_connectivity(PGconn *conn);
 void		terminate(int retval);
 
 int
@@ -602,6 +612,190 @@ update_registration(PGconn *conn)
 }
 
 
+/*
+ * update_node_connectivity()
+ *
+ * Attempt to connect to each node in the cluster, and record in shared memory
+ * whether it is reachable from the local node, together with the round-trip
+ * time of a minimal query. This enables "repmgr cluster matrix" to build
+ * a connectivity matrix without executing "repmgr cluster show" on each node
+ * via SSH.
+ *
+ * Connection attempts and queries are made concurrently, and the whole check
+ * will take at most CONNECTIVITY_CHECK_TIMEOUT seconds, so it does not unduly
+ * delay monitoring of the local and upstream nodes.
+ */
+void
+update_node_connectivity(PGconn *conn)
+{
+	NodeInfoList nodes = T_NODE_INFO_LIST_INITIALIZER;
+	NodeInfoListCell *cell = NULL;
+	int		   *rtt_us = NULL;
+	int			reachable_count = 0;
+	int			i = 0;
+	instr_time	start_time;
+
+	if (get_all_node_records(conn, &nodes) == false)
+	{
+		/* get_all_node_records() will display the error */
+		return;
+	}
+
+	if (nodes.node_count == 0)
+	{
+		clear_node_info_list(&nodes);
+		return;
+	}
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	reachable_count = establish_db_connections_parallel(&nodes,
+														nodes.node_count,
+														CONNECTIVITY_CHECK_TIMEOUT);
+
+	/* measure round-trip time with a minimal query, within the remaining time */
+	rtt_us = (int *) pg_malloc(sizeof(int) * nodes.node_count);
+	_measure_query_rtt(&nodes, rtt_us, start_time, CONNECTIVITY_CHECK_TIMEOUT);
+
+	for (cell = nodes.head; cell; cell = cell->next, i++)
+	{
+		bool		reachable = (PQstatus(cell->node_info->conn) == CONNECTION_OK);
+
+		log_verbose(LOG_DEBUG, "update_node_connectivity(): node %i reachable: %s; rtt: %i",
+					cell->node_info->node_id,
+					format_bool(reachable),
+					rtt_us[i]);
+
+		close_connection(&cell->node_info->conn);
+
+		if (repmgrd_set_node_connectivity(conn, cell->node_info->node_id, reachable, rtt_us[i]) == false)
+			break;
+	}
+
+	log_debug("update_node_connectivity(): %i of %i nodes reachable",
+			  reachable_count, nodes.node_count);
+
+	pfree(rtt_us);
+	clear_node_info_list(&nodes);
+}
+
+
+/*
+ * _measure_query_rtt()
+ *
+ * Execute "SELECT 1" on each connected node in "nodes", and store the time
+ * between sending the query to that node and receiving its result (in
+ * microseconds) in the corresponding element of "rtt_us"; -1 is stored for
+ * nodes which are not connected, or which did not respond within "timeout"
+ * seconds of "start_time".
+ */
+static void
+_measure_query_rtt(NodeInfoList *nodes, int *rtt_us, instr_time start_time, int timeout)
+{
+	NodeInfoListCell *cell = NULL;
+	PGconn	  **active_conns = pg_malloc0(sizeof(PGconn *) * nodes->node_count);
+	instr_time *send_times = pg_malloc0(sizeof(instr_time) * nodes->node_count);
+	struct pollfd *pollfds = pg_malloc0(sizeof(struct pollfd) * nodes->node_count);
+	int			active_count = 0;
+	int			i = 0;
+
+	for (cell = nodes->head; cell; cell = cell->next, i++)
+	{
+		PGconn	   *node_conn = cell->node_info->conn;
+
+		rtt_us[i] = -1;
+
+		if (node_conn == NULL || PQstatus(node_conn) != CONNECTION_OK)
+			continue;
+
+		INSTR_TIME_SET_CURRENT(send_times[i]);
+
+		if (PQsendQuery(node_conn, "SELECT 1") == 0)
+			continue;
+
+		active_conns[i] = node_conn;
+		active_count++;
+	}
+
+	while (active_count > 0)
+	{
+		instr_time	elapsed_time;
+		double		remaining_ms;
+		int			poll_count = 0;
+		int			j;
+
+		INSTR_TIME_SET_CURRENT(elapsed_time);
+		INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+		remaining_ms = ((double) timeout * 1000) - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+		if (remaining_ms <= 0)
+			break;
+
+		for (i = 0; i < nodes->node_count; i++)
+		{
+			if (active_conns[i] == NULL)
+				continue;
+
+			pollfds[poll_count].fd = PQsocket(active_conns[i]);
+			pollfds[poll_count].events = POLLIN;
+			pollfds[poll_count].revents = 0;
+			poll_count++;
+		}
+
+		if (poll(pollfds, poll_count, (int) remaining_ms + 1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			log_warning(_("update_node_connectivity(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
+			break;
+		}
+
+		for (i = 0, j = 0; i < nodes->node_count; i++)
+		{
+			PGresult   *res = NULL;
+			bool		success = false;
+
+			if (active_conns[i] == NULL)
+				continue;
+
+			if (pollfds[j++].revents == 0)
+				continue;
+
+			if (PQconsumeInput(active_conns[i]) == 1)
+			{
+				if (PQisBusy(active_conns[i]) == 1)
+					continue;
+
+				while ((res = PQgetResult(active_conns[i])) != NULL)
+				{
+					if (PQresultStatus(res) == PGRES_TUPLES_OK)
+						success = true;
+					PQclear(res);
+				}
+			}
+
+			if (success == true)
+			{
+				instr_time	rtt;
+
+				INSTR_TIME_SET_CURRENT(rtt);
+				INSTR_TIME_SUBTRACT(rtt, send_times[i]);
+				rtt_us[i] = (int) INSTR_TIME_GET_MICROSEC(rtt);
+			}
+
+			active_conns[i] = NULL;
+			active_count--;
+		}
+	}
+
+	pfree(active_conns);
+	pfree(send_times);
+	pfree(pollfds);
+}
+
+
 static void
 daemonize_process(void)
 {
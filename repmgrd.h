@@ -29,6 +29,7 @@ int			calculate_elapsed(instr_time start_time);
 const char *print_monitoring_state(MonitoringState monitoring_state);
 
 void		update_registration(PGconn *conn);
+void		update_node_connectivity(PGconn *conn);
 void		terminate(int retval);
 
 #endif							/* _REPMGRD_H_ */
@@ -25,3 +25,5 @@ SELECT repmgr.set_local_node_id(-1);
 SELECT repmgr.set_local_node_id(NULL);
 SELECT repmgr.standby_get_last_updated();
 SELECT repmgr.standby_set_last_updated();
+SELECT repmgr.set_node_connectivity(-1, TRUE, 100);
+SELECT * FROM repmgr.get_node_connectivity();
@@ -478,6 +478,35 @@ string_remove_trailing_newlines(char *string)
 }
 
 
+/*
+ * read_text_line()
+ *
+ * Read one line of arbitrary length from "stream" into "line", without the
+ * trailing newline. Returns false at end of input.
+ */
+bool
+read_text_line(FILE *stream, PQExpBufferData *line)
+{
+	char		chunk[MAXLEN];
+
+	resetPQExpBuffer(line);
+
+	while (fgets(chunk, sizeof(chunk), stream) != NULL)
+	{
+		appendPQExpBufferStr(line, chunk);
+
+		if (line->len > 0 && line->data[line->len - 1] == '\n')
+		{
+			line->data[--line->len] = '\0';
+			return true;
+		}
+	}
+
+	/* final line without a trailing newline */
+	return line->len > 0 ? true : false;
+}
+
+
 char *
 trim(char *s)
 {
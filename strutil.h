@@ -161,6 +161,8 @@ extern char *string_skip_prefix(const char *prefix, char *string);
 extern char
 		   *string_remove_trailing_newlines(char *string);
 
+extern bool read_text_line(FILE *stream, PQExpBufferData *line);
+
 extern char *trim(char *s);
 
 extern void
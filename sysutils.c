@@ -20,10 +20,43 @@
  */
 
 #include <signal.h>
+#include <fcntl.h>
+#include <poll.h>
 
 #include "repmgr.h"
 
+/*
+ * Time allowed for a command to exit after SIGTERM before it is sent SIGKILL,
+ * and interval at which commands which have closed their output are checked
+ * for termination.
+ */
+#define COMMAND_TASK_KILL_TIMEOUT 5000		/* milliseconds */
+#define COMMAND_TASK_REAP_INTERVAL 10		/* milliseconds */
+
+/* periodic callback executed by execute_commands_parallel_progress() */
+typedef struct
+{
+	int			interval_ms;
+	void		(*callback) (t_command_task *tasks, int task_count, void *arg);
+	void	   *arg;
+} t_progress_hook;
+
+/* SIGINT or SIGTERM received while execute_commands_parallel() is running */
+static volatile sig_atomic_t command_tasks_signal = 0;
+
 static bool _local_command(const char *command, PQExpBufferData *outputbuf, bool simple, int *return_value);
+static int	_execute_commands_parallel(t_command_task *tasks, int task_count, int max_parallel, int timeout,
+									   void (*callback) (t_command_task *task, void *arg), void *arg,
+									   t_progress_hook *progress_hook);
+static bool _start_command_task(t_command_task *task);
+static void _kill_command_task(t_command_task *task);
+static void _finish_command_task(t_command_task *task, int status);
+static void _terminate_command_tasks(t_command_task **active_tasks, int active_count, int signo);
+static void _handle_command_tasks_signal(SIGNAL_ARGS);
+static bool _remote_agent_read_result(t_remote_agent *agent, PQExpBufferData *outputbuf, int *return_value);
+static bool _remote_agent_read(t_remote_agent *agent, int length, instr_time start_time);
+static void _remote_agent_consume(t_remote_agent *agent, int length, PQExpBufferData *outputbuf);
+static bool _remote_agent_read_line(t_remote_agent *agent, PQExpBufferData *line, instr_time start_time);
 
 
 /*
@@ -249,6 +282,1081 @@ make_remote_command(const char *host, const char *user, const char *command, con
 }
 
 
+/*
+ * start_remote_agent()
+ *
+ * Start "repmgr node agent" on the remote host via a single SSH session;
+ * "command" is the remote repmgr invocation including the "node agent"
+ * action. Subsequent requests are passed to remote_agent_command(), which
+ * avoids establishing a new SSH connection for each remote repmgr command.
+ *
+ * The agent must provide its greeting, and each subsequent result, within
+ * "timeout" seconds; otherwise the session is terminated.
+ *
+ * Returns false if the agent could not be started, e.g. because the remote
+ * repmgr version does not provide "node agent"; the caller should then fall
+ * back to remote_command().
+ */
+bool
+start_remote_agent(const char *host, const char *user, const char *command, const char *ssh_options, int timeout, t_remote_agent *agent)
+{
+	int			request_pipe[2];
+	int			response_pipe[2];
+	PQExpBufferData ssh_command;
+	PQExpBufferData greeting;
+	PQExpBufferData scan_format;
+	int			protocol_version = 0;
+	int			repmgr_version = 0;
+	instr_time	start_time;
+
+	agent->active = false;
+	agent->pid = UNKNOWN_PID;
+	agent->request_fp = NULL;
+	agent->response_fd = -1;
+	agent->timeout = timeout;
+	agent->pending_count = 0;
+
+	initPQExpBuffer(&agent->response);
+
+	initPQExpBuffer(&ssh_command);
+	make_remote_command(host, user, command, ssh_options, &ssh_command);
+
+	log_debug("start_remote_agent():\n  %s", ssh_command.data);
+
+	if (pipe(request_pipe) != 0)
+	{
+		log_error(_("unable to create pipe for remote agent"));
+		log_detail("%s", strerror(errno));
+		termPQExpBuffer(&ssh_command);
+		termPQExpBuffer(&agent->response);
+		return false;
+	}
+
+	if (pipe(response_pipe) != 0)
+	{
+		log_error(_("unable to create pipe for remote agent"));
+		log_detail("%s", strerror(errno));
+		close(request_pipe[0]);
+		close(request_pipe[1]);
+		termPQExpBuffer(&ssh_command);
+		termPQExpBuffer(&agent->response);
+		return false;
+	}
+
+	/*
+	 * If the agent goes away, writing a request must fail with EPIPE rather
+	 * than terminate repmgr.
+	 */
+	(void) signal(SIGPIPE, SIG_IGN);
+
+	fflush(NULL);
+
+	agent->pid = fork();
+
+	if (agent->pid == -1)
+	{
+		log_error(_("unable to execute remote command:\n  %s"), ssh_command.data);
+		log_detail("%s", strerror(errno));
+		close(request_pipe[0]);
+		close(request_pipe[1]);
+		close(response_pipe[0]);
+		close(response_pipe[1]);
+		agent->pid = UNKNOWN_PID;
+		termPQExpBuffer(&ssh_command);
+		termPQExpBuffer(&agent->response);
+		return false;
+	}
+
+	if (agent->pid == 0)
+	{
+		close(request_pipe[1]);
+		close(response_pipe[0]);
+
+		if (dup2(request_pipe[0], STDIN_FILENO) < 0 || dup2(response_pipe[1], STDOUT_FILENO) < 0)
+			_exit(127);
+
+		close(request_pipe[0]);
+		close(response_pipe[1]);
+
+		execl("/bin/sh", "sh", "-c", ssh_command.data, (char *) NULL);
+		_exit(127);
+	}
+
+	termPQExpBuffer(&ssh_command);
+
+	close(request_pipe[0]);
+	close(response_pipe[1]);
+
+	(void) fcntl(request_pipe[1], F_SETFD, FD_CLOEXEC);
+	(void) fcntl(response_pipe[0], F_SETFD, FD_CLOEXEC);
+
+	/* responses are read with a time limit; see _remote_agent_read() */
+	agent->response_fd = response_pipe[0];
+	(void) fcntl(agent->response_fd, F_SETFL, fcntl(agent->response_fd, F_GETFL) | O_NONBLOCK);
+
+	agent->request_fp = fdopen(request_pipe[1], "w");
+
+	if (agent->request_fp == NULL)
+	{
+		log_error(_("unable to open pipe for remote agent"));
+		log_detail("%s", strerror(errno));
+
+		close(request_pipe[1]);
+
+		stop_remote_agent(agent);
+		return false;
+	}
+
+	/* the agent announces its protocol and repmgr versions */
+	initPQExpBuffer(&greeting);
+	initPQExpBuffer(&scan_format);
+	appendPQExpBuffer(&scan_format, "%s %%i %%i", REMOTE_AGENT_GREETING);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	if (_remote_agent_read_line(agent, &greeting, start_time) == false
+		|| sscanf(greeting.data, scan_format.data, &protocol_version, &repmgr_version) != 2
+		|| protocol_version != REMOTE_AGENT_PROTOCOL_VERSION)
+	{
+		log_verbose(LOG_DEBUG, "start_remote_agent(): unexpected greeting \"%s\"", greeting.data);
+
+		termPQExpBuffer(&greeting);
+		termPQExpBuffer(&scan_format);
+		stop_remote_agent(agent);
+		return false;
+	}
+
+	termPQExpBuffer(&greeting);
+	termPQExpBuffer(&scan_format);
+
+	agent->active = true;
+	agent->protocol_version = protocol_version;
+	agent->repmgr_version = repmgr_version;
+
+	log_verbose(LOG_DEBUG, "start_remote_agent(): agent started; remote repmgr version is %i",
+				repmgr_version);
+
+	return true;
+}
+
+
+/*
+ * remote_agent_send()
+ *
+ * Send a request to the agent without waiting for its result, so a batch
+ * of requests can be submitted in a single round trip. "request" is the
+ * remote repmgr command line without the repmgr binary and configuration
+ * file, e.g. "node check --archive-ready --optformat". Results are
+ * retrieved in order with remote_agent_command().
+ */
+bool
+remote_agent_send(t_remote_agent *agent, const char *request)
+{
+	if (agent->active == false)
+		return false;
+
+	if (agent->pending_count >= REMOTE_AGENT_MAX_PENDING)
+	{
+		log_warning(_("too many pending remote agent requests"));
+		return false;
+	}
+
+	if (strchr(request, '\n') != NULL)
+	{
+		log_warning(_("remote agent request may not contain a newline"));
+		return false;
+	}
+
+	log_verbose(LOG_DEBUG, "remote_agent_send():\n  %s", request);
+
+	if (fprintf(agent->request_fp, "%s\n", request) < 0 || fflush(agent->request_fp) != 0)
+	{
+		log_warning(_("unable to send request to remote agent"));
+		log_detail("%s", strerror(errno));
+		stop_remote_agent(agent);
+		return false;
+	}
+
+	agent->pending[agent->pending_count++] = pg_strdup(request);
+
+	return true;
+}
+
+
+/*
+ * remote_agent_command()
+ *
+ * Execute "request" via the agent and store its output in "outputbuf" and
+ * its exit code in "return_value" (if not NULL). If "request" was already
+ * submitted with remote_agent_send(), its result is read; results of any
+ * requests submitted before it are discarded.
+ *
+ * Returns false if the agent session failed; like remote_command(), a
+ * non-zero exit code from the remote repmgr is not treated as failure.
+ */
+bool
+remote_agent_command(t_remote_agent *agent, const char *request, PQExpBufferData *outputbuf, int *return_value)
+{
+	bool		queued = false;
+	int			i;
+
+	if (agent->active == false)
+		return false;
+
+	for (i = 0; i < agent->pending_count; i++)
+	{
+		if (strcmp(agent->pending[i], request) == 0)
+		{
+			queued = true;
+			break;
+		}
+	}
+
+	if (queued == true)
+	{
+		/* discard results of requests which are no longer of interest */
+		while (strcmp(agent->pending[0], request) != 0)
+		{
+			log_verbose(LOG_DEBUG, "remote_agent_command(): discarding result of \"%s\"",
+						agent->pending[0]);
+
+			if (_remote_agent_read_result(agent, NULL, NULL) == false)
+				return false;
+		}
+	}
+	else if (remote_agent_send(agent, request) == false)
+	{
+		return false;
+	}
+
+	if (_remote_agent_read_result(agent, outputbuf, return_value) == false)
+		return false;
+
+	if (outputbuf != NULL)
+	{
+		if (outputbuf->data != NULL && outputbuf->data[0] != '\0')
+			log_verbose(LOG_DEBUG, "remote_agent_command(): output returned was:\n%s", outputbuf->data);
+		else
+			log_verbose(LOG_DEBUG, "remote_agent_command(): no output returned");
+	}
+
+	return true;
+}
+
+
+/*
+ * Read the result of the oldest pending request.
+ */
+static bool
+_remote_agent_read_result(t_remote_agent *agent, PQExpBufferData *outputbuf, int *return_value)
+{
+	PQExpBufferData header;
+	PQExpBufferData scan_format;
+	int			result_value = 0;
+	int			result_length = 0;
+	instr_time	start_time;
+	int			i;
+
+	initPQExpBuffer(&header);
+	initPQExpBuffer(&scan_format);
+	appendPQExpBuffer(&scan_format, "%s %%i %%i", REMOTE_AGENT_RESULT);
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	if (_remote_agent_read_line(agent, &header, start_time) == false
+		|| sscanf(header.data, scan_format.data, &result_value, &result_length) != 2
+		|| result_length < 0)
+	{
+		log_warning(_("unexpected response from remote agent"));
+		if (header.data[0] != '\0')
+			log_detail("%s", header.data);
+
+		termPQExpBuffer(&header);
+		termPQExpBuffer(&scan_format);
+		stop_remote_agent(agent);
+		return false;
+	}
+
+	termPQExpBuffer(&header);
+	termPQExpBuffer(&scan_format);
+
+	if (_remote_agent_read(agent, result_length, start_time) == false)
+	{
+		log_warning(_("remote agent session terminated unexpectedly"));
+		stop_remote_agent(agent);
+		return false;
+	}
+
+	_remote_agent_consume(agent, result_length, outputbuf);
+
+	if (return_value != NULL)
+		*return_value = result_value;
+
+	pfree(agent->pending[0]);
+
+	for (i = 1; i < agent->pending_count; i++)
+		agent->pending[i - 1] = agent->pending[i];
+
+	agent->pending_count--;
+
+	return true;
+}
+
+
+/*
+ * _remote_agent_read()
+ *
+ * Read output from the agent until "response" contains at least "length"
+ * bytes or, if "length" is negative, a complete line. Returns false at end
+ * of output, or if the agent's timeout has expired since "start_time"; in
+ * the latter case, the agent process is sent SIGTERM so the session can be
+ * closed without waiting for the outstanding request to complete.
+ */
+static bool
+_remote_agent_read(t_remote_agent *agent, int length, instr_time start_time)
+{
+	char		buf[MAXLEN];
+
+	for (;;)
+	{
+		instr_time	elapsed_time;
+		double		remaining_ms;
+		struct pollfd pollfd;
+		ssize_t		bytes_read;
+
+		if (length < 0)
+		{
+			if (memchr(agent->response.data, '\n', agent->response.len) != NULL)
+				return true;
+		}
+		else if (agent->response.len >= (size_t) length)
+			return true;
+
+		INSTR_TIME_SET_CURRENT(elapsed_time);
+		INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+		remaining_ms = ((double) agent->timeout * 1000) - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+		if (remaining_ms <= 0)
+		{
+			log_warning(_("no response from remote agent within %i seconds"), agent->timeout);
+
+			if (agent->pid != UNKNOWN_PID)
+				(void) kill(agent->pid, SIGTERM);
+
+			return false;
+		}
+
+		pollfd.fd = agent->response_fd;
+		pollfd.events = POLLIN;
+		pollfd.revents = 0;
+
+		if (poll(&pollfd, 1, (int) remaining_ms + 1) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			log_warning(_("unable to read response from remote agent"));
+			log_detail("%s", strerror(errno));
+			return false;
+		}
+
+		if (pollfd.revents == 0)
+			continue;
+
+		bytes_read = read(agent->response_fd, buf, sizeof(buf));
+
+		if (bytes_read > 0)
+			appendBinaryPQExpBuffer(&agent->response, buf, bytes_read);
+		else if (bytes_read == 0)
+			return false;
+		else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+			return false;
+	}
+}
+
+
+/*
+ * _remote_agent_consume()
+ *
+ * Remove the first "length" bytes from the agent's unprocessed output,
+ * appending them to "outputbuf" if not NULL.
+ */
+static void
+_remote_agent_consume(t_remote_agent *agent, int length, PQExpBufferData *outputbuf)
+{
+	if (outputbuf != NULL)
+		appendBinaryPQExpBuffer(outputbuf, agent->response.data, length);
+
+	agent->response.len -= length;
+	memmove(agent->response.data, agent->response.data + length, agent->response.len);
+	agent->response.data[agent->response.len] = '\0';
+}
+
+
+/*
+ * _remote_agent_read_line()
+ *
+ * Read one line of output from the agent into "line", without the trailing
+ * newline.
+ */
+static bool
+_remote_agent_read_line(t_remote_agent *agent, PQExpBufferData *line, instr_time start_time)
+{
+	char	   *newline = NULL;
+
+	resetPQExpBuffer(line);
+
+	if (_remote_agent_read(agent, -1, start_time) == false)
+		return false;
+
+	newline = memchr(agent->response.data, '\n', agent->response.len);
+
+	_remote_agent_consume(agent, newline - agent->response.data, line);
+	_remote_agent_consume(agent, 1, NULL);
+
+	return true;
+}
+
+
+/*
+ * stop_remote_agent()
+ *
+ * Close the agent session and wait for the SSH process to exit; if it
+ * has not done so within REMOTE_AGENT_STOP_TIMEOUT milliseconds, it is
+ * sent SIGKILL.
+ */
+void
+stop_remote_agent(t_remote_agent *agent)
+{
+	int			i;
+
+	if (agent->request_fp != NULL)
+	{
+		if (agent->active == true)
+			(void) fprintf(agent->request_fp, "%s\n", REMOTE_AGENT_QUIT);
+
+		fclose(agent->request_fp);
+		agent->request_fp = NULL;
+	}
+
+	if (agent->response_fd >= 0)
+	{
+		close(agent->response_fd);
+		agent->response_fd = -1;
+	}
+
+	if (agent->response.data != NULL)
+		termPQExpBuffer(&agent->response);
+
+	if (agent->pid != UNKNOWN_PID)
+	{
+		instr_time	start_time;
+
+		INSTR_TIME_SET_CURRENT(start_time);
+
+		for (;;)
+		{
+			instr_time	elapsed_time;
+			pid_t		wait_result = waitpid(agent->pid, NULL, WNOHANG);
+
+			if (wait_result == agent->pid || (wait_result < 0 && errno != EINTR))
+				break;
+
+			INSTR_TIME_SET_CURRENT(elapsed_time);
+			INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+
+			if (INSTR_TIME_GET_MILLISEC(elapsed_time) >= REMOTE_AGENT_STOP_TIMEOUT)
+			{
+				log_verbose(LOG_WARNING, _("remote agent did not terminate, sending SIGKILL"));
+
+				(void) kill(agent->pid, SIGKILL);
+				(void) waitpid(agent->pid, NULL, 0);
+				break;
+			}
+
+			pg_usleep(COMMAND_TASK_REAP_INTERVAL * 1000L);
+		}
+
+		agent->pid = UNKNOWN_PID;
+	}
+
+	for (i = 0; i < agent->pending_count; i++)
+		pfree(agent->pending[i]);
+
+	agent->pending_count = 0;
+	agent->active = false;
+}
+
+
+/*
+ * Initialise a command task; "command" is copied and will be freed by
+ * term_command_task().
+ */
+void
+init_command_task(t_command_task *task, int id, const char *command)
+{
+	memset(task, 0, sizeof(t_command_task));
+
+	task->id = id;
+	task->command = pg_strdup(command);
+	task->pid = UNKNOWN_PID;
+	task->fd = -1;
+	task->return_value = -1;
+
+	initPQExpBuffer(&task->output);
+}
+
+
+void
+term_command_task(t_command_task *task)
+{
+	if (task->command != NULL)
+	{
+		pfree(task->command);
+		task->command = NULL;
+	}
+
+	termPQExpBuffer(&task->output);
+}
+
+
+/*
+ * execute_commands_parallel()
+ *
+ * Execute the provided shell commands (typically "ssh" invocations created
+ * with make_remote_command()) concurrently, with at most "max_parallel"
+ * commands running at any one time. Each command's standard output is read
+ * through a non-blocking pipe into the task's output buffer.
+ *
+ * Any command which has not completed within "timeout" seconds of being
+ * started is terminated, and marked as timed out; if "timeout" is zero,
+ * commands are not subject to a time limit.
+ *
+ * If provided, "callback" is executed as soon as each command completes,
+ * so callers can process results as they arrive.
+ *
+ * As each command runs in its own process group, it will not receive
+ * signals generated from the terminal; if SIGINT or SIGTERM is received
+ * while commands are running, it is forwarded to each running command,
+ * and repmgr exits once they have terminated.
+ *
+ * Returns the number of commands which completed successfully.
+ */
+int
+execute_commands_parallel(t_command_task *tasks, int task_count, int max_parallel, int timeout,
+						  void (*callback) (t_command_task *task, void *arg), void *arg)
+{
+	return _execute_commands_parallel(tasks, task_count, max_parallel, timeout,
+									  callback, arg, NULL);
+}
+
+
+/*
+ * execute_commands_parallel_progress()
+ *
+ * As execute_commands_parallel(), without a time limit, but additionally
+ * executing "progress_callback" with the full task list every
+ * "progress_interval_ms" milliseconds while commands are running, so
+ * callers can report progress from the output received so far.
+ */
+int
+execute_commands_parallel_progress(t_command_task *tasks, int task_count, int max_parallel, int progress_interval_ms,
+								   void (*progress_callback) (t_command_task *tasks, int task_count, void *arg), void *arg)
+{
+	t_progress_hook progress_hook;
+
+	progress_hook.interval_ms = progress_interval_ms;
+	progress_hook.callback = progress_callback;
+	progress_hook.arg = arg;
+
+	return _execute_commands_parallel(tasks, task_count, max_parallel, 0,
+									  NULL, NULL, &progress_hook);
+}
+
+
+/*
+ * signal_command_tasks()
+ *
+ * Send "signo" to each running command (and any processes it has spawned),
+ * e.g. SIGSTOP and SIGCONT to pause and resume commands from a progress
+ * callback.
+ */
+void
+signal_command_tasks(t_command_task *tasks, int task_count, int signo)
+{
+	int			i;
+
+	for (i = 0; i < task_count; i++)
+	{
+		if (tasks[i].pid == UNKNOWN_PID)
+			continue;
+
+		/* the command was started in its own process group */
+		(void) kill(-tasks[i].pid, signo);
+	}
+}
+
+
+static int
+_execute_commands_parallel(t_command_task *tasks, int task_count, int max_parallel, int timeout,
+						   void (*callback) (t_command_task *task, void *arg), void *arg,
+						   t_progress_hook *progress_hook)
+{
+	t_command_task **active_tasks = NULL;
+	struct pollfd *pollfds = NULL;
+	int			active_count = 0;
+	int			next_task = 0;
+	int			success_count = 0;
+	instr_time	last_progress_time;
+	pqsigfunc	prev_sigint_handler;
+	pqsigfunc	prev_sigterm_handler;
+
+	if (task_count == 0)
+		return 0;
+
+	INSTR_TIME_SET_CURRENT(last_progress_time);
+
+	command_tasks_signal = 0;
+
+	prev_sigint_handler = pqsignal(SIGINT, _handle_command_tasks_signal);
+	prev_sigterm_handler = pqsignal(SIGTERM, _handle_command_tasks_signal);
+
+	/* don't override a signal which is being ignored, e.g. via "nohup" */
+	if (prev_sigint_handler == SIG_IGN)
+		(void) pqsignal(SIGINT, SIG_IGN);
+
+	if (prev_sigterm_handler == SIG_IGN)
+		(void) pqsignal(SIGTERM, SIG_IGN);
+
+	if (max_parallel < 1)
+		max_parallel = 1;
+
+	if (max_parallel > task_count)
+		max_parallel = task_count;
+
+	active_tasks = pg_malloc0(sizeof(t_command_task *) * max_parallel);
+	pollfds = pg_malloc0(sizeof(struct pollfd) * max_parallel);
+
+	while (next_task < task_count || active_count > 0)
+	{
+		double		min_remaining_ms = (double) timeout * 1000;
+		int			poll_timeout = -1;
+		bool		awaiting_exit = false;
+		char		buf[MAXLEN];
+		int			i;
+
+		/* start new commands while capacity is available */
+		while (next_task < task_count && active_count < max_parallel)
+		{
+			t_command_task *task = &tasks[next_task++];
+
+			if (_start_command_task(task) == false)
+			{
+				if (callback != NULL)
+					(*callback) (task, arg);
+				continue;
+			}
+
+			active_tasks[active_count++] = task;
+		}
+
+		if (active_count == 0)
+			continue;
+
+		for (i = 0; i < active_count; i++)
+		{
+			instr_time	elapsed_time;
+			double		remaining_ms;
+
+			INSTR_TIME_SET_CURRENT(elapsed_time);
+			INSTR_TIME_SUBTRACT(elapsed_time, active_tasks[i]->start_time);
+			remaining_ms = ((double) timeout * 1000) - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+			if (remaining_ms < min_remaining_ms)
+				min_remaining_ms = remaining_ms;
+
+			pollfds[i].fd = active_tasks[i]->fd;
+			pollfds[i].events = POLLIN;
+			pollfds[i].revents = 0;
+
+			/* output complete, or termination requested - wait for exit */
+			if (active_tasks[i]->fd < 0 || active_tasks[i]->timed_out == true)
+				awaiting_exit = true;
+		}
+
+		if (min_remaining_ms < 0)
+			min_remaining_ms = 0;
+
+		if (timeout > 0)
+			poll_timeout = (int) min_remaining_ms + 1;
+
+		if (awaiting_exit == true && (poll_timeout < 0 || poll_timeout > COMMAND_TASK_REAP_INTERVAL))
+			poll_timeout = COMMAND_TASK_REAP_INTERVAL;
+
+		/* wake up in time to execute the progress callback */
+		if (progress_hook != NULL)
+		{
+			instr_time	elapsed_time;
+			double		progress_remaining_ms;
+
+			INSTR_TIME_SET_CURRENT(elapsed_time);
+			INSTR_TIME_SUBTRACT(elapsed_time, last_progress_time);
+			progress_remaining_ms = (double) progress_hook->interval_ms - INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+			if (progress_remaining_ms < 0)
+				progress_remaining_ms = 0;
+
+			if (poll_timeout < 0 || progress_remaining_ms < poll_timeout)
+				poll_timeout = (int) progress_remaining_ms + 1;
+		}
+
+		if (poll(pollfds, active_count, poll_timeout) < 0 && errno != EINTR)
+		{
+			log_warning(_("execute_commands_parallel(): poll() returned with error"));
+			log_detail("%s", strerror(errno));
+			break;
+		}
+
+		if (command_tasks_signal != 0)
+		{
+			int			signo = command_tasks_signal;
+
+			_terminate_command_tasks(active_tasks, active_count, signo);
+
+			/* exit as if the signal had been received directly */
+			(void) pqsignal(SIGINT, prev_sigint_handler);
+			(void) pqsignal(SIGTERM, prev_sigterm_handler);
+			(void) raise(signo);
+
+			exit(ERR_SYS_FAILURE);
+		}
+
+		/*
+		 * Read any available output; iterate backwards so completed entries
+		 * can be replaced by the last active entry.
+		 */
+		for (i = active_count - 1; i >= 0; i--)
+		{
+			t_command_task *task = active_tasks[i];
+			int			status = -1;
+			pid_t		wait_result = 0;
+
+			if (task->fd >= 0 && pollfds[i].revents != 0)
+			{
+				for (;;)
+				{
+					ssize_t		bytes_read = read(task->fd, buf, sizeof(buf));
+
+					if (bytes_read > 0)
+					{
+						appendBinaryPQExpBuffer(&task->output, buf, bytes_read);
+						continue;
+					}
+
+					/* EOF, or an error other than "no data available yet" */
+					if (bytes_read == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+					{
+						close(task->fd);
+						task->fd = -1;
+					}
+
+					break;
+				}
+			}
+
+			/*
+			 * The command has finished once it has exited; check for this
+			 * without blocking, as it may have closed its output but still be
+			 * running, or be ignoring SIGTERM.
+			 */
+			if (task->fd < 0 || task->timed_out == true)
+			{
+				wait_result = waitpid(task->pid, &status, WNOHANG);
+
+				/* the command can no longer be waited for */
+				if (wait_result < 0 && errno != EINTR)
+				{
+					status = -1;
+					wait_result = task->pid;
+				}
+			}
+
+			if (wait_result != task->pid)
+			{
+				if (task->timed_out == true)
+				{
+					_kill_command_task(task);
+				}
+				else if (timeout > 0)
+				{
+					instr_time	elapsed_time;
+
+					INSTR_TIME_SET_CURRENT(elapsed_time);
+					INSTR_TIME_SUBTRACT(elapsed_time, task->start_time);
+
+					if (INSTR_TIME_GET_DOUBLE(elapsed_time) >= (double) timeout)
+					{
+						log_verbose(LOG_WARNING, _("command timed out after %i seconds:\n  %s"),
+									timeout, task->command);
+
+						task->timed_out = true;
+						INSTR_TIME_SET_CURRENT(task->term_time);
+
+						/* the command was started in its own process group */
+						kill(-task->pid, SIGTERM);
+					}
+				}
+
+				continue;
+			}
+
+			_finish_command_task(task, status);
+
+			if (task->success == true)
+				success_count++;
+
+			if (callback != NULL)
+				(*callback) (task, arg);
+
+			active_count--;
+			active_tasks[i] = active_tasks[active_count];
+		}
+
+		if (progress_hook != NULL)
+		{
+			instr_time	elapsed_time;
+
+			INSTR_TIME_SET_CURRENT(elapsed_time);
+			INSTR_TIME_SUBTRACT(elapsed_time, last_progress_time);
+
+			if (INSTR_TIME_GET_MILLISEC(elapsed_time) >= (double) progress_hook->interval_ms)
+			{
+				(*progress_hook->callback) (tasks, task_count, progress_hook->arg);
+				INSTR_TIME_SET_CURRENT(last_progress_time);
+			}
+		}
+	}
+
+	(void) pqsignal(SIGINT, prev_sigint_handler);
+	(void) pqsignal(SIGTERM, prev_sigterm_handler);
+
+	pfree(active_tasks);
+	pfree(pollfds);
+
+	return success_count;
+}
+
+
+static void
+_handle_command_tasks_signal(SIGNAL_ARGS)
+{
+	command_tasks_signal = postgres_signal_arg;
+}
+
+
+/*
+ * _terminate_command_tasks()
+ *
+ * Forward "signo" to each running command's process group, and wait for
+ * the commands to exit; any which have not done so within
+ * COMMAND_TASK_KILL_TIMEOUT milliseconds are sent SIGKILL.
+ */
+static void
+_terminate_command_tasks(t_command_task **active_tasks, int active_count, int signo)
+{
+	instr_time	start_time;
+	int			remaining = active_count;
+	bool		killed = false;
+	int			i;
+
+	log_notice(_("%s signal received, terminating %i running command(s)"),
+			   signo == SIGTERM ? "TERM" : "INT",
+			   active_count);
+
+	for (i = 0; i < active_count; i++)
+	{
+		(void) kill(-active_tasks[i]->pid, signo);
+
+		/* in case the command was paused with SIGSTOP */
+		(void) kill(-active_tasks[i]->pid, SIGCONT);
+	}
+
+	INSTR_TIME_SET_CURRENT(start_time);
+
+	while (remaining > 0)
+	{
+		instr_time	elapsed_time;
+
+		for (i = 0; i < active_count; i++)
+		{
+			pid_t		wait_result;
+
+			if (active_tasks[i]->pid == UNKNOWN_PID)
+				continue;
+
+			wait_result = waitpid(active_tasks[i]->pid, NULL, killed == true ? 0 : WNOHANG);
+
+			if (wait_result == active_tasks[i]->pid || (wait_result < 0 && errno != EINTR))
+			{
+				active_tasks[i]->pid = UNKNOWN_PID;
+				remaining--;
+			}
+		}
+
+		/* after SIGKILL, the commands are waited for without WNOHANG */
+		if (remaining == 0 || killed == true)
+			continue;
+
+		INSTR_TIME_SET_CURRENT(elapsed_time);
+		INSTR_TIME_SUBTRACT(elapsed_time, start_time);
+
+		if (INSTR_TIME_GET_MILLISEC(elapsed_time) >= COMMAND_TASK_KILL_TIMEOUT)
+		{
+			log_warning(_("%i command(s) did not terminate, sending SIGKILL"), remaining);
+
+			for (i = 0; i < active_count; i++)
+			{
+				if (active_tasks[i]->pid != UNKNOWN_PID)
+					(void) kill(-active_tasks[i]->pid, SIGKILL);
+			}
+
+			killed = true;
+			continue;
+		}
+
+		pg_usleep(COMMAND_TASK_REAP_INTERVAL * 1000L);
+	}
+}
+
+
+static bool
+_start_command_task(t_command_task *task)
+{
+	int			pipefd[2];
+
+	INSTR_TIME_SET_CURRENT(task->start_time);
+
+	log_verbose(LOG_DEBUG, "execute_commands_parallel(): executing:\n  %s", task->command);
+
+	if (pipe(pipefd) != 0)
+	{
+		log_error(_("unable to create pipe for command:\n  %s"), task->command);
+		log_detail("%s", strerror(errno));
+		return false;
+	}
+
+	fflush(NULL);
+
+	task->pid = fork();
+
+	if (task->pid == -1)
+	{
+		log_error(_("unable to execute command:\n  %s"), task->command);
+		log_detail("%s", strerror(errno));
+		close(pipefd[0]);
+		close(pipefd[1]);
+		task->pid = UNKNOWN_PID;
+		return false;
+	}
+
+	if (task->pid == 0)
+	{
+		/*
+		 * Run the command in its own process group, so it can be terminated
+		 * together with any processes it spawns (e.g. "ssh") on timeout;
+		 * SIGINT and SIGTERM are forwarded by execute_commands_parallel().
+		 */
+		(void) setpgid(0, 0);
+
+		close(pipefd[0]);
+
+		if (dup2(pipefd[1], STDOUT_FILENO) < 0)
+			_exit(127);
+
+		close(pipefd[1]);
+
+		execl("/bin/sh", "sh", "-c", task->command, (char *) NULL);
+		_exit(127);
+	}
+
+	/*
+	 * Also set the process group from the parent, so it exists before any
+	 * kill(-pid, ...) regardless of which process is scheduled first; one of
+	 * the two calls may fail harmlessly with EACCES or ESRCH.
+	 */
+	(void) setpgid(task->pid, task->pid);
+
+	close(pipefd[1]);
+
+	task->fd = pipefd[0];
+	(void) fcntl(task->fd, F_SETFL, fcntl(task->fd, F_GETFL) | O_NONBLOCK);
+	(void) fcntl(task->fd, F_SETFD, FD_CLOEXEC);
+
+	return true;
+}
+
+
+/*
+ * _kill_command_task()
+ *
+ * Send SIGKILL to a timed out command which has not exited within
+ * COMMAND_TASK_KILL_TIMEOUT milliseconds of being sent SIGTERM.
+ */
+static void
+_kill_command_task(t_command_task *task)
+{
+	instr_time	elapsed_time;
+
+	if (task->killed == true)
+		return;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, task->term_time);
+
+	if (INSTR_TIME_GET_MILLISEC(elapsed_time) < COMMAND_TASK_KILL_TIMEOUT)
+		return;
+
+	log_verbose(LOG_WARNING, _("command did not terminate after SIGTERM, sending SIGKILL:\n  %s"),
+				task->command);
+
+	(void) kill(-task->pid, SIGKILL);
+	task->killed = true;
+}
+
+
+/*
+ * _finish_command_task()
+ *
+ * Record the result of a command which has exited with "status"; -1
+ * indicates the exit status is not available.
+ */
+static void
+_finish_command_task(t_command_task *task, int status)
+{
+	instr_time	elapsed_time;
+
+	if (task->fd >= 0)
+	{
+		close(task->fd);
+		task->fd = -1;
+	}
+
+	task->pid = UNKNOWN_PID;
+
+	if (status != -1 && WIFEXITED(status))
+		task->return_value = WEXITSTATUS(status);
+
+	task->success = (task->timed_out == false && task->return_value == 0) ? true : false;
+
+	INSTR_TIME_SET_CURRENT(elapsed_time);
+	INSTR_TIME_SUBTRACT(elapsed_time, task->start_time);
+	task->elapsed_ms = (int) INSTR_TIME_GET_MILLISEC(elapsed_time);
+
+	log_verbose(LOG_DEBUG, "execute_commands_parallel(): command returned %i after %i ms; output was:\n%s",
+				task->return_value, task->elapsed_ms, task->output.data);
+}
+
+
 pid_t
 disable_wal_receiver(PGconn *conn)
 {
@@ -19,6 +19,69 @@
 #ifndef _SYSUTILS_H_
 #define _SYSUTILS_H_
 
+/*
+ * A shell command to be executed by execute_commands_parallel(); "id" is
+ * available for the caller's use, e.g. to identify the node the command
+ * was executed on.
+ */
+typedef struct s_command_task
+{
+	int			id;
+	char	   *command;
+	PQExpBufferData output;
+	int			return_value;
+	bool		success;
+	bool		timed_out;
+	int			elapsed_ms;
+	/* internal state */
+	pid_t		pid;
+	int			fd;
+	instr_time	start_time;
+	instr_time	term_time;
+	bool		killed;
+} t_command_task;
+
+/*
+ * "repmgr node agent" protocol; see do_node_agent(). The agent announces
+ * itself with a greeting line, then answers each request line with a
+ * result header line followed by exactly "length" bytes of output.
+ */
+#define REMOTE_AGENT_GREETING			"REPMGR-AGENT"
+#define REMOTE_AGENT_RESULT				"RESULT"
+#define REMOTE_AGENT_QUIT				"QUIT"
+#define REMOTE_AGENT_WAIT_SHUTDOWN		"WAIT-SHUTDOWN"
+#define REMOTE_AGENT_PROTOCOL_VERSION	2
+#define REMOTE_AGENT_MAX_PENDING		16
+#define REMOTE_AGENT_STOP_TIMEOUT		5000	/* milliseconds */
+
+/* result codes returned by the agent for a "WAIT-SHUTDOWN" request */
+#define REMOTE_AGENT_WAIT_SHUTDOWN_DONE		0
+#define REMOTE_AGENT_WAIT_SHUTDOWN_TIMEOUT	1
+#define REMOTE_AGENT_WAIT_SHUTDOWN_STALE	2
+
+/*
+ * Client-side state of a "repmgr node agent" session; requests which have
+ * been sent but whose results have not yet been read are held in "pending"
+ * in the order they were sent. "response" holds output read from the agent
+ * which has not yet been processed, and "timeout" is the time in seconds
+ * allowed for each response.
+ */
+typedef struct s_remote_agent
+{
+	bool		active;
+	int			protocol_version;
+	int			repmgr_version;
+	pid_t		pid;
+	FILE	   *request_fp;
+	int			response_fd;
+	PQExpBufferData response;
+	int			timeout;
+	int			pending_count;
+	char	   *pending[REMOTE_AGENT_MAX_PENDING];
+} t_remote_agent;
+
+#define T_REMOTE_AGENT_INITIALIZER { false, 0, 0, UNKNOWN_PID, NULL, -1, { NULL, 0, 0 }, 0, 0, { NULL } }
+
 extern bool local_command(const char *command, PQExpBufferData *outputbuf);
 extern bool local_command_return_value(const char *command, PQExpBufferData *outputbuf, int *return_value);
 extern bool local_command_simple(const char *command, PQExpBufferData *outputbuf);
@@ -26,6 +89,19 @@ extern bool local_command_simple(const char *command, PQExpBufferData *outputbuf
 extern bool remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *outputbuf);
 extern void make_remote_command(const char *host, const char *user, const char *command, const char *ssh_options, PQExpBufferData *ssh_command);
 
+extern bool start_remote_agent(const char *host, const char *user, const char *command, const char *ssh_options, int timeout, t_remote_agent *agent);
+extern bool remote_agent_send(t_remote_agent *agent, const char *request);
+extern bool remote_agent_command(t_remote_agent *agent, const char *request, PQExpBufferData *outputbuf, int *return_value);
+extern void stop_remote_agent(t_remote_agent *agent);
+
+extern void init_command_task(t_command_task *task, int id, const char *command);
+extern void term_command_task(t_command_task *task);
+extern int	execute_commands_parallel(t_command_task *tasks, int task_count, int max_parallel, int timeout,
+									  void (*callback) (t_command_task *task, void *arg), void *arg);
+extern void signal_command_tasks(t_command_task *tasks, int task_count, int signo);
+extern int	execute_commands_parallel_progress(t_command_task *tasks, int task_count, int max_parallel, int progress_interval_ms,
+											   void (*progress_callback) (t_command_task *tasks, int task_count, void *arg), void *arg);
+
 extern pid_t disable_wal_receiver(PGconn *conn);
 extern pid_t enable_wal_receiver(PGconn *conn, bool wait_startup);
 